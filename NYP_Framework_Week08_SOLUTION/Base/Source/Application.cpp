@@ -3,6 +3,8 @@
 #include "KeyboardController.h"
 #include "SceneManager.h"
 #include "GraphicsManager.h"
+#include "StreamBuffer.h"
+#include "RenderStats.h"
 
 //Include GLEW
 #include <GL/glew.h>
@@ -16,6 +18,7 @@
 
 #include "SceneText.h"
 #include "FPSCounter.h"
+#include "ThreadPool/ThreadPool.h"
 
 GLFWwindow* m_window;
 const unsigned char FPS = 120; // FPS of this game
@@ -109,6 +112,9 @@ void Application::Init()
 
 	// Init systems
 	GraphicsManager::GetInstance()->Init();
+	CStreamBuffer::GetInstance()->Init();
+	CRenderStats::GetInstance()->Init();
+	CThreadPool::GetInstance()->Init();
 }
 
 void Application::Run()
@@ -129,10 +135,15 @@ void Application::Run()
 		// Update the FPS counter
 		CFPSCounter::GetInstance()->Update(dElapsedTime);
 		SceneManager::GetInstance()->Update(dElapsedTime);
+		// Count and time the rendering of this frame
+		CRenderStats::GetInstance()->BeginFrame();
 		SceneManager::GetInstance()->Render();
+		CRenderStats::GetInstance()->EndFrame();
 
 		//Swap buffers
 		glfwSwapBuffers(m_window);
+		// Fence the streamed geometry of this frame
+		CStreamBuffer::GetInstance()->EndFrame();
 		//Get and organize events, like keyboard and mouse input, window resizing, etc...
 
         m_timer.waitUntil(frameTime);       // Frame rate limiter. Limits each frame to a specified time in ms.   
@@ -144,6 +155,13 @@ void Application::Run()
 
 void Application::Exit()
 {
+	// Stop the worker threads
+	CThreadPool::GetInstance()->Exit();
+
+	// Delete the streaming buffer and the timer queries while the OpenGL context is still there
+	CStreamBuffer::GetInstance()->Destroy();
+	CRenderStats::GetInstance()->Destroy();
+
 	//Close OpenGL window and terminate GLFW
 	glfwDestroyWindow(m_window);
 	//Finalize and clean up GLFW
@@ -170,6 +170,9 @@ void CEnemy3D::Update(double dt)
 		// Reset the timer
 		m_fElapsedTimeBeforeUpdate = 0.0f;
 	}
+
+	// Update the cross-fade between the levels of detail
+	UpdateLOD(dt);
 }
 
 // Constrain the position within the borders
@@ -206,8 +209,7 @@ void CEnemy3D::Render(void)
 {
 	if ((GetLODStatus() == true))
 	{
-		if (theDetailLevel != NO_DETAILS)
-			RenderHelper::RenderMesh(GetLODMesh());
+		RenderLOD();
 	}
 	else
 		RenderHelper::RenderMesh(modelMesh);
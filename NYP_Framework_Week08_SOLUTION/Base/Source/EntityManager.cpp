@@ -5,10 +5,17 @@
 #include "SpatialPartition\SpatialPartition.h"
 #include "SceneGraph\SceneGraph.h"
 #include "Projectile/Laser.h"
+#include "OcclusionCulling/OcclusionCulling.h"
+#include "GenericEntity.h"
+#include "RenderQueue.h"
+#include <algorithm>
 
 #include <iostream>
 using namespace std;
 
+// The number of generic entities in each job of a parallel render
+static const int RENDER_JOB_SIZE = 32;
+
 // Update all entities
 void EntityManager::Update(double _dt)
 {
@@ -32,6 +39,9 @@ void EntityManager::Update(double _dt)
 	// Check for Collision amongst entities with collider properties
 	CheckForCollision();
 
+	// Delete the scene nodes which were removed in this frame, before their entities are deleted below
+	CSceneGraph::GetInstance()->FlushDeletions();
+
 	// Clean up entities that are done
 	it = entityList.begin();
 	while (it != end)
@@ -72,13 +82,40 @@ void EntityManager::Update(double _dt)
 void EntityManager::Render()
 {
 	// Render all entities
+	theParallelEntities.clear();
 	std::list<EntityBase*>::iterator it, end;
 	end = entityList.end();
 	for (it = entityList.begin(); it != end; ++it)
 	{
-		(*it)->Render();
+		// Skip the entities which are drawn by CStaticBatch
+		if ((*it)->IsStatic())
+			continue;
+
+		// The generic entities only render through RenderHelper, so they can be recorded on other threads.
+		// The other entities may make OpenGL calls of their own, such as to rebuild a text mesh
+		if (dynamic_cast<GenericEntity*>(*it) != NULL)
+		{
+			theParallelEntities.push_back(*it);
+			continue;
+		}
+
+		// Skip the entities which are hidden behind the occluders
+		if (IsVisible(*it))
+			(*it)->Render();
 	}
 
+	// Record the generic entities on the thread pool
+	const int numOfJobs = ((int)theParallelEntities.size() + RENDER_JOB_SIZE - 1) / RENDER_JOB_SIZE;
+	CRenderQueue::GetInstance()->RecordParallel(numOfJobs, [this](const int jobIndex)
+	{
+		const int jobEnd = std::min((jobIndex + 1) * RENDER_JOB_SIZE, (int)theParallelEntities.size());
+		for (int i = jobIndex * RENDER_JOB_SIZE; i < jobEnd; ++i)
+		{
+			if (IsVisible(theParallelEntities[i]))
+				theParallelEntities[i]->Render();
+		}
+	});
+
 	// Render the projectiles
 	std::list<EntityBase*>::iterator item_projectile = projectileList.begin();
 	while (item_projectile != projectileList.end())
@@ -88,6 +125,15 @@ void EntityManager::Render()
 	}
 }
 
+// Check if an entity is not hidden behind the occluders
+bool EntityManager::IsVisible(EntityBase* theEntity) const
+{
+	CCollider* theCollider = dynamic_cast<CCollider*>(theEntity);
+	if ((theEntity->HasCollider() == false) || (theCollider == NULL))
+		return true;
+	return COcclusionCulling::GetInstance()->IsBoxVisible(theEntity->GetPosition(), theCollider->GetMinAABB(), theCollider->GetMaxAABB());
+}
+
 // Render the UI entities
 void EntityManager::RenderUI()
 {
@@ -3,6 +3,7 @@
 
 #include "SingletonTemplate.h"
 #include <list>
+#include <vector>
 #include "Vector3.h"
 
 class EntityBase;
@@ -19,6 +20,7 @@ public:
 	};
 
 	void Update(double _dt);
+	// Render the entities. The generic entities are recorded in parallel by CRenderQueue::RecordParallel
 	void Render();
 	void RenderUI();
 
@@ -31,6 +33,9 @@ private:
 	EntityManager();
 	virtual ~EntityManager();
 
+	// Check if an entity is not hidden behind the occluders
+	bool IsVisible(EntityBase* theEntity) const;
+
 	// Check for overlap
 	bool CheckOverlap(Vector3 thisMinAABB, Vector3 thisMaxAABB, Vector3 thatMinAABB, Vector3 thatMaxAABB);
 	// Check if this entity's bounding sphere collided with that entity's bounding sphere 
@@ -53,6 +58,8 @@ private:
 	std::list<EntityBase*> entityList;
 	// List of Projectiles
 	std::list<EntityBase*> projectileList;
+	// The generic entities to be recorded in parallel, kept so it is not allocated every frame
+	std::vector<EntityBase*> theParallelEntities;
 };
 
 #endif // ENTITY_MANAGER_H
\ No newline at end of file
@@ -16,6 +16,9 @@ GenericEntity::~GenericEntity()
 void GenericEntity::Update(double _dt)
 {
 	// Does nothing here, can inherit & override or create your own version of this class :D
+
+	// Update the cross-fade between the levels of detail
+	UpdateLOD(_dt);
 }
 
 void GenericEntity::Render()
@@ -27,8 +30,7 @@ void GenericEntity::Render()
 
 	if ((GetLODStatus() == true))
 	{
-		if (theDetailLevel != NO_DETAILS)
-			RenderHelper::RenderMesh(GetLODMesh());
+		RenderLOD();
 	}
 	else
 		RenderHelper::RenderMesh(modelMesh);
@@ -50,6 +52,12 @@ void GenericEntity::GetAABB(Vector3& maxAABB, Vector3& minAABB)
 	minAABB = this->minAABB;
 }
 
+// Get the mesh of this entity
+Mesh* GenericEntity::GetMesh(void) const
+{
+	return modelMesh;
+}
+
 GenericEntity* Create::Entity(	const std::string& _meshName, 
 								const Vector3& _position,
 								const Vector3& _scale,
@@ -22,6 +22,9 @@ public:
 	// Get the maxAABB and minAABB
 	void GetAABB(Vector3& maxAABB, Vector3& minAABB);
 
+	// Get the mesh of this entity
+	Mesh* GetMesh(void) const;
+
 private:
 	Mesh* modelMesh;
 };
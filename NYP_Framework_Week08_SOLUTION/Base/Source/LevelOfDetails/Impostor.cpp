@@ -0,0 +1,259 @@
+#include "Impostor.h"
+#include "MeshBuilder.h"
+#include "GraphicsManager.h"
+#include "RenderHelper.h"
+#include "CameraBase.h"
+#include "MyMath.h"
+#include <GL/glew.h>
+#include <cmath>
+#include <iostream>
+using namespace std;
+
+/********************************************************************************
+ Constructor
+ ********************************************************************************/
+CImpostor::CImpostor(void)
+	: theAtlasMesh(NULL)
+	, atlasTexture(0)
+	, radius(1.0f)
+{
+}
+
+/********************************************************************************
+ Destructor
+ ********************************************************************************/
+CImpostor::~CImpostor(void)
+{
+	// Do not delete the Mesh here as MeshBuilder will take care of them.
+	// The Mesh also deletes the atlas texture
+	theAtlasMesh = NULL;
+}
+
+/********************************************************************************
+ Render theSourceMesh from all the angles into the atlas
+ ********************************************************************************/
+bool CImpostor::Init(const std::string& _meshName, Mesh* theSourceMesh, const float radius)
+{
+	if ((theSourceMesh == NULL) || (radius <= 0.0f))
+	{
+		cout << "CImpostor::Init: Unable to create the impostor " << _meshName << endl;
+		return false;
+	}
+	this->radius = radius;
+
+	const int atlasWidth = ATLAS_COLUMNS * CELL_SIZE;
+	const int atlasHeight = ATLAS_ROWS * CELL_SIZE;
+
+	// Create the atlas texture, with a transparent background
+	glGenTextures(1, &atlasTexture);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// Create a frame buffer to render into the atlas
+	GLuint frameBuffer = 0, depthBuffer = 0;
+	glGenFramebuffers(1, &frameBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlasTexture, 0);
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasWidth, atlasHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		cout << "CImpostor::Init: The frame buffer for " << _meshName << " is incomplete" << endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteRenderbuffers(1, &depthBuffer);
+		glDeleteFramebuffers(1, &frameBuffer);
+		glDeleteTextures(1, &atlasTexture);
+		atlasTexture = 0;
+		return false;
+	}
+
+	// Save the states which are changed here
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	Mtx44 savedProjection = GraphicsManager::GetInstance()->GetProjectionMatrix();
+	CameraBase* savedCamera = GraphicsManager::GetInstance()->GetActiveCamera();
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// Look at the mesh along the -z axis, with the mesh rotated to each view angle
+	GraphicsManager::GetInstance()->SetOrthographicProjection(-radius, radius, -radius, radius, -radius * 2.0f, radius * 2.0f);
+	GraphicsManager::GetInstance()->DetachCamera();
+	MS& modelStack = GraphicsManager::GetInstance()->GetModelStack();
+
+	RenderHelper::PreRenderMesh();
+	for (int pitchIndex = 0; pitchIndex < NUM_PITCH_VIEWS; ++pitchIndex)
+	{
+		for (int yawIndex = 0; yawIndex < NUM_YAW_VIEWS; ++yawIndex)
+		{
+			// The cells are in the same order as the quads of GenerateText, which starts from the top row
+			int view = pitchIndex * NUM_YAW_VIEWS + yawIndex;
+			int row = view / ATLAS_COLUMNS;
+			int column = view % ATLAS_COLUMNS;
+			glViewport(column * CELL_SIZE, (ATLAS_ROWS - 1 - row) * CELL_SIZE, CELL_SIZE, CELL_SIZE);
+
+			modelStack.PushMatrix();
+			modelStack.LoadIdentity();
+			modelStack.Rotate(GetPitchAngle(pitchIndex), 1, 0, 0);
+			modelStack.Rotate(-yawIndex * 360.0f / NUM_YAW_VIEWS, 0, 1, 0);
+			RenderHelper::RenderMesh(theSourceMesh);
+			modelStack.PopMatrix();
+		}
+	}
+	RenderHelper::PostRenderMesh();
+
+	// Restore the states
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+	GraphicsManager::GetInstance()->GetProjectionMatrix() = savedProjection;
+	if (savedCamera)
+		GraphicsManager::GetInstance()->AttachCamera(savedCamera);
+
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDeleteFramebuffers(1, &frameBuffer);
+
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// A quad for each cell of the atlas
+	theAtlasMesh = MeshBuilder::GetInstance()->GenerateText(_meshName + "_IMPOSTOR", ATLAS_ROWS, ATLAS_COLUMNS);
+	theAtlasMesh->textureID = atlasTexture;
+	return true;
+}
+
+/********************************************************************************
+ Render the impostor facing the camera
+ ********************************************************************************/
+void CImpostor::Render(void)
+{
+	if (theAtlasMesh == NULL)
+		return;
+
+	// Find the camera's position in the model space of the entity
+	MS& modelStack = GraphicsManager::GetInstance()->GetModelStack();
+	Mtx44 modelView = GraphicsManager::GetInstance()->GetViewMatrix() * modelStack.Top();
+	Mtx44 modelView_inverse;
+	try
+	{
+		modelView_inverse = modelView.GetInverse();
+	}
+	catch (DivideByZero)
+	{
+		return;
+	}
+	float cameraX = modelView_inverse.a[12];
+	float cameraY = modelView_inverse.a[13];
+	float cameraZ = modelView_inverse.a[14];
+
+	// Choose the view nearest to the camera's angle
+	float yaw = Math::RadianToDegree(atan2(cameraX, cameraZ));
+	float pitch = Math::RadianToDegree(atan2(cameraY, sqrt(cameraX * cameraX + cameraZ * cameraZ)));
+	int yawIndex = (int)floor(yaw / (360.0f / NUM_YAW_VIEWS) + 0.5f);
+	yawIndex = ((yawIndex % NUM_YAW_VIEWS) + NUM_YAW_VIEWS) % NUM_YAW_VIEWS;
+	int pitchIndex = 0;
+	while ((pitchIndex + 1 < NUM_PITCH_VIEWS) && (pitch > (GetPitchAngle(pitchIndex) + GetPitchAngle(pitchIndex + 1)) * 0.5f))
+		pitchIndex++;
+	int view = pitchIndex * NUM_YAW_VIEWS + yawIndex;
+
+	// Turn the quad to face the camera
+	modelStack.PushMatrix();
+	modelStack.Rotate(yaw, 0, 1, 0);
+	modelStack.Rotate(-pitch, 1, 0, 0);
+	modelStack.Scale(radius * 2.0f, radius * 2.0f, 1.0f);
+	RenderHelper::SetAlphaTest(true);
+	RenderHelper::RenderMesh(theAtlasMesh, view * 6, 6);
+	RenderHelper::SetAlphaTest(false);
+	modelStack.PopMatrix();
+}
+
+/********************************************************************************
+ Get the mesh with a quad for each cell of the atlas
+ ********************************************************************************/
+Mesh* CImpostor::GetAtlasMesh(void) const
+{
+	return theAtlasMesh;
+}
+
+/********************************************************************************
+ Get the angle of the camera above the horizon for a pitch view, in degrees
+ ********************************************************************************/
+float CImpostor::GetPitchAngle(const int pitchIndex)
+{
+	return pitchIndex * 40.0f;
+}
+
+/********************************************************************************
+ Constructor
+ ********************************************************************************/
+CImpostorBuilder::CImpostorBuilder(void)
+{
+}
+
+/********************************************************************************
+ Destructor
+ ********************************************************************************/
+CImpostorBuilder::~CImpostorBuilder(void)
+{
+	std::map<std::string, CImpostor*>::iterator it;
+	for (it = impostorMap.begin(); it != impostorMap.end(); ++it)
+	{
+		delete it->second;
+	}
+	impostorMap.clear();
+}
+
+/********************************************************************************
+ Generate an impostor from a mesh in MeshBuilder
+ ********************************************************************************/
+CImpostor* CImpostorBuilder::GenerateImpostor(const std::string& _meshName, const std::string& _sourceMeshName, const float radius)
+{
+	Mesh* theSourceMesh = MeshBuilder::GetInstance()->GetMesh(_sourceMeshName);
+	if (theSourceMesh == nullptr)
+		return nullptr;
+
+	CImpostor* theImpostor = new CImpostor();
+	if (theImpostor->Init(_meshName, theSourceMesh, radius) == false)
+	{
+		delete theImpostor;
+		return nullptr;
+	}
+
+	// Clean up first if there is an existing impostor with the same name
+	RemoveImpostor(_meshName);
+	impostorMap[_meshName] = theImpostor;
+	return theImpostor;
+}
+
+/********************************************************************************
+ Get an impostor
+ ********************************************************************************/
+CImpostor* CImpostorBuilder::GetImpostor(const std::string& _meshName)
+{
+	if (impostorMap.count(_meshName) != 0)
+		return impostorMap[_meshName];
+
+	return nullptr;
+}
+
+/********************************************************************************
+ Remove and delete an impostor
+ ********************************************************************************/
+void CImpostorBuilder::RemoveImpostor(const std::string& _meshName)
+{
+	CImpostor* theImpostor = GetImpostor(_meshName);
+	if (theImpostor != nullptr)
+	{
+		delete theImpostor;
+		impostorMap.erase(_meshName);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Mesh.h"
+#include "SingletonTemplate.h"
+#include <map>
+#include <string>
+
+// A billboard impostor for a mesh.
+// The mesh is pre-rendered from several angles into a texture atlas, and the impostor is drawn
+// as a quad facing the camera, using the atlas cell whose angle is nearest to the camera's.
+class CImpostor
+{
+public:
+	enum
+	{
+		NUM_YAW_VIEWS = 8,		// Views around the mesh
+		NUM_PITCH_VIEWS = 2,	// Views from the side and from above
+		NUM_VIEWS = NUM_YAW_VIEWS * NUM_PITCH_VIEWS,
+		ATLAS_COLUMNS = 4,
+		ATLAS_ROWS = NUM_VIEWS / ATLAS_COLUMNS,
+		CELL_SIZE = 128,		// Size of each view in the atlas, in pixels
+	};
+
+	CImpostor(void);
+	virtual ~CImpostor(void);
+
+	// Render theSourceMesh from all the angles into the atlas. radius is the bounding radius of the mesh
+	bool Init(const std::string& _meshName, Mesh* theSourceMesh, const float radius);
+	// Render the impostor facing the camera. The model stack should have the entity's transformation
+	void Render(void);
+
+	// Get the mesh with a quad for each cell of the atlas
+	Mesh* GetAtlasMesh(void) const;
+	// Get the angle of the camera above the horizon for a pitch view, in degrees
+	static float GetPitchAngle(const int pitchIndex);
+
+protected:
+	Mesh* theAtlasMesh;
+	unsigned atlasTexture;
+	float radius;
+};
+
+// Creates and stores the impostors of the LOD-enabled meshes
+class CImpostorBuilder : public Singleton<CImpostorBuilder>
+{
+	friend Singleton<CImpostorBuilder>;
+public:
+	virtual ~CImpostorBuilder(void);
+
+	// Generate an impostor named _meshName from a mesh in MeshBuilder
+	CImpostor* GenerateImpostor(const std::string& _meshName, const std::string& _sourceMeshName, const float radius);
+	// Get an impostor
+	CImpostor* GetImpostor(const std::string& _meshName);
+	// Remove and delete an impostor
+	void RemoveImpostor(const std::string& _meshName);
+
+protected:
+	CImpostorBuilder(void);
+
+	std::map<std::string, CImpostor*> impostorMap;
+};
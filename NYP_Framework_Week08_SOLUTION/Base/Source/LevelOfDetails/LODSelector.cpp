@@ -0,0 +1,192 @@
+#include "LODSelector.h"
+#include "MyMath.h"
+#include "ThreadPool/ThreadPool.h"
+#include <cmath>
+#include <cfloat>
+
+// Number of objects which each job of the batch processes
+static const int NUM_OF_OBJECTS_PER_JOB = 256;
+
+/********************************************************************************
+ Constructor
+ ********************************************************************************/
+CLODSelector::CLODSelector(void)
+	: pixelsPerUnit(1.0f)
+	, errorBudget(1.0f)
+	, hysteresis(0.2f)
+	, numOfObjects(0)
+{
+}
+
+/********************************************************************************
+ Destructor
+ ********************************************************************************/
+CLODSelector::~CLODSelector(void)
+{
+	theLODs.clear();
+}
+
+/********************************************************************************
+ Initialise the selector
+ ********************************************************************************/
+void CLODSelector::Init(const float fovY, const int screenHeight)
+{
+	pixelsPerUnit = (float)screenHeight / (2.0f * tan(Math::DegreeToRadian(fovY) * 0.5f));
+}
+
+/********************************************************************************
+ Set the maximum screen-space error, in pixels
+ ********************************************************************************/
+void CLODSelector::SetErrorBudget(const float errorBudget)
+{
+	this->errorBudget = errorBudget;
+}
+
+/********************************************************************************
+ Get the maximum screen-space error, in pixels
+ ********************************************************************************/
+float CLODSelector::GetErrorBudget(void) const
+{
+	return errorBudget;
+}
+
+/********************************************************************************
+ Set the hysteresis band
+ ********************************************************************************/
+void CLODSelector::SetHysteresis(const float hysteresis)
+{
+	this->hysteresis = Math::Clamp(hysteresis, 0.0f, 0.9f);
+}
+
+/********************************************************************************
+ Get the hysteresis band
+ ********************************************************************************/
+float CLODSelector::GetHysteresis(void) const
+{
+	return hysteresis;
+}
+
+/********************************************************************************
+ Add an object to this frame's batch
+ ********************************************************************************/
+void CLODSelector::Add(CLevelOfDetails* theLOD, const Vector3& position, const float radius)
+{
+	if ((theLOD == NULL) || (theLOD->GetLODStatus() == false))
+		return;
+
+	theLODs.push_back(theLOD);
+	positionX.push_back(position.x);
+	positionY.push_back(position.y);
+	positionZ.push_back(position.z);
+	// Convert the errors into world units
+	errorMid.push_back(theLOD->GetLODError(CLevelOfDetails::MID_DETAILS) * radius);
+	errorLow.push_back(theLOD->GetLODError(CLevelOfDetails::LOW_DETAILS) * radius);
+	// An object without an impostor can never meet the budget at the impostor level
+	if (theLOD->GetImpostor())
+		errorImpostor.push_back(theLOD->GetLODError(CLevelOfDetails::IMPOSTOR_DETAILS) * radius);
+	else
+		errorImpostor.push_back(FLT_MAX);
+	theDetailLevels.push_back(theLOD->GetDetailLevel());
+}
+
+/********************************************************************************
+ Select the detail levels of all the objects in the batch
+ ********************************************************************************/
+void CLODSelector::Update(const Vector3& theCameraPosition)
+{
+	numOfObjects = (int)theLODs.size();
+
+	int numOfJobs = (numOfObjects + NUM_OF_OBJECTS_PER_JOB - 1) / NUM_OF_OBJECTS_PER_JOB;
+	CThreadPool::GetInstance()->ParallelFor(numOfJobs, [this, &theCameraPosition](const int jobIndex)
+	{
+		int startIndex = jobIndex * NUM_OF_OBJECTS_PER_JOB;
+		SelectDetailLevels(startIndex, Math::Min(startIndex + NUM_OF_OBJECTS_PER_JOB, numOfObjects), theCameraPosition);
+	});
+
+	// Write the results back to the objects
+	for (int i = 0; i < numOfObjects; ++i)
+	{
+		theLODs[i]->SetDetailLevel((CLevelOfDetails::DETAIL_LEVEL)theDetailLevels[i]);
+	}
+
+	theLODs.clear();
+	positionX.clear();
+	positionY.clear();
+	positionZ.clear();
+	errorMid.clear();
+	errorLow.clear();
+	errorImpostor.clear();
+	theDetailLevels.clear();
+}
+
+/********************************************************************************
+ Get the number of objects which were processed in the last Update
+ ********************************************************************************/
+int CLODSelector::GetNumOfObjects(void) const
+{
+	return numOfObjects;
+}
+
+/********************************************************************************
+ Select the detail levels of a range of objects in the batch
+ ********************************************************************************/
+void CLODSelector::SelectDetailLevels(const int startIndex, const int endIndex, const Vector3& theCameraPosition)
+{
+	// Switching to a cheaper level needs the error to be below the lower band,
+	// while switching to a more detailed level needs the error to be above the upper band
+	const float lowerBudget = errorBudget * (1.0f - hysteresis);
+	const float upperBudget = errorBudget * (1.0f + hysteresis);
+
+	for (int i = startIndex; i < endIndex; ++i)
+	{
+		float dx = positionX[i] - theCameraPosition.x;
+		float dy = positionY[i] - theCameraPosition.y;
+		float dz = positionZ[i] - theCameraPosition.z;
+		float distance = Math::Max(sqrt(dx * dx + dy * dy + dz * dz), Math::EPSILON);
+
+		// The screen-space error of each level, in pixels
+		float scaleToPixels = pixelsPerUnit / distance;
+		float pixelErrors[CLevelOfDetails::NUM_DETAIL_LEVEL];
+		pixelErrors[CLevelOfDetails::NO_DETAILS] = 0.0f;
+		pixelErrors[CLevelOfDetails::HIGH_DETAILS] = 0.0f;
+		pixelErrors[CLevelOfDetails::MID_DETAILS] = errorMid[i] * scaleToPixels;
+		pixelErrors[CLevelOfDetails::LOW_DETAILS] = errorLow[i] * scaleToPixels;
+		pixelErrors[CLevelOfDetails::IMPOSTOR_DETAILS] = (errorImpostor[i] == FLT_MAX) ? FLT_MAX : errorImpostor[i] * scaleToPixels;
+
+		// The cheapest level which meets the budget
+		int idealLevel = CLevelOfDetails::HIGH_DETAILS;
+		for (int level = CLevelOfDetails::NUM_DETAIL_LEVEL - 1; level > CLevelOfDetails::HIGH_DETAILS; --level)
+		{
+			if (pixelErrors[level] <= errorBudget)
+			{
+				idealLevel = level;
+				break;
+			}
+		}
+
+		int currentLevel = theDetailLevels[i];
+		if ((currentLevel == CLevelOfDetails::NO_DETAILS) || (currentLevel == idealLevel))
+		{
+			// No previous level to keep, or no change
+			theDetailLevels[i] = idealLevel;
+		}
+		else if (idealLevel > currentLevel)
+		{
+			// Cheaper level. Only switch to the cheapest level whose error is well inside the budget
+			for (int level = idealLevel; level > currentLevel; --level)
+			{
+				if (pixelErrors[level] <= lowerBudget)
+				{
+					theDetailLevels[i] = level;
+					break;
+				}
+			}
+		}
+		else
+		{
+			// More detailed level. Only switch when the current level's error is well over the budget
+			if (pixelErrors[currentLevel] > upperBudget)
+				theDetailLevels[i] = idealLevel;
+		}
+	}
+}
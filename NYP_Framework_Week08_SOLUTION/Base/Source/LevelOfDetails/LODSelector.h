@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Vector3.h"
+#include "SingletonTemplate.h"
+#include "LevelOfDetails.h"
+#include <vector>
+using namespace std;
+
+// Selects the detail level of each object from its projected screen-space error.
+// Objects are added to a batch during the frame, and the whole batch is processed in one pass.
+// The cheapest detail level whose error, projected onto the screen, is within the error budget
+// is chosen. A hysteresis band around the budget stops objects from flickering between levels.
+class CLODSelector : public Singleton<CLODSelector>
+{
+	friend Singleton<CLODSelector>;
+public:
+	// Destructor
+	virtual ~CLODSelector(void);
+
+	// Initialise the selector with the camera's vertical field of view in degrees and the screen height in pixels
+	void Init(const float fovY, const int screenHeight);
+
+	// Set the maximum screen-space error, in pixels
+	void SetErrorBudget(const float errorBudget);
+	// Get the maximum screen-space error, in pixels
+	float GetErrorBudget(void) const;
+	// Set the hysteresis band, as a fraction of the error budget
+	void SetHysteresis(const float hysteresis);
+	// Get the hysteresis band, as a fraction of the error budget
+	float GetHysteresis(void) const;
+
+	// Add an object to this frame's batch. radius is the object's bounding radius in world space
+	void Add(CLevelOfDetails* theLOD, const Vector3& position, const float radius);
+	// Select the detail levels of all the objects in the batch, then clear the batch
+	void Update(const Vector3& theCameraPosition);
+
+	// Get the number of objects which were processed in the last Update
+	int GetNumOfObjects(void) const;
+
+protected:
+	// Constructor
+	CLODSelector(void);
+
+	// Select the detail levels of the objects from startIndex to endIndex-1
+	void SelectDetailLevels(const int startIndex, const int endIndex, const Vector3& theCameraPosition);
+
+	// Number of pixels covered by 1 world unit at a distance of 1 world unit
+	float pixelsPerUnit;
+	float errorBudget;
+	float hysteresis;
+
+	// The batch is stored as a structure of arrays
+	vector<CLevelOfDetails*> theLODs;
+	vector<float> positionX;
+	vector<float> positionY;
+	vector<float> positionZ;
+	vector<float> errorMid;
+	vector<float> errorLow;
+	vector<float> errorImpostor;
+	vector<int> theDetailLevels;
+
+	int numOfObjects;
+};
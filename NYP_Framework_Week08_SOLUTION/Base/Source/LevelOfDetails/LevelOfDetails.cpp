@@ -1,5 +1,9 @@
 #include "LevelOfDetails.h"
+#include "Impostor.h"
 #include "MeshBuilder.h"
+#include "RenderHelper.h"
+
+const float CLevelOfDetails::LOD_FADE_DURATION = 0.25f;
 
 /********************************************************************************
  Constructor
@@ -10,7 +14,15 @@ CLevelOfDetails::CLevelOfDetails()
 	, modelMesh_LowDetails(NULL)
 	, m_bActive(false)
 	, theDetailLevel(HIGH_DETAILS)
+	, theImpostor(NULL)
+	, previousDetailLevel(NO_DETAILS)
+	, fadeProgress(1.0f)
 {
+	LOD_Errors[NO_DETAILS] = 0.0f;
+	LOD_Errors[HIGH_DETAILS] = 0.0f;
+	LOD_Errors[MID_DETAILS] = 0.02f;
+	LOD_Errors[LOW_DETAILS] = 0.08f;
+	LOD_Errors[IMPOSTOR_DETAILS] = 0.25f;
 }
 
 /********************************************************************************
@@ -21,6 +33,8 @@ CLevelOfDetails::~CLevelOfDetails()
 	modelMesh_HighDetails = NULL;
 	modelMesh_MidDetails = NULL;
 	modelMesh_LowDetails = NULL;
+	// Do not delete the impostor here as CImpostorBuilder will take care of them.
+	theImpostor = NULL;
 }
 
 /********************************************************************************
@@ -46,6 +60,20 @@ bool CLevelOfDetails::InitLOD(const std::string& _meshName_High,
 	return true;
 }
 
+/********************************************************************************
+ Initialise the LOD system with the levels generated by MeshBuilder::GenerateOBJLOD
+ ********************************************************************************/
+bool CLevelOfDetails::InitLOD(const std::string& _meshName)
+{
+	// Use the impostor of this mesh, if one was generated
+	SetImpostor(CImpostorBuilder::GetInstance()->GetImpostor(_meshName));
+
+	// Level 0 is the high details mesh, level 1 is the mid details mesh and level 2 is the low details mesh
+	return InitLOD(	MeshBuilder::GetLODMeshName(_meshName, 0),
+					MeshBuilder::GetLODMeshName(_meshName, 1),
+					MeshBuilder::GetLODMeshName(_meshName, 2));
+}
+
 /********************************************************************************
  Destroy the LOD system
  ********************************************************************************/
@@ -143,8 +171,113 @@ bool CLevelOfDetails::SetDetailLevel(const DETAIL_LEVEL theDetailLevel)
 {
 	if ((theDetailLevel >= NO_DETAILS) && (theDetailLevel < NUM_DETAIL_LEVEL))
 	{
+		// Do not switch to an impostor if there is none
+		if ((theDetailLevel == IMPOSTOR_DETAILS) && (theImpostor == NULL))
+			return false;
+
+		// Start a cross-fade if the object switches between two visible detail levels
+		if ((theDetailLevel != this->theDetailLevel) &&
+			(theDetailLevel != NO_DETAILS) && (this->theDetailLevel != NO_DETAILS))
+		{
+			previousDetailLevel = this->theDetailLevel;
+			fadeProgress = 0.0f;
+		}
+		else if (theDetailLevel == NO_DETAILS)
+		{
+			fadeProgress = 1.0f;
+		}
+
 		this->theDetailLevel = theDetailLevel;
 		return true;
 	}
 	return false;
 }
+
+/********************************************************************************
+ Set the geometric error of the mid and low detail meshes
+ ********************************************************************************/
+void CLevelOfDetails::SetLODErrors(const float error_Mid, const float error_Low, const float error_Impostor)
+{
+	LOD_Errors[MID_DETAILS] = error_Mid;
+	LOD_Errors[LOW_DETAILS] = error_Low;
+	LOD_Errors[IMPOSTOR_DETAILS] = error_Impostor;
+}
+
+/********************************************************************************
+ Get the geometric error of a detail level
+ ********************************************************************************/
+float CLevelOfDetails::GetLODError(const DETAIL_LEVEL theDetailLevel) const
+{
+	if ((theDetailLevel >= NO_DETAILS) && (theDetailLevel < NUM_DETAIL_LEVEL))
+		return LOD_Errors[theDetailLevel];
+	return 0.0f;
+}
+
+/********************************************************************************
+ Set the impostor which is drawn at IMPOSTOR_DETAILS
+ ********************************************************************************/
+void CLevelOfDetails::SetImpostor(CImpostor* theImpostor)
+{
+	this->theImpostor = theImpostor;
+}
+
+/********************************************************************************
+ Get the impostor which is drawn at IMPOSTOR_DETAILS
+ ********************************************************************************/
+CImpostor* CLevelOfDetails::GetImpostor(void) const
+{
+	return theImpostor;
+}
+
+/********************************************************************************
+ Update the cross-fade between the previous and current detail levels
+ ********************************************************************************/
+void CLevelOfDetails::UpdateLOD(const double dt)
+{
+	if (fadeProgress < 1.0f)
+	{
+		fadeProgress += (float)dt / LOD_FADE_DURATION;
+		if (fadeProgress > 1.0f)
+			fadeProgress = 1.0f;
+	}
+}
+
+/********************************************************************************
+ Render the current detail level, cross-fading from the previous detail level
+ ********************************************************************************/
+void CLevelOfDetails::RenderLOD(void)
+{
+	if (theDetailLevel == NO_DETAILS)
+		return;
+
+	if ((fadeProgress < 1.0f) && (previousDetailLevel != NO_DETAILS))
+	{
+		// The previous level keeps the pixels which the current level does not draw yet
+		RenderHelper::SetDitherFade(fadeProgress, true);
+		RenderDetailLevel(previousDetailLevel);
+		RenderHelper::SetDitherFade(fadeProgress, false);
+		RenderDetailLevel(theDetailLevel);
+		RenderHelper::DisableDitherFade();
+	}
+	else
+	{
+		RenderDetailLevel(theDetailLevel);
+	}
+}
+
+/********************************************************************************
+ Render a detail level
+ ********************************************************************************/
+void CLevelOfDetails::RenderDetailLevel(const DETAIL_LEVEL theDetailLevel)
+{
+	if (theDetailLevel == IMPOSTOR_DETAILS)
+	{
+		if (theImpostor)
+			theImpostor->Render();
+		return;
+	}
+
+	Mesh* theMesh = GetLODMesh(theDetailLevel);
+	if (theMesh)
+		RenderHelper::RenderMesh(theMesh);
+}
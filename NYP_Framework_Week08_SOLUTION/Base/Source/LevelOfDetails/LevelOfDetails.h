@@ -2,6 +2,8 @@
 #include "Vector3.h"
 #include "Mesh.h"
 
+class CImpostor;
+
 class CLevelOfDetails
 {
 public:
@@ -15,6 +17,7 @@ public:
 		HIGH_DETAILS,
 		MID_DETAILS,
 		LOW_DETAILS,
+		IMPOSTOR_DETAILS,
 		NUM_DETAIL_LEVEL,
 	};
 
@@ -24,6 +27,8 @@ public:
 	bool InitLOD(	const std::string& _meshName_High, 
 					const std::string& _meshName_Mid, 
 					const std::string& _meshName_Low);
+	// Initialise the LOD system with the levels generated by MeshBuilder::GenerateOBJLOD
+	bool InitLOD(const std::string& _meshName);
 	bool DestroyLOD(void);
 
 	void SetLODStatus(const bool bActive);
@@ -35,7 +40,36 @@ public:
 	int GetDetailLevel(void) const;
 	bool SetDetailLevel(const DETAIL_LEVEL theDetailLevel);
 
+	// Set the geometric error of the mid, low and impostor details, as a fraction of the object's bounding radius
+	void SetLODErrors(const float error_Mid, const float error_Low, const float error_Impostor = 0.25f);
+	// Get the geometric error of a detail level, as a fraction of the object's bounding radius
+	float GetLODError(const DETAIL_LEVEL theDetailLevel) const;
+
+	// Set the impostor which is drawn at IMPOSTOR_DETAILS
+	void SetImpostor(CImpostor* theImpostor);
+	// Get the impostor which is drawn at IMPOSTOR_DETAILS
+	CImpostor* GetImpostor(void) const;
+
+	// Update the cross-fade between the previous and current detail levels
+	void UpdateLOD(const double dt);
+	// Render the current detail level, cross-fading from the previous detail level after a switch
+	void RenderLOD(void);
+
+	// Duration of the cross-fade between two detail levels, in seconds
+	static const float LOD_FADE_DURATION;
+
 protected:
+	// Render a detail level
+	void RenderDetailLevel(const DETAIL_LEVEL theDetailLevel);
+
 	bool m_bActive;
 	DETAIL_LEVEL theDetailLevel;
+	// The geometric error of each detail level
+	float LOD_Errors[NUM_DETAIL_LEVEL];
+
+	CImpostor* theImpostor;
+
+	// The detail level before the last switch, and the progress of the cross-fade from 0 to 1
+	DETAIL_LEVEL previousDetailLevel;
+	float fadeProgress;
 };
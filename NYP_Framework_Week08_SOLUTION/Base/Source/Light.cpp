@@ -1,6 +1,6 @@
 #include "Light.h"
 #include "GraphicsManager.h"
-#include "ShaderProgram.h"
+#include <sstream>
 
 Light::Light()
 {
@@ -12,6 +12,9 @@ Light::Light()
 	kQ = 0.f;
 	cosCutoff = cosInner = 0.8f;
 	exponent = 1.f;
+	enabled = true;
+	lifetime = -1.f;
+	fadeSpeed = 0.f;
 }
 
 Light::~Light()
@@ -20,43 +23,67 @@ Light::~Light()
 
 void Light::Update(double _dt)
 {
-	// Does nothing now~
+	if (lifetime < 0.f)
+		return;
+
+	// Fade out, then wait to be removed
+	power = Math::Max(power - fadeSpeed * (float)_dt, 0.f);
+	lifetime = Math::Max(lifetime - (float)_dt, 0.f);
 }
 
-void Light::UpdateUniforms()
+bool Light::IsDone() const
 {
-	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
+	return (lifetime == 0.f);
+}
 
-	if (currProg == nullptr)
-		return;
+bool Light::GetUniformData(LightUniformData& _data) const
+{
+	if (!enabled)
+		return false;
+
+	// A directional light's position is the direction towards it
+	_data.type = type;
+	_data.position[0] = position.x;
+	_data.position[1] = position.y;
+	_data.position[2] = position.z;
+	_data.color[0] = color.r;
+	_data.color[1] = color.g;
+	_data.color[2] = color.b;
+	_data.power = power;
+	_data.kC = kC;
+	_data.kL = kL;
+	_data.kQ = kQ;
+	_data.spotDirection[0] = spotDirection.x;
+	_data.spotDirection[1] = spotDirection.y;
+	_data.spotDirection[2] = spotDirection.z;
+	_data.cosCutoff = cosCutoff;
+	_data.cosInner = cosInner;
+	_data.exponent = exponent;
+	return true;
+}
+
+Light* Create::Flash(	const Vector3& _position,
+						const Color& _color,
+						const float _power,
+						const float _range,
+						const float _lifetime)
+{
+	// Give each flash its own name in the graphics manager
+	static unsigned flashCount = 0;
+	std::ostringstream ss;
+	ss << "flash" << flashCount++;
 
-	Vector3 lightDir(position.x, position.y, position.z);
-
-	if (type == Light::LIGHT_DIRECTIONAL)
-	{
-		Vector3 lightDirection_cameraspace = GraphicsManager::GetInstance()->GetViewMatrix() * lightDir;
-		currProg->UpdateVector3(name + ".position_cameraspace", &lightDirection_cameraspace.x);
-	}
-	else if (type == Light::LIGHT_SPOT)
-	{
-		Vector3 lightPosition_cameraspace = GraphicsManager::GetInstance()->GetViewMatrix() * lightDir;
-		currProg->UpdateVector3(name + ".position_cameraspace", &lightPosition_cameraspace.x);
-		Vector3 spotDirection_cameraspace = GraphicsManager::GetInstance()->GetViewMatrix() * spotDirection;
-		currProg->UpdateVector3(name + ".spotDirection", &spotDirection_cameraspace.x);
-	}
-	else
-	{
-		Vector3 lightPosition_cameraspace = GraphicsManager::GetInstance()->GetViewMatrix() * lightDir;
-		currProg->UpdateVector3(name + ".position_cameraspace", &lightPosition_cameraspace.x);
-	}
-
-	currProg->UpdateInt(name + ".type", type);
-	currProg->UpdateVector3(name + ".color", &color.r);
-	currProg->UpdateFloat(name + ".power", power);
-	currProg->UpdateFloat(name + ".kC", kC);
-	currProg->UpdateFloat(name + ".kL", kL);
-	currProg->UpdateFloat(name + ".kQ", kQ);
-	currProg->UpdateFloat(name + ".cosCutoff", cosCutoff);
-	currProg->UpdateFloat(name + ".cosInner", cosInner);
-	currProg->UpdateFloat(name + ".exponent", exponent);
+	Light* result = new Light();
+	result->type = Light::LIGHT_POINT;
+	result->position.Set(_position.x, _position.y, _position.z);
+	result->color = _color;
+	result->power = _power;
+	result->kC = 1.f;
+	result->kL = 0.f;
+	result->kQ = (_power * 256.f - 1.f) / (_range * _range);
+	result->lifetime = _lifetime;
+	result->fadeSpeed = (_lifetime > 0.f ? _power / _lifetime : _power);
+	result->name = ss.str();
+	GraphicsManager::GetInstance()->AddLight(result->name, result);
+	return result;
 }
\ No newline at end of file
@@ -29,12 +29,30 @@ public:
 	float cosInner;
 	float exponent;
 	std::string name;
+	// A disabled light does not light the scene
+	bool enabled;
+	// Seconds before the light is removed, or a negative number if it is never removed
+	float lifetime;
+	// The power which the light loses each second
+	float fadeSpeed;
 
 	virtual void Update(double _dt);
-	virtual void UpdateUniforms();
+	virtual bool IsDone() const;
+	virtual bool GetUniformData(LightUniformData& _data) const;
 
 	Light();
 	virtual ~Light();
 };
 
+namespace Create
+{
+	// Add a point light which fades out and is removed after its lifetime, such as a muzzle flash
+	// or an explosion. Its attenuation makes its power fall below 1/256 at the range
+	Light* Flash(	const Vector3& _position,
+					const Color& _color,
+					const float _power,
+					const float _range,
+					const float _lifetime);
+};
+
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Minimap.h"
 #include "GraphicsManager.h"
 #include "RenderHelper.h"
+#include "SpriteBatch.h"
 #include "../EntityManager.h"
 #include "GL\glew.h"
 
@@ -153,6 +154,9 @@ void CMinimap::RenderUI()
 		// Push the current transformation into the modelStack
 		modelStack.PushMatrix();
 
+			// Draw the batched sprites before the stencil states change
+			CSpriteBatch::GetInstance()->Flush();
+
 			// Enable stencil mode
 			glEnable(GL_STENCIL_TEST);
 
@@ -166,6 +170,7 @@ void CMinimap::RenderUI()
 
 			if (m_cMinimap_Stencil)
 				RenderHelper::RenderMesh(m_cMinimap_Stencil);
+			CSpriteBatch::GetInstance()->Flush();
 
 			// Switch off stencil function
 			glStencilFunc(GL_EQUAL, 1, 0xFF); // Pass test if stencil value is 1
@@ -192,6 +197,7 @@ void CMinimap::RenderUI()
 			modelStack.PopMatrix();
 
 			// Disable depth test
+			CSpriteBatch::GetInstance()->Flush();
 			glDisable(GL_DEPTH_TEST);
 
 			// Display the Avatar
@@ -199,6 +205,7 @@ void CMinimap::RenderUI()
 				RenderHelper::RenderMesh(m_cMinimap_Avatar);
 
 			// Enable depth test
+			CSpriteBatch::GetInstance()->Flush();
 			glEnable(GL_DEPTH_TEST);
 
 			// Disable stencil test
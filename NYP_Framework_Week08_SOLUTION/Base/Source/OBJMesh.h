@@ -8,7 +8,6 @@ class OBJMesh : public Mesh
 public:
 	OBJMesh(const std::string &meshName);
 	~OBJMesh();
-	void Render();
 
 	unsigned texCoordBuffer;
 	unsigned normalBuffer;
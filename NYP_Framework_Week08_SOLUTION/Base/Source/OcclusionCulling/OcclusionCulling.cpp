@@ -0,0 +1,535 @@
+#include "OcclusionCulling.h"
+#include "LoadOBJ.h"
+#include "ThreadPool/ThreadPool.h"
+#include <emmintrin.h>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// Transform a point by a column-major matrix and return the clip space x, y and w
+static inline void TransformToClip(const Mtx44& theMatrix, const Vector3& thePoint, float& clipX, float& clipY, float& clipW)
+{
+	const float* a = theMatrix.a;
+	clipX = a[0] * thePoint.x + a[4] * thePoint.y + a[8] * thePoint.z + a[12];
+	clipY = a[1] * thePoint.x + a[5] * thePoint.y + a[9] * thePoint.z + a[13];
+	clipW = a[3] * thePoint.x + a[7] * thePoint.y + a[11] * thePoint.z + a[15];
+}
+
+/********************************************************************************
+ Constructor
+ ********************************************************************************/
+COcclusionCulling::COcclusionCulling(void)
+	: m_bActive(true)
+	, nearDist(0.1f)
+	, bHasDepth(false)
+	, numOfTests(0)
+	, numOfOccluded(0)
+{
+	theViewProjection.SetToIdentity();
+}
+
+/********************************************************************************
+ Destructor
+ ********************************************************************************/
+COcclusionCulling::~COcclusionCulling(void)
+{
+	ClearOccluders();
+}
+
+/********************************************************************************
+ Initialise the occlusion culler
+ ********************************************************************************/
+void COcclusionCulling::Init(const float nearDist)
+{
+	this->nearDist = nearDist;
+
+	// Create the Hi-Z mip chain, down to a 1x1 level
+	theHiZ.clear();
+	theHiZWidth.clear();
+	theHiZHeight.clear();
+	int width = BUFFER_WIDTH;
+	int height = BUFFER_HEIGHT;
+	while (true)
+	{
+		theHiZ.push_back(vector<float>(width * height, 0.0f));
+		theHiZWidth.push_back(width);
+		theHiZHeight.push_back(height);
+		if ((width == 1) && (height == 1))
+			break;
+		width = std::max(1, (width + 1) / 2);
+		height = std::max(1, (height + 1) / 2);
+	}
+	bHasDepth = false;
+}
+
+/********************************************************************************
+ Remove all the occluders
+ ********************************************************************************/
+void COcclusionCulling::ClearOccluders(void)
+{
+	theOccluders.clear();
+	bHasDepth = false;
+}
+
+/********************************************************************************
+ Add an occluder mesh with positions and triangle indices in model space
+ ********************************************************************************/
+int COcclusionCulling::AddOccluder(const vector<Vector3>& vertices, const vector<unsigned>& indices, const Mtx44& modelMatrix)
+{
+	if ((vertices.size() == 0) || (indices.size() < 3))
+	{
+		cout << "COcclusionCulling::AddOccluder: The occluder has no triangles" << endl;
+		return -1;
+	}
+
+	COccluder anOccluder;
+	anOccluder.vertices = vertices;
+	anOccluder.indices = indices;
+	anOccluder.modelMatrix = modelMatrix;
+	theOccluders.push_back(anOccluder);
+	return (int)theOccluders.size() - 1;
+}
+
+/********************************************************************************
+ Add an occluder mesh from an OBJ file
+ ********************************************************************************/
+int COcclusionCulling::AddOccluderOBJ(const std::string& file_path, const Mtx44& modelMatrix)
+{
+	std::vector<Position> vertices;
+	std::vector<TexCoord> uvs;
+	std::vector<Vector3> normals;
+	bool success = LoadOBJ(file_path.c_str(), vertices, uvs, normals);
+	if (!success)
+	{
+		cout << "COcclusionCulling::AddOccluderOBJ: Unable to load " << file_path << endl;
+		return -1;
+	}
+
+	std::vector<Vertex> vertex_buffer_data;
+	std::vector<unsigned> index_buffer_data;
+	IndexVBO(vertices, uvs, normals, index_buffer_data, vertex_buffer_data);
+
+	vector<Vector3> thePositions;
+	thePositions.reserve(vertex_buffer_data.size());
+	for (int i = 0; i < (int)vertex_buffer_data.size(); ++i)
+	{
+		const Position& pos = vertex_buffer_data[i].pos;
+		thePositions.push_back(Vector3(pos.x, pos.y, pos.z));
+	}
+	return AddOccluder(thePositions, index_buffer_data, modelMatrix);
+}
+
+/********************************************************************************
+ Add a box shaped occluder, in world space
+ ********************************************************************************/
+int COcclusionCulling::AddOccluderBox(const Vector3& minAABB, const Vector3& maxAABB)
+{
+	vector<Vector3> vertices;
+	vertices.push_back(Vector3(minAABB.x, minAABB.y, minAABB.z));
+	vertices.push_back(Vector3(maxAABB.x, minAABB.y, minAABB.z));
+	vertices.push_back(Vector3(maxAABB.x, maxAABB.y, minAABB.z));
+	vertices.push_back(Vector3(minAABB.x, maxAABB.y, minAABB.z));
+	vertices.push_back(Vector3(minAABB.x, minAABB.y, maxAABB.z));
+	vertices.push_back(Vector3(maxAABB.x, minAABB.y, maxAABB.z));
+	vertices.push_back(Vector3(maxAABB.x, maxAABB.y, maxAABB.z));
+	vertices.push_back(Vector3(minAABB.x, maxAABB.y, maxAABB.z));
+
+	// The rasteriser does not cull back faces, so the winding does not matter
+	const unsigned boxIndices[36] = {	0, 1, 2, 0, 2, 3,	// back
+										4, 5, 6, 4, 6, 7,	// front
+										0, 4, 7, 0, 7, 3,	// left
+										1, 5, 6, 1, 6, 2,	// right
+										3, 2, 6, 3, 6, 7,	// top
+										0, 1, 5, 0, 5, 4 };	// bottom
+	vector<unsigned> indices(boxIndices, boxIndices + 36);
+
+	Mtx44 modelMatrix;
+	modelMatrix.SetToIdentity();
+	return AddOccluder(vertices, indices, modelMatrix);
+}
+
+/********************************************************************************
+ Update the model matrix of an occluder
+ ********************************************************************************/
+void COcclusionCulling::SetOccluderTransform(const int occluderID, const Mtx44& modelMatrix)
+{
+	if ((occluderID < 0) || (occluderID >= (int)theOccluders.size()))
+		return;
+	theOccluders[occluderID].modelMatrix = modelMatrix;
+}
+
+/********************************************************************************
+ Get the number of occluders
+ ********************************************************************************/
+int COcclusionCulling::GetNumOfOccluders(void) const
+{
+	return (int)theOccluders.size();
+}
+
+/********************************************************************************
+ Enable or disable the occlusion culling
+ ********************************************************************************/
+void COcclusionCulling::SetStatus(const bool bActive)
+{
+	m_bActive = bActive;
+}
+
+/********************************************************************************
+ Get the status of the occlusion culling
+ ********************************************************************************/
+bool COcclusionCulling::GetStatus(void) const
+{
+	return m_bActive;
+}
+
+/********************************************************************************
+ Rasterise the occluders and build the Hi-Z buffer
+ ********************************************************************************/
+void COcclusionCulling::Update(const Mtx44& viewProjection)
+{
+	numOfTests = 0;
+	numOfOccluded = 0;
+
+	if ((!m_bActive) || (theHiZ.size() == 0))
+		return;
+
+	theViewProjection = viewProjection;
+
+	// Transform the occluders into screen space and bin the triangles into the tiles
+	theTriangles.clear();
+	for (int i = 0; i < NUM_TILES; ++i)
+		theTileBins[i].clear();
+
+	vector<float> screenX, screenY, screenZ;
+	for (int i = 0; i < (int)theOccluders.size(); ++i)
+	{
+		const COccluder& anOccluder = theOccluders[i];
+		Mtx44 MVP = viewProjection * anOccluder.modelMatrix;
+
+		int numOfVertices = (int)anOccluder.vertices.size();
+		screenX.resize(numOfVertices);
+		screenY.resize(numOfVertices);
+		screenZ.resize(numOfVertices);
+		for (int j = 0; j < numOfVertices; ++j)
+		{
+			float clipX, clipY, clipW;
+			TransformToClip(MVP, anOccluder.vertices[j], clipX, clipY, clipW);
+			if (clipW < nearDist)
+			{
+				// Mark this vertex as behind the near plane
+				screenZ[j] = -1.0f;
+				continue;
+			}
+			float invW = 1.0f / clipW;
+			screenX[j] = (clipX * invW * 0.5f + 0.5f) * BUFFER_WIDTH;
+			screenY[j] = (0.5f - clipY * invW * 0.5f) * BUFFER_HEIGHT;
+			screenZ[j] = invW;
+		}
+
+		for (int j = 0; j + 2 < (int)anOccluder.indices.size(); j += 3)
+		{
+			unsigned index[3] = { anOccluder.indices[j], anOccluder.indices[j + 1], anOccluder.indices[j + 2] };
+			if ((index[0] >= (unsigned)numOfVertices) || (index[1] >= (unsigned)numOfVertices) || (index[2] >= (unsigned)numOfVertices))
+				continue;
+
+			// Skip triangles which cross the near plane. This only makes the occluder smaller,
+			// so objects are never wrongly culled
+			if ((screenZ[index[0]] < 0.0f) || (screenZ[index[1]] < 0.0f) || (screenZ[index[2]] < 0.0f))
+				continue;
+
+			CScreenTriangle aTriangle;
+			for (int k = 0; k < 3; ++k)
+			{
+				aTriangle.x[k] = screenX[index[k]];
+				aTriangle.y[k] = screenY[index[k]];
+				aTriangle.z[k] = screenZ[index[k]];
+			}
+
+			// Make the triangle counter-clockwise so that the edge functions are positive inside it
+			float area = (aTriangle.x[1] - aTriangle.x[0]) * (aTriangle.y[2] - aTriangle.y[0]) -
+						 (aTriangle.y[1] - aTriangle.y[0]) * (aTriangle.x[2] - aTriangle.x[0]);
+			if (fabs(area) < 0.0001f)
+				continue;
+			if (area < 0.0f)
+			{
+				std::swap(aTriangle.x[1], aTriangle.x[2]);
+				std::swap(aTriangle.y[1], aTriangle.y[2]);
+				std::swap(aTriangle.z[1], aTriangle.z[2]);
+			}
+
+			// Find the tiles which the bounding rectangle of the triangle touches
+			float minX = std::min(aTriangle.x[0], std::min(aTriangle.x[1], aTriangle.x[2]));
+			float maxX = std::max(aTriangle.x[0], std::max(aTriangle.x[1], aTriangle.x[2]));
+			float minY = std::min(aTriangle.y[0], std::min(aTriangle.y[1], aTriangle.y[2]));
+			float maxY = std::max(aTriangle.y[0], std::max(aTriangle.y[1], aTriangle.y[2]));
+			if ((maxX < 0.0f) || (maxY < 0.0f) || (minX >= BUFFER_WIDTH) || (minY >= BUFFER_HEIGHT))
+				continue;
+
+			int minTileX = std::max(0, (int)minX / TILE_WIDTH);
+			int maxTileX = std::min(NUM_TILES_X - 1, (int)maxX / TILE_WIDTH);
+			int minTileY = std::max(0, (int)minY / TILE_HEIGHT);
+			int maxTileY = std::min(NUM_TILES_Y - 1, (int)maxY / TILE_HEIGHT);
+
+			int triangleIndex = (int)theTriangles.size();
+			theTriangles.push_back(aTriangle);
+			for (int tileY = minTileY; tileY <= maxTileY; ++tileY)
+			{
+				for (int tileX = minTileX; tileX <= maxTileX; ++tileX)
+				{
+					theTileBins[tileY * NUM_TILES_X + tileX].push_back(triangleIndex);
+				}
+			}
+		}
+	}
+
+	// Rasterise the tiles in parallel. Each tile only writes to its own pixels
+	CThreadPool::GetInstance()->ParallelFor(NUM_TILES, [this](const int tileIndex) { RasteriseTile(tileIndex); });
+
+	BuildHiZ();
+	bHasDepth = true;
+}
+
+/********************************************************************************
+ Rasterise the triangles binned to a tile
+ ********************************************************************************/
+void COcclusionCulling::RasteriseTile(const int tileIndex)
+{
+	int minX = (tileIndex % NUM_TILES_X) * TILE_WIDTH;
+	int minY = (tileIndex / NUM_TILES_X) * TILE_HEIGHT;
+	int maxX = minX + TILE_WIDTH;
+	int maxY = minY + TILE_HEIGHT;
+
+	// Clear this tile to the far plane
+	vector<float>& theDepth = theHiZ[0];
+	for (int y = minY; y < maxY; ++y)
+	{
+		std::fill(theDepth.begin() + y * BUFFER_WIDTH + minX, theDepth.begin() + y * BUFFER_WIDTH + maxX, 0.0f);
+	}
+
+	const vector<int>& theBin = theTileBins[tileIndex];
+	for (int i = 0; i < (int)theBin.size(); ++i)
+	{
+		RasteriseTriangle(theTriangles[theBin[i]], minX, minY, maxX, maxY);
+	}
+}
+
+/********************************************************************************
+ Rasterise one triangle, 4 pixels at a time, keeping the nearest depth
+ ********************************************************************************/
+void COcclusionCulling::RasteriseTriangle(const CScreenTriangle& theTriangle, const int minX, const int minY, const int maxX, const int maxY)
+{
+	const float* x = theTriangle.x;
+	const float* y = theTriangle.y;
+	const float* z = theTriangle.z;
+
+	// Clip the bounding rectangle of the triangle to the tile. startX is aligned to 4 pixels
+	int startX = std::max(minX, (int)std::min(x[0], std::min(x[1], x[2])));
+	int endX = std::min(maxX, (int)std::max(x[0], std::max(x[1], x[2])) + 1);
+	int startY = std::max(minY, (int)std::min(y[0], std::min(y[1], y[2])));
+	int endY = std::min(maxY, (int)std::max(y[0], std::max(y[1], y[2])) + 1);
+	startX = minX + ((startX - minX) & ~3);
+	if ((startX >= endX) || (startY >= endY))
+		return;
+
+	// Edge functions E(px, py) = A * px + B * py + C for the edge opposite each vertex
+	float A[3], B[3], C[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+		A[i] = y[j] - y[k];
+		B[i] = x[k] - x[j];
+		C[i] = x[j] * y[k] - x[k] * y[j];
+	}
+
+	// 1/w is linear in screen space, so it can be interpolated with the edge functions
+	float area = C[0] + C[1] + C[2];
+	float invArea = 1.0f / area;
+	float zA = (A[0] * z[0] + A[1] * z[1] + A[2] * z[2]) * invArea;
+	float zB = (B[0] * z[0] + B[1] * z[1] + B[2] * z[2]) * invArea;
+	float zC = (C[0] * z[0] + C[1] * z[1] + C[2] * z[2]) * invArea;
+
+	const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	__m128 edgeA[3];
+	for (int i = 0; i < 3; ++i)
+		edgeA[i] = _mm_set1_ps(A[i]);
+	__m128 depthA = _mm_set1_ps(zA);
+
+	float* theDepth = &theHiZ[0][0];
+	for (int py = startY; py < endY; ++py)
+	{
+		float centreY = py + 0.5f;
+		__m128 edgeRow[3];
+		for (int i = 0; i < 3; ++i)
+			edgeRow[i] = _mm_set1_ps(B[i] * centreY + C[i]);
+		__m128 depthRow = _mm_set1_ps(zB * centreY + zC);
+
+		float* theRow = theDepth + py * BUFFER_WIDTH;
+		for (int px = startX; px < endX; px += 4)
+		{
+			__m128 centreX = _mm_add_ps(_mm_set1_ps((float)px), pixelOffsets);
+
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA[0], centreX), edgeRow[0]);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA[1], centreX), edgeRow[1]);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA[2], centreX), edgeRow[2]);
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+			if (_mm_movemask_ps(inside) == 0)
+				continue;
+
+			__m128 newDepth = _mm_add_ps(_mm_mul_ps(depthA, centreX), depthRow);
+			__m128 oldDepth = _mm_loadu_ps(theRow + px);
+			__m128 nearest = _mm_max_ps(oldDepth, newDepth);
+			_mm_storeu_ps(theRow + px, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, oldDepth)));
+		}
+	}
+}
+
+/********************************************************************************
+ Build the Hi-Z mip chain. Each texel keeps the farthest depth of the 2x2 texels below it
+ ********************************************************************************/
+void COcclusionCulling::BuildHiZ(void)
+{
+	for (int level = 1; level < (int)theHiZ.size(); ++level)
+	{
+		const vector<float>& theSource = theHiZ[level - 1];
+		int sourceWidth = theHiZWidth[level - 1];
+		int sourceHeight = theHiZHeight[level - 1];
+		vector<float>& theDest = theHiZ[level];
+		int destWidth = theHiZWidth[level];
+		int destHeight = theHiZHeight[level];
+
+		for (int y = 0; y < destHeight; ++y)
+		{
+			int y0 = std::min(y * 2, sourceHeight - 1);
+			int y1 = std::min(y * 2 + 1, sourceHeight - 1);
+			for (int x = 0; x < destWidth; ++x)
+			{
+				int x0 = std::min(x * 2, sourceWidth - 1);
+				int x1 = std::min(x * 2 + 1, sourceWidth - 1);
+				theDest[y * destWidth + x] = std::min(	std::min(theSource[y0 * sourceWidth + x0], theSource[y0 * sourceWidth + x1]),
+														std::min(theSource[y1 * sourceWidth + x0], theSource[y1 * sourceWidth + x1]));
+			}
+		}
+	}
+}
+
+/********************************************************************************
+ Check if an AABB in world space may be visible
+ ********************************************************************************/
+bool COcclusionCulling::IsBoxVisible(const Vector3& minAABB, const Vector3& maxAABB) const
+{
+	if ((!m_bActive) || (!bHasDepth) || (theOccluders.size() == 0))
+		return true;
+	return TestBox(theViewProjection, minAABB, maxAABB);
+}
+
+/********************************************************************************
+ Check if an entity's AABB, which is relative to its position, may be visible
+ ********************************************************************************/
+bool COcclusionCulling::IsBoxVisible(const Vector3& position, const Vector3& minAABB, const Vector3& maxAABB) const
+{
+	return IsBoxVisible(position + minAABB, position + maxAABB);
+}
+
+/********************************************************************************
+ Check if an AABB in model space, transformed by a model matrix, may be visible
+ ********************************************************************************/
+bool COcclusionCulling::IsBoxVisible(const Mtx44& modelMatrix, const Vector3& minAABB, const Vector3& maxAABB) const
+{
+	if ((!m_bActive) || (!bHasDepth) || (theOccluders.size() == 0))
+		return true;
+	return TestBox(theViewProjection * modelMatrix, minAABB, maxAABB);
+}
+
+/********************************************************************************
+ Test a box against the Hi-Z buffer. Returns false only if it is fully occluded
+ ********************************************************************************/
+bool COcclusionCulling::TestBox(const Mtx44& MVP, const Vector3& minAABB, const Vector3& maxAABB) const
+{
+	numOfTests++;
+
+	// Project the 8 corners of the box and find its screen rectangle and nearest depth
+	float minX = (float)BUFFER_WIDTH, maxX = 0.0f;
+	float minY = (float)BUFFER_HEIGHT, maxY = 0.0f;
+	float maxDepth = 0.0f;
+	for (int i = 0; i < 8; ++i)
+	{
+		Vector3 theCorner(	(i & 1) ? maxAABB.x : minAABB.x,
+							(i & 2) ? maxAABB.y : minAABB.y,
+							(i & 4) ? maxAABB.z : minAABB.z);
+		float clipX, clipY, clipW;
+		TransformToClip(MVP, theCorner, clipX, clipY, clipW);
+
+		// The box crosses the near plane, so it is too close to be occluded
+		if (clipW <= nearDist)
+			return true;
+
+		float invW = 1.0f / clipW;
+		float screenX = (clipX * invW * 0.5f + 0.5f) * BUFFER_WIDTH;
+		float screenY = (0.5f - clipY * invW * 0.5f) * BUFFER_HEIGHT;
+		minX = std::min(minX, screenX);
+		maxX = std::max(maxX, screenX);
+		minY = std::min(minY, screenY);
+		maxY = std::max(maxY, screenY);
+		maxDepth = std::max(maxDepth, invW);
+	}
+
+	// Leave boxes which are outside of the screen to the frustum culling
+	if ((maxX < 0.0f) || (maxY < 0.0f) || (minX >= BUFFER_WIDTH) || (minY >= BUFFER_HEIGHT))
+		return true;
+	int x0 = std::max(0, (int)minX);
+	int x1 = std::min(BUFFER_WIDTH - 1, (int)maxX);
+	int y0 = std::max(0, (int)minY);
+	int y1 = std::min(BUFFER_HEIGHT - 1, (int)maxY);
+
+	// Choose the mip level where the rectangle covers about 4x4 texels
+	int level = 0;
+	while ((level + 1 < (int)theHiZ.size()) && (((x1 - x0) >> level) > 4 || ((y1 - y0) >> level) > 4))
+		level++;
+
+	const vector<float>& theLevel = theHiZ[level];
+	int levelWidth = theHiZWidth[level];
+	for (int y = y0 >> level; y <= (y1 >> level); ++y)
+	{
+		for (int x = x0 >> level; x <= (x1 >> level); ++x)
+		{
+			// The farthest occluder depth at this texel is behind the nearest point of the box
+			if (theLevel[y * levelWidth + x] <= maxDepth)
+				return true;
+		}
+	}
+
+	numOfOccluded++;
+	return false;
+}
+
+/********************************************************************************
+ Get the number of tests since the last Update
+ ********************************************************************************/
+int COcclusionCulling::GetNumOfTests(void) const
+{
+	return numOfTests.load();
+}
+
+/********************************************************************************
+ Get the number of occluded results since the last Update
+ ********************************************************************************/
+int COcclusionCulling::GetNumOfOccluded(void) const
+{
+	return numOfOccluded.load();
+}
+
+/********************************************************************************
+ PrintSelf
+ ********************************************************************************/
+void COcclusionCulling::PrintSelf(void) const
+{
+	cout << "******* Start of COcclusionCulling::PrintSelf() **********************************" << endl;
+	cout << "Status\t\t:\t" << (m_bActive ? "Active" : "Inactive") << endl;
+	cout << "Buffer size\t:\t" << BUFFER_WIDTH << " x " << BUFFER_HEIGHT << " in " << NUM_TILES << " tiles" << endl;
+	cout << "Occluders\t:\t" << theOccluders.size() << " (" << theTriangles.size() << " triangles on screen)" << endl;
+	cout << "Occluded\t:\t" << numOfOccluded.load() << " / " << numOfTests.load() << endl;
+	cout << "******* End of COcclusionCulling::PrintSelf() ************************************" << endl;
+}
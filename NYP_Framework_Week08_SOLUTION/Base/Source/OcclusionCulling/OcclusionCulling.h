@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Vector3.h"
+#include "Mtx44.h"
+#include "SingletonTemplate.h"
+#include <vector>
+#include <string>
+#include <atomic>
+using namespace std;
+
+// A software rasterised occlusion culler.
+// The designated occluders are rasterised into a low resolution depth buffer on the CPU,
+// and a hierarchical-Z (Hi-Z) mip chain is built from it. Bounding boxes which passed the
+// frustum culling can then be tested against the Hi-Z buffer before they are rendered.
+// The depth buffer stores 1/w, so a larger value is nearer to the camera and 0 is the far plane.
+class COcclusionCulling : public Singleton<COcclusionCulling>
+{
+	friend Singleton<COcclusionCulling>;
+public:
+	// Size of the depth buffer. TILE_WIDTH must be a multiple of 4 for the SIMD rasteriser
+	enum
+	{
+		BUFFER_WIDTH = 256,
+		BUFFER_HEIGHT = 192,
+		TILE_WIDTH = 64,
+		TILE_HEIGHT = 48,
+		NUM_TILES_X = BUFFER_WIDTH / TILE_WIDTH,
+		NUM_TILES_Y = BUFFER_HEIGHT / TILE_HEIGHT,
+		NUM_TILES = NUM_TILES_X * NUM_TILES_Y,
+	};
+
+	// Destructor
+	virtual ~COcclusionCulling(void);
+
+	// Initialise the occlusion culler. nearDist is the near plane used by the projection matrix
+	void Init(const float nearDist);
+	// Remove all the occluders
+	void ClearOccluders(void);
+
+	// Add an occluder mesh with positions and triangle indices in model space
+	int AddOccluder(const vector<Vector3>& vertices, const vector<unsigned>& indices, const Mtx44& modelMatrix);
+	// Add an occluder mesh from an OBJ file
+	int AddOccluderOBJ(const std::string& file_path, const Mtx44& modelMatrix);
+	// Add a box shaped occluder, in world space
+	int AddOccluderBox(const Vector3& minAABB, const Vector3& maxAABB);
+	// Update the model matrix of an occluder
+	void SetOccluderTransform(const int occluderID, const Mtx44& modelMatrix);
+	// Get the number of occluders
+	int GetNumOfOccluders(void) const;
+
+	// Enable or disable the occlusion culling. When disabled, all tests return visible
+	void SetStatus(const bool bActive);
+	// Get the status of the occlusion culling
+	bool GetStatus(void) const;
+
+	// Rasterise the occluders using this frame's view-projection matrix and build the Hi-Z buffer
+	void Update(const Mtx44& viewProjection);
+
+	// Check if an AABB in world space may be visible. Returns false only if it is fully occluded
+	bool IsBoxVisible(const Vector3& minAABB, const Vector3& maxAABB) const;
+	// Check if an entity's AABB, which is relative to its position, may be visible
+	bool IsBoxVisible(const Vector3& position, const Vector3& minAABB, const Vector3& maxAABB) const;
+	// Check if an AABB in model space, transformed by a model matrix, may be visible
+	bool IsBoxVisible(const Mtx44& modelMatrix, const Vector3& minAABB, const Vector3& maxAABB) const;
+
+	// Get the number of tests and occluded results since the last Update. For debugging
+	int GetNumOfTests(void) const;
+	int GetNumOfOccluded(void) const;
+
+	// PrintSelf for debug purposes
+	void PrintSelf(void) const;
+
+protected:
+	// Constructor
+	COcclusionCulling(void);
+
+	// An occluder mesh
+	struct COccluder
+	{
+		vector<Vector3> vertices;
+		vector<unsigned> indices;
+		Mtx44 modelMatrix;
+	};
+
+	// A triangle in screen space. x and y are in pixels and z is 1/w
+	struct CScreenTriangle
+	{
+		float x[3], y[3], z[3];
+	};
+
+	// Rasterise the triangles binned to a tile
+	void RasteriseTile(const int tileIndex);
+	// Rasterise one triangle, clipped to a rectangle of the depth buffer
+	void RasteriseTriangle(const CScreenTriangle& theTriangle, const int minX, const int minY, const int maxX, const int maxY);
+	// Build the Hi-Z mip chain from the depth buffer
+	void BuildHiZ(void);
+	// Project a box with the MVP matrix and test it against the Hi-Z buffer
+	bool TestBox(const Mtx44& MVP, const Vector3& minAABB, const Vector3& maxAABB) const;
+
+	bool m_bActive;
+	float nearDist;
+	// True if the depth buffer has been rasterised at least once
+	bool bHasDepth;
+
+	vector<COccluder> theOccluders;
+
+	// The triangles of this frame, and the list of triangles for each tile
+	vector<CScreenTriangle> theTriangles;
+	vector<int> theTileBins[NUM_TILES];
+
+	// The Hi-Z mip chain. Level 0 is the depth buffer itself
+	vector< vector<float> > theHiZ;
+	vector<int> theHiZWidth;
+	vector<int> theHiZHeight;
+
+	// The view-projection matrix which the depth buffer was rasterised with
+	Mtx44 theViewProjection;
+
+	// Statistics. The tests may run on several threads at once, such as when CRenderQueue records in parallel
+	mutable std::atomic<int> numOfTests;
+	mutable std::atomic<int> numOfOccluded;
+};
@@ -9,6 +9,7 @@
 #include "MyMath.h"
 #include "../SpatialPartition/SpatialPartition.h"
 #include "../SceneGraph/SceneGraph.h"
+#include "../Light.h"
 
 #include <iostream>
 using namespace std;
@@ -49,6 +50,9 @@ void CGrenade::Update(double dt)
 		SetStatus(false);
 		SetIsDone(true);	// This method informs EntityManager to remove this instance
 
+		// Light up the surroundings of the explosion
+		Create::Flash(position, Color(1.0f, 0.5f, 0.1f), 8.0f, 60.0f, 0.5f);
+
 		// Check the SpatialPartition to destroy nearby objects
 		vector<EntityBase*> ExportList = CSpatialPartition::GetInstance()->GetObjects(position, 20.0f);
 		for (int i = 0; i < (int)ExportList.size(); ++i)
@@ -109,9 +109,9 @@ void CLaser::Render(void)
 			modelStack.Rotate(180 / Math::PI * angle_y, 0.0f, 0.0f, 1.0f);
 			modelStack.PushMatrix();
 					modelStack.Scale(scale.x * m_fLength, scale.y, scale.z);
-					glLineWidth(10.0f);
+					RenderHelper::SetLineWidth(10.0f);
 					RenderHelper::RenderMesh(modelMesh);
-					glLineWidth(1.0f);
+					RenderHelper::SetLineWidth(1.0f);
 				modelStack.PopMatrix();
 			modelStack.PopMatrix();
 		modelStack.PopMatrix();
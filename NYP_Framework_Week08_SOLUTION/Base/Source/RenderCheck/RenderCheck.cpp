@@ -0,0 +1,161 @@
+#include "RenderCheck.h"
+#include "../GenericEntity.h"
+#include "../SpatialPartition/SpatialPartition.h"
+#include "../SpatialPartition/StaticBatch.h"
+#include "../FrustumCulling/FrustumCulling.h"
+#include "GraphicsDevice/RecordingDevice.h"
+#include "GraphicsManager.h"
+#include "MeshBuilder.h"
+#include "RenderHelper.h"
+#include "SpriteBatch.h"
+#include "StreamBuffer.h"
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/********************************************************************************
+ Constructor
+ ********************************************************************************/
+CRenderCheck::CRenderCheck(void)
+{
+}
+
+/********************************************************************************
+ Destructor
+ ********************************************************************************/
+CRenderCheck::~CRenderCheck(void)
+{
+}
+
+/********************************************************************************
+ Run the checks on a recording device, then go back to OpenGL
+ ********************************************************************************/
+bool CRenderCheck::Run(void)
+{
+	CRecordingDevice theDevice;
+	theDevice.SetLogging(false);
+	CGraphicsDevice::SetDevice(&theDevice);
+
+	GraphicsManager::GetInstance()->Init();
+	CStreamBuffer::GetInstance()->Init();
+	if (GraphicsManager::GetInstance()->LoadShader("default", "Shader//comg.vertexshader", "Shader//comg.fragmentshader") == nullptr)
+	{
+		cout << "CRenderCheck::Run: Unable to load the default shader" << endl;
+		CGraphicsDevice::SetDevice(nullptr);
+		return false;
+	}
+	GraphicsManager::GetInstance()->SetActiveShader("default");
+
+	// The same meshes as SceneText
+	MeshBuilder::GetInstance()->GenerateAxes("reference");
+	MeshBuilder::GetInstance()->GenerateRing("ring", Color(1, 0, 1), 36, 1, 0.5f);
+	MeshBuilder::GetInstance()->GenerateSphere("lightball", Color(1, 1, 1), 18, 36, 1.f);
+	MeshBuilder::GetInstance()->GenerateCube("cube", Color(1.0f, 1.0f, 0.0f), 1.0f);
+	MeshBuilder::GetInstance()->GenerateQuad("quad", Color(1, 1, 1), 1.f);
+
+	bool bPassed = CheckStaticBatch(theDevice);
+	bPassed = CheckSpriteLayer(theDevice) && bPassed;
+
+	// Delete everything made on the recording device while it is still current
+	CStaticBatch::GetInstance()->Destroy();
+	CSpriteBatch::GetInstance()->Destroy();
+	CStreamBuffer::GetInstance()->Destroy();
+	MeshBuilder::GetInstance()->RemoveMesh("reference");
+	MeshBuilder::GetInstance()->RemoveMesh("ring");
+	MeshBuilder::GetInstance()->RemoveMesh("lightball");
+	MeshBuilder::GetInstance()->RemoveMesh("cube");
+	MeshBuilder::GetInstance()->RemoveMesh("quad");
+	GraphicsManager::GetInstance()->Destroy();
+	CGraphicsDevice::SetDevice(nullptr);
+
+	if (bPassed)
+		cout << "CRenderCheck::Run: All the checks passed" << endl;
+	return bPassed;
+}
+
+/********************************************************************************
+ Merge the entities which SceneText adds to CStaticBatch, and render them from above.
+ The sphere and the ring are triangle strips, so they are left out. The walls and the axes
+ fall into 3 cells of the Spatial Partition, which makes 3 chunks of triangles and 1 of lines
+ ********************************************************************************/
+bool CRenderCheck::CheckStaticBatch(CRecordingDevice& theDevice)
+{
+	CSpatialPartition::GetInstance()->Init(100, 100, 10, 10.2);
+
+	vector<GenericEntity*> theEntities;
+	theEntities.push_back(Create::Entity("reference", Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f), false));
+	theEntities.push_back(Create::Entity("lightball", Vector3(0.0f, 20.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f), false));
+	theEntities.push_back(Create::Entity("ring", Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f), false));
+	Vector3 wallPositions[4] = {	Vector3(0.0f, 0.0f, -60.0f), Vector3(0.0f, 0.0f, 60.0f),
+									Vector3(-60.0f, 0.0f, 0.0f), Vector3(60.0f, 0.0f, 0.0f) };
+	Vector3 wallScales[4] = {	Vector3(80.0f, 20.0f, 2.0f), Vector3(80.0f, 20.0f, 2.0f),
+								Vector3(2.0f, 20.0f, 80.0f), Vector3(2.0f, 20.0f, 80.0f) };
+	for (int i = 0; i < 4; ++i)
+		theEntities.push_back(Create::Entity("cube", wallPositions[i], wallScales[i], false));
+
+	int numOfStatic = 0;
+	for (unsigned i = 0; i < theEntities.size(); ++i)
+		CStaticBatch::GetInstance()->Add(theEntities[i]);
+	CStaticBatch::GetInstance()->Build();
+	for (unsigned i = 0; i < theEntities.size(); ++i)
+	{
+		if (theEntities[i]->IsStatic())
+			numOfStatic++;
+	}
+
+	// Look down from SceneText's second camera, which sees every chunk
+	CFrustumCulling::GetInstance()->Init(45.0f, 4.0f / 3.0f, 0.1f, 10000.0f);
+	CFrustumCulling::GetInstance()->Update(Vector3(0, 700, 10), Vector3(0, 0, 0), Vector3(0, 1, 0));
+
+	theDevice.Clear();
+	CStaticBatch::GetInstance()->Render();
+
+	bool bPassed = Check("Static entities", numOfStatic, 5);
+	bPassed = Check("Static batch chunks", CStaticBatch::GetInstance()->GetNumOfChunks(), 4) && bPassed;
+	bPassed = Check("Static batch DrawElements", theDevice.GetNumOfCalls("DrawElements"), 4) && bPassed;
+
+	CStaticBatch::GetInstance()->Clear();
+	for (unsigned i = 0; i < theEntities.size(); ++i)
+		delete theEntities[i];
+	CSpatialPartition::GetInstance()->Destroy();
+	return bPassed;
+}
+
+/********************************************************************************
+ Render a layer of 10 x 10 tiles which share a texture, which is a single draw call
+ ********************************************************************************/
+bool CRenderCheck::CheckSpriteLayer(CRecordingDevice& theDevice)
+{
+	theDevice.Clear();
+
+	MS& modelStack = GraphicsManager::GetInstance()->GetModelStack();
+	CSpriteBatch::GetInstance()->Begin();
+	for (int x = 0; x < 10; ++x)
+	{
+		for (int y = 0; y < 10; ++y)
+		{
+			modelStack.PushMatrix();
+			modelStack.Translate((float)x, (float)y, 0.0f);
+			RenderHelper::RenderMesh(MeshBuilder::GetInstance()->GetMesh("quad"));
+			modelStack.PopMatrix();
+		}
+	}
+	CSpriteBatch::GetInstance()->End();
+
+	bool bPassed = Check("Sprites", CSpriteBatch::GetInstance()->GetNumOfSprites(), 100);
+	bPassed = Check("Sprite layer DrawElements", theDevice.GetNumOfCalls("DrawElements"), 1) && bPassed;
+	return bPassed;
+}
+
+/********************************************************************************
+ Compare a count against the expected count, and print it if they differ
+ ********************************************************************************/
+bool CRenderCheck::Check(const std::string& _name, const int _count, const int _expected)
+{
+	if (_count == _expected)
+		return true;
+
+	cout << "CRenderCheck: " << _name << " is " << _count << " instead of " << _expected << endl;
+	return false;
+}
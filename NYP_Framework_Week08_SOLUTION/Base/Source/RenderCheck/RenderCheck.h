@@ -0,0 +1,32 @@
+#ifndef RENDER_CHECK_H
+#define RENDER_CHECK_H
+
+#include "SingletonTemplate.h"
+#include <string>
+
+class CRecordingDevice;
+
+// Renders SceneText's static entities and a layer of sprites through CRecordingDevice, without an OpenGL
+// context, and checks that they take as many draw calls as they do on OpenGL.
+// Run the program with "-checkrender" to run it instead of the game
+class CRenderCheck : public Singleton<CRenderCheck>
+{
+	friend Singleton<CRenderCheck>;
+public:
+	virtual ~CRenderCheck(void);
+
+	// Run the checks, and print the ones which fail. Return true if they all pass
+	bool Run(void);
+
+protected:
+	CRenderCheck(void);
+
+	// Merge the walls and the reference axes with CStaticBatch, and render the chunks
+	bool CheckStaticBatch(CRecordingDevice& theDevice);
+	// Render a layer of tiles with CSpriteBatch
+	bool CheckSpriteLayer(CRecordingDevice& theDevice);
+	// Compare a count against the expected count, and print it if they differ
+	bool Check(const std::string& _name, const int _count, const int _expected);
+};
+
+#endif // RENDER_CHECK_H
@@ -6,6 +6,9 @@
 #include "../Application.h"
 #include "Utility.h"
 #include "LoadTGA.h"
+#include "FontData.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
 #include <sstream>
 #include "KeyboardController.h"
 #include "MouseController.h"
@@ -44,6 +47,7 @@ CScene2D::CScene2D()
 	, Scene2D_RearStructure(NULL)
 	, theEnemy(NULL)
 	, Scene2D_Hero_Animated(NULL)
+	, theAtlas(NULL)
 {
 }
 
@@ -61,6 +65,7 @@ CScene2D::CScene2D(SceneManager* _sceneMgr)
 	, Scene2D_RearStructure(NULL)
 	, theEnemy(NULL)
 	, Scene2D_Hero_Animated(NULL)
+	, theAtlas(NULL)
 {
 	_sceneMgr->AddScene("Scene2D", this);
 }
@@ -126,6 +131,12 @@ CScene2D::~CScene2D()
 		Scene2D_Hero_Animated = NULL;
 	}
 
+	if (theAtlas)
+	{
+		delete theAtlas;
+		theAtlas = NULL;
+	}
+
 	if (thePlayerInfo->DropInstance() == false)
 	{
 		cout << "CScene2D: Unable to drop CPlayerInfo2D class" << endl;
@@ -200,41 +211,31 @@ void CScene2D::Init()
 	MeshBuilder::GetInstance()->GetMesh("quad")->textureID = LoadTGA("Image//calibri.tga");
 	MeshBuilder::GetInstance()->GenerateText("text", 16, 16);
 	MeshBuilder::GetInstance()->GetMesh("text")->textureID = LoadTGA("Image//calibri.tga");
+	CFontData::GetInstance()->Load("Image//FontData.csv");
 	MeshBuilder::GetInstance()->GetMesh("text")->material.kAmbient.Set(1, 0, 0);
 
 	// Load background image
 	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_BKGROUND", Color(1, 1, 1), 1.f);
 	MeshBuilder::GetInstance()->GetMesh("SCENE2D_BKGROUND")->textureID = LoadTGA("Image//Scene2D_Background.tga");
 
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_GROUND", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_GROUND")->textureID = LoadTGA("Image//Scene2D_Tile_Ground.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_HERO", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_HERO")->textureID = LoadTGA("Image//Scene2D_Tile_Hero.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_TREE", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_TREE")->textureID = LoadTGA("Image//Scene2D_Tile_Tree.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_REARSTRUCTURE", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_REARSTRUCTURE")->textureID = 
-		LoadTGA("Image//Scene2D_RearStructure.tga");
-
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_HERO_RIGHT_0", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_HERO_RIGHT_0")->textureID = LoadTGA("Image//Scene2D_Tile_Hero_Right_0.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_HERO_RIGHT_1", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_HERO_RIGHT_1")->textureID = LoadTGA("Image//Scene2D_Tile_Hero_Right_1.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_HERO_RIGHT_2", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_HERO_RIGHT_2")->textureID = LoadTGA("Image//Scene2D_Tile_Hero_Right_2.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_HERO_RIGHT_3", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_HERO_RIGHT_3")->textureID = LoadTGA("Image//Scene2D_Tile_Hero_Right_3.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_HERO_LEFT_1", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_HERO_LEFT_1")->textureID = LoadTGA("Image//Scene2D_Tile_Hero_Left_1.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_HERO_LEFT_2", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_HERO_LEFT_2")->textureID = LoadTGA("Image//Scene2D_Tile_Hero_Left_2.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_HERO_LEFT_3", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_HERO_LEFT_3")->textureID = LoadTGA("Image//Scene2D_Tile_Hero_Left_3.tga");
-
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_ENEMY", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_ENEMY")->textureID = LoadTGA("Image//Scene2D_Tile_Enemy.tga");
-	MeshBuilder::GetInstance()->GenerateQuad("SCENE2D_TILE_TREASURECHEST", Color(1, 1, 1), 1.f);
-	MeshBuilder::GetInstance()->GetMesh("SCENE2D_TILE_TREASURECHEST")->textureID = LoadTGA("Image//Scene2D_Tile_TreasureChest.tga");
+	// Pack the tiles and the animation frames into one atlas, so they share a texture and are batched together.
+	// The hero's frames are added first, in the order of the animation indices, so an animation index is also their atlas index
+	theAtlas = new CTextureAtlas();
+	theAtlas->AddImage("SCENE2D_TILE_HERO_RIGHT_0", "Image//Scene2D_Tile_Hero_Right_0.tga");
+	theAtlas->AddImage("SCENE2D_TILE_HERO_RIGHT_1", "Image//Scene2D_Tile_Hero_Right_1.tga");
+	theAtlas->AddImage("SCENE2D_TILE_HERO_RIGHT_2", "Image//Scene2D_Tile_Hero_Right_2.tga");
+	theAtlas->AddImage("SCENE2D_TILE_HERO_RIGHT_3", "Image//Scene2D_Tile_Hero_Right_3.tga");
+	theAtlas->AddImage("SCENE2D_TILE_HERO_LEFT_1", "Image//Scene2D_Tile_Hero_Left_1.tga");
+	theAtlas->AddImage("SCENE2D_TILE_HERO_LEFT_2", "Image//Scene2D_Tile_Hero_Left_2.tga");
+	theAtlas->AddImage("SCENE2D_TILE_HERO_LEFT_3", "Image//Scene2D_Tile_Hero_Left_3.tga");
+	theAtlas->AddImage("SCENE2D_TILE_GROUND", "Image//Scene2D_Tile_Ground.tga");
+	theAtlas->AddImage("SCENE2D_TILE_HERO", "Image//Scene2D_Tile_Hero.tga");
+	theAtlas->AddImage("SCENE2D_TILE_TREE", "Image//Scene2D_Tile_Tree.tga");
+	theAtlas->AddImage("SCENE2D_TILE_REARSTRUCTURE", "Image//Scene2D_RearStructure.tga");
+	theAtlas->AddImage("SCENE2D_TILE_ENEMY", "Image//Scene2D_Tile_Enemy.tga");
+	theAtlas->AddImage("SCENE2D_TILE_TREASURECHEST", "Image//Scene2D_Tile_TreasureChest.tga");
+	theAtlas->Build();
+	theAtlas->GenerateQuads(Color(1, 1, 1), 1.f);
 
 	// Create entities into the scene
 	Create::Entity("reference", Vector3(0.0f, 0.0f, 0.0f)); // Reference
@@ -419,17 +420,24 @@ void CScene2D::Render()
 	// PreRenderText
 	RenderHelper::PreRenderText();
 
+		// Collect the sprites, and draw each layer of them with as few draw calls as the textures allow
+		CSpriteBatch::GetInstance()->Begin();
+
 		// Render the required entities
 		EntityManager::GetInstance()->RenderUI();
+		CSpriteBatch::GetInstance()->Flush();
 
 		// Render the rear tile map
 		RenderRearTileMap();
+		CSpriteBatch::GetInstance()->Flush();
 		// Render the tile map
 		RenderTileMap();
+		CSpriteBatch::GetInstance()->Flush();
 		// Render the Enemy
 		RenderEnemy();
 		// Render the player
 		RenderPlayer();
+		CSpriteBatch::GetInstance()->End();
 
 		textObj[0]->RenderUI();
 		textObj[1]->RenderUI();
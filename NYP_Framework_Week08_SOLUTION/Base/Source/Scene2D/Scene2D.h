@@ -15,6 +15,7 @@
 class ShaderProgram;
 class SceneManager;
 class TextEntity;
+class CTextureAtlas;
 class CScene2D : public Scene
 {	
 public:
@@ -48,6 +49,8 @@ private:
 	SpriteEntity* Scene2D_RearStructure;
 	SpriteEntity** Scene2D_Hero_Animated;
 	SpriteEntity* Scene2D_Goodies_TreasureChest;
+	// The atlas of the tiles and the animation frames
+	CTextureAtlas* theAtlas;
 
 	// Handle to the tilemaps
 	CMap* m_cMap;
@@ -0,0 +1,359 @@
+#include "Animation.h"
+#include "SceneNode.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+using namespace std;
+
+// Insert a key into a track, keeping the track ordered by time
+template <typename T>
+static void InsertKey(std::vector<float>& theTimes, std::vector<T>& theValues, const float time, const T& theValue)
+{
+	int index = (int)(std::upper_bound(theTimes.begin(), theTimes.end(), time) - theTimes.begin());
+	theTimes.insert(theTimes.begin() + index, time);
+	theValues.insert(theValues.begin() + index, theValue);
+}
+
+// Find the key at or before a time, and the fraction of the way to the next key
+static int FindKey(const std::vector<float>& theTimes, const float time, int& keyHint, float& fraction)
+{
+	const int numOfKeys = (int)theTimes.size();
+
+	// Start from the last key found if the time has not gone back past it, else search for it
+	int index = keyHint;
+	if ((index < 0) || (index >= numOfKeys) || (theTimes[index] > time))
+		index = std::max(0, (int)(std::upper_bound(theTimes.begin(), theTimes.end(), time) - theTimes.begin()) - 1);
+	while ((index + 1 < numOfKeys) && (theTimes[index + 1] <= time))
+		index++;
+	keyHint = index;
+
+	fraction = 0.0f;
+	if ((index + 1 < numOfKeys) && (time > theTimes[index]))
+		fraction = (time - theTimes[index]) / (theTimes[index + 1] - theTimes[index]);
+	return index;
+}
+
+CAnimationClip::CAnimationClip(void)
+	: theWrapMode(WRAP_LOOP)
+	, duration(0.0f)
+{
+}
+
+CAnimationClip::~CAnimationClip(void)
+{
+}
+
+// Add a translation key at a time, in seconds
+void CAnimationClip::AddPositionKey(const float time, const Vector3& thePosition)
+{
+	InsertKey(thePositionTimes, thePositionValues, time, thePosition);
+	duration = std::max(duration, time);
+}
+
+// Add a rotation key at a time, in seconds
+void CAnimationClip::AddRotationKey(const float time, const Quaternion& theRotation)
+{
+	Quaternion theKey = theRotation;
+	InsertKey(theRotationTimes, theRotationValues, time, theKey.Normalize());
+	duration = std::max(duration, time);
+}
+
+// Add a rotation key of degrees about an axis at a time, in seconds
+void CAnimationClip::AddRotationKey(const float time, const float degrees, const Vector3& theAxis)
+{
+	Quaternion theRotation;
+	try
+	{
+		theRotation.SetToRotation(degrees, theAxis.x, theAxis.y, theAxis.z);
+	}
+	catch (DivideByZero)
+	{
+		cout << "CAnimationClip::AddRotationKey: The axis of rotation is a zero vector" << endl;
+		return;
+	}
+	AddRotationKey(time, theRotation);
+}
+
+// Add a scale key at a time, in seconds
+void CAnimationClip::AddScaleKey(const float time, const Vector3& theScale)
+{
+	InsertKey(theScaleTimes, theScaleValues, time, theScale);
+	duration = std::max(duration, time);
+}
+
+// Set how the clip continues after its last key
+void CAnimationClip::SetWrapMode(const WRAP_MODE theWrapMode)
+{
+	this->theWrapMode = theWrapMode;
+}
+
+// Get how the clip continues after its last key
+CAnimationClip::WRAP_MODE CAnimationClip::GetWrapMode(void) const
+{
+	return theWrapMode;
+}
+
+// Get the time of the last key, in seconds
+float CAnimationClip::GetDuration(void) const
+{
+	return duration;
+}
+
+// Return true if the clip has translation keys
+bool CAnimationClip::HasPositionTrack(void) const
+{
+	return !thePositionTimes.empty();
+}
+
+// Return true if the clip has rotation keys
+bool CAnimationClip::HasRotationTrack(void) const
+{
+	return !theRotationTimes.empty();
+}
+
+// Return true if the clip has scale keys
+bool CAnimationClip::HasScaleTrack(void) const
+{
+	return !theScaleTimes.empty();
+}
+
+// Keep a playing time within the range which the wrap mode repeats, so it does not lose precision over time
+float CAnimationClip::WrapTime(const float time) const
+{
+	if (duration <= 0.0f)
+		return 0.0f;
+
+	switch (theWrapMode)
+	{
+	case WRAP_LOOP:
+		{
+			float wrappedTime = fmod(time, duration);
+			return (wrappedTime < 0.0f ? wrappedTime + duration : wrappedTime);
+		}
+	case WRAP_PINGPONG:
+		{
+			float wrappedTime = fmod(time, duration * 2.0f);
+			return (wrappedTime < 0.0f ? wrappedTime + duration * 2.0f : wrappedTime);
+		}
+	default:
+		return std::min(std::max(time, 0.0f), duration);
+	}
+}
+
+// Get the time in the clip for a playing time kept by WrapTime
+float CAnimationClip::GetSampleTime(const float time) const
+{
+	// The second half of a ping-pong plays the clip backwards
+	if ((theWrapMode == WRAP_PINGPONG) && (time > duration))
+		return duration * 2.0f - time;
+	return time;
+}
+
+// Sample the translation track
+Vector3 CAnimationClip::SamplePosition(const float time, int& keyHint) const
+{
+	float fraction;
+	int index = FindKey(thePositionTimes, time, keyHint, fraction);
+	if (fraction <= 0.0f)
+		return thePositionValues[index];
+	return thePositionValues[index] + (thePositionValues[index + 1] - thePositionValues[index]) * fraction;
+}
+
+// Sample the rotation track
+Quaternion CAnimationClip::SampleRotation(const float time, int& keyHint) const
+{
+	float fraction;
+	int index = FindKey(theRotationTimes, time, keyHint, fraction);
+	if (fraction <= 0.0f)
+		return theRotationValues[index];
+	return Slerp(theRotationValues[index], theRotationValues[index + 1], fraction);
+}
+
+// Sample the scale track
+Vector3 CAnimationClip::SampleScale(const float time, int& keyHint) const
+{
+	float fraction;
+	int index = FindKey(theScaleTimes, time, keyHint, fraction);
+	if (fraction <= 0.0f)
+		return theScaleValues[index];
+	return theScaleValues[index] + (theScaleValues[index + 1] - theScaleValues[index]) * fraction;
+}
+
+CAnimator::CAnimator(void)
+{
+}
+
+CAnimator::~CAnimator(void)
+{
+	// Detach the nodes, as they may outlive the animator
+	for (unsigned i = 0; i < theNodes.size(); ++i)
+		theNodes[i]->SetAnimationIndex(-1);
+	theNodes.clear();
+
+	std::map<std::string, CAnimationClip*>::iterator it;
+	for (it = theClipMap.begin(); it != theClipMap.end(); ++it)
+	{
+		delete it->second;
+	}
+	theClipMap.clear();
+}
+
+// Create a clip. An existing clip with the same name is replaced
+CAnimationClip* CAnimator::CreateClip(const std::string& _clipName)
+{
+	RemoveClip(_clipName);
+	CAnimationClip* theClip = new CAnimationClip();
+	theClipMap[_clipName] = theClip;
+	return theClip;
+}
+
+// Get a clip
+CAnimationClip* CAnimator::GetClip(const std::string& _clipName)
+{
+	if (theClipMap.count(_clipName) != 0)
+		return theClipMap[_clipName];
+
+	return nullptr;
+}
+
+// Stop all the nodes playing a clip, then remove and delete it
+void CAnimator::RemoveClip(const std::string& _clipName)
+{
+	CAnimationClip* theClip = GetClip(_clipName);
+	if (theClip == nullptr)
+		return;
+
+	// Go backwards, as Stop moves the last node into the stopped node's place
+	for (int i = (int)theNodes.size() - 1; i >= 0; --i)
+	{
+		if (theClips[i] == theClip)
+			Stop(theNodes[i]);
+	}
+	delete theClip;
+	theClipMap.erase(_clipName);
+}
+
+// Play a clip on a node from its start
+bool CAnimator::Play(CSceneNode* theNode, CAnimationClip* theClip, const float speed)
+{
+	if ((theNode == nullptr) || (theClip == nullptr))
+	{
+		cout << "CAnimator::Play: Unable to play the clip" << endl;
+		return false;
+	}
+
+	int index = FindIndex(theNode);
+	if (index < 0)
+	{
+		index = (int)theNodes.size();
+		theNodes.push_back(theNode);
+		theClips.push_back(theClip);
+		theTimes.push_back(0.0f);
+		theSpeeds.push_back(speed);
+		thePositionKeys.push_back(0);
+		theRotationKeys.push_back(0);
+		theScaleKeys.push_back(0);
+		theNode->SetAnimationIndex(index);
+		return true;
+	}
+
+	// Restart the node with the new clip
+	theClips[index] = theClip;
+	theTimes[index] = 0.0f;
+	theSpeeds[index] = speed;
+	thePositionKeys[index] = 0;
+	theRotationKeys[index] = 0;
+	theScaleKeys[index] = 0;
+	return true;
+}
+
+// Play a clip on a node from its start, using the clip's name
+bool CAnimator::Play(CSceneNode* theNode, const std::string& _clipName, const float speed)
+{
+	return Play(theNode, GetClip(_clipName), speed);
+}
+
+// Stop the clip on a node. The node keeps its last sampled transformation
+void CAnimator::Stop(CSceneNode* theNode)
+{
+	int index = FindIndex(theNode);
+	if (index < 0)
+		return;
+
+	// Move the last node into this node's place, so the arrays stay packed
+	const int last = (int)theNodes.size() - 1;
+	if (index != last)
+	{
+		theNodes[index] = theNodes[last];
+		theClips[index] = theClips[last];
+		theTimes[index] = theTimes[last];
+		theSpeeds[index] = theSpeeds[last];
+		thePositionKeys[index] = thePositionKeys[last];
+		theRotationKeys[index] = theRotationKeys[last];
+		theScaleKeys[index] = theScaleKeys[last];
+		theNodes[index]->SetAnimationIndex(index);
+	}
+	theNodes.pop_back();
+	theClips.pop_back();
+	theTimes.pop_back();
+	theSpeeds.pop_back();
+	thePositionKeys.pop_back();
+	theRotationKeys.pop_back();
+	theScaleKeys.pop_back();
+	theNode->SetAnimationIndex(-1);
+}
+
+// Return true if a node is playing a clip
+bool CAnimator::IsPlaying(CSceneNode* theNode) const
+{
+	return (FindIndex(theNode) >= 0);
+}
+
+// Set the speed of a playing node. A speed of 0 pauses it
+void CAnimator::SetSpeed(CSceneNode* theNode, const float speed)
+{
+	int index = FindIndex(theNode);
+	if (index >= 0)
+		theSpeeds[index] = speed;
+}
+
+// Get the number of nodes which are playing a clip
+int CAnimator::GetNumOfAnimatedNodes(void) const
+{
+	return (int)theNodes.size();
+}
+
+// Advance and sample the clips of all the animated nodes
+void CAnimator::Update(const float dt)
+{
+	const int numOfNodes = (int)theNodes.size();
+
+	// Advance the playing times
+	for (int i = 0; i < numOfNodes; ++i)
+		theTimes[i] = theClips[i]->WrapTime(theTimes[i] + dt * theSpeeds[i]);
+
+	// Sample the tracks and write them into the nodes, which marks them for the world transformation update
+	for (int i = 0; i < numOfNodes; ++i)
+	{
+		const CAnimationClip* theClip = theClips[i];
+		const float time = theClip->GetSampleTime(theTimes[i]);
+		if (theClip->HasPositionTrack())
+			theNodes[i]->SetTranslate(theClip->SamplePosition(time, thePositionKeys[i]));
+		if (theClip->HasRotationTrack())
+			theNodes[i]->SetRotation(theClip->SampleRotation(time, theRotationKeys[i]));
+		if (theClip->HasScaleTrack())
+			theNodes[i]->SetScale(theClip->SampleScale(time, theScaleKeys[i]));
+	}
+}
+
+// Find the index of a node in the arrays, or -1 if it is not playing a clip
+int CAnimator::FindIndex(CSceneNode* theNode) const
+{
+	if (theNode == nullptr)
+		return -1;
+
+	int index = theNode->GetAnimationIndex();
+	if ((index < 0) || (index >= (int)theNodes.size()) || (theNodes[index] != theNode))
+		return -1;
+	return index;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Vector3.h"
+#include "Quaternion.h"
+#include "SingletonTemplate.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class CSceneNode;
+
+// A set of keyframe tracks for the translation, rotation and scale of a Scene Node.
+// The keys are placed in seconds, so an animation plays at the same speed at any frame rate.
+// A track without keys leaves that part of the node's transformation unchanged.
+class CAnimationClip
+{
+public:
+	enum WRAP_MODE
+	{
+		WRAP_ONCE = 0,	// Stop at the last key
+		WRAP_LOOP,		// Restart from the first key
+		WRAP_PINGPONG,	// Play forwards, then backwards
+		NUM_WRAP_MODE
+	};
+
+	CAnimationClip(void);
+	virtual ~CAnimationClip(void);
+
+	// Add a translation key at a time, in seconds
+	void AddPositionKey(const float time, const Vector3& thePosition);
+	// Add a rotation key at a time, in seconds
+	void AddRotationKey(const float time, const Quaternion& theRotation);
+	// Add a rotation key of degrees about an axis at a time, in seconds
+	void AddRotationKey(const float time, const float degrees, const Vector3& theAxis);
+	// Add a scale key at a time, in seconds
+	void AddScaleKey(const float time, const Vector3& theScale);
+
+	// Set how the clip continues after its last key
+	void SetWrapMode(const WRAP_MODE theWrapMode);
+	// Get how the clip continues after its last key
+	WRAP_MODE GetWrapMode(void) const;
+	// Get the time of the last key, in seconds
+	float GetDuration(void) const;
+
+	// Return true if the clip has translation keys
+	bool HasPositionTrack(void) const;
+	// Return true if the clip has rotation keys
+	bool HasRotationTrack(void) const;
+	// Return true if the clip has scale keys
+	bool HasScaleTrack(void) const;
+
+	// Keep a playing time within the range which the wrap mode repeats
+	float WrapTime(const float time) const;
+	// Get the time in the clip for a playing time kept by WrapTime
+	float GetSampleTime(const float time) const;
+
+	// Sample the tracks at a time from GetSampleTime. keyHint is the key found by the last sample
+	// of the same track, and it is updated so a clip which is played forwards seldom needs a search
+	Vector3 SamplePosition(const float time, int& keyHint) const;
+	Quaternion SampleRotation(const float time, int& keyHint) const;
+	Vector3 SampleScale(const float time, int& keyHint) const;
+
+protected:
+	WRAP_MODE theWrapMode;
+	float duration;
+
+	// The times and values of each track are kept in separate arrays, ordered by time
+	std::vector<float> thePositionTimes;
+	std::vector<Vector3> thePositionValues;
+	std::vector<float> theRotationTimes;
+	std::vector<Quaternion> theRotationValues;
+	std::vector<float> theScaleTimes;
+	std::vector<Vector3> theScaleValues;
+};
+
+// Plays the animation clips on the Scene Nodes.
+// The playing state of all the animated nodes is kept in parallel arrays, and it is advanced and
+// sampled in one pass by CSceneGraph::Update, before the world transformations are computed.
+class CAnimator : public Singleton<CAnimator>
+{
+	friend Singleton<CAnimator>;
+public:
+	virtual ~CAnimator(void);
+
+	// Create a clip. An existing clip with the same name is replaced
+	CAnimationClip* CreateClip(const std::string& _clipName);
+	// Get a clip
+	CAnimationClip* GetClip(const std::string& _clipName);
+	// Stop all the nodes playing a clip, then remove and delete it
+	void RemoveClip(const std::string& _clipName);
+
+	// Play a clip on a node from its start. speed is a multiplier of the clip's time
+	bool Play(CSceneNode* theNode, CAnimationClip* theClip, const float speed = 1.0f);
+	// Play a clip on a node from its start, using the clip's name
+	bool Play(CSceneNode* theNode, const std::string& _clipName, const float speed = 1.0f);
+	// Stop the clip on a node. The node keeps its last sampled transformation
+	void Stop(CSceneNode* theNode);
+	// Return true if a node is playing a clip
+	bool IsPlaying(CSceneNode* theNode) const;
+	// Set the speed of a playing node. A speed of 0 pauses it
+	void SetSpeed(CSceneNode* theNode, const float speed);
+	// Get the number of nodes which are playing a clip
+	int GetNumOfAnimatedNodes(void) const;
+
+	// Advance and sample the clips of all the animated nodes. dt is in seconds
+	void Update(const float dt);
+
+protected:
+	CAnimator(void);
+
+	// Find the index of a node in the arrays, or -1 if it is not playing a clip
+	int FindIndex(CSceneNode* theNode) const;
+
+	std::map<std::string, CAnimationClip*> theClipMap;
+
+	// The playing state, with one element per animated node
+	std::vector<CSceneNode*> theNodes;
+	std::vector<CAnimationClip*> theClips;
+	std::vector<float> theTimes;
+	std::vector<float> theSpeeds;
+	std::vector<int> thePositionKeys;
+	std::vector<int> theRotationKeys;
+	std::vector<int> theScaleKeys;
+};
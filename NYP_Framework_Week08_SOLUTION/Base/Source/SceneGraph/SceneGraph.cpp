@@ -1,16 +1,94 @@
 #include "SceneGraph.h"
+#include "Animation.h"
 #include "MeshBuilder.h"
 #include "../EntityManager.h"
 #include "GraphicsManager.h"
 #include "RenderHelper.h"
+#include "RenderQueue.h"
+#include "ThreadPool/ThreadPool.h"
+#include "Collider/Collider.h"
+#include "MyMath.h"
+#include <algorithm>
+#include <cmath>
+
+// The side effect buffer and the node which the calling thread is updating, during a parallel update
+static thread_local int theCurrentBuffer = 0;
+static thread_local int theCurrentNode = 0;
+
+// Transform an AABB by a matrix, and return the AABB which encloses the result
+static void TransformAABB(const Mtx44& theMatrix, const Vector3& minAABB, const Vector3& maxAABB, Vector3& out_min, Vector3& out_max)
+{
+	const float theMin[3] = { minAABB.x, minAABB.y, minAABB.z };
+	const float theMax[3] = { maxAABB.x, maxAABB.y, maxAABB.z };
+	float newMin[3], newMax[3];
+	for (int row = 0; row < 3; ++row)
+	{
+		// Start from the translation, then add the smaller and larger contribution of each axis
+		newMin[row] = newMax[row] = theMatrix.a[12 + row];
+		for (int column = 0; column < 3; ++column)
+		{
+			float a = theMatrix.a[column * 4 + row] * theMin[column];
+			float b = theMatrix.a[column * 4 + row] * theMax[column];
+			newMin[row] += (a < b) ? a : b;
+			newMax[row] += (a < b) ? b : a;
+		}
+	}
+	out_min.Set(newMin[0], newMin[1], newMin[2]);
+	out_max.Set(newMax[0], newMax[1], newMax[2]);
+}
+
+// Extract the 6 planes of the view frustum from a view-projection matrix. The normals point inwards
+static void ExtractFrustumPlanes(const Mtx44& theMatrix, float thePlanes[6][4])
+{
+	for (int i = 0; i < 6; ++i)
+	{
+		// Left, right, bottom, top, near and far planes are the last row plus or minus the first 3 rows
+		int row = i / 2;
+		float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+		for (int column = 0; column < 4; ++column)
+			thePlanes[i][column] = theMatrix.a[column * 4 + 3] + sign * theMatrix.a[column * 4 + row];
+	}
+}
+
+// Return false if an AABB is completely outside one of the frustum planes
+static bool IsAABBInFrustum(const float thePlanes[6][4], const Vector3& minAABB, const Vector3& maxAABB)
+{
+	for (int i = 0; i < 6; ++i)
+	{
+		// Test the corner which is furthest along the plane's normal
+		float x = (thePlanes[i][0] > 0.0f) ? maxAABB.x : minAABB.x;
+		float y = (thePlanes[i][1] > 0.0f) ? maxAABB.y : minAABB.y;
+		float z = (thePlanes[i][2] > 0.0f) ? maxAABB.z : minAABB.z;
+		if (thePlanes[i][0] * x + thePlanes[i][1] * y + thePlanes[i][2] * z + thePlanes[i][3] < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+// Mark the entities of a node and all its children as done
+static void SetSubtreeDone(CSceneNode* theNode)
+{
+	if (theNode->GetEntity())
+		theNode->GetEntity()->SetIsDone(true);
+
+	const vector<CSceneNode*>& theChildren = theNode->GetChildren();
+	for (unsigned i = 0; i < theChildren.size(); ++i)
+		SetSubtreeDone(theChildren[i]);
+}
 
 CSceneGraph::CSceneGraph(void)
 	: ID(0)
 	, theRoot(NULL)
+	, bHierarchyChanged(true)
+	, bFrustumCulling(true)
+	, bParallelUpdate(false)
+	, bInParallelUpdate(false)
+	, updateJobSize(64)
 {
 	theRoot = new CSceneNode();
 	// Assign the first ID to the root. Default is 0
 	theRoot->SetID(this->GenerateID());
+	RegisterNode(theRoot);
 }
 
 CSceneGraph::~CSceneGraph()
@@ -19,11 +97,36 @@ CSceneGraph::~CSceneGraph()
 
 void CSceneGraph::Destroy()
 {
+	// The queued nodes are still in the tree, so they are deleted with the rest
+	theDeletionQueue.clear();
 	if (theRoot)
 	{
 		theRoot->DeleteAllChildren();
 		delete theRoot;
+		theRoot = NULL;
 	}
+	theIDIndex.clear();
+	theEntityIndex.clear();
+	theFlatNodes.clear();
+	theParentIndices.clear();
+	theEntityPositions.clear();
+	theLocalTransforms.clear();
+	theWorldTransforms.clear();
+	theDirtyFlags.clear();
+	theSubtreeEnds.clear();
+	theColliders.clear();
+	theColliderMins.clear();
+	theColliderMaxs.clear();
+	theOwnBoundsMins.clear();
+	theOwnBoundsMaxs.clear();
+	theSubtreeBoundsMins.clear();
+	theSubtreeBoundsMaxs.clear();
+	theOwnBounded.clear();
+	theSubtreeBounded.clear();
+	theBoundsDirty.clear();
+	theSplitNodes.clear();
+	theUpdateJobs.clear();
+	theSideEffects.clear();
 	Singleton<CSceneGraph>::Destroy();
 }
 
@@ -48,37 +151,180 @@ CSceneNode* CSceneGraph::AddNode(EntityBase* theEntity)
 // Delete a Node from this Scene Graph using the pointer to the node
 bool CSceneGraph::DeleteNode(EntityBase* theEntity)
 {
-	return theRoot->DeleteChild(theEntity);
+	// The lookup indices are not changed during a parallel update, so the node can be found here
+	if (bInParallelUpdate)
+	{
+		if (GetNode(theEntity) == NULL)
+			return false;
+		QueueSideEffect([this, theEntity]() { QueueDeletion(GetNode(theEntity)); });
+		return true;
+	}
+	return QueueDeletion(GetNode(theEntity));
 }
 
 // Delete a Node from this Scene Graph using its ID
 bool CSceneGraph::DeleteNode(const int ID)
 {
-	return theRoot->DeleteChild(ID);
+	if (bInParallelUpdate)
+	{
+		if (GetNode(ID) == NULL)
+			return false;
+		QueueSideEffect([this, ID]() { QueueDeletion(GetNode(ID)); });
+		return true;
+	}
+	return QueueDeletion(GetNode(ID));
 }
 
 // Detach a Node from this Scene Graph using the pointer to the entity
 CSceneNode* CSceneGraph::DetachNode(EntityBase* theEntity)
 {
-	return theRoot->DetachChild(theEntity);
+	return DetachSubtree(GetNode(theEntity));
 }
 
 // Detach a Node from this Scene Graph using its ID
 CSceneNode* CSceneGraph::DetachNode(const int ID)
 {
-	return theRoot->DetachChild(ID);
+	return DetachSubtree(GetNode(ID));
 }
 
 // Get a Node using the pointer to the node
 CSceneNode* CSceneGraph::GetNode(EntityBase* theEntity) const
 {
-	return theRoot->GetEntity(theEntity);
+	// The root is the only node without an entity
+	if (theEntity == NULL)
+		return theRoot;
+
+	std::unordered_map<EntityBase*, CSceneNode*>::const_iterator it = theEntityIndex.find(theEntity);
+	if (it != theEntityIndex.end())
+		return it->second;
+	return NULL;
 }
 
 // Get a Node using its ID
 CSceneNode* CSceneGraph::GetNode(const int ID) const
 {
-	return theRoot->GetEntity(ID);
+	std::unordered_map<int, CSceneNode*>::const_iterator it = theIDIndex.find(ID);
+	if (it != theIDIndex.end())
+		return it->second;
+	return NULL;
+}
+
+// Add a node to the lookup indices
+void CSceneGraph::RegisterNode(CSceneNode* theNode)
+{
+	theIDIndex[theNode->GetID()] = theNode;
+	if (theNode->GetEntity())
+		theEntityIndex[theNode->GetEntity()] = theNode;
+}
+
+// Remove a node from the lookup indices
+void CSceneGraph::UnregisterNode(CSceneNode* theNode)
+{
+	// Only remove the entries which still point to this node
+	std::unordered_map<int, CSceneNode*>::iterator itID = theIDIndex.find(theNode->GetID());
+	if ((itID != theIDIndex.end()) && (itID->second == theNode))
+		theIDIndex.erase(itID);
+
+	std::unordered_map<EntityBase*, CSceneNode*>::iterator itEntity = theEntityIndex.find(theNode->GetEntity());
+	if ((itEntity != theEntityIndex.end()) && (itEntity->second == theNode))
+		theEntityIndex.erase(itEntity);
+}
+
+// Remove a node and all its children from the lookup indices
+void CSceneGraph::UnregisterSubtree(CSceneNode* theNode)
+{
+	UnregisterNode(theNode);
+
+	const vector<CSceneNode*>& theChildren = theNode->GetChildren();
+	for (unsigned i = 0; i < theChildren.size(); ++i)
+		UnregisterSubtree(theChildren[i]);
+}
+
+// Queue a node and all its children for deletion
+bool CSceneGraph::QueueDeletion(CSceneNode* theNode)
+{
+	if (theNode == NULL)
+		return false;
+
+	// Deleting the root only deletes its children
+	if (theNode == theRoot)
+	{
+		const vector<CSceneNode*>& theChildren = theRoot->GetChildren();
+		for (unsigned i = 0; i < theChildren.size(); ++i)
+			QueueDeletion(theChildren[i]);
+		return true;
+	}
+
+	// The node may be hit more than once before the queue is flushed
+	if (theNode->IsPendingDelete())
+		return true;
+
+	theNode->SetPendingDelete(true);
+	SetSubtreeDone(theNode);
+	theDeletionQueue.push_back(theNode);
+	return true;
+}
+
+// Delete all the Nodes which were queued for deletion
+void CSceneGraph::FlushDeletions(void)
+{
+	if (theDeletionQueue.empty())
+		return;
+
+	// Skip the nodes inside a queued subtree, as they are deleted with their queued ancestor
+	std::vector<CSceneNode*> theTopNodes;
+	std::vector<CSceneNode*> theParents;
+	theTopNodes.reserve(theDeletionQueue.size());
+	theParents.reserve(theDeletionQueue.size());
+	for (unsigned i = 0; i < theDeletionQueue.size(); ++i)
+	{
+		CSceneNode* theNode = theDeletionQueue[i];
+		bool bInsideQueuedSubtree = false;
+		for (CSceneNode* theAncestor = theNode->GetParent(); theAncestor != NULL; theAncestor = theAncestor->GetParent())
+		{
+			if (theAncestor->IsPendingDelete())
+			{
+				bInsideQueuedSubtree = true;
+				break;
+			}
+		}
+		if (bInsideQueuedSubtree)
+			continue;
+
+		theTopNodes.push_back(theNode);
+		if (theNode->GetParent())
+			theParents.push_back(theNode->GetParent());
+	}
+
+	// Compact the children of each parent once, however many of its children were removed
+	std::sort(theParents.begin(), theParents.end());
+	theParents.erase(std::unique(theParents.begin(), theParents.end()), theParents.end());
+	for (unsigned i = 0; i < theParents.size(); ++i)
+		theParents[i]->RemovePendingChildren();
+
+	// Delete the subtrees
+	for (unsigned i = 0; i < theTopNodes.size(); ++i)
+	{
+		CSceneNode* theNode = theTopNodes[i];
+		theNode->DeleteAllChildren();
+		UnregisterNode(theNode);
+		delete theNode;
+	}
+	theDeletionQueue.clear();
+	SetHierarchyChanged();
+}
+
+// Detach a node and all its children from its parent
+CSceneNode* CSceneGraph::DetachSubtree(CSceneNode* theNode)
+{
+	// The root and the nodes queued for deletion cannot be detached
+	if ((theNode == NULL) || (theNode == theRoot) || (theNode->IsPendingDelete()))
+		return NULL;
+
+	if (theNode->GetParent())
+		theNode->GetParent()->RemoveChild(theNode);
+	UnregisterSubtree(theNode);
+	return theNode;
 }
 
 // Return the number of nodes in this Scene Graph
@@ -87,10 +333,45 @@ int CSceneGraph::GetNumOfNode(void) const
 	return theRoot->GetNumOfChild();
 }
 
-// Recalculate the AABB
+// Recalculate the world bounds of all the nodes
 void CSceneGraph::ReCalc_AABB(void)
 {
-	theRoot->ReCalc_AABB();
+	if (theRoot == NULL)
+		return;
+
+	if (bHierarchyChanged)
+		Flatten();
+
+	// Force the transformations and the bounds of every node to be recomputed
+	for (unsigned i = 0; i < theFlatNodes.size(); ++i)
+		theFlatNodes[i]->SetDirty(true);
+	UpdateWorldTransforms();
+}
+
+// Get the world bounds of a node and all its children
+bool CSceneGraph::GetWorldBounds(const CSceneNode* theNode, Vector3& minAABB, Vector3& maxAABB) const
+{
+	int index = theNode->GetFlatIndex();
+	if ((bHierarchyChanged) || (index < 0) || (index >= (int)theFlatNodes.size()) || (theFlatNodes[index] != theNode))
+		return false;
+	if (!theSubtreeBounded[index])
+		return false;
+
+	minAABB = theSubtreeBoundsMins[index];
+	maxAABB = theSubtreeBoundsMaxs[index];
+	return true;
+}
+
+// Enable / Disable skipping the subtrees which are outside the view frustum when rendering
+void CSceneGraph::SetFrustumCulling(const bool bFrustumCulling)
+{
+	this->bFrustumCulling = bFrustumCulling;
+}
+
+// Return true if the subtrees outside the view frustum are skipped when rendering
+bool CSceneGraph::GetFrustumCulling(void) const
+{
+	return bFrustumCulling;
 }
 
 // Generate an ID for a Scene Node
@@ -103,14 +384,411 @@ int CSceneGraph::GenerateID(void)
 // Update the Scene Graph
 void CSceneGraph::Update(const float dt)
 {
-	if (theRoot)
-		theRoot->Update(dt);
+	if (theRoot == NULL)
+		return;
+
+	if (bHierarchyChanged)
+		Flatten();
+
+	if ((bParallelUpdate) && (CThreadPool::GetInstance()->GetNumOfThreads() > 1) && (theUpdateJobs.size() > 1))
+	{
+		ParallelUpdate(dt);
+	}
+	else
+	{
+		// Update the nodes in parent-before-child order, as the recursive update does.
+		// If an entity adds or moves nodes, the rest of this snapshot is still updated, and the new
+		// nodes are picked up by the next Flatten. Deleted nodes are only freed in FlushDeletions
+		const unsigned numOfNodes = theFlatNodes.size();
+		for (unsigned i = 0; i < numOfNodes; ++i)
+			theFlatNodes[i]->UpdateSelf(dt);
+	}
+
+	// Sample the animations after the entities, so the animated tracks are final, and before the propagation
+	CAnimator::GetInstance()->Update(dt);
+
+	UpdateWorldTransforms();
 }
 // Render the Scene Graph
 void CSceneGraph::Render(void) const
 {
-	if (theRoot)
+	if (theRoot == NULL)
+		return;
+
+	// The world transformations are out of date, so fall back to the recursive render
+	if (bHierarchyChanged)
+	{
 		theRoot->Render();
+		return;
+	}
+
+	// The frustum in the space of the Scene Graph
+	float thePlanes[6][4];
+	ExtractFrustumPlanes(	GraphicsManager::GetInstance()->GetProjectionMatrix() *
+							GraphicsManager::GetInstance()->GetViewMatrix() *
+							GraphicsManager::GetInstance()->GetModelStack().Top(), thePlanes);
+
+	theVisibleNodes.clear();
+	unsigned i = 0;
+	while (i < theFlatNodes.size())
+	{
+		if (bFrustumCulling)
+		{
+			// Skip the whole subtree if its bounds are outside the frustum
+			if ((theSubtreeBounded[i]) && (!IsAABBInFrustum(thePlanes, theSubtreeBoundsMins[i], theSubtreeBoundsMaxs[i])))
+			{
+				i = theSubtreeEnds[i];
+				continue;
+			}
+			// Skip this node only, as some of its children may still be inside the frustum
+			if ((theOwnBounded[i]) && (!IsAABBInFrustum(thePlanes, theOwnBoundsMins[i], theOwnBoundsMaxs[i])))
+			{
+				++i;
+				continue;
+			}
+		}
+
+		if (theFlatNodes[i]->GetEntity())
+			theVisibleNodes.push_back(i);
+		++i;
+	}
+
+	// Record the visible nodes on the thread pool. Each job has a model stack of its own
+	const int numOfJobs = ((int)theVisibleNodes.size() + updateJobSize - 1) / updateJobSize;
+	CRenderQueue::GetInstance()->RecordParallel(numOfJobs, [this](const int jobIndex)
+	{
+		MS& modelStack = GraphicsManager::GetInstance()->GetModelStack();
+		const int jobEnd = std::min((jobIndex + 1) * updateJobSize, (int)theVisibleNodes.size());
+		for (int j = jobIndex * updateJobSize; j < jobEnd; ++j)
+		{
+			modelStack.PushMatrix();
+			modelStack.MultMatrix(theWorldTransforms[theVisibleNodes[j]]);
+			theFlatNodes[theVisibleNodes[j]]->RenderSelf();
+			modelStack.PopMatrix();
+		}
+	});
+}
+
+// Enable / Disable updating the subtrees of the Scene Graph in parallel
+void CSceneGraph::SetParallelUpdate(const bool bParallelUpdate)
+{
+	this->bParallelUpdate = bParallelUpdate;
+}
+
+// Return true if the subtrees of the Scene Graph are updated in parallel
+bool CSceneGraph::GetParallelUpdate(void) const
+{
+	return bParallelUpdate;
+}
+
+// Set the number of nodes in each job of a parallel update
+void CSceneGraph::SetUpdateJobSize(const int updateJobSize)
+{
+	if (updateJobSize < 1)
+		return;
+
+	this->updateJobSize = updateJobSize;
+	if (!bHierarchyChanged)
+		BuildUpdateJobs();
+}
+
+// Run a side effect of an entity's Update
+void CSceneGraph::QueueSideEffect(const std::function<void(void)>& theSideEffect)
+{
+	if (!bInParallelUpdate)
+	{
+		theSideEffect();
+		return;
+	}
+
+	// Each job has its own buffer, so no locking is needed
+	theSideEffects[theCurrentBuffer].push_back(std::make_pair(theCurrentNode, theSideEffect));
+}
+
+// Mark the flattened scene graph as out of date, after nodes were added, deleted or detached
+void CSceneGraph::SetHierarchyChanged(void)
+{
+	bHierarchyChanged = true;
+}
+
+// Get the world transformation of a node, as computed in the last Update
+Mtx44 CSceneGraph::GetWorldTransform(const CSceneNode* theNode) const
+{
+	int index = theNode->GetFlatIndex();
+	if ((bHierarchyChanged) || (index < 0) || (index >= (int)theFlatNodes.size()) || (theFlatNodes[index] != theNode))
+	{
+		Mtx44 identity;
+		identity.SetToIdentity();
+		return identity;
+	}
+	return theWorldTransforms[index];
+}
+
+// Rebuild the flattened scene graph from the tree
+void CSceneGraph::Flatten(void)
+{
+	theFlatNodes.clear();
+	theParentIndices.clear();
+	theSubtreeEnds.clear();
+
+	// Depth-first traversal, so every parent is stored before its children
+	std::vector< std::pair<CSceneNode*, int> > theStack;
+	theStack.push_back(std::make_pair(theRoot, -1));
+	while (!theStack.empty())
+	{
+		CSceneNode* theNode = theStack.back().first;
+		int parentIndex = theStack.back().second;
+		theStack.pop_back();
+
+		int index = (int)theFlatNodes.size();
+		theNode->SetFlatIndex(index);
+		// Force the local transformation to be recomputed
+		theNode->SetDirty(true);
+		theFlatNodes.push_back(theNode);
+		theParentIndices.push_back(parentIndex);
+
+		// Push the children in reverse, so they are stored in the same order as in the tree
+		const vector<CSceneNode*>& theChildren = theNode->GetChildren();
+		for (int i = (int)theChildren.size() - 1; i >= 0; --i)
+			theStack.push_back(std::make_pair(theChildren[i], index));
+	}
+
+	// Cache the colliders, as they are needed for the bounds in every Update
+	theColliders.resize(theFlatNodes.size());
+	for (unsigned i = 0; i < theFlatNodes.size(); ++i)
+		theColliders[i] = dynamic_cast<CCollider*>(theFlatNodes[i]->GetEntity());
+	theColliderMins.resize(theFlatNodes.size());
+	theColliderMaxs.resize(theFlatNodes.size());
+	theOwnBoundsMins.resize(theFlatNodes.size());
+	theOwnBoundsMaxs.resize(theFlatNodes.size());
+	theSubtreeBoundsMins.resize(theFlatNodes.size());
+	theSubtreeBoundsMaxs.resize(theFlatNodes.size());
+	theOwnBounded.assign(theFlatNodes.size(), 0);
+	theSubtreeBounded.assign(theFlatNodes.size(), 0);
+	theBoundsDirty.assign(theFlatNodes.size(), 1);
+	theEntityPositions.resize(theFlatNodes.size());
+	theLocalTransforms.resize(theFlatNodes.size());
+	theWorldTransforms.resize(theFlatNodes.size());
+	theDirtyFlags.assign(theFlatNodes.size(), 1);
+
+	// A subtree ends where the next node outside it starts. Go backwards so the children are done first
+	theSubtreeEnds.assign(theFlatNodes.size(), 0);
+	for (int i = (int)theFlatNodes.size() - 1; i >= 0; --i)
+	{
+		if (theSubtreeEnds[i] == 0)
+			theSubtreeEnds[i] = i + 1;
+		int parentIndex = theParentIndices[i];
+		if ((parentIndex >= 0) && (theSubtreeEnds[i] > theSubtreeEnds[parentIndex]))
+			theSubtreeEnds[parentIndex] = theSubtreeEnds[i];
+	}
+
+	bHierarchyChanged = false;
+	BuildUpdateJobs();
+}
+
+// Split the flattened scene graph into jobs for a parallel update
+void CSceneGraph::BuildUpdateJobs(void)
+{
+	theSplitNodes.clear();
+	theUpdateJobs.clear();
+	if (theFlatNodes.empty())
+		return;
+
+	int batchStart = -1, batchEnd = -1;
+	AddUpdateJobs(0, batchStart, batchEnd);
+	if (batchStart >= 0)
+		theUpdateJobs.push_back(std::make_pair(batchStart, batchEnd));
+
+	// One side effect buffer per job, and one for the split nodes
+	theSideEffects.resize(theUpdateJobs.size() + 1);
+}
+
+// Add a subtree to the jobs of a parallel update
+void CSceneGraph::AddUpdateJobs(const int index, int& batchStart, int& batchEnd)
+{
+	int subtreeEnd = theSubtreeEnds[index];
+	if (subtreeEnd - index > updateJobSize)
+	{
+		// The subtree is too large for one job. Update its root first, then split its children into jobs
+		if (batchStart >= 0)
+			theUpdateJobs.push_back(std::make_pair(batchStart, batchEnd));
+		batchStart = batchEnd = -1;
+
+		theSplitNodes.push_back(index);
+		for (int child = index + 1; child < subtreeEnd; child = theSubtreeEnds[child])
+			AddUpdateJobs(child, batchStart, batchEnd);
+		return;
+	}
+
+	// Subtrees which are next to each other in the flattened scene graph share a job until it is full
+	if (batchStart < 0)
+		batchStart = index;
+	batchEnd = subtreeEnd;
+	if (batchEnd - batchStart >= updateJobSize)
+	{
+		theUpdateJobs.push_back(std::make_pair(batchStart, batchEnd));
+		batchStart = batchEnd = -1;
+	}
+}
+
+// Update the nodes in parallel
+void CSceneGraph::ParallelUpdate(const float dt)
+{
+	bInParallelUpdate = true;
+
+	// The roots of the split subtrees are updated first, so every parent is still updated before its children
+	const int splitBuffer = (int)theUpdateJobs.size();
+	theCurrentBuffer = splitBuffer;
+	for (unsigned i = 0; i < theSplitNodes.size(); ++i)
+	{
+		theCurrentNode = theSplitNodes[i];
+		theFlatNodes[theSplitNodes[i]]->UpdateSelf(dt);
+	}
+
+	CThreadPool::GetInstance()->ParallelFor((int)theUpdateJobs.size(), [this, dt](const int jobIndex)
+	{
+		theCurrentBuffer = jobIndex;
+		for (int i = theUpdateJobs[jobIndex].first; i < theUpdateJobs[jobIndex].second; ++i)
+		{
+			theCurrentNode = i;
+			theFlatNodes[i]->UpdateSelf(dt);
+		}
+	});
+
+	bInParallelUpdate = false;
+
+	// Run the side effects in the order of the nodes which queued them, which is the order of a serial update
+	std::vector< std::pair<int, std::function<void(void)> > > theOrderedSideEffects;
+	for (unsigned i = 0; i < theSideEffects.size(); ++i)
+	{
+		theOrderedSideEffects.insert(theOrderedSideEffects.end(), theSideEffects[i].begin(), theSideEffects[i].end());
+		theSideEffects[i].clear();
+	}
+	std::stable_sort(theOrderedSideEffects.begin(), theOrderedSideEffects.end(),
+		[](const std::pair<int, std::function<void(void)> >& a, const std::pair<int, std::function<void(void)> >& b)
+		{
+			return a.first < b.first;
+		});
+	for (unsigned i = 0; i < theOrderedSideEffects.size(); ++i)
+		theOrderedSideEffects[i].second();
+}
+
+// Recompute the local transformations which changed, then the world transformations of the changed subtrees
+void CSceneGraph::UpdateWorldTransforms(void)
+{
+	if (bHierarchyChanged)
+		Flatten();
+
+	for (unsigned i = 0; i < theFlatNodes.size(); ++i)
+	{
+		CSceneNode* theNode = theFlatNodes[i];
+		EntityBase* theEntity = theNode->GetEntity();
+
+		// The local transformation changes when the node's transformation or the entity's position changes
+		bool bChanged = theNode->IsDirty();
+		if (theEntity)
+		{
+			Vector3 thePosition = theEntity->GetPosition();
+			if ((thePosition.x != theEntityPositions[i].x) ||
+				(thePosition.y != theEntityPositions[i].y) ||
+				(thePosition.z != theEntityPositions[i].z))
+				bChanged = true;
+
+			if (bChanged)
+			{
+				theEntityPositions[i] = thePosition;
+				Mtx44 translation;
+				translation.SetToTranslation(thePosition.x, thePosition.y, thePosition.z);
+				theLocalTransforms[i] = translation * theNode->GetTransform();
+			}
+		}
+		else if (bChanged)
+		{
+			// The root has no entity, and its transformation is not applied when rendering
+			theLocalTransforms[i].SetToIdentity();
+		}
+		theNode->SetDirty(false);
+
+		// A change in the parent moves the whole subtree. The parent was processed before this node
+		int parentIndex = theParentIndices[i];
+		if ((parentIndex >= 0) && (theDirtyFlags[parentIndex]))
+			bChanged = true;
+		theDirtyFlags[i] = bChanged ? 1 : 0;
+
+		if (bChanged)
+		{
+			if (parentIndex >= 0)
+				theWorldTransforms[i] = theWorldTransforms[parentIndex] * theLocalTransforms[i];
+			else
+				theWorldTransforms[i] = theLocalTransforms[i];
+		}
+
+		// The node's own bounds change when it moves, or when its collider is switched or resized
+		bool bHasCollider = (theColliders[i] != NULL) && (theEntity->HasCollider());
+		if (bHasCollider)
+		{
+			Vector3 theColliderMin = theColliders[i]->GetMinAABB();
+			Vector3 theColliderMax = theColliders[i]->GetMaxAABB();
+			if ((!theOwnBounded[i]) ||
+				(theColliderMin.x != theColliderMins[i].x) || (theColliderMin.y != theColliderMins[i].y) || (theColliderMin.z != theColliderMins[i].z) ||
+				(theColliderMax.x != theColliderMaxs[i].x) || (theColliderMax.y != theColliderMaxs[i].y) || (theColliderMax.z != theColliderMaxs[i].z))
+			{
+				theColliderMins[i] = theColliderMin;
+				theColliderMaxs[i] = theColliderMax;
+				bChanged = true;
+			}
+		}
+		else if (theOwnBounded[i])
+		{
+			bChanged = true;
+		}
+
+		if (bChanged)
+		{
+			theOwnBounded[i] = bHasCollider ? 1 : 0;
+			if (bHasCollider)
+				TransformAABB(theWorldTransforms[i], theColliderMins[i], theColliderMaxs[i], theOwnBoundsMins[i], theOwnBoundsMaxs[i]);
+			theBoundsDirty[i] = 1;
+		}
+	}
+
+	UpdateWorldBounds();
+}
+
+// Merge the world bounds of the changed nodes into their parents' bounds, from the leaves up
+void CSceneGraph::UpdateWorldBounds(void)
+{
+	// The children are stored after their parent, so going backwards finishes every child before its parent
+	for (int i = (int)theFlatNodes.size() - 1; i >= 0; --i)
+	{
+		if (!theBoundsDirty[i])
+			continue;
+		theBoundsDirty[i] = 0;
+
+		bool bBounded = (theOwnBounded[i] != 0);
+		Vector3 theMin = theOwnBoundsMins[i];
+		Vector3 theMax = theOwnBoundsMaxs[i];
+		for (int child = i + 1; child < theSubtreeEnds[i]; child = theSubtreeEnds[child])
+		{
+			if (!theSubtreeBounded[child])
+			{
+				bBounded = false;
+				break;
+			}
+			const Vector3& theChildMin = theSubtreeBoundsMins[child];
+			const Vector3& theChildMax = theSubtreeBoundsMaxs[child];
+			theMin.Set(Math::Min(theMin.x, theChildMin.x), Math::Min(theMin.y, theChildMin.y), Math::Min(theMin.z, theChildMin.z));
+			theMax.Set(Math::Max(theMax.x, theChildMax.x), Math::Max(theMax.y, theChildMax.y), Math::Max(theMax.z, theChildMax.z));
+		}
+
+		theSubtreeBounded[i] = bBounded ? 1 : 0;
+		theSubtreeBoundsMins[i] = theMin;
+		theSubtreeBoundsMaxs[i] = theMax;
+
+		// The parent's bounds include this node's bounds, so they need to be merged again
+		if (theParentIndices[i] >= 0)
+			theBoundsDirty[theParentIndices[i]] = 1;
+	}
 }
 
 // PrintSelf for debug purposes
@@ -4,9 +4,14 @@
 #include "EntityBase.h"
 #include "Vector3.h"
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include "Mtx44.h"
 #include "SceneNode.h"
 
 class Mesh;
+class CCollider;
 
 class CSceneGraph : public Singleton<CSceneGraph>
 {
@@ -22,10 +27,12 @@ public:
 
 	// Add a Node to this Scene Graph
 	CSceneNode* AddNode(EntityBase* theEntity = NULL);
-	// Delete a Node from this Scene Graph using the pointer to the node
+	// Queue a Node for deletion from this Scene Graph using the pointer to the node
 	bool DeleteNode(EntityBase* theEntity);
-	// Delete a Node from this Scene Graph using its ID
+	// Queue a Node for deletion from this Scene Graph using its ID
 	bool DeleteNode(const int ID);
+	// Delete all the Nodes which were queued for deletion. Call this once per frame, after the collision checks
+	void FlushDeletions(void);
 	// Detach a Node from this Scene Graph using the pointer to the entity
 	CSceneNode* DetachNode(EntityBase* theEntity);
 	// Detach a Node from this Scene Graph using its ID
@@ -36,25 +43,123 @@ public:
 	CSceneNode* GetNode(const int ID) const;
 	// Return the number of nodes in this Scene Graph
 	int GetNumOfNode(void) const;
-	// Recalculate the AABB
+	// Recalculate the world bounds of all the nodes. The entities' collider AABBs are not changed
 	void ReCalc_AABB(void);
+	// Get the world bounds of a node and all its children, as computed in the last Update.
+	// Returns false if the node or one of its children has no collider, so it has no bounds
+	bool GetWorldBounds(const CSceneNode* theNode, Vector3& minAABB, Vector3& maxAABB) const;
+	// Enable / Disable skipping the subtrees which are outside the view frustum when rendering
+	void SetFrustumCulling(const bool bFrustumCulling);
+	// Return true if the subtrees outside the view frustum are skipped when rendering
+	bool GetFrustumCulling(void) const;
 
 	// Generate an ID for a Scene Node
 	int GenerateID(void);
 
+	// Add a node to the lookup indices
+	void RegisterNode(CSceneNode* theNode);
+	// Remove a node from the lookup indices
+	void UnregisterNode(CSceneNode* theNode);
+	// Remove a node and all its children from the lookup indices
+	void UnregisterSubtree(CSceneNode* theNode);
+
 	// Update the Scene Graph
 	void Update(const float dt);
-	// Render the Scene Graph
+	// Render the Scene Graph. The nodes are culled on this thread, and the visible ones are recorded
+	// in jobs of the update job size by CRenderQueue::RecordParallel
 	void Render(void) const;
 
+	// Enable / Disable updating the subtrees of the Scene Graph in parallel
+	void SetParallelUpdate(const bool bParallelUpdate);
+	// Return true if the subtrees of the Scene Graph are updated in parallel
+	bool GetParallelUpdate(void) const;
+	// Set the number of nodes in each job of a parallel update. Larger subtrees are split into several jobs
+	void SetUpdateJobSize(const int updateJobSize);
+	// Run a side effect of an entity's Update, such as adding a node. During a parallel update, the side
+	// effects are run after all the jobs are done, in the same order as in a serial update.
+	// Entities must not add nodes directly while the Scene Graph is being updated in parallel.
+	void QueueSideEffect(const std::function<void(void)>& theSideEffect);
+
+	// Mark the flattened scene graph as out of date, after nodes were added, deleted or detached
+	void SetHierarchyChanged(void);
+	// Get the world transformation of a node, as computed in the last Update
+	Mtx44 GetWorldTransform(const CSceneNode* theNode) const;
+
 	// PrintSelf for debug purposes
 	void PrintSelf(void) const;
 
 protected:
+	// Queue a node and all its children for deletion
+	bool QueueDeletion(CSceneNode* theNode);
+	// Detach a node and all its children from its parent
+	CSceneNode* DetachSubtree(CSceneNode* theNode);
+
+	// Rebuild the flattened scene graph from the tree
+	void Flatten(void);
+	// Recompute the local transformations which changed, then the world transformations and bounds of the changed subtrees
+	void UpdateWorldTransforms(void);
+	// Merge the world bounds of the changed nodes into their parents' bounds, from the leaves up
+	void UpdateWorldBounds(void);
+	// Split the flattened scene graph into jobs for a parallel update
+	void BuildUpdateJobs(void);
+	// Add a subtree to the jobs of a parallel update
+	void AddUpdateJobs(const int index, int& batchStart, int& batchEnd);
+	// Update the nodes in parallel
+	void ParallelUpdate(const float dt);
+
 	// The root of the scene graph. 
 	// It usually does not have a mesh, and is the starting point for all scene graph operations
 	CSceneNode* theRoot;
 
 	// The next ID to be assigned to a scene node.
 	int ID;
+
+	// Lookup indices from a node's ID and from its entity to the node
+	std::unordered_map<int, CSceneNode*> theIDIndex;
+	std::unordered_map<EntityBase*, CSceneNode*> theEntityIndex;
+
+	// The nodes which are waiting to be deleted in FlushDeletions
+	std::vector<CSceneNode*> theDeletionQueue;
+
+	// The flattened scene graph. The nodes are stored with every parent before its children,
+	// so the world transformations can be computed in a single pass from the front.
+	bool bHierarchyChanged;
+	std::vector<CSceneNode*> theFlatNodes;
+	std::vector<int> theParentIndices;
+	// The entity positions which the local transformations were computed from
+	std::vector<Vector3> theEntityPositions;
+	// The translation to the entity's position, followed by the node's transformation
+	std::vector<Mtx44> theLocalTransforms;
+	// The parent's world transformation, followed by the local transformation
+	std::vector<Mtx44> theWorldTransforms;
+	// Set for the nodes whose world transformation changed in the last Update
+	std::vector<unsigned char> theDirtyFlags;
+	// The index after the last node in each node's subtree
+	std::vector<int> theSubtreeEnds;
+
+	// The world bounds of each node's own collider AABB, and of the node with all its children.
+	// These are kept separate from the entities' collider AABBs
+	std::vector<CCollider*> theColliders;
+	std::vector<Vector3> theColliderMins, theColliderMaxs;
+	std::vector<Vector3> theOwnBoundsMins, theOwnBoundsMaxs;
+	std::vector<Vector3> theSubtreeBoundsMins, theSubtreeBoundsMaxs;
+	// Set for the nodes which have a collider, and for the subtrees where every node has a collider
+	std::vector<unsigned char> theOwnBounded, theSubtreeBounded;
+	// Set for the nodes whose bounds need to be merged into their parents' in this Update
+	std::vector<unsigned char> theBoundsDirty;
+	bool bFrustumCulling;
+
+	// Parallel update
+	bool bParallelUpdate;
+	bool bInParallelUpdate;
+	int updateJobSize;
+	// The roots of the subtrees which are too large for one job. They are updated before the jobs
+	std::vector<int> theSplitNodes;
+	// The range of nodes in each job, from first to one after the last
+	std::vector< std::pair<int, int> > theUpdateJobs;
+	// The side effects queued by each job, with the index of the node which queued them
+	std::vector< std::vector< std::pair<int, std::function<void(void)> > > > theSideEffects;
+
+	// The nodes with an entity which passed the frustum culling in the last Render
+	mutable std::vector<int> theVisibleNodes;
 };
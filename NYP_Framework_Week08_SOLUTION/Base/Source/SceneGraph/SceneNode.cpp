@@ -1,20 +1,49 @@
 #include "SceneNode.h"
 #include "../EntityManager.h"
+#include "SlabAllocator.h"
 #include <algorithm>
 
 #include "SceneGraph.h"
+#include "Animation.h"
 #include "GraphicsManager.h"
 #include "../GenericEntity.h"
+#include "../OcclusionCulling/OcclusionCulling.h"
+
+// The pool which all the Scene Nodes are allocated from
+static SlabAllocator<CSceneNode> theNodePool;
 
 CSceneNode::CSceneNode(void)
 	: ID(-1)
 	, theEntity(NULL)
 	, theParent(NULL)
+	, flatIndex(-1)
+	, animationIndex(-1)
+	, bPendingDelete(false)
 {
 }
 
 CSceneNode::~CSceneNode()
 {
+	// Stop the animation, so CAnimator does not keep a pointer to this node
+	if (animationIndex >= 0)
+		CAnimator::GetInstance()->Stop(this);
+}
+
+// Scene Nodes are allocated from a pool of slabs instead of the heap
+void* CSceneNode::operator new(size_t size)
+{
+	// A derived class does not fit into the pool's blocks
+	if (size != sizeof(CSceneNode))
+		return ::operator new(size);
+	return theNodePool.Allocate();
+}
+
+void CSceneNode::operator delete(void* p, size_t size)
+{
+	if (size != sizeof(CSceneNode))
+		::operator delete(p);
+	else
+		theNodePool.Free(p);
 }
 
 // Release all memory for this node and its children
@@ -25,6 +54,7 @@ void CSceneNode::Destroy(void)
 	for (it = theChildren.begin(); it != theChildren.end(); ++it)
 	{
 		(*it)->Destroy();
+		CSceneGraph::GetInstance()->UnregisterNode(*it);
 		delete *it;
 		theChildren.erase(it);
 	}
@@ -87,8 +117,12 @@ CSceneNode* CSceneNode::AddChild(EntityBase* theEntity)
 		aNewNode->SetParent(this);
 		// Assign an ID to this node
 		aNewNode->SetID(CSceneGraph::GetInstance()->GenerateID());
+		// Add this node to the Scene Graph's lookup indices
+		CSceneGraph::GetInstance()->RegisterNode(aNewNode);
 		// Add to vector list
 		this->theChildren.push_back(aNewNode);
+		// The flattened scene graph needs to be rebuilt
+		CSceneGraph::GetInstance()->SetHierarchyChanged();
 		// Return this new scene node
 		return aNewNode;
 	}
@@ -114,9 +148,11 @@ bool CSceneNode::DeleteChild(EntityBase* theEntity)
 					cout << "CSceneNode::DeleteChild: Deleted child nodes for theEntity." << endl;
 				}
 				(*it)->GetEntity()->SetIsDone(true);
+				CSceneGraph::GetInstance()->UnregisterNode(*it);
 				delete *it;
 				it = theChildren.erase(it);
 			}
+			CSceneGraph::GetInstance()->SetHierarchyChanged();
 		}
 		return true;	// return true to say that this Node contains theEntity
 	}
@@ -134,8 +170,10 @@ bool CSceneNode::DeleteChild(EntityBase* theEntity)
 					// If DeleteChild method call above DID remove theEntity
 					// Then we should proceed to removed this child from our vector of children
 					(*it)->GetEntity()->SetIsDone(true);
+					CSceneGraph::GetInstance()->UnregisterNode(*it);
 					delete *it;
 					theChildren.erase(it);
+					CSceneGraph::GetInstance()->SetHierarchyChanged();
 					//break;	// Stop deleting since we have already found and deleted theEntity
 					return true;
 				}
@@ -164,9 +202,11 @@ bool CSceneNode::DeleteChild(const int ID)
 					cout << "CSceneNode::DeleteChild: Deleted child nodes for ID=" << ID << endl;
 				}
 				(*it)->GetEntity()->SetIsDone(true);
+				CSceneGraph::GetInstance()->UnregisterNode(*it);
 				delete *it;
 				it = theChildren.erase(it);
 			}
+			CSceneGraph::GetInstance()->SetHierarchyChanged();
 		}
 		return true;	// return true to say that this Node contains theEntity
 	}
@@ -184,8 +224,10 @@ bool CSceneNode::DeleteChild(const int ID)
 					// If DeleteChild method call above DID remove theEntity
 					// Then we should proceed to removed this child from our vector of children
 					(*it)->GetEntity()->SetIsDone(true);
+					CSceneGraph::GetInstance()->UnregisterNode(*it);
 					delete *it;
 					theChildren.erase(it);
+					CSceneGraph::GetInstance()->SetHierarchyChanged();
 					//break;	// Stop deleting since we have already found and deleted theEntity
 					return true;
 				}
@@ -200,18 +242,20 @@ bool CSceneNode::DeleteAllChildren(void)
 {
 	bool bResult = false;
 
+	// Delete all the children, then clear the vector once instead of erasing them one by one
 	vector <CSceneNode*>::iterator it = theChildren.begin();
 	while (it != theChildren.end())
 	{
-		if ((*it)->DeleteAllChildren())
-		{
-			cout << "CSceneNode::DeleteChild: Delete child nodes." << endl;
-		}
+		(*it)->DeleteAllChildren();
 		(*it)->GetEntity()->SetIsDone(true);
+		CSceneGraph::GetInstance()->UnregisterNode(*it);
 		delete *it;
-		it = theChildren.erase(it);
+		++it;
 		bResult = true;
 	}
+	theChildren.clear();
+	if (bResult)
+		CSceneGraph::GetInstance()->SetHierarchyChanged();
 	return bResult;
 }
 // Detach a child from this node using the pointer to the node
@@ -229,6 +273,8 @@ CSceneNode* CSceneNode::DetachChild(EntityBase* theEntity)
 				{
 					// Remove this node from the children
 					theChildren.erase(it);
+					CSceneGraph::GetInstance()->UnregisterSubtree(theNode);
+					CSceneGraph::GetInstance()->SetHierarchyChanged();
 					return theNode;
 				}
 			}
@@ -256,6 +302,8 @@ CSceneNode* CSceneNode::DetachChild(const int ID)
 				{
 					// Remove this node from the children
 					theChildren.erase(it);
+					CSceneGraph::GetInstance()->UnregisterSubtree(theNode);
+					CSceneGraph::GetInstance()->SetHierarchyChanged();
 					return theNode;
 				}
 			}
@@ -264,6 +312,39 @@ CSceneNode* CSceneNode::DetachChild(const int ID)
 	}
 	return NULL;
 }
+// Remove a direct child from this node, without deleting it
+bool CSceneNode::RemoveChild(CSceneNode* theChild)
+{
+	vector <CSceneNode*>::iterator it = std::find(theChildren.begin(), theChildren.end(), theChild);
+	if (it == theChildren.end())
+		return false;
+
+	theChildren.erase(it);
+	theChild->SetParent(NULL);
+	CSceneGraph::GetInstance()->SetHierarchyChanged();
+	return true;
+}
+// Remove all the children which are pending deletion in one pass, without deleting them
+void CSceneNode::RemovePendingChildren(void)
+{
+	vector <CSceneNode*>::iterator it = std::remove_if(theChildren.begin(), theChildren.end(),
+		[](CSceneNode* theChild) { return theChild->IsPendingDelete(); });
+	if (it == theChildren.end())
+		return;
+
+	theChildren.erase(it, theChildren.end());
+	CSceneGraph::GetInstance()->SetHierarchyChanged();
+}
+// Set if this node is queued for deletion
+void CSceneNode::SetPendingDelete(const bool bPendingDelete)
+{
+	this->bPendingDelete = bPendingDelete;
+}
+// Return true if this node is queued for deletion
+bool CSceneNode::IsPendingDelete(void) const
+{
+	return bPendingDelete;
+}
 // Get the entity inside this Scene Graph
 CSceneNode* CSceneNode::GetEntity(EntityBase* theEntity)
 {
@@ -323,139 +404,41 @@ int CSceneNode::GetNumOfChild(void)
 	return NumOfChild;
 }
 
-// Recalculate the AABB (to be called by Scene Graph only)
-void CSceneNode::ReCalc_AABB(void)
+// Get the direct children of this node
+const vector<CSceneNode*>& CSceneNode::GetChildren(void) const
 {
-	if (!theEntity)
-	{
-		cout << "ReCalc_AABB: theRoot start" << endl;
-		// If this Scene Node is the root, then just iterate through all the children
-		vector <CSceneNode*>::iterator it = theChildren.begin();
-		while (it != theChildren.end())
-		{
-			(*it)->ReCalc_AABB();
-			it++;
-		}
-		cout << "ReCalc_AABB: theRoot end" << endl;
-	}
-	else
-	{
-		cout << "\tReCalc_AABB: first tier scene node START" << endl;
-		Vector3 theEntityPosition, theMaxAABB, theMinAABB;
-
-		// Get the AABB of the entity in this Scene Node
-		GenericEntity* theGenericEntity = dynamic_cast<GenericEntity*>(theEntity);
-		theGenericEntity->GetAABB(theMaxAABB, theMinAABB);
-		theEntityPosition = theGenericEntity->GetPosition();
-		cout << "\t\tBEFORE" << theEntityPosition + theMaxAABB << ", " << theEntityPosition + theMinAABB << endl;
-
-		// Compare the children's AABB against this
-		//Vector3 theChildPosition, theChildMaxAABB, theChildMinAABB;
-		vector <CSceneNode*>::iterator it = theChildren.begin();
-		while (it != theChildren.end())
-		{
-			// Get the AABB for this child
-			(*it)->ReCalc_AABB(theEntityPosition, theMaxAABB, theMinAABB);
-
-			// Go to the next child
-			it++;
-		}
+	return theChildren;
+}
 
-		// Update the entity's AABB to include the children's AABB
-		theGenericEntity->SetAABB(theMaxAABB, theMinAABB);
-		cout << "\t\tAFTER" << theEntityPosition + theMaxAABB << ", " << theEntityPosition + theMinAABB << endl;
-		cout << "\tReCalc_AABB: first tier scene node END" << endl;
-	}
+// Set the index of this node in the flattened scene graph
+void CSceneNode::SetFlatIndex(const int flatIndex)
+{
+	this->flatIndex = flatIndex;
 }
 
-// Recalculate the AABB (for Scene Nodes with Entity in it only)
-void CSceneNode::ReCalc_AABB(Vector3 theParentPosition, Vector3& MaxAABB, Vector3& MinAABB)
+// Get the index of this node in the flattened scene graph
+int CSceneNode::GetFlatIndex(void) const
 {
-	// If this Scene Node has an entity
-	// This should not be an issue as there should not be any root node at this point
-	if (theEntity)
-	{
-		cout << "\t\tReCalc_AABB: child scene node START" << endl;
-		Vector3 theEntityPosition, theMaxAABB, theMinAABB;
-
-		// Get the AABB of the entity in this Scene Node
-		GenericEntity* theGenericEntity = dynamic_cast<GenericEntity*>(theEntity);
-		theGenericEntity->GetAABB(theMaxAABB, theMinAABB);
-		Vector3 theOffsetFromParent;
-		GetTranslate(theOffsetFromParent.x, theOffsetFromParent.y, theOffsetFromParent.z);
-		theEntityPosition = theParentPosition + theOffsetFromParent;// theGenericEntity->GetPosition();
-		cout << "\t\t\tThis was passed in " << theParentPosition  << ", " << MaxAABB << ", " << MinAABB << endl;
-		cout << "\t\t\tThis is the parent's AABB: " << theParentPosition + MaxAABB << ", " << theParentPosition + MinAABB << endl;
-		cout << "\t\t\tThis is the child's AABB: " << theEntityPosition + theMaxAABB << ", " << theEntityPosition + theMinAABB << endl;
-
-		// Check if the entity's AABB is larger than the parent
-		// If yes, then set the entity's AABB to the parent'sAABB
-		if (theEntityPosition.x + theMaxAABB.x > theParentPosition.x + MaxAABB.x)
-			MaxAABB.x = (theEntityPosition + theMaxAABB).x - theParentPosition.x;
-		if (theEntityPosition.y + theMaxAABB.y > theParentPosition.y + MaxAABB.y)
-			MaxAABB.y = (theEntityPosition + theMaxAABB).y - theParentPosition.y;
-		if (theEntityPosition.z + theMaxAABB.z > theParentPosition.z + MaxAABB.z)
-			MaxAABB.z = (theEntityPosition + theMaxAABB).z - theParentPosition.z;
-		if (theEntityPosition.x + theMinAABB.x < theParentPosition.x + MinAABB.x)
-			MinAABB.x = (theEntityPosition + theMinAABB).x - theParentPosition.x;
-		if (theEntityPosition.y + theMinAABB.y < theParentPosition.y + MinAABB.y)
-			MinAABB.y = (theEntityPosition + theMinAABB).x - theParentPosition.y;
-		if (theEntityPosition.z + theMinAABB.z < theParentPosition.z + MinAABB.z)
-			MinAABB.z = (theEntityPosition + theMinAABB).z - theParentPosition.z;
-
-		cout << "\t\t\tThis was the parent's AABB after adding in the child's" << theParentPosition + MaxAABB << ", " << theParentPosition + MinAABB << endl;
-
-		// Check the children of this Scene Node
-		//Vector3 theChildPosition, theChildMaxAABB, theChildMinAABB;
-		vector <CSceneNode*>::iterator it = theChildren.begin();
-		while (it != theChildren.end())
-		{
-			// Get the AABB for this child
-			(*it)->ReCalc_AABB(theEntityPosition, theMaxAABB, theMinAABB);
+	return flatIndex;
+}
 
-			// Go to the next child
-			it++;
-		}
+// Set the index of this node in CAnimator's arrays
+void CSceneNode::SetAnimationIndex(const int animationIndex)
+{
+	this->animationIndex = animationIndex;
+}
 
-		// Check if the entity's AABB is larger than the parent
-		// If yes, then set the entity's AABB to the parent'sAABB
-		if (theEntityPosition.x + theMaxAABB.x > theParentPosition.x + MaxAABB.x)
-			MaxAABB.x = (theEntityPosition + theMaxAABB).x - theParentPosition.x;
-		if (theEntityPosition.y + theMaxAABB.y > theParentPosition.y + MaxAABB.y)
-			MaxAABB.y = (theEntityPosition + theMaxAABB).y - theParentPosition.y;
-		if (theEntityPosition.z + theMaxAABB.z > theParentPosition.z + MaxAABB.z)
-			MaxAABB.z = (theEntityPosition + theMaxAABB).z - theParentPosition.z;
-		if (theEntityPosition.x + theMinAABB.x < theParentPosition.x + MinAABB.x)
-			MinAABB.x = (theEntityPosition + theMinAABB).x - theParentPosition.x;
-		if (theEntityPosition.y + theMinAABB.y < theParentPosition.y + MinAABB.y)
-			MinAABB.y = (theEntityPosition + theMinAABB).y - theParentPosition.y;
-		if (theEntityPosition.z + theMinAABB.z < theParentPosition.z + MinAABB.z)
-			MinAABB.z = (theEntityPosition + theMinAABB).z - theParentPosition.z;
-
-		// Update the entity's AABB to include the children's AABB
-		theGenericEntity->SetAABB(theMaxAABB, theMinAABB);
-		cout << "\t\t\tAFTER" << theEntityPosition + theMaxAABB << ", " << theEntityPosition + theMinAABB << endl;
-		cout << "\t\tReCalc_AABB: child scene node END" << endl;
-	}
+// Get the index of this node in CAnimator's arrays, or -1 if it is not animated
+int CSceneNode::GetAnimationIndex(void) const
+{
+	return animationIndex;
 }
 
 // Update the Scene Graph
 void CSceneNode::Update(const float dt)
 {
-	// Update the Transformation between this node and its children
-	if (theUpdateTransformation)
-	{
-		ApplyTransform(GetUpdateTransform());
-	}
-
-	if (theEntity)
-	{
-		// Update this Scene Node
-		theEntity->Update(dt);
-	}
-
-	// Count the number of children in this node
-	int NumOfChild = theChildren.size();
+	// Update this Scene Node
+	UpdateSelf(dt);
 
 	// Update the children
 	std::vector<CSceneNode*>::iterator it;
@@ -479,8 +462,7 @@ void CSceneNode::Render(void)
 									theEntity->GetPosition().z);
 			modelStack.MultMatrix(GetTransform());
 
-			// Render the entity
-			theEntity->Render();
+			RenderSelf();
 		}
 
 		// Render the children
@@ -493,6 +475,38 @@ void CSceneNode::Render(void)
 	modelStack.PopMatrix();
 }
 
+// Update this node only, without its children
+void CSceneNode::UpdateSelf(const float dt)
+{
+	// Update the Transformation between this node and its children
+	if (theUpdateTransformation)
+	{
+		ApplyTransform(GetUpdateTransform());
+	}
+
+	if (theEntity)
+	{
+		// Update this Scene Node
+		theEntity->Update(dt);
+	}
+}
+
+// Render this node's entity only, with its transformation already on the model stack
+void CSceneNode::RenderSelf(void)
+{
+	if (theEntity == NULL)
+		return;
+
+	// Render the entity if it is not hidden behind the occluders
+	MS& modelStack = GraphicsManager::GetInstance()->GetModelStack();
+	CCollider* theCollider = dynamic_cast<CCollider*>(theEntity);
+	if ((theEntity->HasCollider() == false) || (theCollider == NULL) ||
+		(COcclusionCulling::GetInstance()->IsBoxVisible(modelStack.Top(), theCollider->GetMinAABB(), theCollider->GetMaxAABB())))
+	{
+		theEntity->Render();
+	}
+}
+
 // PrintSelf for debug purposes
 void CSceneNode::PrintSelf(const int numTabs)
 {
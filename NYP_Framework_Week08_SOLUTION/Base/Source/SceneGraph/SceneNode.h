@@ -13,6 +13,10 @@ public:
 	CSceneNode(void);
 	virtual ~CSceneNode();
 
+	// Scene Nodes are allocated from a pool of slabs instead of the heap
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 	// Release all memory for this node and its children
 	void Destroy(void);
 
@@ -43,20 +47,41 @@ public:
 	CSceneNode* DetachChild(EntityBase* theEntity = NULL);
 	// Detach a child from this node using its ID
 	CSceneNode* DetachChild(const int ID);
+	// Remove a direct child from this node, without deleting it
+	bool RemoveChild(CSceneNode* theChild);
+	// Remove all the children which are pending deletion in one pass, without deleting them
+	void RemovePendingChildren(void);
+	// Set if this node is queued for deletion
+	void SetPendingDelete(const bool bPendingDelete);
+	// Return true if this node is queued for deletion
+	bool IsPendingDelete(void) const;
 	// Get the entity inside this Scene Graph
 	CSceneNode* GetEntity(EntityBase* theEntity);
 	// Get a child from this node using its ID
 	CSceneNode* GetEntity(const int ID);
 	// Return the number of children in this group
 	int GetNumOfChild(void);
-	// Recalculate the AABB (to be called by Scene Graph only)
-	void ReCalc_AABB(void);
+	// Get the direct children of this node
+	const vector<CSceneNode*>& GetChildren(void) const;
+	// Set the index of this node in the flattened scene graph
+	void SetFlatIndex(const int flatIndex);
+	// Get the index of this node in the flattened scene graph
+	int GetFlatIndex(void) const;
+	// Set the index of this node in CAnimator's arrays
+	void SetAnimationIndex(const int animationIndex);
+	// Get the index of this node in CAnimator's arrays, or -1 if it is not animated
+	int GetAnimationIndex(void) const;
 
 	// Update the Scene Graph
 	void Update(const float dt);
 	// Render the Scene Graph
 	void Render(void);
 
+	// Update this node only, without its children
+	void UpdateSelf(const float dt);
+	// Render this node's entity only, with its transformation already on the model stack
+	void RenderSelf(void);
+
 	// PrintSelf for debug purposes
 	void PrintSelf(const int numTabs = 0);
 
@@ -64,9 +89,12 @@ protected:
 	int			ID;
 	EntityBase* theEntity;
 	CSceneNode* theParent;
+	// Index in the flattened scene graph
+	int			flatIndex;
+	// Index in CAnimator's arrays
+	int			animationIndex;
+	// Set when this node is queued for deletion
+	bool		bPendingDelete;
 
 	vector<CSceneNode*> theChildren;
-
-	// Recalculate the AABB
-	void ReCalc_AABB(Vector3 theParentPosition, Vector3& MaxAABB, Vector3& MinAABB);
 };
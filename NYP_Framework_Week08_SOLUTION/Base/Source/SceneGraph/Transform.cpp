@@ -5,16 +5,22 @@ using namespace std;
 
 // Default Constructor
 CTransform::CTransform(void)
-	: theUpdateTransformation(NULL)
+	: theTranslate(0.0f, 0.0f, 0.0f)
+	, theScale(1.0f, 1.0f, 1.0f)
+	, bMatrixDirty(true)
+	, theUpdateTransformation(NULL)
+	, m_bDirty(true)
 {
-	Mtx.SetToIdentity();
-	DefaultMtx.SetToIdentity();
 }
 
 // Overloaded Constructor
 CTransform::CTransform(const float dx, const float dy, const float dz)
+	: theTranslate(dx, dy, dz)
+	, theScale(1.0f, 1.0f, 1.0f)
+	, bMatrixDirty(true)
+	, theUpdateTransformation(NULL)
+	, m_bDirty(true)
 {
-	Mtx.SetToTranslation(dx, dy, dz);
 }
 
 // Destructor
@@ -30,38 +36,40 @@ CTransform::~CTransform(void)
 // Apply a translation to the Transformation Matrix
 void CTransform::ApplyTranslate(const float dx, const float dy, const float dz)
 {
-	Mtx44 TempMtx;
-	TempMtx.SetToTranslation(dx, dy, dz);
-	Mtx = Mtx*TempMtx;
+	// The translation is applied before the rotation and scale, so it is rotated and scaled
+	Vector3 theScaledTranslate(dx * theScale.x, dy * theScale.y, dz * theScale.z);
+	theTranslate += theRotation * theScaledTranslate;
+	bMatrixDirty = true;
+	m_bDirty = true;
 }
 // Get the translation from the Transformation Matrix
 void CTransform::GetTranslate(float& x, float& y, float& z)
 {
-	x = Mtx.a[12];
-	y = Mtx.a[13];
-	z = Mtx.a[14];
+	x = theTranslate.x;
+	y = theTranslate.y;
+	z = theTranslate.z;
 }
 // Get the x-axis translation from the Transformation Matrix
 float CTransform::GetTranslate_X(void) const
 {
-	return Mtx.a[12];
+	return theTranslate.x;
 }
 // Get the y-axis translation from the Transformation Matrix
 float CTransform::GetTranslate_Y(void) const
 {
-	return Mtx.a[13];
+	return theTranslate.y;
 }
 // Get the z-axis translation from the Transformation Matrix
 float CTransform::GetTranslate_Z(void) const
 {
-	return Mtx.a[14];
+	return theTranslate.z;
 }
 // Set the translation
 void CTransform::SetTranslate(float x, float y, float z)
 {
-	Mtx.a[12] = x;
-	Mtx.a[13] = y;
-	Mtx.a[14] = z;
+	theTranslate.Set(x, y, z);
+	bMatrixDirty = true;
+	m_bDirty = true;
 }
 // Set the translation
 void CTransform::SetTranslate(Vector3 theTranslateVector)
@@ -71,48 +79,36 @@ void CTransform::SetTranslate(Vector3 theTranslateVector)
 // Apply a rotation to the Transformation Matrix
 void CTransform::ApplyRotate(const float angle, const float rx, const float ry, const float rz)
 {
-	Mtx44 TempMtx;
-	TempMtx.SetToRotation(angle, rx, ry, rz);
-	Mtx = Mtx*TempMtx;
+	// The rotation is applied before the scale. This is exact when the scale is the same on all the axes
+	Quaternion theNewRotation;
+	theNewRotation.SetToRotation(angle, rx, ry, rz);
+	theRotation = (theRotation * theNewRotation).Normalize();
+	bMatrixDirty = true;
+	m_bDirty = true;
 }
-// Get the rotation from the Transformation Matrix
+// Get the rotation about an axis in degrees
 float CTransform::GetRotate(const AXIS theAxis) const
 {
+	float component = theRotation.z;
 	if (theAxis == X_AXIS)
-	{
-		float y = acos(Mtx.a[5]);	// Equals to cos a
-		float z = asin(-Mtx.a[9]);	// Equals to sin a
-
-		if (abs(y - z) < Math::EPSILON)
-			return y;
-		else
-		{
-			// This Matrix is wrong!
-		}
-	}
+		component = theRotation.x;
 	else if (theAxis == Y_AXIS)
-	{
-		float x = acos(Mtx.a[0]);	// Equals to cos a
-		float z = asin(Mtx.a[8]);	// Equals to -sin a
-		if (abs(x - z) < Math::EPSILON)
-			return x;
-		else
-		{
-			// This Matrix is wrong!
-		}
-	}
-	else // Z_AXIS
-	{
-		float x = acos(Mtx.a[0]);	// Equals to cos a
-		float y = asin(-Mtx.a[4]);	// Equals to -sin a
-		if (abs(x - y) < Math::EPSILON)
-			return x;
-		else
-		{
-			// This Matrix is wrong!
-		}
-	}
-	return 0.0f;
+		component = theRotation.y;
+
+	return Math::RadianToDegree(2.0f * atan2(component, theRotation.w));
+}
+// Set the rotation
+void CTransform::SetRotation(const Quaternion& theRotation)
+{
+	this->theRotation = theRotation;
+	this->theRotation.Normalize();
+	bMatrixDirty = true;
+	m_bDirty = true;
+}
+// Get the rotation
+Quaternion CTransform::GetRotation(void) const
+{
+	return theRotation;
 }
 // Set the scale of the Transformation Matrix
 void CTransform::SetScale(const float sx, const float sy, const float sz)
@@ -125,7 +121,9 @@ void CTransform::SetScale(const float sx, const float sy, const float sz)
 	if (scaleZ == 0.0f)
 		scaleZ = 1.0f;
 
-	Mtx.SetToScale(scaleX, scaleY, scaleZ);
+	theScale.Set(scaleX, scaleY, scaleZ);
+	bMatrixDirty = true;
+	m_bDirty = true;
 }
 // Set the scale of the Transformation Matrix
 void CTransform::SetScale(Vector3 theScaleVector)
@@ -135,47 +133,72 @@ void CTransform::SetScale(Vector3 theScaleVector)
 // Get the scale from the Transformation Matrix
 void CTransform::GetScale(float& x, float& y, float& z) const
 {
-	x = Mtx.a[0];
-	y = Mtx.a[5];
-	z = Mtx.a[10];
+	x = theScale.x;
+	y = theScale.y;
+	z = theScale.z;
 }
 // Get the x-axis scale from the Transformation Matrix
 float CTransform::GetScale_X(void) const
 {
-	return Mtx.a[0];
+	return theScale.x;
 }
 // Get the y-axis scale from the Transformation Matrix
 float CTransform::GetScale_Y(void) const
 {
-	return Mtx.a[5];
+	return theScale.y;
 }
 // Get the z-axis scale from the Transformation Matrix
 float CTransform::GetScale_Z(void) const
 {
-	return Mtx.a[10];
+	return theScale.z;
 }
 // Apply a Transformation Matrix to the Transformation Matrix here
 void CTransform::ApplyTransform(Mtx44 newMTX)
 {
-	Mtx = Mtx * newMTX;
+	SetTransform(GetTransform() * newMTX);
+}
+// Set the translation, rotation and scale from a Transformation Matrix without shear
+void CTransform::SetTransform(const Mtx44& theMatrix)
+{
+	Decompose(theMatrix, theTranslate, theRotation, theScale);
+	bMatrixDirty = true;
+	m_bDirty = true;
 }
 
 // Reset the transformation matrix to identity matrix
 void CTransform::Reset(void)
 {
-	Mtx.SetToIdentity();
+	theTranslate.SetZero();
+	theRotation.SetToIdentity();
+	theScale.Set(1.0f, 1.0f, 1.0f);
+	bMatrixDirty = true;
+	m_bDirty = true;
 }
 
 // Get the transformation matrix
 Mtx44 CTransform::GetTransform(void) const
 {
+	if (bMatrixDirty)
+	{
+		Mtx = Compose(theTranslate, theRotation, theScale);
+		bMatrixDirty = false;
+	}
 	return Mtx;
 }
 
 // Get the inverse of the transformation matrix
 Mtx44 CTransform::GetInverseTransform(void) const
 {
-	return Mtx.GetInverse();
+	if ((Math::FAbs(theScale.x) < Math::EPSILON) ||
+		(Math::FAbs(theScale.y) < Math::EPSILON) ||
+		(Math::FAbs(theScale.z) < Math::EPSILON))
+		throw DivideByZero();
+
+	// (T * R * S)^-1 = S^-1 * R^-1 * T^-1
+	Mtx44 theInverseScale, theInverseTranslate;
+	theInverseScale.SetToScale(1.0f / theScale.x, 1.0f / theScale.y, 1.0f / theScale.z);
+	theInverseTranslate.SetToTranslation(-theTranslate.x, -theTranslate.y, -theTranslate.z);
+	return theInverseScale * theRotation.Conjugate().ToMatrix() * theInverseTranslate;
 }
 
 // Set the Update Transformation
@@ -187,8 +210,12 @@ void CTransform::SetUpdateTransformation(CUpdateTransformation* theUpdateTransfo
 // Get the update transformation matrix
 Mtx44 CTransform::GetUpdateTransform(void) const
 {
+	Mtx44 theUpdateMtx;
 	if (theUpdateTransformation == NULL)
-		return DefaultMtx;
+	{
+		theUpdateMtx.SetToIdentity();
+		return theUpdateMtx;
+	}
 
 	// Update theUpdateTransformation
 	theUpdateTransformation->Update();
@@ -196,9 +223,22 @@ Mtx44 CTransform::GetUpdateTransform(void) const
 	return theUpdateTransformation->GetUpdateTransformation();
 }
 
+// Return true if the transformation matrix was changed since the dirty flag was cleared
+bool CTransform::IsDirty(void) const
+{
+	return m_bDirty;
+}
+
+// Set or clear the dirty flag
+void CTransform::SetDirty(const bool bDirty)
+{
+	m_bDirty = bDirty;
+}
+
 // Print Self
 void CTransform::PrintSelf(void) const
 {
+	Mtx44 Mtx = GetTransform();
 	cout << "======================================================================" << endl;
 	cout << "CTransform::PrintSelf" << endl;
 	cout << "----------------------------------------------------------------------" << endl;
@@ -208,3 +248,43 @@ void CTransform::PrintSelf(void) const
 	cout << "[\t" << Mtx.a[ 3] << "\t" << Mtx.a[ 7] << "\t" << Mtx.a[11] << "\t" << Mtx.a[15] << "\t]" << endl;
 	cout << "======================================================================" << endl;
 }
+
+// Compose a Transformation Matrix, translate * rotate * scale
+Mtx44 CTransform::Compose(const Vector3& theTranslate, const Quaternion& theRotation, const Vector3& theScale)
+{
+	// Scale the columns of the rotation matrix, then put in the translation
+	Mtx44 result = theRotation.ToMatrix();
+	for (int row = 0; row < 3; ++row)
+	{
+		result.a[row] *= theScale.x;
+		result.a[4 + row] *= theScale.y;
+		result.a[8 + row] *= theScale.z;
+	}
+	result.a[12] = theTranslate.x;
+	result.a[13] = theTranslate.y;
+	result.a[14] = theTranslate.z;
+	return result;
+}
+
+// Split a Transformation Matrix without shear into a translation, a rotation and a scale
+void CTransform::Decompose(const Mtx44& theMatrix, Vector3& theTranslate, Quaternion& theRotation, Vector3& theScale)
+{
+	theTranslate.Set(theMatrix.a[12], theMatrix.a[13], theMatrix.a[14]);
+
+	// The scale is the length of each column
+	Vector3 column0(theMatrix.a[0], theMatrix.a[1], theMatrix.a[2]);
+	Vector3 column1(theMatrix.a[4], theMatrix.a[5], theMatrix.a[6]);
+	Vector3 column2(theMatrix.a[8], theMatrix.a[9], theMatrix.a[10]);
+	theScale.Set(column0.Length(), column1.Length(), column2.Length());
+
+	// A mirrored matrix is stored as a negative x scale, so the rotation stays a proper rotation
+	Mtx44 theRotationMatrix = theMatrix;
+	if (column0.Cross(column1).Dot(column2) < 0.0f)
+	{
+		theScale.x = -theScale.x;
+		theRotationMatrix.a[0] = -theRotationMatrix.a[0];
+		theRotationMatrix.a[1] = -theRotationMatrix.a[1];
+		theRotationMatrix.a[2] = -theRotationMatrix.a[2];
+	}
+	theRotation.SetFromMatrix(theRotationMatrix);
+}
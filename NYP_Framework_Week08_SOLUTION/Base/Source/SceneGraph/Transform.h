@@ -1,7 +1,12 @@
 ﻿#pragma once
 #include "Mtx44.h"
+#include "Vector3.h"
+#include "Quaternion.h"
 #include "UpdateTransformation.h"
 
+// A transformation stored as a translation, a rotation and a scale.
+// The matrix, translate * rotate * scale, is only composed again when it is needed after a change.
+
 class CTransform
 {
 public:
@@ -36,8 +41,12 @@ public:
 	void SetTranslate(Vector3 theTranslateVector);
 	// Apply a rotation to the Transformation Matrix
 	void ApplyRotate(const float angle, const float rx, const float ry, const float rz);
-	// Get the rotation from the Transformation Matrix
+	// Get the rotation about an axis in degrees. This is exact when the rotation is about that axis only
 	float GetRotate(const AXIS theAxis) const;
+	// Set the rotation
+	void SetRotation(const Quaternion& theRotation);
+	// Get the rotation
+	Quaternion GetRotation(void) const;
 	// Set the scale of the Transformation Matrix
 	void SetScale(const float sx, const float sy, const float sz);
 	// Set the scale of the Transformation Matrix
@@ -53,6 +62,8 @@ public:
 
 	// Apply a Transformation Matrix to the Transformation Matrix here
 	void ApplyTransform(Mtx44 newMTX);
+	// Set the translation, rotation and scale from a Transformation Matrix without shear
+	void SetTransform(const Mtx44& theMatrix);
 
 	// Reset the transformation matrix to identity matrix
 	void Reset (void); //reset to identity
@@ -66,10 +77,27 @@ public:
 	// Get the update transformation matrix
 	Mtx44 GetUpdateTransform(void) const;
 
+	// Return true if the transformation matrix was changed since the dirty flag was cleared
+	bool IsDirty(void) const;
+	// Set or clear the dirty flag
+	void SetDirty(const bool bDirty = true);
+
 	// Print Self
 	void PrintSelf(void) const;
 
+	// Compose a Transformation Matrix, translate * rotate * scale
+	static Mtx44 Compose(const Vector3& theTranslate, const Quaternion& theRotation, const Vector3& theScale);
+	// Split a Transformation Matrix without shear into a translation, a rotation and a scale
+	static void Decompose(const Mtx44& theMatrix, Vector3& theTranslate, Quaternion& theRotation, Vector3& theScale);
+
 protected:
-	Mtx44 Mtx, DefaultMtx;
+	Vector3 theTranslate;
+	Quaternion theRotation;
+	Vector3 theScale;
+	// The composed matrix, and whether it needs to be composed again
+	mutable Mtx44 Mtx;
+	mutable bool bMatrixDirty;
 	CUpdateTransformation* theUpdateTransformation;
+	// Set whenever Mtx is changed
+	bool m_bDirty;
 };
@@ -6,6 +6,8 @@
 #include "Application.h"
 #include "Utility.h"
 #include "LoadTGA.h"
+#include "FontData.h"
+#include "SpriteBatch.h"
 #include "KeyboardController.h"
 #include "MouseController.h"
 #include "SceneManager.h"
@@ -13,7 +15,9 @@
 #include "ShaderProgram.h"
 #include "EntityManager.h"
 #include "RenderHelper.h"
+#include "RenderQueue.h"
 #include "FPSCounter.h"
+#include "RenderStats.h"
 
 #include "GenericEntity.h"
 #include "GroundEntity.h"
@@ -23,9 +27,13 @@
 #include "SkyBox/SkyBoxEntity.h"
 #include "Minimap\Minimap.h"
 #include "SceneGraph\SceneGraph.h"
-#include "SceneGraph\UpdateTransformation.h"
+#include "SceneGraph\Animation.h"
 #include "SpatialPartition\SpatialPartition.h"
+#include "SpatialPartition\StaticBatch.h"
 #include "FrustumCulling\FrustumCulling.h"
+#include "OcclusionCulling\OcclusionCulling.h"
+#include "LevelOfDetails\LODSelector.h"
+#include "LevelOfDetails\Impostor.h"
 
 #include <iostream>
 using namespace std;
@@ -33,7 +41,8 @@ using namespace std;
 SceneText* SceneText::sInstance = new SceneText(SceneManager::GetInstance());
 
 SceneText::SceneText()
-	: theMinimap(NULL)
+	: bShowStats(false)
+	, theMinimap(NULL)
 	, theCameraEffects(NULL)
 	, theMouse(NULL)
 	, theKeyboard(NULL)
@@ -41,7 +50,8 @@ SceneText::SceneText()
 }
 
 SceneText::SceneText(SceneManager* _sceneMgr)
-	: theMinimap(NULL)
+	: bShowStats(false)
+	, theMinimap(NULL)
 	, theCameraEffects(NULL)
 	, theMouse(NULL)
 	, theKeyboard(NULL)
@@ -75,6 +85,10 @@ SceneText::~SceneText()
 
 	// Delete the scene graph
 	CSceneGraph::GetInstance()->Destroy();
+	// Delete the animation clips
+	CAnimator::GetInstance()->Destroy();
+	// Delete the merged static entities
+	CStaticBatch::GetInstance()->Destroy();
 	// Delete the Spatial Partition
 	CSpatialPartition::GetInstance()->Destroy();
 	// Delete the EntityManager
@@ -85,42 +99,8 @@ void SceneText::Init()
 {
 	currProg = GraphicsManager::GetInstance()->LoadShader("default", "Shader//comg.vertexshader", "Shader//comg.fragmentshader");
 	
-	// Tell the shader program to store these uniform locations
-	currProg->AddUniform("MVP");
-	currProg->AddUniform("MV");
-	currProg->AddUniform("MV_inverse_transpose");
-	currProg->AddUniform("material.kAmbient");
-	currProg->AddUniform("material.kDiffuse");
-	currProg->AddUniform("material.kSpecular");
-	currProg->AddUniform("material.kShininess");
-	currProg->AddUniform("lightEnabled");
-	currProg->AddUniform("numLights");
-	currProg->AddUniform("lights[0].type");
-	currProg->AddUniform("lights[0].position_cameraspace");
-	currProg->AddUniform("lights[0].color");
-	currProg->AddUniform("lights[0].power");
-	currProg->AddUniform("lights[0].kC");
-	currProg->AddUniform("lights[0].kL");
-	currProg->AddUniform("lights[0].kQ");
-	currProg->AddUniform("lights[0].spotDirection");
-	currProg->AddUniform("lights[0].cosCutoff");
-	currProg->AddUniform("lights[0].cosInner");
-	currProg->AddUniform("lights[0].exponent");
-	currProg->AddUniform("lights[1].type");
-	currProg->AddUniform("lights[1].position_cameraspace");
-	currProg->AddUniform("lights[1].color");
-	currProg->AddUniform("lights[1].power");
-	currProg->AddUniform("lights[1].kC");
-	currProg->AddUniform("lights[1].kL");
-	currProg->AddUniform("lights[1].kQ");
-	currProg->AddUniform("lights[1].spotDirection");
-	currProg->AddUniform("lights[1].cosCutoff");
-	currProg->AddUniform("lights[1].cosInner");
-	currProg->AddUniform("lights[1].exponent");
-	currProg->AddUniform("colorTextureEnabled");
-	currProg->AddUniform("colorTexture");
-	currProg->AddUniform("textEnabled");
-	currProg->AddUniform("textColor");
+	// The shader program looks up the uniforms which RenderHelper uses when it is linked,
+	// and the lights are uploaded into buffers by the graphics manager
 	
 	// Tell the graphics manager to use the shader we just loaded
 	GraphicsManager::GetInstance()->SetActiveShader("default");
@@ -147,8 +127,8 @@ void SceneText::Init()
 	lights[1]->color.Set(1, 1, 0.5f);
 	lights[1]->power = 0.4f;
 	lights[1]->name = "lights[1]";
+	lights[1]->enabled = false;
 
-	currProg->UpdateInt("numLights", 1);
 	currProg->UpdateInt("textEnabled", 0);
 	
 	// Create the playerinfo instance, which manages all information about the player
@@ -171,6 +151,7 @@ void SceneText::Init()
 	MeshBuilder::GetInstance()->GetMesh("quad")->textureID = LoadTGA("Image//calibri.tga");
 	MeshBuilder::GetInstance()->GenerateText("text", 16, 16);
 	MeshBuilder::GetInstance()->GetMesh("text")->textureID = LoadTGA("Image//calibri.tga");
+	CFontData::GetInstance()->Load("Image//FontData.csv");
 	MeshBuilder::GetInstance()->GetMesh("text")->material.kAmbient.Set(1, 0, 0);
 	MeshBuilder::GetInstance()->GenerateRing("ring", Color(1, 0, 1), 36, 1, 0.5f);
 	MeshBuilder::GetInstance()->GenerateSphere("lightball", Color(1, 1, 1), 18, 36, 1.f);
@@ -201,30 +182,38 @@ void SceneText::Init()
 	MeshBuilder::GetInstance()->GenerateQuad("GRID_RED", Color(1, 0, 0), 1.f);
 	MeshBuilder::GetInstance()->GenerateRay("laser", 1.0f);
 
-	MeshBuilder::GetInstance()->GenerateOBJ("VASE_HIGH", "Image//Vase_High.obj");
-	MeshBuilder::GetInstance()->GetMesh("VASE_HIGH")->textureID = LoadTGA("Image//chair.tga");
-
-	MeshBuilder::GetInstance()->GenerateOBJ("VASE_MID", "Image//Vase_Mid.obj");
-	MeshBuilder::GetInstance()->GetMesh("VASE_MID")->textureID = LoadTGA("Image//toilet.tga");
-
-	MeshBuilder::GetInstance()->GenerateOBJ("VASE_LOW", "Image//Vase_Low.obj");
-	MeshBuilder::GetInstance()->GetMesh("VASE_LOW")->textureID = LoadTGA("Image//bed.tga");
+	// Generate the 3 LOD levels of the vase from a single OBJ, keeping 100%, 40% and 10% of the triangles
+	MeshBuilder::GetInstance()->GenerateOBJLOD("VASE", "Image//Vase_High.obj", { 1.0f, 0.4f, 0.1f });
+	MeshBuilder::GetInstance()->GetMesh("VASE_LOD0")->textureID = LoadTGA("Image//chair.tga");
+	// The lower levels are left out if the vase cannot be simplified, and then the vase has no LOD
+	if (MeshBuilder::GetInstance()->GetMesh("VASE_LOD1"))
+		MeshBuilder::GetInstance()->GetMesh("VASE_LOD1")->textureID = LoadTGA("Image//toilet.tga");
+	if (MeshBuilder::GetInstance()->GetMesh("VASE_LOD2"))
+		MeshBuilder::GetInstance()->GetMesh("VASE_LOD2")->textureID = LoadTGA("Image//bed.tga");
+	// Pre-render the low details vase into an impostor, which is used beyond the low details
+	CImpostorBuilder::GetInstance()->GenerateImpostor("VASE", "VASE_LOD2", 0.5f);
 
 	// Set up the Spatial Partition and pass it to the EntityManager to manage
 	CSpatialPartition::GetInstance()->Init(100, 100, 10, 10.2);
 	CSpatialPartition::GetInstance()->SetMeshRenderMode(CGrid::FILL);
 	CSpatialPartition::GetInstance()->SetMesh("GRID_YELLOW");
 	CSpatialPartition::GetInstance()->SetCamera(&camera);
-	CSpatialPartition::GetInstance()->SetLevelOfDetails(10000.0f, 160000.0f);
+	CSpatialPartition::GetInstance()->SetLevelOfDetails(1.0f, 0.2f);
 
 	// Initialise the Frustum Culling
 	CFrustumCulling::GetInstance()->Init(45.0f, 4.0f / 3.0f, 0.1f, 10000.0f);
 
+	// Initialise the screen-space LOD selection
+	CLODSelector::GetInstance()->Init(45.0f, Application::GetInstance().GetWindowHeight());
+
+	// Initialise the Occlusion Culling
+	COcclusionCulling::GetInstance()->Init(0.1f);
+
 	// Create entities into the scene
-	Create::Entity("reference", Vector3(0.0f, 0.0f, 0.0f)); // Reference
-	Create::Entity("lightball", Vector3(lights[0]->position.x, lights[0]->position.y, lights[0]->position.z)); // Lightball
+	CStaticBatch::GetInstance()->Add(Create::Entity("reference", Vector3(0.0f, 0.0f, 0.0f))); // Reference
+	CStaticBatch::GetInstance()->Add(Create::Entity("lightball", Vector3(lights[0]->position.x, lights[0]->position.y, lights[0]->position.z))); // Lightball
 	//GenericEntity* aCube = Create::Entity("cube", Vector3(-20.0f, 0.0f, -20.0f));
-	Create::Entity("ring", Vector3(0.0f, 0.0f, 0.0f)); // Reference
+	CStaticBatch::GetInstance()->Add(Create::Entity("ring", Vector3(0.0f, 0.0f, 0.0f))); // Reference
 
 
 	
@@ -247,6 +236,9 @@ void SceneText::Init()
 	// Create entities such as NPC etc
 	this->CreateEntities();
 
+	// Merge the entities which never move, now that the Spatial Partition is set up
+	CStaticBatch::GetInstance()->Build();
+
 	// Setup the 2D entities
 	float halfWindowWidth = Application::GetInstance().GetWindowWidth() / 2.0f;
 	float halfWindowHeight = Application::GetInstance().GetWindowHeight() / 2.0f;
@@ -258,6 +250,13 @@ void SceneText::Init()
 	}
 	textObj[0]->SetText("HELLO WORLD");
 
+	// The render stats overlay, in the top left corner. It is empty until it is shown
+	float statsFontSize = 15.0f;
+	for (int i = 0; i <= CRenderStats::NUM_PASS; ++i)
+	{
+		statsText[i] = Create::Text2DObject("text", Vector3(-halfWindowWidth, halfWindowHeight - statsFontSize*i - statsFontSize / 2.0f, 0.0f), "", Vector3(statsFontSize, statsFontSize, statsFontSize), Color(1.0f, 1.0f, 0.0f));
+	}
+
 	// Hardware Abstraction
 	theKeyboard = new CKeyboard();
 	theKeyboard->Create(playerInfo);
@@ -361,6 +360,10 @@ void SceneText::Update(double dt)
 
 	//camera.Update(dt); // Can put the camera into an entity rather than here (Then we don't have to write this)
 
+	// Toggle the Occlusion Culling. It is updated in Render, from the camera which is attached there
+	if (KeyboardController::GetInstance()->IsKeyPressed('8'))
+		COcclusionCulling::GetInstance()->SetStatus(!COcclusionCulling::GetInstance()->GetStatus());
+
 	// Update the Scene Graph
 	CSceneGraph::GetInstance()->Update((float)dt);
 
@@ -393,6 +396,13 @@ void SceneText::Update(double dt)
 	DisplayText << "Sway:" << playerInfo->m_fCameraSwayAngle;
 	textObj[2]->SetText(DisplayText.str());
 
+	// Toggle the render stats overlay. The stats are from the last frame, and the GPU times from a few frames before
+	if (KeyboardController::GetInstance()->IsKeyPressed(VK_F3))
+		bShowStats = !bShowStats;
+	statsText[0]->SetText(bShowStats ? CRenderStats::GetInstance()->GetFrameSummary() : "");
+	for (int i = 0; i < CRenderStats::NUM_PASS; ++i)
+		statsText[i + 1]->SetText(bShowStats ? CRenderStats::GetInstance()->GetPassSummary((CRenderStats::PASS)i) : "");
+
 
 
 	// Update camera effects
@@ -414,12 +424,19 @@ void SceneText::Render()
 		GraphicsManager::GetInstance()->SetPerspectiveProjection(45.0f, 4.0f / 3.0f, 0.1f, 10000.0f);
 		GraphicsManager::GetInstance()->AttachCamera(&camera2);
 	}
+	GraphicsManager::GetInstance()->UpdateFrameUniforms();
+
+	// Rasterise the occluders from the attached camera, so the occlusion tests match the view being drawn
+	COcclusionCulling::GetInstance()->Update(GraphicsManager::GetInstance()->GetProjectionMatrix() * GraphicsManager::GetInstance()->GetViewMatrix());
 
 	// PreRenderMesh
 	RenderHelper::PreRenderMesh();
+		// Collect the meshes, then draw them sorted by state and depth
+		CRenderQueue::GetInstance()->Begin();
 		EntityManager::GetInstance()->Render();
 		CSceneGraph::GetInstance()->Render();
 		CSpatialPartition::GetInstance()->Render(playerInfo->GetPos(), playerInfo->GetTarget(), playerInfo->GetUp());
+		CRenderQueue::GetInstance()->Flush();
 	// PostRenderMesh
 	RenderHelper::PostRenderMesh();
 
@@ -432,9 +449,15 @@ void SceneText::Render()
 		GraphicsManager::GetInstance()->SetOrthographicProjection(-halfWindowWidth, halfWindowWidth, -halfWindowHeight, halfWindowHeight, -10, 10);
 		GraphicsManager::GetInstance()->DetachCamera();
 
+		// Count and time the 2D entities separately from the 3D passes
+		CRenderStats::GetInstance()->BeginPass(CRenderStats::PASS_UI);
+
 		// PreRenderText
 		RenderHelper::PreRenderText();
 
+			// Collect the sprites, and draw them with as few draw calls as the textures allow
+			CSpriteBatch::GetInstance()->Begin();
+
 			EntityManager::GetInstance()->RenderUI();
 
 			if (KeyboardController::GetInstance()->IsKeyDown('9'))
@@ -445,9 +468,13 @@ void SceneText::Render()
 			// Render Minimap
 			theMinimap->RenderUI();
 
+			CSpriteBatch::GetInstance()->End();
+
 		// PostRenderText
 		RenderHelper::PostRenderText();
 
+		CRenderStats::GetInstance()->EndPass();
+
 	// Disable blend mode
 	glDisable(GL_BLEND);
 }
@@ -479,19 +506,22 @@ void SceneText::CreateEntities(void)
 
 
 
-	GenericEntity* pNPCTorso = Create::Entity("VASE_HIGH", Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f), false);
+	GenericEntity* pNPCTorso = Create::Entity("VASE_LOD0", Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f), false);
 
-	pNPCTorso->InitLOD("VASE_HIGH", "VASE_MID", "VASE_LOW");
+	pNPCTorso->InitLOD("VASE");
 	pNPCTorso->SetCollider(true);
 	pNPCTorso->SetAABB(Vector3(0.45f, 0.45f, 0.45f), Vector3(-0.45f, -0.45f, -0.45f));
 
 	// Add the pointer to the root of the Scene Graph
 	CSceneNode* pNPCSceneNode = CSceneGraph::GetInstance()->AddNode(pNPCTorso);
 	pNPCSceneNode->SetTranslate(Vector3(0.0f, 1.0f, -10.0f));
-	CUpdateTransformation* aRotateMtx = new CUpdateTransformation();
-	aRotateMtx->ApplyUpdate(1.0f, 0, 1, 0);
-	aRotateMtx->SetSteps(-60, 60);
-	pNPCSceneNode->SetUpdateTransformation(aRotateMtx);
+	// Swing the NPC 60 degrees to each side of the front, once every 4 seconds
+	CAnimationClip* aSwingClip = CAnimator::GetInstance()->CreateClip("NPC_SWING");
+	aSwingClip->AddRotationKey(0.0f, 0.0f, Vector3(0, 1, 0));
+	aSwingClip->AddRotationKey(1.0f, 60.0f, Vector3(0, 1, 0));
+	aSwingClip->AddRotationKey(3.0f, -60.0f, Vector3(0, 1, 0));
+	aSwingClip->AddRotationKey(4.0f, 0.0f, Vector3(0, 1, 0));
+	CAnimator::GetInstance()->Play(pNPCSceneNode, aSwingClip);
 
 	// Add the entity into the Spatial Partition
 	CSpatialPartition::GetInstance()->Add(pNPCTorso);
@@ -503,11 +533,11 @@ void SceneText::CreateEntities(void)
 	srand(NULL);
 	for (int i = 0; i < 100; i++)
 	{
-		CEnemy3D* anEnemy3D = Create::Enemy3D("VASE_HIGH",
+		CEnemy3D* anEnemy3D = Create::Enemy3D("VASE_LOD0",
 									Vector3(rand() % 1000 - 500.0f, 0.0f, rand() % 1000 - 500.0f), 
 									Vector3(1.0f, 1.0f, 1.0f), 
 									false);
-		anEnemy3D->InitLOD("VASE_HIGH", "VASE_MID", "VASE_LOW");
+		anEnemy3D->InitLOD("VASE");
 		anEnemy3D->Init();
 		anEnemy3D->SetSpeed(10.0f);
 		anEnemy3D->SetCollider(true);
@@ -523,4 +553,17 @@ void SceneText::CreateEntities(void)
 	}
 
 	CSceneGraph::GetInstance()->ReCalc_AABB();
+	// Update the enemies' subtrees on the thread pool
+	CSceneGraph::GetInstance()->SetParallelUpdate(true);
+
+	// Add some walls to act as occluders
+	Vector3 wallPositions[4] = {	Vector3(0.0f, 0.0f, -60.0f), Vector3(0.0f, 0.0f, 60.0f),
+									Vector3(-60.0f, 0.0f, 0.0f), Vector3(60.0f, 0.0f, 0.0f) };
+	Vector3 wallScales[4] = {	Vector3(80.0f, 20.0f, 2.0f), Vector3(80.0f, 20.0f, 2.0f),
+								Vector3(2.0f, 20.0f, 80.0f), Vector3(2.0f, 20.0f, 80.0f) };
+	for (int i = 0; i < 4; ++i)
+	{
+		CStaticBatch::GetInstance()->Add(Create::Entity("cube", wallPositions[i], wallScales[i]));
+		COcclusionCulling::GetInstance()->AddOccluderBox(wallPositions[i] - wallScales[i] * 0.5f, wallPositions[i] + wallScales[i] * 0.5f);
+	}
 }
\ No newline at end of file
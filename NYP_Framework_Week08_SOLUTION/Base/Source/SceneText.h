@@ -15,6 +15,7 @@
 #include "CameraEffects\CameraEffects.h"
 #include "HardwareAbstraction\Mouse.h"
 #include "SpatialPartition/Grid.h"
+#include "RenderStats.h"
 
 class ShaderProgram;
 class SceneManager;
@@ -45,6 +46,9 @@ private:
 	FPSCamera camera2;
 	ostringstream DisplayText;
 	TextEntity* textObj[4];
+	// The render stats overlay: a line for the whole frame, then a line for each pass
+	TextEntity* statsText[CRenderStats::NUM_PASS + 1];
+	bool bShowStats;
 	Light* lights[2];
 
 
@@ -1,9 +1,11 @@
 #include "Grid.h"
 #include "stdio.h"
 #include "MeshBuilder.h"
+#include "MyMath.h"
 #include "RenderHelper.h"
 #include "../GenericEntity.h"
 #include "../SceneGraph/SceneGraph.h"
+#include "../LevelOfDetails/LODSelector.h"
 
 /********************************************************************************
 Constructor
@@ -116,11 +118,11 @@ void CGrid::Render(void)
 		{
 			// Set to wire render mode if wire render mode is required
 			if (meshRenderMode == WIRE)
-				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+				RenderHelper::SetWireframe(true);
 			RenderHelper::RenderMesh(theMesh);
 			// Set back to fill render mode if wire render mode is required
 			if (meshRenderMode == WIRE)
-				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+				RenderHelper::SetWireframe(false);
 		}
 	}
 }
@@ -254,6 +256,33 @@ void CGrid::SetDetailLevel(const CLevelOfDetails::DETAIL_LEVEL theDetailLevel)
 	}
 }
 
+/********************************************************************************
+Add the objects in this CGrid to the LOD batch
+********************************************************************************/
+void CGrid::SelectDetailLevels(void)
+{
+	GenericEntity* aGenericEntity = NULL;
+	Vector3 maxAABB, minAABB;
+	for (int i = 0; i < (int)ListOfObjects.size(); ++i)
+	{
+		aGenericEntity = (GenericEntity*)ListOfObjects[i];
+		if (aGenericEntity->GetLODStatus() == true)
+		{
+			// Use the scaled AABB to find the bounding radius of the object
+			aGenericEntity->GetAABB(maxAABB, minAABB);
+			Vector3 scale = aGenericEntity->GetScale();
+			Vector3 halfSize = (maxAABB - minAABB) * 0.5f;
+			halfSize.Set(halfSize.x * scale.x, halfSize.y * scale.y, halfSize.z * scale.z);
+			float radius = halfSize.Length();
+			// Fall back to the scale if this object has no AABB
+			if (radius < Math::EPSILON)
+				radius = scale.Length() * 0.5f;
+
+			CLODSelector::GetInstance()->Add(aGenericEntity, aGenericEntity->GetPosition(), radius);
+		}
+	}
+}
+
 // Get number of objects in this grid
 int CGrid::GetNumOfObject(void) const
 {
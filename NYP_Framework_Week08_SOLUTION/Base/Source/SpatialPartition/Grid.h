@@ -60,6 +60,8 @@ public:
 
 	// Set the Level of Detail for objects in this CGrid
 	void SetDetailLevel(const CLevelOfDetails::DETAIL_LEVEL theDetailLevel);
+	// Add the objects in this CGrid to the LOD batch, so that each of them selects its own level of detail
+	void SelectDetailLevels(void);
 
 	// Get number of objects in this grid
 	int GetNumOfObject(void) const;
@@ -4,6 +4,9 @@
 #include "GraphicsManager.h"
 #include "RenderHelper.h"
 #include "../FrustumCulling/FrustumCulling.h"
+#include "../OcclusionCulling/OcclusionCulling.h"
+#include "../LevelOfDetails/LODSelector.h"
+#include "StaticBatch.h"
 #include "KeyboardController.h"
 
 template <typename T> vector<T> concat(vector<T> &a, vector<T> &b) {
@@ -170,19 +173,8 @@ void CSpatialPartition::EnableFrustumCulling()
 			// Do Frustum Culling. We only render the grid if it is in the Frustum
 			if (CFrustumCulling::GetInstance()->isBoxInFrustum(gridPos, xGridSize, zGridSize))
 			{
-				float distance = CalculateDistanceSquare(&(theCamera->GetCameraPos()), i, j);
-				if (distance < LevelOfDetails_Distances[0])
-				{
-					theGrid[i*zNumOfGrid + j].SetDetailLevel(CLevelOfDetails::HIGH_DETAILS);
-				}
-				else if (distance < LevelOfDetails_Distances[1])
-				{
-					theGrid[i*zNumOfGrid + j].SetDetailLevel(CLevelOfDetails::MID_DETAILS);
-				}
-				else
-				{
-					theGrid[i*zNumOfGrid + j].SetDetailLevel(CLevelOfDetails::LOW_DETAILS);
-				}
+				// Add the objects in this grid to the LOD batch
+				theGrid[i*zNumOfGrid + j].SelectDetailLevels();
 			}
 			else
 			{
@@ -191,6 +183,9 @@ void CSpatialPartition::EnableFrustumCulling()
 		}
 		//cout << endl;
 	}
+
+	// Select the detail level of each object from its screen-space error
+	CLODSelector::GetInstance()->Update(theCamera->GetCameraPos());
 }
 
 void CSpatialPartition::DisableFrustumCulling()
@@ -202,24 +197,15 @@ void CSpatialPartition::DisableFrustumCulling()
 			// Update the grid
 			theGrid[i*zNumOfGrid + j].Update(&MigrationList);
 
-				float distance = CalculateDistanceSquare(&(theCamera->GetCameraPos()), i, j);
-				if (distance < LevelOfDetails_Distances[0])
-				{
-					theGrid[i*zNumOfGrid + j].SetDetailLevel(CLevelOfDetails::HIGH_DETAILS);
-				}
-				else if (distance < LevelOfDetails_Distances[1])
-				{
-					theGrid[i*zNumOfGrid + j].SetDetailLevel(CLevelOfDetails::MID_DETAILS);
-				}
-				else
-				{
-					theGrid[i*zNumOfGrid + j].SetDetailLevel(CLevelOfDetails::LOW_DETAILS);
-				}
-
-			}
+			// Add the objects in this grid to the LOD batch
+			theGrid[i*zNumOfGrid + j].SelectDetailLevels();
+		}
 
 		//cout << endl;
 	}
+
+	// Select the detail level of each object from its screen-space error
+	CLODSelector::GetInstance()->Update(theCamera->GetCameraPos());
 }
 
 void CSpatialPartition::DisableLOD()
@@ -279,6 +265,9 @@ void CSpatialPartition::Render(Vector3 theCameraPosition, Vector3 theCameraTarge
 	//Update frustum culling values
 	CFrustumCulling::GetInstance()->Update(theCameraPosition, theCameraTarget, theCameraUp);
 
+	// Render the visible chunks of the merged static entities
+	CStaticBatch::GetInstance()->Render();
+
 	// Render the Spatial Partitions
 	MS& modelStack = GraphicsManager::GetInstance()->GetModelStack();
 
@@ -297,7 +286,11 @@ void CSpatialPartition::Render(Vector3 theCameraPosition, Vector3 theCameraTarge
 			// Do Frustum Culling. We only render the grid if it is in the Frustum
 			if (CFrustumCulling::GetInstance()->isBoxInFrustum(gridPos, xGridSize, zGridSize))
 			{
-				if (theGrid[i*zNumOfGrid + j].GetNumOfObject() > 0)
+				// Do Occlusion Culling on the grid's quad, which lies flat at yOffset
+				Vector3 gridMin(gridXPos - (xGridSize >> 1), yOffset, gridZPos - (zGridSize >> 1));
+				Vector3 gridMax(gridXPos + (xGridSize >> 1), yOffset, gridZPos + (zGridSize >> 1));
+				if ((theGrid[i*zNumOfGrid + j].GetNumOfObject() > 0) &&
+					(COcclusionCulling::GetInstance()->IsBoxVisible(gridMin, gridMax)))
 				{
 					// Demonstrate that frustum culling is working
 				    //	cout << "Frustum Culling works!" << endl;
@@ -447,12 +440,12 @@ void CSpatialPartition::RemoveCamera(void)
 }
 
 /********************************************************************************
-Set LOD distances
+Set the LOD screen-space error budget and hysteresis
 ********************************************************************************/
-void CSpatialPartition::SetLevelOfDetails(const float distance_High2Mid, const float distance_Mid2Low)
+void CSpatialPartition::SetLevelOfDetails(const float errorBudget, const float hysteresis)
 {
-	LevelOfDetails_Distances[0] = distance_High2Mid;
-	LevelOfDetails_Distances[1] = distance_Mid2Low;
+	CLODSelector::GetInstance()->SetErrorBudget(errorBudget);
+	CLODSelector::GetInstance()->SetHysteresis(hysteresis);
 }
 
 /********************************************************************************
@@ -79,8 +79,8 @@ public:
 	// Get the camera pointer stored in this class instance
 	void RemoveCamera(void);
 
-	// Set LOD distances
-	void SetLevelOfDetails(const float distance_High2Mid, const float distance_Mid2Low);
+	// Set the LOD screen-space error budget in pixels, and the hysteresis band as a fraction of the budget
+	void SetLevelOfDetails(const float errorBudget, const float hysteresis);
 	// Check if a CGrid is visible to the camera
 	bool IsVisible(Vector3 theCameraPosition, Vector3 theCameraDirection, const int xIndex, const int zIndex);
 
@@ -121,7 +121,4 @@ protected:
 
 	// We store the pointer to the Camera so we can get it's position and direction to calculate LOD and visibility
 	FPSCamera* theCamera;
-
-	// LOD distances
-	float LevelOfDetails_Distances[2];
 };
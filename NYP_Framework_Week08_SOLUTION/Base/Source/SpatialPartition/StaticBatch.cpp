@@ -0,0 +1,227 @@
+#include "StaticBatch.h"
+#include "SpatialPartition.h"
+#include "../GenericEntity.h"
+#include "../FrustumCulling/FrustumCulling.h"
+#include "../OcclusionCulling/OcclusionCulling.h"
+#include "GraphicsManager.h"
+#include "RenderHelper.h"
+#include "Mesh.h"
+#include "MeshBuilder.h"
+#include "Vertex.h"
+#include <algorithm>
+#include <cfloat>
+#include <map>
+
+// The vertices and the indices of each cell, for the entities which share a texture and a draw mode
+struct MergedMesh
+{
+	unsigned textureID;
+	Mesh::DRAW_MODE mode;
+	std::vector<Vertex> theVertices;
+	std::vector<std::vector<unsigned> > theCellIndices;
+	std::vector<Vector3> theCellMin, theCellMax;
+};
+
+/********************************************************************************
+ Constructor
+ ********************************************************************************/
+CStaticBatch::CStaticBatch(void)
+	: numOfDrawCalls(0)
+{
+}
+
+/********************************************************************************
+ Destructor
+ ********************************************************************************/
+CStaticBatch::~CStaticBatch(void)
+{
+	Clear();
+}
+
+/********************************************************************************
+ Add an entity to be merged by Build
+ ********************************************************************************/
+void CStaticBatch::Add(GenericEntity* theEntity)
+{
+	if ((theEntity == nullptr) || (theEntity->GetMesh() == nullptr) || (theEntity->GetLODStatus() == true))
+		return;
+	if (theEntity->GetMesh()->mode == Mesh::DRAW_TRIANGLE_STRIP)
+		return;
+
+	theEntities.push_back(theEntity);
+}
+
+/********************************************************************************
+ Merge the added entities, and mark them as static
+ ********************************************************************************/
+void CStaticBatch::Build(void)
+{
+	// Drop the last build, but keep the added entities
+	std::vector<GenericEntity*> theAddedEntities;
+	theAddedEntities.swap(theEntities);
+	Clear();
+	theEntities.swap(theAddedEntities);
+
+	CSpatialPartition* thePartition = CSpatialPartition::GetInstance();
+	const int numOfCells = std::max(1, thePartition->GetxNumOfGrid() * thePartition->GetzNumOfGrid());
+
+	std::vector<MergedMesh> theMergedMeshes;
+	std::map<unsigned long long, int> theMergedIndices;
+	std::vector<Vertex> theVertices;
+	std::vector<unsigned> theIndices;
+
+	for (unsigned i = 0; i < theEntities.size(); ++i)
+	{
+		GenericEntity* theEntity = theEntities[i];
+		Mesh* theMesh = theEntity->GetMesh();
+		if (!theMesh->ReadBack(theVertices, theIndices))
+			continue;
+
+		// Find the merged mesh with the same texture and draw mode
+		const unsigned long long theKey = ((unsigned long long)theMesh->textureID << 8) | theMesh->mode;
+		std::map<unsigned long long, int>::iterator it = theMergedIndices.find(theKey);
+		if (it == theMergedIndices.end())
+		{
+			it = theMergedIndices.insert(std::make_pair(theKey, (int)theMergedMeshes.size())).first;
+			theMergedMeshes.push_back(MergedMesh());
+			theMergedMeshes.back().textureID = theMesh->textureID;
+			theMergedMeshes.back().mode = theMesh->mode;
+			theMergedMeshes.back().theCellIndices.resize(numOfCells);
+			theMergedMeshes.back().theCellMin.assign(numOfCells, Vector3(FLT_MAX, FLT_MAX, FLT_MAX));
+			theMergedMeshes.back().theCellMax.assign(numOfCells, Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+		}
+		MergedMesh& theMerged = theMergedMeshes[it->second];
+		const int cell = GetCellIndex(theEntity->GetPosition());
+
+		// Move the vertices into world space. The normals are scaled by the inverse of the scale, then normalised
+		const Vector3 thePosition = theEntity->GetPosition();
+		const Vector3 theScale = theEntity->GetScale();
+		const unsigned baseVertex = theMerged.theVertices.size();
+		Vector3& theMin = theMerged.theCellMin[cell];
+		Vector3& theMax = theMerged.theCellMax[cell];
+		for (unsigned j = 0; j < theVertices.size(); ++j)
+		{
+			Vertex v = theVertices[j];
+			v.pos.Set(v.pos.x * theScale.x + thePosition.x, v.pos.y * theScale.y + thePosition.y, v.pos.z * theScale.z + thePosition.z);
+			Vector3 theNormal(v.normal.x / theScale.x, v.normal.y / theScale.y, v.normal.z / theScale.z);
+			if (!theNormal.IsZero())
+				v.normal = theNormal.Normalized();
+			theMerged.theVertices.push_back(v);
+
+			theMin.Set(std::min(theMin.x, v.pos.x), std::min(theMin.y, v.pos.y), std::min(theMin.z, v.pos.z));
+			theMax.Set(std::max(theMax.x, v.pos.x), std::max(theMax.y, v.pos.y), std::max(theMax.z, v.pos.z));
+		}
+		for (unsigned j = 0; j < theIndices.size(); ++j)
+			theMerged.theCellIndices[cell].push_back(baseVertex + theIndices[j]);
+
+		theEntity->SetStatic(true);
+	}
+
+	// Upload each merged mesh, with the indices of each cell one after another
+	for (unsigned i = 0; i < theMergedMeshes.size(); ++i)
+	{
+		MergedMesh& theMerged = theMergedMeshes[i];
+		Mesh* theMesh = new Mesh("staticbatch");
+		theMesh->mode = theMerged.mode;
+		theMesh->textureID = theMerged.textureID;
+		theMesh->bSharedTexture = true;
+
+		theIndices.clear();
+		for (int cell = 0; cell < numOfCells; ++cell)
+		{
+			const std::vector<unsigned>& theCellIndices = theMerged.theCellIndices[cell];
+			if (theCellIndices.empty())
+				continue;
+
+			Chunk theChunk;
+			theChunk.theMesh = theMesh;
+			theChunk.offset = theIndices.size();
+			theChunk.count = theCellIndices.size();
+			theChunk.minAABB = theMerged.theCellMin[cell];
+			theChunk.maxAABB = theMerged.theCellMax[cell];
+			theChunks.push_back(theChunk);
+			theIndices.insert(theIndices.end(), theCellIndices.begin(), theCellIndices.end());
+		}
+
+		theMesh->Upload(theMerged.theVertices, theIndices, MeshBuilder::GetInstance()->GetVertexFormat());
+		theMeshes.push_back(theMesh);
+	}
+}
+
+/********************************************************************************
+ Delete the merged meshes, and let EntityManager draw the entities again
+ ********************************************************************************/
+void CStaticBatch::Clear(void)
+{
+	for (unsigned i = 0; i < theEntities.size(); ++i)
+		theEntities[i]->SetStatic(false);
+	theEntities.clear();
+
+	for (unsigned i = 0; i < theMeshes.size(); ++i)
+		delete theMeshes[i];
+	theMeshes.clear();
+	theChunks.clear();
+}
+
+/********************************************************************************
+ Render the chunks which are in the frustum and not hidden behind the occluders
+ ********************************************************************************/
+void CStaticBatch::Render(void)
+{
+	numOfDrawCalls = 0;
+	if (theChunks.empty())
+		return;
+
+	// The vertices are in world space already
+	MS& modelStack = GraphicsManager::GetInstance()->GetModelStack();
+	modelStack.PushMatrix();
+	modelStack.LoadIdentity();
+
+	for (unsigned i = 0; i < theChunks.size(); ++i)
+	{
+		const Chunk& theChunk = theChunks[i];
+		const Vector3 theCentre = (theChunk.minAABB + theChunk.maxAABB) * 0.5f;
+		const float radius = (theChunk.maxAABB - theChunk.minAABB).Length() * 0.5f;
+		if (!CFrustumCulling::GetInstance()->isSphereInFrustum(theCentre, radius))
+			continue;
+		if (!COcclusionCulling::GetInstance()->IsBoxVisible(theChunk.minAABB, theChunk.maxAABB))
+			continue;
+
+		RenderHelper::RenderMesh(theChunk.theMesh, theChunk.offset, theChunk.count);
+		numOfDrawCalls++;
+	}
+
+	modelStack.PopMatrix();
+}
+
+/********************************************************************************
+ Get the number of chunks
+ ********************************************************************************/
+int CStaticBatch::GetNumOfChunks(void) const
+{
+	return (int)theChunks.size();
+}
+
+/********************************************************************************
+ Get the number of chunks drawn by the last Render
+ ********************************************************************************/
+int CStaticBatch::GetNumOfDrawCalls(void) const
+{
+	return numOfDrawCalls;
+}
+
+/********************************************************************************
+ Get the CSpatialPartition cell of a position. Positions outside go to the nearest cell
+ ********************************************************************************/
+int CStaticBatch::GetCellIndex(const Vector3& thePosition) const
+{
+	CSpatialPartition* thePartition = CSpatialPartition::GetInstance();
+	if ((thePartition->GetxNumOfGrid() <= 0) || (thePartition->GetzNumOfGrid() <= 0))
+		return 0;
+
+	int xIndex = (int)floor((thePosition.x + thePartition->GetxSize() * 0.5f) / thePartition->GetxGridSize());
+	int zIndex = (int)floor((thePosition.z + thePartition->GetzSize() * 0.5f) / thePartition->GetzGridSize());
+	xIndex = std::min(std::max(xIndex, 0), thePartition->GetxNumOfGrid() - 1);
+	zIndex = std::min(std::max(zIndex, 0), thePartition->GetzNumOfGrid() - 1);
+	return xIndex * thePartition->GetzNumOfGrid() + zIndex;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "SingletonTemplate.h"
+#include "Vector3.h"
+#include <vector>
+
+class Mesh;
+class GenericEntity;
+
+// Merges the meshes of the entities which never move into a few large meshes when a level loads, so they
+// are not drawn one at a time. The vertices are moved into world space, and the meshes which share a texture
+// and a draw mode are merged together. Within each merged mesh, the indices are grouped into chunks by the
+// CSpatialPartition cell of each entity, so each visible chunk is drawn with one draw call
+class CStaticBatch : public Singleton<CStaticBatch>
+{
+	friend Singleton<CStaticBatch>;
+public:
+	virtual ~CStaticBatch(void);
+
+	// Add an entity to be merged by Build. Entities with levels of detail, or triangle strips, are left alone
+	void Add(GenericEntity* theEntity);
+	// Merge the added entities, and mark them as static so EntityManager no longer draws them.
+	// Call it after CSpatialPartition::Init
+	void Build(void);
+	// Delete the merged meshes, and let EntityManager draw the entities again
+	void Clear(void);
+
+	// Render the chunks which are in the frustum and not hidden behind the occluders
+	void Render(void);
+
+	// Get the number of chunks
+	int GetNumOfChunks(void) const;
+	// Get the number of chunks drawn by the last Render
+	int GetNumOfDrawCalls(void) const;
+
+protected:
+	CStaticBatch(void);
+
+	// A range of a merged mesh's indices, from the entities in one cell
+	struct Chunk
+	{
+		Mesh* theMesh;
+		unsigned offset;
+		unsigned count;
+		Vector3 minAABB, maxAABB;
+	};
+
+	// Get the CSpatialPartition cell of a position
+	int GetCellIndex(const Vector3& thePosition) const;
+
+	std::vector<GenericEntity*> theEntities;
+	std::vector<Mesh*> theMeshes;
+	std::vector<Chunk> theChunks;
+	int numOfDrawCalls;
+};
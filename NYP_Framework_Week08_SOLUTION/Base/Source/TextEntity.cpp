@@ -3,12 +3,15 @@
 #include "EntityManager.h"
 #include "GraphicsManager.h"
 #include "RenderHelper.h"
+#include "TextMesh.h"
 
 TextEntity::TextEntity(Mesh* _modelMesh, const std::string& _text, const Color& _color) :
 modelMesh(_modelMesh),
 position(0.0f, 0.0f, 0.0f),
 scale(1.0f, 1.0f, 1.0f),
 text(_text),
+textMesh(new CTextMesh("text")),
+bTextChanged(true),
 mode(MODE_2D),
 color(_color)
 {
@@ -16,6 +19,7 @@ color(_color)
 
 TextEntity::~TextEntity()
 {
+	delete textMesh;
 }
 
 void TextEntity::Update(double _dt)
@@ -32,7 +36,7 @@ void TextEntity::Render()
 	modelStack.PushMatrix();
 	modelStack.Translate(position.x, position.y, position.z);
 	modelStack.Scale(scale.x, scale.y, scale.z);
-	RenderHelper::RenderText(modelMesh, text, color);
+	RenderText();
 	modelStack.PopMatrix();
 }
 
@@ -45,10 +49,28 @@ void TextEntity::RenderUI()
 	modelStack.PushMatrix();
 	modelStack.Translate(position.x, position.y, position.z);
 	modelStack.Scale(scale.x, scale.y, scale.z);
-	RenderHelper::RenderText(modelMesh, text, color);
+	RenderText();
 	modelStack.PopMatrix();
 }
 
+void TextEntity::SetText(const std::string& _text)
+{
+	if (_text == text)
+		return;
+	text = _text;
+	bTextChanged = true;
+}
+
+void TextEntity::RenderText(void)
+{
+	if (bTextChanged)
+	{
+		textMesh->Build(text);
+		bTextChanged = false;
+	}
+	RenderHelper::RenderText(textMesh, modelMesh, color);
+}
+
 TextEntity* Create::Text2DObject(const std::string& _meshName, const Vector3& _position, const std::string& _text, const Vector3& _scale, const Color& _color)
 {
 	Mesh* modelMesh = MeshBuilder::GetInstance()->GetMesh(_meshName);
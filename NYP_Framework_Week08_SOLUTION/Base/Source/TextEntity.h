@@ -7,6 +7,7 @@
 #include <string>
 
 class Mesh;
+class CTextMesh;
 
 class TextEntity : public EntityBase
 {
@@ -31,17 +32,24 @@ public:
 	inline void SetScale(const Vector3& _value){ scale = _value; };
 	inline Vector3 GetScale(){ return scale; };
 
-	inline void SetText(const std::string& _text){ text = _text; };
+	// Set the text. The glyph quads are only rebuilt when the text has changed
+	void SetText(const std::string& _text);
 	inline std::string GetText(){ return text; };
 
 	inline void SetTextRenderMode(TEXT_RENDERMODE _mode){ mode = _mode; };
 	inline void SetColor(const Color& _color){ color = _color; };
 
 private:
+	// Rebuild the text mesh if the text has changed, then render it
+	void RenderText(void);
+
 	Vector3 position;
 	Vector3 scale;
 	Mesh* modelMesh;
 	std::string text;
+	// The glyph quads of the text, drawn in one draw call
+	CTextMesh* textMesh;
+	bool bTextChanged;
 	TEXT_RENDERMODE mode;
 	Color color;
 };
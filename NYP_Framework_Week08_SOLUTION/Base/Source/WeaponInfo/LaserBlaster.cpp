@@ -2,6 +2,7 @@
 #include "../Projectile/Laser.h"
 #include "MeshBuilder.h"
 #include "../EntityManager.h"
+#include "../Light.h"
 
 CLaserBlaster::CLaserBlaster()
 {
@@ -57,6 +58,8 @@ void CLaserBlaster::Discharge(Vector3 position, Vector3 target, CPlayerInfo* _so
 			//aLaser->SetCollider(false);
 			aLaser->SetCollider(true);
 			aLaser->SetAABB(Vector3(0.5f, 0.5f, 0.5f), Vector3(-0.5f, -0.5f, -0.5f));
+			// Flash of the laser leaving the blaster
+			Create::Flash(position, Color(1.0f, 0.3f, 0.3f), 1.5f, 25.0f, 0.15f);
 			bFire = false;
 			magRounds--;
 		}
@@ -1,5 +1,6 @@
 #include "RPG.h"
 #include "../Projectile/Projectile.h"
+#include "../Light.h"
 
 CRPG::CRPG()
 {
@@ -51,6 +52,8 @@ void CRPG::Discharge(Vector3 position, Vector3 target, CPlayerInfo* _source)
 				_source);
 			aProjectile->SetCollider(true);
 			aProjectile->SetAABB(Vector3(0.5f, 0.5f, 0.5f), Vector3(-0.5f, -0.5f, -0.5f));
+			// Muzzle flash
+			Create::Flash(position, Color(1.0f, 0.6f, 0.2f), 3.0f, 40.0f, 0.15f);
 			bFire = false;
 			magRounds--;
 		}
@@ -1,5 +1,6 @@
 #include "WeaponInfo.h"
 #include "../Projectile/Projectile.h"
+#include "../Light.h"
 
 #include <iostream>
 using namespace std;
@@ -154,6 +155,8 @@ void CWeaponInfo::Discharge(Vector3 position, Vector3 target, CPlayerInfo* _sour
 															_source);
 			aProjectile->SetCollider(true);
 			aProjectile->SetAABB(Vector3(0.5f, 0.5f, 0.5f), Vector3(-0.5f, -0.5f, -0.5f));
+			// Muzzle flash
+			Create::Flash(position, Color(1.0f, 0.8f, 0.4f), 2.0f, 30.0f, 0.1f);
 			bFire = false;
 			magRounds--;
 		}
@@ -1,11 +1,17 @@
 
 
 #include "Application.h"
+#include "RenderCheck/RenderCheck.h"
+#include <cstring>
 
 #define _DEBUGMODE 1;	//	0=Non-debug mode, 1=Debug mode
 
-int main( void )
+int main( int argc, char* argv[] )
 {
+	// Check the render path without a window
+	if ((argc > 1) && (strcmp(argv[1], "-checkrender") == 0))
+		return CRenderCheck::GetInstance()->Run() ? 0 : 1;
+
 	Application &app = Application::GetInstance();
 	app.Init();
 	app.Run();
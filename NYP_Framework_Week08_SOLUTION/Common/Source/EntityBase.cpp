@@ -6,6 +6,7 @@ EntityBase::EntityBase()
 	, isDone(false)
 	, m_bCollider(false)
 	, bLaser(false)
+	, bStatic(false)
 {
 }
 
@@ -57,4 +58,16 @@ void EntityBase::SetIsLaser(const bool bLaser)
 bool EntityBase::GetIsLaser(void) const
 {
 	return bLaser;
-}
\ No newline at end of file
+}
+
+// Set the flag to indicate if this entity is drawn as a part of the merged static geometry
+void EntityBase::SetStatic(const bool _value)
+{
+	bStatic = _value;
+}
+
+// Check if this entity is drawn as a part of the merged static geometry
+bool EntityBase::IsStatic(void) const
+{
+	return bStatic;
+}
@@ -31,6 +31,11 @@ public:
 	// Get the flag, bLaser
 	virtual bool GetIsLaser(void) const;
 
+	// Set the flag to indicate if this entity is drawn as a part of the merged static geometry
+	void SetStatic(const bool _value);
+	// Check if this entity is drawn as a part of the merged static geometry
+	bool IsStatic(void) const;
+
 protected:
 	Vector3 position;
 	Vector3 scale;
@@ -38,6 +43,7 @@ protected:
 	bool isDone;
 	bool m_bCollider;
 	bool bLaser;
+	bool bStatic;
 };
 
 #endif // ENTITY_BASE_H
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "FontData.h"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+using namespace std;
+
+CFontData::CFontData(void)
+	: numOfRows(16)
+	, numOfCols(16)
+	, startChar(0)
+{
+	for (int i = 0; i < MAX_GLYPHS; ++i)
+		theGlyphWidths[i] = 1.0f;
+}
+
+CFontData::~CFontData(void)
+{
+}
+
+/**
+* Load the glyph metrics from a data file of "Name,Value" lines
+*/
+bool CFontData::Load(const std::string& filePath)
+{
+	ifstream fileStream(filePath.c_str());
+	if (!fileStream.is_open())
+	{
+		cout << "CFontData::Load: Unable to open " << filePath << endl;
+		return false;
+	}
+
+	int imageWidth = 0, imageHeight = 0, cellWidth = 0, cellHeight = 0;
+	int theBaseWidths[MAX_GLYPHS];
+	for (int i = 0; i < MAX_GLYPHS; ++i)
+		theBaseWidths[i] = -1;
+
+	string theLine;
+	while (getline(fileStream, theLine))
+	{
+		size_t comma = theLine.find(',');
+		if (comma == string::npos)
+			continue;
+		const string theName = theLine.substr(0, comma);
+		const int theValue = atoi(theLine.c_str() + comma + 1);
+
+		if (theName == "Image Width")
+			imageWidth = theValue;
+		else if (theName == "Image Height")
+			imageHeight = theValue;
+		else if (theName == "Cell Width")
+			cellWidth = theValue;
+		else if (theName == "Cell Height")
+			cellHeight = theValue;
+		else if (theName == "Start Char")
+			startChar = theValue;
+		else if ((theName.compare(0, 5, "Char ") == 0) && (theName.find("Base Width") != string::npos))
+		{
+			const int theChar = atoi(theName.c_str() + 5);
+			if ((theChar >= 0) && (theChar < MAX_GLYPHS))
+				theBaseWidths[theChar] = theValue;
+		}
+	}
+
+	if ((imageWidth <= 0) || (imageHeight <= 0) || (cellWidth <= 0) || (cellHeight <= 0))
+	{
+		cout << "CFontData::Load: " << filePath << " has no image or cell size" << endl;
+		return false;
+	}
+
+	numOfCols = imageWidth / cellWidth;
+	numOfRows = imageHeight / cellHeight;
+	for (int i = 0; i < MAX_GLYPHS; ++i)
+		theGlyphWidths[i] = (theBaseWidths[i] >= 0 ? (float)theBaseWidths[i] / cellWidth : 1.0f);
+	return true;
+}
+
+/**
+* Get the width of a glyph, as a fraction of a cell
+*/
+float CFontData::GetGlyphWidth(const unsigned char theChar) const
+{
+	return theGlyphWidths[theChar];
+}
+
+/**
+* Get the texture coordinates of the bottom left corner of a glyph's cell
+*/
+void CFontData::GetGlyphTexCoord(const unsigned char theChar, float& u, float& v) const
+{
+	int index = (int)theChar - startChar;
+	if (index < 0)
+		index = 0;
+	u = (float)(index % numOfCols) / numOfCols;
+	v = 1.0f - (float)(index / numOfCols + 1) / numOfRows;
+}
+
+/**
+* Get the width of a cell in texture coordinates
+*/
+float CFontData::GetCellU(void) const
+{
+	return 1.0f / numOfCols;
+}
+
+/**
+* Get the height of a cell in texture coordinates
+*/
+float CFontData::GetCellV(void) const
+{
+	return 1.0f / numOfRows;
+}
+
+/**
+* Get the width of a string, in cells
+*/
+float CFontData::GetTextWidth(const std::string& theText) const
+{
+	float width = 0.0f;
+	for (unsigned i = 0; i < theText.length(); ++i)
+		width += theGlyphWidths[(unsigned char)theText[i]];
+	return width;
+}
@@ -0,0 +1,39 @@
+#ifndef FONT_DATA_H
+#define FONT_DATA_H
+
+#include "SingletonTemplate.h"
+#include <string>
+
+// The glyph metrics of the bitmap font, read from the data file which is exported with the font's
+// texture, such as Image//FontData.csv. The glyphs sit in a grid of cells, starting from the top left,
+// and each glyph is as wide as its base width. Without a data file, every glyph is a whole cell wide
+class CFontData : public Singleton<CFontData>
+{
+	friend Singleton<CFontData>;
+public:
+	static const int MAX_GLYPHS = 256;
+
+	virtual ~CFontData(void);
+
+	// Load the glyph metrics from a data file
+	bool Load(const std::string& filePath);
+
+	// Get the width of a glyph, as a fraction of a cell
+	float GetGlyphWidth(const unsigned char theChar) const;
+	// Get the texture coordinates of the bottom left corner of a glyph's cell
+	void GetGlyphTexCoord(const unsigned char theChar, float& u, float& v) const;
+	// Get the size of a cell in texture coordinates
+	float GetCellU(void) const;
+	float GetCellV(void) const;
+	// Get the width of a string, in cells
+	float GetTextWidth(const std::string& theText) const;
+
+protected:
+	CFontData(void);
+
+	int numOfRows, numOfCols;
+	int startChar;
+	float theGlyphWidths[MAX_GLYPHS];
+};
+
+#endif // FONT_DATA_H
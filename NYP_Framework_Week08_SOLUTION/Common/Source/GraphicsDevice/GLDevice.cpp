@@ -0,0 +1,398 @@
+#include "GLDevice.h"
+#include "GL\glew.h"
+#include <GLFW/glfw3.h>
+#include <vector>
+
+// GL_ARB_buffer_storage is newer than our GLEW, so its entry point is loaded by hand
+typedef void (GLAPIENTRY * PFNBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+CGLDevice::CGLDevice(void)
+	: theBufferStorage(nullptr)
+	, bBufferStorageLoaded(false)
+{
+}
+
+CGLDevice::~CGLDevice(void)
+{
+}
+
+/**
+* Check for an optional feature. The extensions can only be checked once the OpenGL context is created
+*/
+bool CGLDevice::IsSupported(const FEATURE _feature)
+{
+	switch (_feature)
+	{
+	case FEATURE_TIMER_QUERY:
+		return (GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+	case FEATURE_BUFFER_STORAGE:
+		if (!bBufferStorageLoaded)
+		{
+			if (glfwExtensionSupported("GL_ARB_buffer_storage"))
+				theBufferStorage = (void*)glfwGetProcAddress("glBufferStorage");
+			bBufferStorageLoaded = true;
+		}
+		return (theBufferStorage != nullptr);
+	default:
+		return false;
+	}
+}
+
+void CGLDevice::Enable(const unsigned _cap)
+{
+	glEnable(_cap);
+}
+
+void CGLDevice::Disable(const unsigned _cap)
+{
+	glDisable(_cap);
+}
+
+void CGLDevice::ClearColor(const float _r, const float _g, const float _b, const float _a)
+{
+	glClearColor(_r, _g, _b, _a);
+}
+
+void CGLDevice::DepthFunc(const unsigned _func)
+{
+	glDepthFunc(_func);
+}
+
+void CGLDevice::BlendFunc(const unsigned _srcFactor, const unsigned _dstFactor)
+{
+	glBlendFunc(_srcFactor, _dstFactor);
+}
+
+void CGLDevice::PolygonMode(const unsigned _face, const unsigned _mode)
+{
+	glPolygonMode(_face, _mode);
+}
+
+void CGLDevice::LineWidth(const float _width)
+{
+	glLineWidth(_width);
+}
+
+int CGLDevice::GetInteger(const unsigned _name)
+{
+	GLint value = 0;
+	glGetIntegerv(_name, &value);
+	return value;
+}
+
+unsigned CGLDevice::GenBuffer(void)
+{
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	return buffer;
+}
+
+void CGLDevice::DeleteBuffer(const unsigned _buffer)
+{
+	glDeleteBuffers(1, &_buffer);
+}
+
+void CGLDevice::BindBuffer(const unsigned _target, const unsigned _buffer)
+{
+	glBindBuffer(_target, _buffer);
+}
+
+void CGLDevice::BindBufferBase(const unsigned _target, const unsigned _index, const unsigned _buffer)
+{
+	glBindBufferBase(_target, _index, _buffer);
+}
+
+void CGLDevice::BufferData(const unsigned _target, const unsigned _size, const void* _data, const unsigned _usage)
+{
+	glBufferData(_target, _size, _data, _usage);
+}
+
+/**
+* Give a buffer immutable storage, if glBufferStorage could be loaded
+*/
+bool CGLDevice::BufferStorage(const unsigned _target, const unsigned _size, const void* _data, const unsigned _flags)
+{
+	if (!IsSupported(FEATURE_BUFFER_STORAGE))
+		return false;
+	((PFNBUFFERSTORAGEPROC)theBufferStorage)(_target, _size, _data, _flags);
+	return true;
+}
+
+void CGLDevice::BufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, const void* _data)
+{
+	glBufferSubData(_target, _offset, _size, _data);
+}
+
+void CGLDevice::GetBufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, void* _data)
+{
+	glGetBufferSubData(_target, _offset, _size, _data);
+}
+
+int CGLDevice::GetBufferSize(const unsigned _target)
+{
+	GLint size = 0;
+	glGetBufferParameteriv(_target, GL_BUFFER_SIZE, &size);
+	return size;
+}
+
+void* CGLDevice::MapBufferRange(const unsigned _target, const unsigned _offset, const unsigned _size, const unsigned _access)
+{
+	return glMapBufferRange(_target, _offset, _size, _access);
+}
+
+void CGLDevice::UnmapBuffer(const unsigned _target)
+{
+	glUnmapBuffer(_target);
+}
+
+unsigned CGLDevice::GenVertexArray(void)
+{
+	GLuint vertexArray = 0;
+	glGenVertexArrays(1, &vertexArray);
+	return vertexArray;
+}
+
+void CGLDevice::DeleteVertexArray(const unsigned _vertexArray)
+{
+	glDeleteVertexArrays(1, &_vertexArray);
+}
+
+void CGLDevice::BindVertexArray(const unsigned _vertexArray)
+{
+	glBindVertexArray(_vertexArray);
+}
+
+void CGLDevice::EnableVertexAttribArray(const unsigned _index)
+{
+	glEnableVertexAttribArray(_index);
+}
+
+void CGLDevice::DisableVertexAttribArray(const unsigned _index)
+{
+	glDisableVertexAttribArray(_index);
+}
+
+void CGLDevice::VertexAttribPointer(const unsigned _index, const int _size, const unsigned _type, const bool _normalised,
+								   const int _stride, const unsigned _offset)
+{
+	glVertexAttribPointer(_index, _size, _type, _normalised ? GL_TRUE : GL_FALSE, _stride, (void*)(size_t)_offset);
+}
+
+void CGLDevice::VertexAttribDivisor(const unsigned _index, const unsigned _divisor)
+{
+	glVertexAttribDivisor(_index, _divisor);
+}
+
+void CGLDevice::VertexAttrib4f(const unsigned _index, const float _x, const float _y, const float _z, const float _w)
+{
+	glVertexAttrib4f(_index, _x, _y, _z, _w);
+}
+
+void CGLDevice::DrawElements(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset)
+{
+	glDrawElements(_mode, _count, _type, (void*)(size_t)_offset);
+}
+
+void CGLDevice::DrawElementsInstanced(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset,
+									 const int _numOfInstances)
+{
+	glDrawElementsInstanced(_mode, _count, _type, (void*)(size_t)_offset, _numOfInstances);
+}
+
+unsigned CGLDevice::CreateShader(const unsigned _type)
+{
+	return glCreateShader(_type);
+}
+
+void CGLDevice::DeleteShader(const unsigned _shader)
+{
+	glDeleteShader(_shader);
+}
+
+void CGLDevice::ShaderSource(const unsigned _shader, const std::string& _source)
+{
+	const char* theSource = _source.c_str();
+	glShaderSource(_shader, 1, &theSource, NULL);
+}
+
+void CGLDevice::CompileShader(const unsigned _shader)
+{
+	glCompileShader(_shader);
+}
+
+int CGLDevice::GetShaderInt(const unsigned _shader, const unsigned _name)
+{
+	GLint value = 0;
+	glGetShaderiv(_shader, _name, &value);
+	return value;
+}
+
+std::string CGLDevice::GetShaderInfoLog(const unsigned _shader)
+{
+	const int length = GetShaderInt(_shader, GL_INFO_LOG_LENGTH);
+	if (length <= 0)
+		return "";
+	std::vector<char> theLog(length + 1, '\0');
+	glGetShaderInfoLog(_shader, length, NULL, &theLog[0]);
+	return std::string(&theLog[0]);
+}
+
+unsigned CGLDevice::CreateProgram(void)
+{
+	return glCreateProgram();
+}
+
+void CGLDevice::DeleteProgram(const unsigned _program)
+{
+	glDeleteProgram(_program);
+}
+
+void CGLDevice::AttachShader(const unsigned _program, const unsigned _shader)
+{
+	glAttachShader(_program, _shader);
+}
+
+void CGLDevice::DetachShader(const unsigned _program, const unsigned _shader)
+{
+	glDetachShader(_program, _shader);
+}
+
+void CGLDevice::LinkProgram(const unsigned _program)
+{
+	glLinkProgram(_program);
+}
+
+int CGLDevice::GetProgramInt(const unsigned _program, const unsigned _name)
+{
+	GLint value = 0;
+	glGetProgramiv(_program, _name, &value);
+	return value;
+}
+
+std::string CGLDevice::GetProgramInfoLog(const unsigned _program)
+{
+	const int length = GetProgramInt(_program, GL_INFO_LOG_LENGTH);
+	if (length <= 0)
+		return "";
+	std::vector<char> theLog(length + 1, '\0');
+	glGetProgramInfoLog(_program, length, NULL, &theLog[0]);
+	return std::string(&theLog[0]);
+}
+
+void CGLDevice::UseProgram(const unsigned _program)
+{
+	glUseProgram(_program);
+}
+
+int CGLDevice::GetUniformLocation(const unsigned _program, const char* _name)
+{
+	return glGetUniformLocation(_program, _name);
+}
+
+unsigned CGLDevice::GetUniformBlockIndex(const unsigned _program, const char* _name)
+{
+	return glGetUniformBlockIndex(_program, _name);
+}
+
+void CGLDevice::UniformBlockBinding(const unsigned _program, const unsigned _blockIndex, const unsigned _binding)
+{
+	glUniformBlockBinding(_program, _blockIndex, _binding);
+}
+
+void CGLDevice::Uniform1i(const int _location, const int _value)
+{
+	glUniform1i(_location, _value);
+}
+
+void CGLDevice::Uniform1f(const int _location, const float _value)
+{
+	glUniform1f(_location, _value);
+}
+
+void CGLDevice::Uniform3fv(const int _location, const float* _value)
+{
+	glUniform3fv(_location, 1, _value);
+}
+
+void CGLDevice::UniformMatrix4fv(const int _location, const float* _value)
+{
+	glUniformMatrix4fv(_location, 1, GL_FALSE, _value);
+}
+
+unsigned CGLDevice::GenTexture(void)
+{
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	return texture;
+}
+
+void CGLDevice::DeleteTexture(const unsigned _texture)
+{
+	glDeleteTextures(1, &_texture);
+}
+
+void CGLDevice::ActiveTexture(const unsigned _unit)
+{
+	glActiveTexture(_unit);
+}
+
+void CGLDevice::BindTexture(const unsigned _target, const unsigned _texture)
+{
+	glBindTexture(_target, _texture);
+}
+
+void CGLDevice::TexBuffer(const unsigned _target, const unsigned _format, const unsigned _buffer)
+{
+	glTexBuffer(_target, _format, _buffer);
+}
+
+void* CGLDevice::FenceSync(void)
+{
+	return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+unsigned CGLDevice::ClientWaitSync(void* _sync, const unsigned _flags, const unsigned long long _timeout)
+{
+	return glClientWaitSync((GLsync)_sync, _flags, _timeout);
+}
+
+void CGLDevice::DeleteSync(void* _sync)
+{
+	glDeleteSync((GLsync)_sync);
+}
+
+unsigned CGLDevice::GenQuery(void)
+{
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	return query;
+}
+
+void CGLDevice::DeleteQuery(const unsigned _query)
+{
+	glDeleteQueries(1, &_query);
+}
+
+void CGLDevice::BeginQuery(const unsigned _target, const unsigned _query)
+{
+	glBeginQuery(_target, _query);
+}
+
+void CGLDevice::EndQuery(const unsigned _target)
+{
+	glEndQuery(_target);
+}
+
+unsigned CGLDevice::GetQueryObjectui(const unsigned _query, const unsigned _name)
+{
+	GLuint value = 0;
+	glGetQueryObjectuiv(_query, _name, &value);
+	return value;
+}
+
+unsigned long long CGLDevice::GetQueryObjectui64(const unsigned _query, const unsigned _name)
+{
+	GLuint64 value = 0;
+	glGetQueryObjectui64v(_query, _name, &value);
+	return value;
+}
@@ -0,0 +1,14 @@
+#include "GraphicsDevice.h"
+#include "GLDevice.h"
+
+// The OpenGL device lives for the whole program, so the device can always go back to it
+static CGLDevice theGLDevice;
+CGraphicsDevice* CGraphicsDevice::theDevice = &theGLDevice;
+
+/**
+* Render through another device, or go back to OpenGL with nullptr
+*/
+void CGraphicsDevice::SetDevice(CGraphicsDevice* _device)
+{
+	theDevice = (_device != nullptr) ? _device : &theGLDevice;
+}
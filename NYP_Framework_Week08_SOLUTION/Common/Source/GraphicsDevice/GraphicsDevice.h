@@ -0,0 +1,126 @@
+#ifndef GRAPHICS_DEVICE_H
+#define GRAPHICS_DEVICE_H
+
+#include <string>
+
+// The OpenGL calls of the render path, so that Mesh, ShaderProgram, GraphicsManager, RenderHelper and the
+// render queue and batches can run on another backend than the real one. CGLDevice passes the calls to
+// OpenGL, CNullDevice does nothing, and CRecordingDevice logs every call with its arguments before passing
+// it on. The enums are the OpenGL ones, and the offsets into buffers are passed as numbers, not pointers.
+// The device is only used on the thread which owns the OpenGL context.
+class CGraphicsDevice
+{
+public:
+	// The optional features which a device may not have
+	enum FEATURE
+	{
+		FEATURE_TIMER_QUERY = 0,		// GL_TIME_ELAPSED queries
+		FEATURE_BUFFER_STORAGE,			// Immutable buffers which can be persistently mapped
+		NUM_FEATURE
+	};
+
+	virtual ~CGraphicsDevice(void) {}
+
+	// Get the device which the rendering goes through. It is the OpenGL device unless another one is set
+	static inline CGraphicsDevice* GetDevice(void) { return theDevice; }
+	// Render through another device, such as a null or recording device, or go back to OpenGL with nullptr.
+	// The device is not deleted, and the objects made with one device must not be used with another
+	static void SetDevice(CGraphicsDevice* _device);
+
+	// Return true if the device has an optional feature
+	virtual bool IsSupported(const FEATURE _feature) = 0;
+
+	// Render states
+	virtual void Enable(const unsigned _cap) = 0;
+	virtual void Disable(const unsigned _cap) = 0;
+	virtual void ClearColor(const float _r, const float _g, const float _b, const float _a) = 0;
+	virtual void DepthFunc(const unsigned _func) = 0;
+	virtual void BlendFunc(const unsigned _srcFactor, const unsigned _dstFactor) = 0;
+	virtual void PolygonMode(const unsigned _face, const unsigned _mode) = 0;
+	virtual void LineWidth(const float _width) = 0;
+	virtual int GetInteger(const unsigned _name) = 0;
+
+	// Buffers
+	virtual unsigned GenBuffer(void) = 0;
+	virtual void DeleteBuffer(const unsigned _buffer) = 0;
+	virtual void BindBuffer(const unsigned _target, const unsigned _buffer) = 0;
+	virtual void BindBufferBase(const unsigned _target, const unsigned _index, const unsigned _buffer) = 0;
+	virtual void BufferData(const unsigned _target, const unsigned _size, const void* _data, const unsigned _usage) = 0;
+	// Give a buffer immutable storage. Return false if FEATURE_BUFFER_STORAGE is not there
+	virtual bool BufferStorage(const unsigned _target, const unsigned _size, const void* _data, const unsigned _flags) = 0;
+	virtual void BufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, const void* _data) = 0;
+	virtual void GetBufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, void* _data) = 0;
+	// Get the size of the buffer bound to a target, in bytes
+	virtual int GetBufferSize(const unsigned _target) = 0;
+	virtual void* MapBufferRange(const unsigned _target, const unsigned _offset, const unsigned _size, const unsigned _access) = 0;
+	virtual void UnmapBuffer(const unsigned _target) = 0;
+
+	// Vertex arrays
+	virtual unsigned GenVertexArray(void) = 0;
+	virtual void DeleteVertexArray(const unsigned _vertexArray) = 0;
+	virtual void BindVertexArray(const unsigned _vertexArray) = 0;
+	virtual void EnableVertexAttribArray(const unsigned _index) = 0;
+	virtual void DisableVertexAttribArray(const unsigned _index) = 0;
+	virtual void VertexAttribPointer(const unsigned _index, const int _size, const unsigned _type, const bool _normalised,
+									 const int _stride, const unsigned _offset) = 0;
+	virtual void VertexAttribDivisor(const unsigned _index, const unsigned _divisor) = 0;
+	virtual void VertexAttrib4f(const unsigned _index, const float _x, const float _y, const float _z, const float _w) = 0;
+
+	// Draw calls, with the offset into the bound index buffer in bytes
+	virtual void DrawElements(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset) = 0;
+	virtual void DrawElementsInstanced(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset,
+									   const int _numOfInstances) = 0;
+
+	// Shaders and programs
+	virtual unsigned CreateShader(const unsigned _type) = 0;
+	virtual void DeleteShader(const unsigned _shader) = 0;
+	virtual void ShaderSource(const unsigned _shader, const std::string& _source) = 0;
+	virtual void CompileShader(const unsigned _shader) = 0;
+	virtual int GetShaderInt(const unsigned _shader, const unsigned _name) = 0;
+	virtual std::string GetShaderInfoLog(const unsigned _shader) = 0;
+	virtual unsigned CreateProgram(void) = 0;
+	virtual void DeleteProgram(const unsigned _program) = 0;
+	virtual void AttachShader(const unsigned _program, const unsigned _shader) = 0;
+	virtual void DetachShader(const unsigned _program, const unsigned _shader) = 0;
+	virtual void LinkProgram(const unsigned _program) = 0;
+	virtual int GetProgramInt(const unsigned _program, const unsigned _name) = 0;
+	virtual std::string GetProgramInfoLog(const unsigned _program) = 0;
+	virtual void UseProgram(const unsigned _program) = 0;
+
+	// Uniforms
+	virtual int GetUniformLocation(const unsigned _program, const char* _name) = 0;
+	virtual unsigned GetUniformBlockIndex(const unsigned _program, const char* _name) = 0;
+	virtual void UniformBlockBinding(const unsigned _program, const unsigned _blockIndex, const unsigned _binding) = 0;
+	virtual void Uniform1i(const int _location, const int _value) = 0;
+	virtual void Uniform1f(const int _location, const float _value) = 0;
+	virtual void Uniform3fv(const int _location, const float* _value) = 0;
+	virtual void UniformMatrix4fv(const int _location, const float* _value) = 0;
+
+	// Textures
+	virtual unsigned GenTexture(void) = 0;
+	virtual void DeleteTexture(const unsigned _texture) = 0;
+	virtual void ActiveTexture(const unsigned _unit) = 0;
+	virtual void BindTexture(const unsigned _target, const unsigned _texture) = 0;
+	virtual void TexBuffer(const unsigned _target, const unsigned _format, const unsigned _buffer) = 0;
+
+	// Fences, as GPU commands complete sync objects
+	virtual void* FenceSync(void) = 0;
+	virtual unsigned ClientWaitSync(void* _sync, const unsigned _flags, const unsigned long long _timeout) = 0;
+	virtual void DeleteSync(void* _sync) = 0;
+
+	// Queries
+	virtual unsigned GenQuery(void) = 0;
+	virtual void DeleteQuery(const unsigned _query) = 0;
+	virtual void BeginQuery(const unsigned _target, const unsigned _query) = 0;
+	virtual void EndQuery(const unsigned _target) = 0;
+	virtual unsigned GetQueryObjectui(const unsigned _query, const unsigned _name) = 0;
+	virtual unsigned long long GetQueryObjectui64(const unsigned _query, const unsigned _name) = 0;
+
+protected:
+	CGraphicsDevice(void) {}
+
+private:
+	static CGraphicsDevice* theDevice;
+};
+
+#endif // GRAPHICS_DEVICE_H
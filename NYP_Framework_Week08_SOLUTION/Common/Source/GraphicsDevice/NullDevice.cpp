@@ -0,0 +1,249 @@
+#include "NullDevice.h"
+#include "GL\glew.h"
+#include <cstring>
+
+CNullDevice::CNullDevice(void)
+	: lastID(0)
+	, lastLocation(-1)
+{
+}
+
+CNullDevice::~CNullDevice(void)
+{
+}
+
+bool CNullDevice::IsSupported(const FEATURE _feature)
+{
+	return false;
+}
+
+void CNullDevice::Enable(const unsigned _cap) {}
+void CNullDevice::Disable(const unsigned _cap) {}
+void CNullDevice::ClearColor(const float _r, const float _g, const float _b, const float _a) {}
+void CNullDevice::DepthFunc(const unsigned _func) {}
+void CNullDevice::BlendFunc(const unsigned _srcFactor, const unsigned _dstFactor) {}
+void CNullDevice::PolygonMode(const unsigned _face, const unsigned _mode) {}
+void CNullDevice::LineWidth(const float _width) {}
+
+int CNullDevice::GetInteger(const unsigned _name)
+{
+	return 0;
+}
+
+unsigned CNullDevice::GenBuffer(void)
+{
+	return ++lastID;
+}
+
+void CNullDevice::DeleteBuffer(const unsigned _buffer)
+{
+	theBufferData.erase(_buffer);
+	for (std::map<unsigned, unsigned>::iterator it = theBoundBuffers.begin(); it != theBoundBuffers.end(); ++it)
+	{
+		if (it->second == _buffer)
+			it->second = 0;
+	}
+}
+
+void CNullDevice::BindBuffer(const unsigned _target, const unsigned _buffer)
+{
+	theBoundBuffers[_target] = _buffer;
+}
+
+void CNullDevice::BindBufferBase(const unsigned _target, const unsigned _index, const unsigned _buffer)
+{
+	theBoundBuffers[_target] = _buffer;
+}
+
+/**
+* Keep a copy of the data, or zeroes if there is none
+*/
+void CNullDevice::BufferData(const unsigned _target, const unsigned _size, const void* _data, const unsigned _usage)
+{
+	std::vector<unsigned char>* theData = GetBoundBufferData(_target);
+	if (theData == nullptr)
+		return;
+
+	theData->assign(_size, 0);
+	if ((_data != nullptr) && (_size > 0))
+		memcpy(&(*theData)[0], _data, _size);
+}
+
+bool CNullDevice::BufferStorage(const unsigned _target, const unsigned _size, const void* _data, const unsigned _flags)
+{
+	return false;
+}
+
+void CNullDevice::BufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, const void* _data)
+{
+	std::vector<unsigned char>* theData = GetBoundBufferData(_target);
+	if ((theData == nullptr) || (_data == nullptr) || (_size == 0) || (_offset + _size > theData->size()))
+		return;
+
+	memcpy(&(*theData)[_offset], _data, _size);
+}
+
+void CNullDevice::GetBufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, void* _data)
+{
+	std::vector<unsigned char>* theData = GetBoundBufferData(_target);
+	if ((theData == nullptr) || (_data == nullptr) || (_size == 0) || (_offset + _size > theData->size()))
+		return;
+
+	memcpy(_data, &(*theData)[_offset], _size);
+}
+
+int CNullDevice::GetBufferSize(const unsigned _target)
+{
+	std::vector<unsigned char>* theData = GetBoundBufferData(_target);
+	return (theData != nullptr) ? (int)theData->size() : 0;
+}
+
+void* CNullDevice::MapBufferRange(const unsigned _target, const unsigned _offset, const unsigned _size, const unsigned _access)
+{
+	return nullptr;
+}
+
+void CNullDevice::UnmapBuffer(const unsigned _target) {}
+
+unsigned CNullDevice::GenVertexArray(void)
+{
+	return ++lastID;
+}
+
+void CNullDevice::DeleteVertexArray(const unsigned _vertexArray) {}
+void CNullDevice::BindVertexArray(const unsigned _vertexArray) {}
+void CNullDevice::EnableVertexAttribArray(const unsigned _index) {}
+void CNullDevice::DisableVertexAttribArray(const unsigned _index) {}
+void CNullDevice::VertexAttribPointer(const unsigned _index, const int _size, const unsigned _type, const bool _normalised,
+									 const int _stride, const unsigned _offset) {}
+void CNullDevice::VertexAttribDivisor(const unsigned _index, const unsigned _divisor) {}
+void CNullDevice::VertexAttrib4f(const unsigned _index, const float _x, const float _y, const float _z, const float _w) {}
+
+void CNullDevice::DrawElements(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset) {}
+void CNullDevice::DrawElementsInstanced(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset,
+									   const int _numOfInstances) {}
+
+unsigned CNullDevice::CreateShader(const unsigned _type)
+{
+	return ++lastID;
+}
+
+void CNullDevice::DeleteShader(const unsigned _shader) {}
+void CNullDevice::ShaderSource(const unsigned _shader, const std::string& _source) {}
+void CNullDevice::CompileShader(const unsigned _shader) {}
+
+/**
+* Every shader compiles, and has no info log
+*/
+int CNullDevice::GetShaderInt(const unsigned _shader, const unsigned _name)
+{
+	return (_name == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+std::string CNullDevice::GetShaderInfoLog(const unsigned _shader)
+{
+	return "";
+}
+
+unsigned CNullDevice::CreateProgram(void)
+{
+	return ++lastID;
+}
+
+void CNullDevice::DeleteProgram(const unsigned _program) {}
+void CNullDevice::AttachShader(const unsigned _program, const unsigned _shader) {}
+void CNullDevice::DetachShader(const unsigned _program, const unsigned _shader) {}
+void CNullDevice::LinkProgram(const unsigned _program) {}
+
+/**
+* Every program links, and has no info log
+*/
+int CNullDevice::GetProgramInt(const unsigned _program, const unsigned _name)
+{
+	return (_name == GL_LINK_STATUS) ? GL_TRUE : 0;
+}
+
+std::string CNullDevice::GetProgramInfoLog(const unsigned _program)
+{
+	return "";
+}
+
+void CNullDevice::UseProgram(const unsigned _program) {}
+
+/**
+* Every uniform is found, at a location of its own, so the uniform updates are not skipped
+*/
+int CNullDevice::GetUniformLocation(const unsigned _program, const char* _name)
+{
+	return ++lastLocation;
+}
+
+unsigned CNullDevice::GetUniformBlockIndex(const unsigned _program, const char* _name)
+{
+	return 0;
+}
+
+void CNullDevice::UniformBlockBinding(const unsigned _program, const unsigned _blockIndex, const unsigned _binding) {}
+void CNullDevice::Uniform1i(const int _location, const int _value) {}
+void CNullDevice::Uniform1f(const int _location, const float _value) {}
+void CNullDevice::Uniform3fv(const int _location, const float* _value) {}
+void CNullDevice::UniformMatrix4fv(const int _location, const float* _value) {}
+
+unsigned CNullDevice::GenTexture(void)
+{
+	return ++lastID;
+}
+
+void CNullDevice::DeleteTexture(const unsigned _texture) {}
+void CNullDevice::ActiveTexture(const unsigned _unit) {}
+void CNullDevice::BindTexture(const unsigned _target, const unsigned _texture) {}
+void CNullDevice::TexBuffer(const unsigned _target, const unsigned _format, const unsigned _buffer) {}
+
+void* CNullDevice::FenceSync(void)
+{
+	return nullptr;
+}
+
+/**
+* There is no GPU to wait for, so every fence is already signaled
+*/
+unsigned CNullDevice::ClientWaitSync(void* _sync, const unsigned _flags, const unsigned long long _timeout)
+{
+	return GL_ALREADY_SIGNALED;
+}
+
+void CNullDevice::DeleteSync(void* _sync) {}
+
+unsigned CNullDevice::GenQuery(void)
+{
+	return ++lastID;
+}
+
+void CNullDevice::DeleteQuery(const unsigned _query) {}
+void CNullDevice::BeginQuery(const unsigned _target, const unsigned _query) {}
+void CNullDevice::EndQuery(const unsigned _target) {}
+
+/**
+* Every query is done at once, with a result of 0
+*/
+unsigned CNullDevice::GetQueryObjectui(const unsigned _query, const unsigned _name)
+{
+	return (_name == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+
+unsigned long long CNullDevice::GetQueryObjectui64(const unsigned _query, const unsigned _name)
+{
+	return 0;
+}
+
+/**
+* Get the bytes of the buffer bound to a target, or nullptr if no buffer is bound to it
+*/
+std::vector<unsigned char>* CNullDevice::GetBoundBufferData(const unsigned _target)
+{
+	std::map<unsigned, unsigned>::iterator it = theBoundBuffers.find(_target);
+	if ((it == theBoundBuffers.end()) || (it->second == 0))
+		return nullptr;
+
+	return &theBufferData[it->second];
+}
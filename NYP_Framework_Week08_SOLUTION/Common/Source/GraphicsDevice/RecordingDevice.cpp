@@ -0,0 +1,582 @@
+#include "RecordingDevice.h"
+#include "NullDevice.h"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+	// An argument which is logged in hex, as the OpenGL enums are
+	struct Enum
+	{
+		unsigned value;
+		explicit Enum(const unsigned _value) : value(_value) {}
+	};
+
+	ostream& operator<<(ostream& os, const Enum& _enum)
+	{
+		return os << "0x" << hex << setw(4) << setfill('0') << _enum.value << dec << setfill(' ');
+	}
+
+	// Log a pointer to data as "data" or "null", since its address changes from run to run
+	const char* Data(const void* _data)
+	{
+		return (_data != nullptr) ? "data" : "null";
+	}
+
+	// Log a name in quotes
+	string Quote(const char* _name)
+	{
+		return string("\"") + ((_name != nullptr) ? _name : "") + "\"";
+	}
+
+	// Log the 3 floats of a vector
+	string Vec3(const float* _value)
+	{
+		if (_value == nullptr)
+			return "null";
+		ostringstream os;
+		os << "[" << _value[0] << ", " << _value[1] << ", " << _value[2] << "]";
+		return os.str();
+	}
+
+	void AddArgs(ostringstream& os)
+	{
+	}
+
+	template<typename T, typename... Args>
+	void AddArgs(ostringstream& os, const T& _first, const Args&... _rest)
+	{
+		os << _first;
+		if (sizeof...(_rest) > 0)
+			os << ", ";
+		AddArgs(os, _rest...);
+	}
+}
+
+CRecordingDevice::CRecordingDevice(CGraphicsDevice* _innerDevice)
+	: theInnerDevice(_innerDevice)
+	, bOwnsInnerDevice(false)
+	, bLogging(true)
+	, numOfCalls(0)
+{
+	if (theInnerDevice == nullptr)
+	{
+		theInnerDevice = new CNullDevice();
+		bOwnsInnerDevice = true;
+	}
+}
+
+CRecordingDevice::~CRecordingDevice(void)
+{
+	if (bOwnsInnerDevice)
+		delete theInnerDevice;
+}
+
+/**
+* Get the calls which were logged since the last Clear
+*/
+const std::vector<std::string>& CRecordingDevice::GetLog(void) const
+{
+	return theLog;
+}
+
+/**
+* Get the number of calls of a function since the last Clear
+*/
+int CRecordingDevice::GetNumOfCalls(const std::string& _name) const
+{
+	std::map<std::string, int>::const_iterator it = theCallCounts.find(_name);
+	return (it != theCallCounts.end()) ? it->second : 0;
+}
+
+/**
+* Get the number of calls of every function since the last Clear
+*/
+int CRecordingDevice::GetNumOfCalls(void) const
+{
+	return numOfCalls;
+}
+
+/**
+* Forget the logged calls and the counts
+*/
+void CRecordingDevice::Clear(void)
+{
+	theLog.clear();
+	theCallCounts.clear();
+	numOfCalls = 0;
+}
+
+/**
+* Enable / Disable the log. The calls are still counted without it
+*/
+void CRecordingDevice::SetLogging(const bool _bLogging)
+{
+	bLogging = _bLogging;
+}
+
+/**
+* Count a call, and log it with its arguments
+*/
+template<typename... Args>
+void CRecordingDevice::Record(const char* _name, const Args&... _args)
+{
+	theCallCounts[_name]++;
+	numOfCalls++;
+	if (!bLogging)
+		return;
+
+	ostringstream os;
+	os << boolalpha << _name << "(";
+	AddArgs(os, _args...);
+	os << ")";
+	theLog.push_back(os.str());
+}
+
+/**
+* Add the value which the last call returned to its log line
+*/
+template<typename T>
+void CRecordingDevice::Returns(const T& _value)
+{
+	if ((!bLogging) || (theLog.empty()))
+		return;
+
+	ostringstream os;
+	os << boolalpha << " = " << _value;
+	theLog.back() += os.str();
+}
+
+bool CRecordingDevice::IsSupported(const FEATURE _feature)
+{
+	bool result = theInnerDevice->IsSupported(_feature);
+	Record("IsSupported", (int)_feature);
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::Enable(const unsigned _cap)
+{
+	theInnerDevice->Enable(_cap);
+	Record("Enable", Enum(_cap));
+}
+
+void CRecordingDevice::Disable(const unsigned _cap)
+{
+	theInnerDevice->Disable(_cap);
+	Record("Disable", Enum(_cap));
+}
+
+void CRecordingDevice::ClearColor(const float _r, const float _g, const float _b, const float _a)
+{
+	theInnerDevice->ClearColor(_r, _g, _b, _a);
+	Record("ClearColor", _r, _g, _b, _a);
+}
+
+void CRecordingDevice::DepthFunc(const unsigned _func)
+{
+	theInnerDevice->DepthFunc(_func);
+	Record("DepthFunc", Enum(_func));
+}
+
+void CRecordingDevice::BlendFunc(const unsigned _srcFactor, const unsigned _dstFactor)
+{
+	theInnerDevice->BlendFunc(_srcFactor, _dstFactor);
+	Record("BlendFunc", Enum(_srcFactor), Enum(_dstFactor));
+}
+
+void CRecordingDevice::PolygonMode(const unsigned _face, const unsigned _mode)
+{
+	theInnerDevice->PolygonMode(_face, _mode);
+	Record("PolygonMode", Enum(_face), Enum(_mode));
+}
+
+void CRecordingDevice::LineWidth(const float _width)
+{
+	theInnerDevice->LineWidth(_width);
+	Record("LineWidth", _width);
+}
+
+int CRecordingDevice::GetInteger(const unsigned _name)
+{
+	int result = theInnerDevice->GetInteger(_name);
+	Record("GetInteger", Enum(_name));
+	Returns(result);
+	return result;
+}
+
+unsigned CRecordingDevice::GenBuffer(void)
+{
+	unsigned result = theInnerDevice->GenBuffer();
+	Record("GenBuffer");
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::DeleteBuffer(const unsigned _buffer)
+{
+	theInnerDevice->DeleteBuffer(_buffer);
+	Record("DeleteBuffer", _buffer);
+}
+
+void CRecordingDevice::BindBuffer(const unsigned _target, const unsigned _buffer)
+{
+	theInnerDevice->BindBuffer(_target, _buffer);
+	Record("BindBuffer", Enum(_target), _buffer);
+}
+
+void CRecordingDevice::BindBufferBase(const unsigned _target, const unsigned _index, const unsigned _buffer)
+{
+	theInnerDevice->BindBufferBase(_target, _index, _buffer);
+	Record("BindBufferBase", Enum(_target), _index, _buffer);
+}
+
+void CRecordingDevice::BufferData(const unsigned _target, const unsigned _size, const void* _data, const unsigned _usage)
+{
+	theInnerDevice->BufferData(_target, _size, _data, _usage);
+	Record("BufferData", Enum(_target), _size, Data(_data), Enum(_usage));
+}
+
+bool CRecordingDevice::BufferStorage(const unsigned _target, const unsigned _size, const void* _data, const unsigned _flags)
+{
+	bool result = theInnerDevice->BufferStorage(_target, _size, _data, _flags);
+	Record("BufferStorage", Enum(_target), _size, Data(_data), Enum(_flags));
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::BufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, const void* _data)
+{
+	theInnerDevice->BufferSubData(_target, _offset, _size, _data);
+	Record("BufferSubData", Enum(_target), _offset, _size, Data(_data));
+}
+
+void CRecordingDevice::GetBufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, void* _data)
+{
+	theInnerDevice->GetBufferSubData(_target, _offset, _size, _data);
+	Record("GetBufferSubData", Enum(_target), _offset, _size, Data(_data));
+}
+
+int CRecordingDevice::GetBufferSize(const unsigned _target)
+{
+	int result = theInnerDevice->GetBufferSize(_target);
+	Record("GetBufferSize", Enum(_target));
+	Returns(result);
+	return result;
+}
+
+void* CRecordingDevice::MapBufferRange(const unsigned _target, const unsigned _offset, const unsigned _size, const unsigned _access)
+{
+	void* result = theInnerDevice->MapBufferRange(_target, _offset, _size, _access);
+	Record("MapBufferRange", Enum(_target), _offset, _size, Enum(_access));
+	Returns(Data(result));
+	return result;
+}
+
+void CRecordingDevice::UnmapBuffer(const unsigned _target)
+{
+	theInnerDevice->UnmapBuffer(_target);
+	Record("UnmapBuffer", Enum(_target));
+}
+
+unsigned CRecordingDevice::GenVertexArray(void)
+{
+	unsigned result = theInnerDevice->GenVertexArray();
+	Record("GenVertexArray");
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::DeleteVertexArray(const unsigned _vertexArray)
+{
+	theInnerDevice->DeleteVertexArray(_vertexArray);
+	Record("DeleteVertexArray", _vertexArray);
+}
+
+void CRecordingDevice::BindVertexArray(const unsigned _vertexArray)
+{
+	theInnerDevice->BindVertexArray(_vertexArray);
+	Record("BindVertexArray", _vertexArray);
+}
+
+void CRecordingDevice::EnableVertexAttribArray(const unsigned _index)
+{
+	theInnerDevice->EnableVertexAttribArray(_index);
+	Record("EnableVertexAttribArray", _index);
+}
+
+void CRecordingDevice::DisableVertexAttribArray(const unsigned _index)
+{
+	theInnerDevice->DisableVertexAttribArray(_index);
+	Record("DisableVertexAttribArray", _index);
+}
+
+void CRecordingDevice::VertexAttribPointer(const unsigned _index, const int _size, const unsigned _type, const bool _normalised,
+										   const int _stride, const unsigned _offset)
+{
+	theInnerDevice->VertexAttribPointer(_index, _size, _type, _normalised, _stride, _offset);
+	Record("VertexAttribPointer", _index, _size, Enum(_type), _normalised, _stride, _offset);
+}
+
+void CRecordingDevice::VertexAttribDivisor(const unsigned _index, const unsigned _divisor)
+{
+	theInnerDevice->VertexAttribDivisor(_index, _divisor);
+	Record("VertexAttribDivisor", _index, _divisor);
+}
+
+void CRecordingDevice::VertexAttrib4f(const unsigned _index, const float _x, const float _y, const float _z, const float _w)
+{
+	theInnerDevice->VertexAttrib4f(_index, _x, _y, _z, _w);
+	Record("VertexAttrib4f", _index, _x, _y, _z, _w);
+}
+
+void CRecordingDevice::DrawElements(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset)
+{
+	theInnerDevice->DrawElements(_mode, _count, _type, _offset);
+	Record("DrawElements", Enum(_mode), _count, Enum(_type), _offset);
+}
+
+void CRecordingDevice::DrawElementsInstanced(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset,
+											 const int _numOfInstances)
+{
+	theInnerDevice->DrawElementsInstanced(_mode, _count, _type, _offset, _numOfInstances);
+	Record("DrawElementsInstanced", Enum(_mode), _count, Enum(_type), _offset, _numOfInstances);
+}
+
+unsigned CRecordingDevice::CreateShader(const unsigned _type)
+{
+	unsigned result = theInnerDevice->CreateShader(_type);
+	Record("CreateShader", Enum(_type));
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::DeleteShader(const unsigned _shader)
+{
+	theInnerDevice->DeleteShader(_shader);
+	Record("DeleteShader", _shader);
+}
+
+void CRecordingDevice::ShaderSource(const unsigned _shader, const std::string& _source)
+{
+	theInnerDevice->ShaderSource(_shader, _source);
+	Record("ShaderSource", _shader, Data(_source.c_str()));
+}
+
+void CRecordingDevice::CompileShader(const unsigned _shader)
+{
+	theInnerDevice->CompileShader(_shader);
+	Record("CompileShader", _shader);
+}
+
+int CRecordingDevice::GetShaderInt(const unsigned _shader, const unsigned _name)
+{
+	int result = theInnerDevice->GetShaderInt(_shader, _name);
+	Record("GetShaderInt", _shader, Enum(_name));
+	Returns(result);
+	return result;
+}
+
+std::string CRecordingDevice::GetShaderInfoLog(const unsigned _shader)
+{
+	std::string result = theInnerDevice->GetShaderInfoLog(_shader);
+	Record("GetShaderInfoLog", _shader);
+	return result;
+}
+
+unsigned CRecordingDevice::CreateProgram(void)
+{
+	unsigned result = theInnerDevice->CreateProgram();
+	Record("CreateProgram");
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::DeleteProgram(const unsigned _program)
+{
+	theInnerDevice->DeleteProgram(_program);
+	Record("DeleteProgram", _program);
+}
+
+void CRecordingDevice::AttachShader(const unsigned _program, const unsigned _shader)
+{
+	theInnerDevice->AttachShader(_program, _shader);
+	Record("AttachShader", _program, _shader);
+}
+
+void CRecordingDevice::DetachShader(const unsigned _program, const unsigned _shader)
+{
+	theInnerDevice->DetachShader(_program, _shader);
+	Record("DetachShader", _program, _shader);
+}
+
+void CRecordingDevice::LinkProgram(const unsigned _program)
+{
+	theInnerDevice->LinkProgram(_program);
+	Record("LinkProgram", _program);
+}
+
+int CRecordingDevice::GetProgramInt(const unsigned _program, const unsigned _name)
+{
+	int result = theInnerDevice->GetProgramInt(_program, _name);
+	Record("GetProgramInt", _program, Enum(_name));
+	Returns(result);
+	return result;
+}
+
+std::string CRecordingDevice::GetProgramInfoLog(const unsigned _program)
+{
+	std::string result = theInnerDevice->GetProgramInfoLog(_program);
+	Record("GetProgramInfoLog", _program);
+	return result;
+}
+
+void CRecordingDevice::UseProgram(const unsigned _program)
+{
+	theInnerDevice->UseProgram(_program);
+	Record("UseProgram", _program);
+}
+
+int CRecordingDevice::GetUniformLocation(const unsigned _program, const char* _name)
+{
+	int result = theInnerDevice->GetUniformLocation(_program, _name);
+	Record("GetUniformLocation", _program, Quote(_name));
+	Returns(result);
+	return result;
+}
+
+unsigned CRecordingDevice::GetUniformBlockIndex(const unsigned _program, const char* _name)
+{
+	unsigned result = theInnerDevice->GetUniformBlockIndex(_program, _name);
+	Record("GetUniformBlockIndex", _program, Quote(_name));
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::UniformBlockBinding(const unsigned _program, const unsigned _blockIndex, const unsigned _binding)
+{
+	theInnerDevice->UniformBlockBinding(_program, _blockIndex, _binding);
+	Record("UniformBlockBinding", _program, _blockIndex, _binding);
+}
+
+void CRecordingDevice::Uniform1i(const int _location, const int _value)
+{
+	theInnerDevice->Uniform1i(_location, _value);
+	Record("Uniform1i", _location, _value);
+}
+
+void CRecordingDevice::Uniform1f(const int _location, const float _value)
+{
+	theInnerDevice->Uniform1f(_location, _value);
+	Record("Uniform1f", _location, _value);
+}
+
+void CRecordingDevice::Uniform3fv(const int _location, const float* _value)
+{
+	theInnerDevice->Uniform3fv(_location, _value);
+	Record("Uniform3fv", _location, Vec3(_value));
+}
+
+void CRecordingDevice::UniformMatrix4fv(const int _location, const float* _value)
+{
+	theInnerDevice->UniformMatrix4fv(_location, _value);
+	Record("UniformMatrix4fv", _location, Data(_value));
+}
+
+unsigned CRecordingDevice::GenTexture(void)
+{
+	unsigned result = theInnerDevice->GenTexture();
+	Record("GenTexture");
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::DeleteTexture(const unsigned _texture)
+{
+	theInnerDevice->DeleteTexture(_texture);
+	Record("DeleteTexture", _texture);
+}
+
+void CRecordingDevice::ActiveTexture(const unsigned _unit)
+{
+	theInnerDevice->ActiveTexture(_unit);
+	Record("ActiveTexture", Enum(_unit));
+}
+
+void CRecordingDevice::BindTexture(const unsigned _target, const unsigned _texture)
+{
+	theInnerDevice->BindTexture(_target, _texture);
+	Record("BindTexture", Enum(_target), _texture);
+}
+
+void CRecordingDevice::TexBuffer(const unsigned _target, const unsigned _format, const unsigned _buffer)
+{
+	theInnerDevice->TexBuffer(_target, _format, _buffer);
+	Record("TexBuffer", Enum(_target), Enum(_format), _buffer);
+}
+
+void* CRecordingDevice::FenceSync(void)
+{
+	void* result = theInnerDevice->FenceSync();
+	Record("FenceSync");
+	Returns(Data(result));
+	return result;
+}
+
+unsigned CRecordingDevice::ClientWaitSync(void* _sync, const unsigned _flags, const unsigned long long _timeout)
+{
+	unsigned result = theInnerDevice->ClientWaitSync(_sync, _flags, _timeout);
+	Record("ClientWaitSync", Data(_sync), Enum(_flags), _timeout);
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::DeleteSync(void* _sync)
+{
+	theInnerDevice->DeleteSync(_sync);
+	Record("DeleteSync", Data(_sync));
+}
+
+unsigned CRecordingDevice::GenQuery(void)
+{
+	unsigned result = theInnerDevice->GenQuery();
+	Record("GenQuery");
+	Returns(result);
+	return result;
+}
+
+void CRecordingDevice::DeleteQuery(const unsigned _query)
+{
+	theInnerDevice->DeleteQuery(_query);
+	Record("DeleteQuery", _query);
+}
+
+void CRecordingDevice::BeginQuery(const unsigned _target, const unsigned _query)
+{
+	theInnerDevice->BeginQuery(_target, _query);
+	Record("BeginQuery", Enum(_target), _query);
+}
+
+void CRecordingDevice::EndQuery(const unsigned _target)
+{
+	theInnerDevice->EndQuery(_target);
+	Record("EndQuery", Enum(_target));
+}
+
+unsigned CRecordingDevice::GetQueryObjectui(const unsigned _query, const unsigned _name)
+{
+	unsigned result = theInnerDevice->GetQueryObjectui(_query, _name);
+	Record("GetQueryObjectui", _query, Enum(_name));
+	Returns(result);
+	return result;
+}
+
+unsigned long long CRecordingDevice::GetQueryObjectui64(const unsigned _query, const unsigned _name)
+{
+	unsigned long long result = theInnerDevice->GetQueryObjectui64(_query, _name);
+	Record("GetQueryObjectui64", _query, Enum(_name));
+	Returns(result);
+	return result;
+}
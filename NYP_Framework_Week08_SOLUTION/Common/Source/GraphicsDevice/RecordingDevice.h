@@ -0,0 +1,134 @@
+#ifndef RECORDING_DEVICE_H
+#define RECORDING_DEVICE_H
+
+#include "GraphicsDevice.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// A device which logs every call with its arguments, then passes it on to another device. With the null
+// device under it, the render path can be run without a context and its calls compared against a known log,
+// such as to check that a change to the render queue still makes the same draw calls. With the OpenGL device
+// under it, it traces the calls of a frame. Each call is logged as a line such as
+// "DrawElements(0x0004, 36, 0x1403, 0)", with the enums in hex, the data pointers as "data" or "null",
+// and the value which a call returns after " = ".
+class CRecordingDevice : public CGraphicsDevice
+{
+public:
+	// Record the calls on top of another device, or on top of a null device of its own with nullptr
+	CRecordingDevice(CGraphicsDevice* _innerDevice = nullptr);
+	virtual ~CRecordingDevice(void);
+
+	// Get the calls which were logged since the last Clear
+	const std::vector<std::string>& GetLog(void) const;
+	// Get the number of calls of a function, such as "DrawElements", or of every function, since the last Clear
+	int GetNumOfCalls(const std::string& _name) const;
+	int GetNumOfCalls(void) const;
+	// Forget the logged calls and the counts
+	void Clear(void);
+	// Enable / Disable the log. The calls are still counted without it, which is cheaper for timing
+	void SetLogging(const bool _bLogging);
+
+	virtual bool IsSupported(const FEATURE _feature);
+
+	// Render states
+	virtual void Enable(const unsigned _cap);
+	virtual void Disable(const unsigned _cap);
+	virtual void ClearColor(const float _r, const float _g, const float _b, const float _a);
+	virtual void DepthFunc(const unsigned _func);
+	virtual void BlendFunc(const unsigned _srcFactor, const unsigned _dstFactor);
+	virtual void PolygonMode(const unsigned _face, const unsigned _mode);
+	virtual void LineWidth(const float _width);
+	virtual int GetInteger(const unsigned _name);
+
+	// Buffers
+	virtual unsigned GenBuffer(void);
+	virtual void DeleteBuffer(const unsigned _buffer);
+	virtual void BindBuffer(const unsigned _target, const unsigned _buffer);
+	virtual void BindBufferBase(const unsigned _target, const unsigned _index, const unsigned _buffer);
+	virtual void BufferData(const unsigned _target, const unsigned _size, const void* _data, const unsigned _usage);
+	virtual bool BufferStorage(const unsigned _target, const unsigned _size, const void* _data, const unsigned _flags);
+	virtual void BufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, const void* _data);
+	virtual void GetBufferSubData(const unsigned _target, const unsigned _offset, const unsigned _size, void* _data);
+	virtual int GetBufferSize(const unsigned _target);
+	virtual void* MapBufferRange(const unsigned _target, const unsigned _offset, const unsigned _size, const unsigned _access);
+	virtual void UnmapBuffer(const unsigned _target);
+
+	// Vertex arrays
+	virtual unsigned GenVertexArray(void);
+	virtual void DeleteVertexArray(const unsigned _vertexArray);
+	virtual void BindVertexArray(const unsigned _vertexArray);
+	virtual void EnableVertexAttribArray(const unsigned _index);
+	virtual void DisableVertexAttribArray(const unsigned _index);
+	virtual void VertexAttribPointer(const unsigned _index, const int _size, const unsigned _type, const bool _normalised,
+								 const int _stride, const unsigned _offset);
+	virtual void VertexAttribDivisor(const unsigned _index, const unsigned _divisor);
+	virtual void VertexAttrib4f(const unsigned _index, const float _x, const float _y, const float _z, const float _w);
+
+	// Draw calls, with the offset into the bound index buffer in bytes
+	virtual void DrawElements(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset);
+	virtual void DrawElementsInstanced(const unsigned _mode, const int _count, const unsigned _type, const unsigned _offset,
+								   const int _numOfInstances);
+
+	// Shaders and programs
+	virtual unsigned CreateShader(const unsigned _type);
+	virtual void DeleteShader(const unsigned _shader);
+	virtual void ShaderSource(const unsigned _shader, const std::string& _source);
+	virtual void CompileShader(const unsigned _shader);
+	virtual int GetShaderInt(const unsigned _shader, const unsigned _name);
+	virtual std::string GetShaderInfoLog(const unsigned _shader);
+	virtual unsigned CreateProgram(void);
+	virtual void DeleteProgram(const unsigned _program);
+	virtual void AttachShader(const unsigned _program, const unsigned _shader);
+	virtual void DetachShader(const unsigned _program, const unsigned _shader);
+	virtual void LinkProgram(const unsigned _program);
+	virtual int GetProgramInt(const unsigned _program, const unsigned _name);
+	virtual std::string GetProgramInfoLog(const unsigned _program);
+	virtual void UseProgram(const unsigned _program);
+
+	// Uniforms
+	virtual int GetUniformLocation(const unsigned _program, const char* _name);
+	virtual unsigned GetUniformBlockIndex(const unsigned _program, const char* _name);
+	virtual void UniformBlockBinding(const unsigned _program, const unsigned _blockIndex, const unsigned _binding);
+	virtual void Uniform1i(const int _location, const int _value);
+	virtual void Uniform1f(const int _location, const float _value);
+	virtual void Uniform3fv(const int _location, const float* _value);
+	virtual void UniformMatrix4fv(const int _location, const float* _value);
+
+	// Textures
+	virtual unsigned GenTexture(void);
+	virtual void DeleteTexture(const unsigned _texture);
+	virtual void ActiveTexture(const unsigned _unit);
+	virtual void BindTexture(const unsigned _target, const unsigned _texture);
+	virtual void TexBuffer(const unsigned _target, const unsigned _format, const unsigned _buffer);
+
+	// Fences, as GPU commands complete sync objects
+	virtual void* FenceSync(void);
+	virtual unsigned ClientWaitSync(void* _sync, const unsigned _flags, const unsigned long long _timeout);
+	virtual void DeleteSync(void* _sync);
+
+	// Queries
+	virtual unsigned GenQuery(void);
+	virtual void DeleteQuery(const unsigned _query);
+	virtual void BeginQuery(const unsigned _target, const unsigned _query);
+	virtual void EndQuery(const unsigned _target);
+	virtual unsigned GetQueryObjectui(const unsigned _query, const unsigned _name);
+	virtual unsigned long long GetQueryObjectui64(const unsigned _query, const unsigned _name);
+
+protected:
+	// Count a call, and log it with its arguments
+	template<typename... Args>
+	void Record(const char* _name, const Args&... _args);
+	// Add the value which the last call returned to its log line
+	template<typename T>
+	void Returns(const T& _value);
+
+	CGraphicsDevice* theInnerDevice;
+	bool bOwnsInnerDevice;
+	bool bLogging;
+	std::vector<std::string> theLog;
+	std::map<std::string, int> theCallCounts;
+	int numOfCalls;
+};
+
+#endif // RECORDING_DEVICE_H
@@ -1,13 +1,23 @@
 #include "GraphicsManager.h"
 #include "GL\glew.h"
 #include <vector>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include "ShaderProgram.h"
 #include "CameraBase.h"
 #include "LightBase.h"
+#include "LightClusters.h"
+#include "RenderStats.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+
+// The model stack of a thread which records for CRenderQueue::RecordParallel
+static thread_local MS* theThreadModelStack = nullptr;
 
 GraphicsManager::GraphicsManager() :
+bLightsUploaded(false),
+frameUniformBuffer(0),
+lightUniformBuffer(0),
 activeShader(nullptr),
 activeCamera(nullptr)
 {
@@ -15,26 +25,44 @@ activeCamera(nullptr)
 
 GraphicsManager::~GraphicsManager()
 {
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	if (frameUniformBuffer != 0)
+		theDevice->DeleteBuffer(frameUniformBuffer);
+	if (lightUniformBuffer != 0)
+		theDevice->DeleteBuffer(lightUniformBuffer);
 }
 
 void GraphicsManager::Init()
 {
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
 	// Black background
-	glClearColor(0.0f, 0.0f, 0.4f, 0.0f);
+	theDevice->ClearColor(0.0f, 0.0f, 0.4f, 0.0f);
 	// Enable depth test
-	glEnable(GL_DEPTH_TEST);
+	theDevice->Enable(GL_DEPTH_TEST);
 	// Accept fragment if it closer to the camera than the former one
-	glDepthFunc(GL_LESS);
+	theDevice->DepthFunc(GL_LESS);
+
+	theDevice->Enable(GL_CULL_FACE);
+
+	theDevice->PolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-	glEnable(GL_CULL_FACE);
+	theDevice->Enable(GL_BLEND);
+	theDevice->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	// Create the uniform buffers shared by all the shaders, and attach them to their binding points
+	frameUniformBuffer = theDevice->GenBuffer();
+	theDevice->BindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+	theDevice->BufferData(GL_UNIFORM_BUFFER, 36 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+	theDevice->BindBufferBase(GL_UNIFORM_BUFFER, ShaderProgram::FRAME_BLOCK_BINDING, frameUniformBuffer);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	lightUniformBuffer = theDevice->GenBuffer();
+	theDevice->BindBuffer(GL_UNIFORM_BUFFER, lightUniformBuffer);
+	theDevice->BufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), NULL, GL_DYNAMIC_DRAW);
+	theDevice->BindBufferBase(GL_UNIFORM_BUFFER, ShaderProgram::LIGHT_BLOCK_BINDING, lightUniformBuffer);
+	theDevice->BindBuffer(GL_UNIFORM_BUFFER, 0);
+	bLightsUploaded = false;
 
-	glGenVertexArrays(1, &vertexArrayID);
-	glBindVertexArray(vertexArrayID);
+	CLightClusters::GetInstance()->Init();
 }
 
 ShaderProgram* GraphicsManager::LoadShader(const std::string& _name, const std::string& _vertexFilePath, const std::string& _fragmentFilePath)
@@ -74,8 +102,9 @@ ShaderProgram* GraphicsManager::LoadShader(const std::string& _name, const std::
 	}
 
 	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	GLuint VertexShaderID = theDevice->CreateShader(GL_VERTEX_SHADER);
+	GLuint FragmentShaderID = theDevice->CreateShader(GL_FRAGMENT_SHADER);
 	
 	GLint Result = GL_FALSE;
 //	int InfoLogLength;
@@ -83,25 +112,18 @@ ShaderProgram* GraphicsManager::LoadShader(const std::string& _name, const std::
 
 	// Compile Vertex Shader
 	printf("Compiling shader : %s\n", _vertexFilePath.c_str());
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer, NULL);
-	glCompileShader(VertexShaderID);
+	theDevice->ShaderSource(VertexShaderID, VertexShaderCode);
+	theDevice->CompileShader(VertexShaderID);
 
-	GLint isCompiled = 0;
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &isCompiled);
+	GLint isCompiled = theDevice->GetShaderInt(VertexShaderID, GL_COMPILE_STATUS);
 	if (isCompiled == GL_FALSE)
 	{
-		GLint maxLength = 0;
-		glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &maxLength);
-
-		// The maxLength includes the NULL character
-		std::vector<GLchar> errorLog(maxLength);
-		glGetShaderInfoLog(VertexShaderID, maxLength, &maxLength, &errorLog[0]);
+		std::string errorLog = theDevice->GetShaderInfoLog(VertexShaderID);
 
 		// Provide the infolog in whatever manor you deem best.
-		printf("%s\n", &errorLog[0]);
+		printf("%s\n", errorLog.c_str());
 		// Exit with failure.
-		glDeleteShader(VertexShaderID); // Don't leak the shader.
+		theDevice->DeleteShader(VertexShaderID); // Don't leak the shader.
 		compileResult = false;
 	}
 	/*
@@ -119,25 +141,18 @@ ShaderProgram* GraphicsManager::LoadShader(const std::string& _name, const std::
 
 	// Compile Fragment Shader
 	printf("Compiling shader : %s\n", _fragmentFilePath.c_str());
-	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer, NULL);
-	glCompileShader(FragmentShaderID);
+	theDevice->ShaderSource(FragmentShaderID, FragmentShaderCode);
+	theDevice->CompileShader(FragmentShaderID);
 
-	GLint isFragmentCompiled = 0;
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &isFragmentCompiled);
+	GLint isFragmentCompiled = theDevice->GetShaderInt(FragmentShaderID, GL_COMPILE_STATUS);
 	if (isFragmentCompiled == GL_FALSE)
 	{
-		GLint maxLength = 0;
-		glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &maxLength);
-
-		// The maxLength includes the NULL character
-		std::vector<GLchar> errorLog(maxLength);
-		glGetShaderInfoLog(FragmentShaderID, maxLength, &maxLength, &errorLog[0]);
+		std::string errorLog = theDevice->GetShaderInfoLog(FragmentShaderID);
 
 		// Provide the infolog in whatever manor you deem best.
-		printf("%s\n", &errorLog[0]);
+		printf("%s\n", errorLog.c_str());
 		// Exit with failure.
-		glDeleteShader(FragmentShaderID); // Don't leak the shader.
+		theDevice->DeleteShader(FragmentShaderID); // Don't leak the shader.
 		compileResult = false;
 	}
 
@@ -162,39 +177,33 @@ ShaderProgram* GraphicsManager::LoadShader(const std::string& _name, const std::
 
 	// Link the program
 	printf("Linking program\n");
-	GLuint ProgramID = glCreateProgram();
-	glAttachShader(ProgramID, VertexShaderID);
-	glAttachShader(ProgramID, FragmentShaderID);
-	glLinkProgram(ProgramID);
-
-	//Note the different functions here: glGetProgram* instead of glGetShader*.
-	GLint isLinked = 0;
-	glGetProgramiv(ProgramID, GL_LINK_STATUS, (int *)&isLinked);
+	GLuint ProgramID = theDevice->CreateProgram();
+	theDevice->AttachShader(ProgramID, VertexShaderID);
+	theDevice->AttachShader(ProgramID, FragmentShaderID);
+	theDevice->LinkProgram(ProgramID);
+
+	//Note the different functions here: GetProgram* instead of GetShader*.
+	GLint isLinked = theDevice->GetProgramInt(ProgramID, GL_LINK_STATUS);
 	if (isLinked == GL_FALSE)
 	{
-		GLint maxLength = 0;
-		glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &maxLength);
-
-		//The maxLength includes the NULL character
-		std::vector<GLchar> infoLog(maxLength);
-		glGetProgramInfoLog(ProgramID, maxLength, &maxLength, &infoLog[0]);
+		std::string infoLog = theDevice->GetProgramInfoLog(ProgramID);
 
 		//We don't need the program anymore.
-		glDeleteProgram(ProgramID);
+		theDevice->DeleteProgram(ProgramID);
 		//Don't leak shaders either.
-		glDeleteShader(VertexShaderID);
-		glDeleteShader(FragmentShaderID);
+		theDevice->DeleteShader(VertexShaderID);
+		theDevice->DeleteShader(FragmentShaderID);
 
 		//Use the infoLog as you see fit.
-		printf("%s\n", &infoLog[0]);
+		printf("%s\n", infoLog.c_str());
 
 		//In this simple program, we'll just leave
 		compileResult = false;
 	}
 
 	//Always detach shaders after a successful link.
-	glDetachShader(ProgramID, VertexShaderID);
-	glDetachShader(ProgramID, FragmentShaderID);
+	theDevice->DetachShader(ProgramID, VertexShaderID);
+	theDevice->DetachShader(ProgramID, FragmentShaderID);
 	/*
 	// Check the program
 	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
@@ -230,7 +239,8 @@ void GraphicsManager::SetActiveShader(const std::string& _name)
 	}
 
 	activeShader = shaderMap[_name];
-	glUseProgram(activeShader->GetProgramID());
+	CGraphicsDevice::GetDevice()->UseProgram(activeShader->GetProgramID());
+	CRenderStats::GetInstance()->AddProgramSwitch();
 }
 
 ShaderProgram* GraphicsManager::GetActiveShader()
@@ -260,6 +270,10 @@ void GraphicsManager::DetachCamera()
 
 Mtx44& GraphicsManager::GetViewMatrix()
 {
+	// The recording threads share the view matrix, which was updated before they started
+	if (theThreadModelStack != nullptr)
+		return viewMatrix;
+
 	if (activeCamera == nullptr)
 	{
 		// Set to default if no camera available
@@ -273,6 +287,36 @@ Mtx44& GraphicsManager::GetViewMatrix()
 	return viewMatrix;
 }
 
+MS& GraphicsManager::GetModelStack()
+{
+	if (theThreadModelStack != nullptr)
+		return *theThreadModelStack;
+	return modelStack;
+}
+
+void GraphicsManager::SetThreadModelStack(MS* _modelStack)
+{
+	theThreadModelStack = _modelStack;
+}
+
+void GraphicsManager::UpdateFrameUniforms()
+{
+	// The clusters depend on the view, so the lights are binned again for every view
+	CLightClusters::GetInstance()->Build(clusteredLights, clusteredLightRanges, GetViewMatrix(), projectionMatrix);
+
+	// mat4 view, then mat4 projection, both column-major like Mtx44, then vec4 clusterParams
+	float frameData[36];
+	memcpy(&frameData[0], &GetViewMatrix().a[0], 16 * sizeof(float));
+	memcpy(&frameData[16], &projectionMatrix.a[0], 16 * sizeof(float));
+	CLightClusters::GetInstance()->GetClusterParams(&frameData[32]);
+
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->BindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+	theDevice->BufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frameData), frameData);
+	theDevice->BindBuffer(GL_UNIFORM_BUFFER, 0);
+	CRenderStats::GetInstance()->AddBufferUpload(sizeof(frameData));
+}
+
 LightBase* GraphicsManager::GetLight(const std::string& _name)
 {
 	if (lightMap.count(_name) == 0)
@@ -304,26 +348,70 @@ void GraphicsManager::UpdateLights(double _dt)
 {
 	std::map<std::string, LightBase*>::iterator it, end;
 	end = lightMap.end();
-	for (it = lightMap.begin(); it != end; ++it)
+	for (it = lightMap.begin(); it != end;)
 	{
 		it->second->Update(_dt);
+		if (it->second->IsDone())
+		{
+			delete it->second;
+			it = lightMap.erase(it);
+		}
+		else
+		{
+			++it;
+		}
 	}
 }
 
 void GraphicsManager::UpdateLightUniforms()
 {
+	// Clear the padding too, so the block can be compared with the uploaded one
+	LightBlock theLights;
+	memset(&theLights, 0, sizeof(theLights));
+
+	// The lights which are cut off at some distance go into the light clusters instead
+	clusteredLights.clear();
+	clusteredLightRanges.clear();
+	LightUniformData theLight;
 	std::map<std::string, LightBase*>::iterator it, end;
 	end = lightMap.end();
 	for (it = lightMap.begin(); it != end; ++it)
 	{
-		it->second->UpdateUniforms();
+		memset(&theLight, 0, sizeof(theLight));
+		if (!it->second->GetUniformData(theLight))
+			continue;
+
+		float range = CLightClusters::GetLightRange(theLight);
+		if (range >= 0.0f)
+		{
+			clusteredLights.push_back(theLight);
+			clusteredLightRanges.push_back(range);
+		}
+		else if (theLights.numLights < MAX_LIGHTS)
+		{
+			theLights.lights[theLights.numLights++] = theLight;
+		}
 	}
+
+	if (bLightsUploaded && memcmp(&theLights, &uploadedLights, sizeof(LightBlock)) == 0)
+		return;
+
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->BindBuffer(GL_UNIFORM_BUFFER, lightUniformBuffer);
+	theDevice->BufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &theLights);
+	theDevice->BindBuffer(GL_UNIFORM_BUFFER, 0);
+	CRenderStats::GetInstance()->AddBufferUpload(sizeof(LightBlock));
+	uploadedLights = theLights;
+	bLightsUploaded = true;
 }
 
 void GraphicsManager::UpdateTexture(int _slot, int _textureValue)
 {
-	glActiveTexture(GL_TEXTURE0 + _slot);
-	glBindTexture(GL_TEXTURE_2D, _textureValue);
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->ActiveTexture(GL_TEXTURE0 + _slot);
+	theDevice->BindTexture(GL_TEXTURE_2D, _textureValue);
+	if (_textureValue != 0)
+		CRenderStats::GetInstance()->AddTextureBind();
 }
 
 void GraphicsManager::UnbindTexture(int _slot)
@@ -4,17 +4,22 @@
 #include "SingletonTemplate.h"
 #include "Mtx44.h"
 #include "MatrixStack.h"
+#include "LightBase.h"
 #include <map>
 #include <string>
+#include <vector>
 
 class ShaderProgram;
 class CameraBase;
-class LightBase;
 
 class GraphicsManager : public Singleton<GraphicsManager>
 {
 	friend Singleton<GraphicsManager>;
 public:
+	// The number of lights in the LightBlock uniform buffer, which is the size of the shaders' lights array.
+	// Only the lights which are never cut off, such as directional lights, go into it
+	static const int MAX_LIGHTS = 8;
+
 	void Init();
 
 	// Basic Shader Loading and Swapping
@@ -32,15 +37,25 @@ public:
 	void DetachCamera();
 	inline CameraBase* GetActiveCamera(){ return activeCamera; };
 	Mtx44& GetViewMatrix();
+	// Upload the view and projection matrices into the FrameBlock uniform buffer shared by all the shaders,
+	// and bin the lights into the clusters of the view. Call it after the camera or the projection
+	// changes, and after UpdateLightUniforms, before rendering with them
+	void UpdateFrameUniforms();
 
-	// Model Stack Modification
-	inline MS& GetModelStack(){ return modelStack; };
+	// Model Stack Modification. A thread which has a model stack of its own gets that one instead
+	MS& GetModelStack();
+	// Give this thread a model stack of its own, or nullptr to use the shared one again.
+	// While it is set, GetViewMatrix does not update the view matrix, so the threads only read it
+	void SetThreadModelStack(MS* _modelStack);
 
 	// Handling Lights
 	LightBase* GetLight(const std::string& _name);
 	void AddLight(const std::string& _name, LightBase* _newLight);
 	void RemoveLight(const std::string& _name);
+	// Update the lights, and remove the ones which are done
 	void UpdateLights(double _dt);
+	// Upload the lights which are never cut off into the LightBlock uniform buffer, if they have changed,
+	// and collect the other lights for the light clusters
 	void UpdateLightUniforms();
 
 	// OpenGL Toggles - WIP
@@ -52,12 +67,27 @@ private:
 	~GraphicsManager();
 
 	std::map<std::string, LightBase*> lightMap;
+	// The lights which are binned into the light clusters, in world space, and their ranges
+	std::vector<LightUniformData> clusteredLights;
+	std::vector<float> clusteredLightRanges;
+
+	// The LightBlock uniform buffer, laid out by the std140 rules
+	struct LightBlock
+	{
+		LightUniformData lights[MAX_LIGHTS];
+		int numLights;
+		int padding[3];
+	};
+	// The lights which were last uploaded, so unchanged lights are not uploaded again
+	LightBlock uploadedLights;
+	bool bLightsUploaded;
+
+	unsigned frameUniformBuffer;
+	unsigned lightUniformBuffer;
 
 	std::map<std::string, ShaderProgram*> shaderMap;
 	ShaderProgram* activeShader;
 
-	unsigned vertexArrayID;
-
 	Mtx44 projectionMatrix;
 	Mtx44 viewMatrix;
 	MS modelStack;
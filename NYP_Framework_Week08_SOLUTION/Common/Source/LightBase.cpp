@@ -12,6 +12,12 @@ void LightBase::Update(double _dt)
 {
 }
 
-void LightBase::UpdateUniforms()
+bool LightBase::IsDone() const
 {
+	return false;
+}
+
+bool LightBase::GetUniformData(LightUniformData& _data) const
+{
+	return false;
 }
\ No newline at end of file
@@ -1,6 +1,27 @@
 #ifndef LIGHT_BASE_H
 #define LIGHT_BASE_H
 
+// One light in the LightBlock uniform buffer, laid out by the std140 rules of the shaders' Light struct.
+// The position and spot direction are in world space; the shaders move them into camera space
+struct LightUniformData
+{
+	int type;
+	float padding0[3];
+	float position[3];
+	float padding1;
+	float color[3];
+	float power;
+	float kC;
+	float kL;
+	float kQ;
+	float padding2;
+	float spotDirection[3];
+	float cosCutoff;
+	float cosInner;
+	float exponent;
+	float padding3[2];
+};
+
 class LightBase
 {
 public:
@@ -8,7 +29,10 @@ public:
 	virtual ~LightBase();
 
 	virtual void Update(double _dt);
-	virtual void UpdateUniforms();
+	// Return true if the light should be removed, such as a flash which has faded out
+	virtual bool IsDone() const;
+	// Fill in the light's entry in the LightBlock uniform buffer. Return false if it does not light the scene
+	virtual bool GetUniformData(LightUniformData& _data) const;
 
 private:
 };
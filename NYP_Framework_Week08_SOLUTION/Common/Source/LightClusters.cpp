@@ -0,0 +1,370 @@
+#include "LightClusters.h"
+#include "ThreadPool/ThreadPool.h"
+#include "RenderStats.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+#include "Vector3.h"
+#include "GL\glew.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// A light is cut off where its attenuated power falls below this
+static const float LIGHT_CUTOFF = 1.0f / 256.0f;
+
+// Replace the contents of a texture buffer
+static void UploadBuffer(const unsigned buffer, const void* theData, const size_t size)
+{
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->BindBuffer(GL_TEXTURE_BUFFER, buffer);
+	theDevice->BufferData(GL_TEXTURE_BUFFER, size, theData, GL_STREAM_DRAW);
+	CRenderStats::GetInstance()->AddBufferUpload((unsigned)size);
+}
+
+CLightClusters::CLightClusters(void)
+	: nearDist(0.0f)
+	, farDist(0.0f)
+	, scaleX(0.0f)
+	, scaleY(0.0f)
+	, sliceScale(0.0f)
+	, sliceBias(0.0f)
+	, bEnabled(false)
+	, numOfLights(0)
+	, lightDataBuffer(0)
+	, clusterGridBuffer(0)
+	, lightIndexBuffer(0)
+	, lightDataTexture(0)
+	, clusterGridTexture(0)
+	, lightIndexTexture(0)
+{
+	theClusterMin.resize(NUM_CLUSTERS * 3);
+	theClusterMax.resize(NUM_CLUSTERS * 3);
+	theClusterCounts.resize(NUM_CLUSTERS);
+	theClusterGrid.resize(NUM_CLUSTERS * 2);
+}
+
+CLightClusters::~CLightClusters(void)
+{
+	if (lightDataTexture != 0)
+	{
+		CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+		theDevice->DeleteTexture(lightDataTexture);
+		theDevice->DeleteTexture(clusterGridTexture);
+		theDevice->DeleteTexture(lightIndexTexture);
+		theDevice->DeleteBuffer(lightDataBuffer);
+		theDevice->DeleteBuffer(clusterGridBuffer);
+		theDevice->DeleteBuffer(lightIndexBuffer);
+	}
+}
+
+/**
+* Create the texture buffers and bind them to their texture units
+*/
+void CLightClusters::Init(void)
+{
+	if (lightDataTexture != 0)
+		return;
+
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	lightDataBuffer = theDevice->GenBuffer();
+	clusterGridBuffer = theDevice->GenBuffer();
+	lightIndexBuffer = theDevice->GenBuffer();
+	lightDataTexture = theDevice->GenTexture();
+	clusterGridTexture = theDevice->GenTexture();
+	lightIndexTexture = theDevice->GenTexture();
+
+	// Start with empty clusters, so a shader never reads an undefined buffer
+	LightUniformData theEmptyLight;
+	memset(&theEmptyLight, 0, sizeof(theEmptyLight));
+	unsigned short theEmptyIndex = 0;
+	std::fill(theClusterGrid.begin(), theClusterGrid.end(), 0);
+	UploadBuffer(lightDataBuffer, &theEmptyLight, sizeof(theEmptyLight));
+	UploadBuffer(clusterGridBuffer, &theClusterGrid[0], theClusterGrid.size() * sizeof(unsigned));
+	UploadBuffer(lightIndexBuffer, &theEmptyIndex, sizeof(theEmptyIndex));
+	theDevice->BindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	theDevice->ActiveTexture(GL_TEXTURE0 + LIGHT_DATA_UNIT);
+	theDevice->BindTexture(GL_TEXTURE_BUFFER, lightDataTexture);
+	theDevice->TexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightDataBuffer);
+	theDevice->ActiveTexture(GL_TEXTURE0 + CLUSTER_GRID_UNIT);
+	theDevice->BindTexture(GL_TEXTURE_BUFFER, clusterGridTexture);
+	theDevice->TexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, clusterGridBuffer);
+	theDevice->ActiveTexture(GL_TEXTURE0 + LIGHT_INDEX_UNIT);
+	theDevice->BindTexture(GL_TEXTURE_BUFFER, lightIndexTexture);
+	theDevice->TexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, lightIndexBuffer);
+	theDevice->ActiveTexture(GL_TEXTURE0);
+}
+
+/**
+* Get the distance at which a light's attenuated power falls below LIGHT_CUTOFF,
+* or a negative number if it never does
+*/
+float CLightClusters::GetLightRange(const LightUniformData& theLight)
+{
+	// Directional lights are not attenuated
+	if (theLight.type == 1)
+		return -1.0f;
+
+	// Solve kQ * d^2 + kL * d + kC = power / LIGHT_CUTOFF
+	const float c = theLight.kC - theLight.power / LIGHT_CUTOFF;
+	if (c >= 0.0f)
+		return 0.0f;
+	if (theLight.kQ > 0.0f)
+		return (-theLight.kL + sqrt(theLight.kL * theLight.kL - 4.0f * theLight.kQ * c)) / (2.0f * theLight.kQ);
+	if (theLight.kL > 0.0f)
+		return -c / theLight.kL;
+	return -1.0f;
+}
+
+/**
+* Bin the lights into the clusters of a perspective view, then upload them
+*/
+void CLightClusters::Build(const std::vector<LightUniformData>& theLights, const std::vector<float>& theRanges,
+						   const Mtx44& theViewMatrix, const Mtx44& theProjectionMatrix)
+{
+	numOfLights = std::min((int)theLights.size(), (int)MAX_LIGHTS);
+
+	// Only a perspective projection is cut into clusters
+	const float* p = theProjectionMatrix.a;
+	bEnabled = (p[15] == 0.0f) && (numOfLights > 0) && (lightDataTexture != 0);
+	if (!bEnabled)
+	{
+		numOfLights = 0;
+		theLightIndices.clear();
+		return;
+	}
+
+	// The near and far distances of a matrix from Mtx44::SetToPerspective
+	const float theNear = p[14] / (p[10] - 1.0f);
+	const float theFar = p[14] / (p[10] + 1.0f);
+	if ((theNear != nearDist) || (theFar != farDist) || (p[0] != scaleX) || (p[5] != scaleY))
+		BuildClusterBounds(theNear, theFar, p[0], p[5]);
+
+	// Move the lights' bounding spheres into view space, 4 at a time
+	const int numOfPaddedLights = (numOfLights + 3) & ~3;
+	theLightX.assign(numOfPaddedLights, 0.0f);
+	theLightY.assign(numOfPaddedLights, 0.0f);
+	theLightZ.assign(numOfPaddedLights, 0.0f);
+	theLightRadius.assign(numOfPaddedLights, 0.0f);
+	for (int i = 0; i < numOfLights; ++i)
+	{
+		theLightX[i] = theLights[i].position[0];
+		theLightY[i] = theLights[i].position[1];
+		theLightZ[i] = theLights[i].position[2];
+		theLightRadius[i] = theRanges[i];
+	}
+
+	const float* v = theViewMatrix.a;
+	for (int i = 0; i < numOfPaddedLights; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&theLightX[i]);
+		__m128 y = _mm_loadu_ps(&theLightY[i]);
+		__m128 z = _mm_loadu_ps(&theLightZ[i]);
+		__m128 viewX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), x), _mm_mul_ps(_mm_set1_ps(v[4]), y)),
+								  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[8]), z), _mm_set1_ps(v[12])));
+		__m128 viewY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[1]), x), _mm_mul_ps(_mm_set1_ps(v[5]), y)),
+								  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[9]), z), _mm_set1_ps(v[13])));
+		__m128 viewZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[2]), x), _mm_mul_ps(_mm_set1_ps(v[6]), y)),
+								  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[10]), z), _mm_set1_ps(v[14])));
+		_mm_storeu_ps(&theLightX[i], viewX);
+		_mm_storeu_ps(&theLightY[i], viewY);
+		_mm_storeu_ps(&theLightZ[i], viewZ);
+	}
+
+	// Find the depth slices which each light reaches, and pack the lights in view space for the shader
+	theFirstSlice.resize(numOfLights);
+	theLastSlice.resize(numOfLights);
+	theLightData.resize(numOfLights);
+	for (int i = 0; i < numOfLights; ++i)
+	{
+		const float depth = -theLightZ[i];
+		const float minDepth = depth - theLightRadius[i];
+		const float maxDepth = depth + theLightRadius[i];
+		if ((maxDepth <= nearDist) || (minDepth >= farDist))
+		{
+			theFirstSlice[i] = 1;
+			theLastSlice[i] = 0;
+		}
+		else
+		{
+			theFirstSlice[i] = (minDepth <= nearDist ? 0 : std::max(0, (int)(log(minDepth) * sliceScale + sliceBias)));
+			theLastSlice[i] = (maxDepth >= farDist ? CLUSTER_Z - 1 : std::min(CLUSTER_Z - 1, (int)(log(maxDepth) * sliceScale + sliceBias)));
+		}
+
+		theLightData[i] = theLights[i];
+		theLightData[i].position[0] = theLightX[i];
+		theLightData[i].position[1] = theLightY[i];
+		theLightData[i].position[2] = theLightZ[i];
+		Vector3 spotDirection = theViewMatrix * Vector3(theLights[i].spotDirection[0], theLights[i].spotDirection[1], theLights[i].spotDirection[2]);
+		theLightData[i].spotDirection[0] = spotDirection.x;
+		theLightData[i].spotDirection[1] = spotDirection.y;
+		theLightData[i].spotDirection[2] = spotDirection.z;
+	}
+
+	// Bin each depth slice on its own thread
+	CThreadPool::GetInstance()->ParallelFor(CLUSTER_Z, [this](const int slice)
+	{
+		BinSlice(slice);
+	});
+
+	// Join the slices' index lists. The slices and their clusters are already in the order of the grid
+	theLightIndices.clear();
+	unsigned offset = 0;
+	for (int cluster = 0; cluster < NUM_CLUSTERS; ++cluster)
+	{
+		unsigned count = std::min(theClusterCounts[cluster], (unsigned)MAX_LIGHT_INDICES - offset);
+		theClusterGrid[cluster * 2] = offset;
+		theClusterGrid[cluster * 2 + 1] = count;
+		offset += count;
+	}
+	for (int slice = 0; slice < CLUSTER_Z; ++slice)
+	{
+		size_t count = std::min(theSliceIndices[slice].size(), (size_t)MAX_LIGHT_INDICES - theLightIndices.size());
+		theLightIndices.insert(theLightIndices.end(), theSliceIndices[slice].begin(), theSliceIndices[slice].begin() + count);
+	}
+	if (theLightIndices.empty())
+		theLightIndices.push_back(0);
+
+	UploadBuffer(lightDataBuffer, &theLightData[0], theLightData.size() * sizeof(LightUniformData));
+	UploadBuffer(clusterGridBuffer, &theClusterGrid[0], theClusterGrid.size() * sizeof(unsigned));
+	UploadBuffer(lightIndexBuffer, &theLightIndices[0], theLightIndices.size() * sizeof(unsigned short));
+	CGraphicsDevice::GetDevice()->BindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+/**
+* Get the parameters of the clusters for the FrameBlock uniform buffer
+*/
+void CLightClusters::GetClusterParams(float* theParams) const
+{
+	theParams[0] = sliceScale;
+	theParams[1] = sliceBias;
+	theParams[2] = (bEnabled ? 1.0f : 0.0f);
+	theParams[3] = 0.0f;
+}
+
+/**
+* Get the number of lights binned by the last Build
+*/
+int CLightClusters::GetNumOfLights(void) const
+{
+	return numOfLights;
+}
+
+/**
+* Get the number of light indices in all the clusters after the last Build
+*/
+int CLightClusters::GetNumOfLightIndices(void) const
+{
+	return (bEnabled ? (int)theLightIndices.size() : 0);
+}
+
+/**
+* Compute the view space bounding box of each cluster
+*/
+void CLightClusters::BuildClusterBounds(const float nearDist, const float farDist, const float scaleX, const float scaleY)
+{
+	this->nearDist = nearDist;
+	this->farDist = farDist;
+	this->scaleX = scaleX;
+	this->scaleY = scaleY;
+
+	// slice = log(depth / near) / log(far / near) * CLUSTER_Z
+	const float logRatio = log(farDist / nearDist);
+	sliceScale = CLUSTER_Z / logRatio;
+	sliceBias = -CLUSTER_Z * log(nearDist) / logRatio;
+
+	for (int z = 0; z < CLUSTER_Z; ++z)
+	{
+		const float sliceNear = nearDist * pow(farDist / nearDist, (float)z / CLUSTER_Z);
+		const float sliceFar = nearDist * pow(farDist / nearDist, (float)(z + 1) / CLUSTER_Z);
+		for (int y = 0; y < CLUSTER_Y; ++y)
+		{
+			// The tile's edges in normalised device coordinates, which widen with the depth
+			const float bottom = -1.0f + 2.0f * y / CLUSTER_Y;
+			const float top = -1.0f + 2.0f * (y + 1) / CLUSTER_Y;
+			for (int x = 0; x < CLUSTER_X; ++x)
+			{
+				const float left = -1.0f + 2.0f * x / CLUSTER_X;
+				const float right = -1.0f + 2.0f * (x + 1) / CLUSTER_X;
+				const int cluster = (z * CLUSTER_Y + y) * CLUSTER_X + x;
+				theClusterMin[cluster * 3] = std::min(left * sliceNear, left * sliceFar) / scaleX;
+				theClusterMax[cluster * 3] = std::max(right * sliceNear, right * sliceFar) / scaleX;
+				theClusterMin[cluster * 3 + 1] = std::min(bottom * sliceNear, bottom * sliceFar) / scaleY;
+				theClusterMax[cluster * 3 + 1] = std::max(top * sliceNear, top * sliceFar) / scaleY;
+				theClusterMin[cluster * 3 + 2] = -sliceFar;
+				theClusterMax[cluster * 3 + 2] = -sliceNear;
+			}
+		}
+	}
+}
+
+/**
+* Test the lights which reach a depth slice against each of its clusters, 4 lights at a time
+*/
+void CLightClusters::BinSlice(const int slice)
+{
+	// Reused by each thread, so the slices do not allocate every frame
+	static thread_local std::vector<float> theX, theY, theZ, theRadiusSquared;
+	static thread_local std::vector<unsigned short> theIndices;
+	theX.clear();
+	theY.clear();
+	theZ.clear();
+	theRadiusSquared.clear();
+	theIndices.clear();
+
+	for (int i = 0; i < numOfLights; ++i)
+	{
+		if ((slice < theFirstSlice[i]) || (slice > theLastSlice[i]))
+			continue;
+		theX.push_back(theLightX[i]);
+		theY.push_back(theLightY[i]);
+		theZ.push_back(theLightZ[i]);
+		theRadiusSquared.push_back(theLightRadius[i] * theLightRadius[i]);
+		theIndices.push_back((unsigned short)i);
+	}
+	// Pad with lights which never pass the test
+	while (theX.size() & 3)
+	{
+		theX.push_back(0.0f);
+		theY.push_back(0.0f);
+		theZ.push_back(0.0f);
+		theRadiusSquared.push_back(-1.0f);
+		theIndices.push_back(0);
+	}
+
+	std::vector<unsigned short>& theSliceList = theSliceIndices[slice];
+	theSliceList.clear();
+	const __m128 zero = _mm_setzero_ps();
+	for (int cluster = slice * CLUSTER_X * CLUSTER_Y; cluster < (slice + 1) * CLUSTER_X * CLUSTER_Y; ++cluster)
+	{
+		const __m128 minX = _mm_set1_ps(theClusterMin[cluster * 3]);
+		const __m128 minY = _mm_set1_ps(theClusterMin[cluster * 3 + 1]);
+		const __m128 minZ = _mm_set1_ps(theClusterMin[cluster * 3 + 2]);
+		const __m128 maxX = _mm_set1_ps(theClusterMax[cluster * 3]);
+		const __m128 maxY = _mm_set1_ps(theClusterMax[cluster * 3 + 1]);
+		const __m128 maxZ = _mm_set1_ps(theClusterMax[cluster * 3 + 2]);
+
+		unsigned count = 0;
+		for (int i = 0; i < (int)theX.size(); i += 4)
+		{
+			// The distance from each light to the nearest point of the cluster's box
+			__m128 x = _mm_loadu_ps(&theX[i]);
+			__m128 y = _mm_loadu_ps(&theY[i]);
+			__m128 z = _mm_loadu_ps(&theZ[i]);
+			__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+			__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+			__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+			__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			int mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_loadu_ps(&theRadiusSquared[i])));
+			for (int j = 0; mask != 0; ++j, mask >>= 1)
+			{
+				if (mask & 1)
+				{
+					theSliceList.push_back(theIndices[i + j]);
+					count++;
+				}
+			}
+		}
+		theClusterCounts[cluster] = count;
+	}
+}
\ No newline at end of file
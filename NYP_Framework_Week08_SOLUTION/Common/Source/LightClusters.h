@@ -0,0 +1,95 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include "SingletonTemplate.h"
+#include "LightBase.h"
+#include "Mtx44.h"
+#include <vector>
+
+// Bins the point and spot lights into a grid of view space clusters every frame, so the fragment
+// shader only loops over the lights which can reach its cluster. The view frustum is cut into
+// screen tiles, and each tile into depth slices which grow exponentially with the distance.
+// The lights, the cluster grid and the light index lists are uploaded into texture buffers.
+class CLightClusters : public Singleton<CLightClusters>
+{
+	friend Singleton<CLightClusters>;
+public:
+	// The size of the cluster grid. The fragment shader has the same constants
+	static const int CLUSTER_X = 16;
+	static const int CLUSTER_Y = 9;
+	static const int CLUSTER_Z = 24;
+	static const int NUM_CLUSTERS = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+	// The most lights which can be binned, and the most light indices in all the clusters together
+	static const int MAX_LIGHTS = 1024;
+	static const int MAX_LIGHT_INDICES = 65536;
+
+	// The texture units of the texture buffers
+	enum TEXTURE_UNIT
+	{
+		LIGHT_DATA_UNIT = 1,	// 6 RGBA32F texels for each light, laid out as LightUniformData
+		CLUSTER_GRID_UNIT,		// An RG32UI texel for each cluster: the offset and number of its light indices
+		LIGHT_INDEX_UNIT,		// An R16UI texel for each light index
+	};
+
+	virtual ~CLightClusters(void);
+
+	// Create the texture buffers. Call it after the OpenGL context is created
+	void Init(void);
+
+	// Get the distance at which a light's attenuated power falls below 1/256,
+	// or a negative number if it never does, such as for a directional light
+	static float GetLightRange(const LightUniformData& theLight);
+
+	// Bin the lights with their ranges into the clusters of a perspective view, then upload them.
+	// The lights are in world space. An orthographic projection clears the clusters
+	void Build(const std::vector<LightUniformData>& theLights, const std::vector<float>& theRanges,
+			   const Mtx44& theViewMatrix, const Mtx44& theProjectionMatrix);
+
+	// Get the scale and bias which turn the log of a view depth into a depth slice,
+	// and 1 if the clusters are in use, for the FrameBlock uniform buffer
+	void GetClusterParams(float* theParams) const;
+
+	// Get the number of lights binned by the last Build
+	int GetNumOfLights(void) const;
+	// Get the number of light indices in all the clusters after the last Build
+	int GetNumOfLightIndices(void) const;
+
+protected:
+	CLightClusters(void);
+
+	// Compute the view space bounding box of each cluster, when the projection has changed
+	void BuildClusterBounds(const float nearDist, const float farDist, const float scaleX, const float scaleY);
+	// Test the lights against the clusters of one depth slice
+	void BinSlice(const int slice);
+
+	// The projection which the cluster bounds were built for
+	float nearDist, farDist, scaleX, scaleY;
+	// log(depth) * sliceScale + sliceBias gives the depth slice
+	float sliceScale, sliceBias;
+	bool bEnabled;
+
+	// The view space bounding box of each cluster
+	std::vector<float> theClusterMin;
+	std::vector<float> theClusterMax;
+
+	// The view space bounding spheres of the lights, padded to a multiple of 4 for SSE
+	std::vector<float> theLightX, theLightY, theLightZ, theLightRadius;
+	// The first and last depth slice which each light reaches
+	std::vector<int> theFirstSlice, theLastSlice;
+	int numOfLights;
+
+	// The light indices and the number of them in each cluster, kept separately for each
+	// depth slice so that the slices can be binned on different threads
+	std::vector<unsigned short> theSliceIndices[CLUSTER_Z];
+	std::vector<unsigned> theClusterCounts;
+
+	// The data which is uploaded into the texture buffers
+	std::vector<LightUniformData> theLightData;
+	std::vector<unsigned> theClusterGrid;
+	std::vector<unsigned short> theLightIndices;
+
+	unsigned lightDataBuffer, clusterGridBuffer, lightIndexBuffer;
+	unsigned lightDataTexture, clusterGridTexture, lightIndexTexture;
+};
+
+#endif // LIGHT_CLUSTERS_H
\ No newline at end of file
@@ -5,20 +5,15 @@
 
 #include "LoadTGA.h"
 
-GLuint LoadTGA(const char *file_path)				// load TGA file to memory
+bool LoadTGAImage(const char *file_path, unsigned& width, unsigned& height, unsigned& bytesPerPixel, std::vector<unsigned char>& data)
 {
 	std::ifstream fileStream(file_path, std::ios::binary);
 	if(!fileStream.is_open()) {
 		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
-		return 0;
+		return false;
 	}
 
 	GLubyte		header[ 18 ];									// first 6 useful header bytes
-	GLuint		bytesPerPixel;								    // number of bytes per pixel in TGA gile
-	GLuint		imageSize;									    // for setting memory
-	GLubyte *	data;
-	GLuint		texture = 0;
-	unsigned	width, height;
 
 	fileStream.read((char*)header, 18);
 	width = header[12] + header[13] * 256;
@@ -30,23 +25,35 @@ GLuint LoadTGA(const char *file_path)				// load TGA file to memory
 	{
 		fileStream.close();							// close file on failure
 		std::cout << "File header error.\n";
-		return 0;										
+		return false;
 	}
 
 	bytesPerPixel	= header[16] / 8;						//divide by 8 to get bytes per pixel
-	imageSize		= width * height * bytesPerPixel;	// calculate memory required for TGA data
-	
-	data = new GLubyte[ imageSize ];
+	data.resize(width * height * bytesPerPixel);		// calculate memory required for TGA data
+
 	fileStream.seekg(18, std::ios::beg);
-	fileStream.read((char *)data, imageSize);
-	fileStream.close();	
+	fileStream.read((char *)&data[0], data.size());
+	fileStream.close();
+
+	return true;
+}
+
+GLuint LoadTGA(const char *file_path)				// load TGA file to memory
+{
+	GLuint		bytesPerPixel;								    // number of bytes per pixel in TGA gile
+	std::vector<unsigned char> data;
+	GLuint		texture = 0;
+	unsigned	width, height;
+
+	if (!LoadTGAImage(file_path, width, height, bytesPerPixel, data))
+		return 0;
 
 	glGenTextures(1, &texture);
 	glBindTexture(GL_TEXTURE_2D, texture);
 	if(bytesPerPixel == 3)
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, &data[0]);
 	else //bytesPerPixel == 4
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, data);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, &data[0]);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -58,8 +65,6 @@ GLuint LoadTGA(const char *file_path)				// load TGA file to memory
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	
 	glGenerateMipmap( GL_TEXTURE_2D );
-	
-	delete []data;
 
 	return texture;						
-}
\ No newline at end of file
+}
@@ -1,6 +1,10 @@
 #ifndef LOAD_TGA_H
 #define LOAD_TGA_H
 
+#include <vector>
+
 GLuint LoadTGA(const char *file_path);
+// Load the pixels of an uncompressed 24 or 32 bit TGA file, in BGR or BGRA order from the bottom row up
+bool LoadTGAImage(const char *file_path, unsigned& width, unsigned& height, unsigned& bytesPerPixel, std::vector<unsigned char>& data);
 
 #endif
\ No newline at end of file
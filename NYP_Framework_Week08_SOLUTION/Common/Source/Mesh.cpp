@@ -2,93 +2,420 @@
 #include "Mesh.h"
 #include "GL\glew.h"
 #include "Vertex.h"
+#include "RenderStats.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+#include <cmath>
+#include <cstring>
+
+// The sizes of the compact vertices, with and without the colour
+static const unsigned COMPACT_VERTEX_SIZE = 24;
+static const unsigned COMPACT_VERTEX_SIZE_NO_COLOR = 20;
+
+// Convert a float to a half float, rounded to the nearest
+static unsigned short FloatToHalf(const float value)
+{
+	unsigned bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+	int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	unsigned mantissa = bits & 0x7FFFFF;
+
+	// Too small for a normal half float, so make it a denormal or 0
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		return sign | (unsigned short)(mantissa >> (14 - exponent));
+	}
+
+	mantissa += 0x1000;
+	if (mantissa & 0x800000)
+	{
+		mantissa = 0;
+		exponent++;
+	}
+	// Too large, so make it infinity
+	if (exponent >= 31)
+		return sign | 0x7C00;
+	return sign | (unsigned short)(exponent << 10) | (unsigned short)(mantissa >> 13);
+}
+
+// Convert a half float to a float
+static float HalfToFloat(const unsigned short half)
+{
+	const int exponent = (half >> 10) & 0x1F;
+	const int mantissa = half & 0x3FF;
+	float value;
+	if (exponent == 0)
+		value = ldexp((float)mantissa, -24);
+	else if (exponent == 31)
+		value = HUGE_VALF;
+	else
+		value = ldexp((float)(mantissa | 0x400), exponent - 25);
+	return (half & 0x8000) ? -value : value;
+}
+
+// Pack a normal into the 10_10_10_2 format, as signed normalised integers
+static unsigned PackNormal(const Vector3& normal)
+{
+	unsigned packed = 0;
+	const float components[3] = { normal.x, normal.y, normal.z };
+	for (int i = 0; i < 3; ++i)
+	{
+		const float value = (components[i] < -1.0f ? -1.0f : (components[i] > 1.0f ? 1.0f : components[i]));
+		const int component = (int)floor(value * 511.0f + 0.5f);
+		packed |= ((unsigned)component & 0x3FF) << (i * 10);
+	}
+	return packed;
+}
+
+// Unpack a normal from the 10_10_10_2 format
+static Vector3 UnpackNormal(const unsigned packed)
+{
+	float components[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		// Sign extend the 10 bits
+		const int component = (int)(packed << (22 - i * 10)) >> 22;
+		components[i] = (component < -511 ? -1.0f : component / 511.0f);
+	}
+	return Vector3(components[0], components[1], components[2]);
+}
+
+// The last generation given to a mesh
+static unsigned lastGeneration = 0;
+
+// Get the number of triangles which a number of indices draw
+static unsigned GetNumOfTriangles(const Mesh::DRAW_MODE mode, const unsigned count)
+{
+	if (mode == Mesh::DRAW_TRIANGLES)
+		return count / 3;
+	if (mode == Mesh::DRAW_TRIANGLE_STRIP)
+		return (count > 2 ? count - 2 : 0);
+	return 0;
+}
 
 Mesh::Mesh(const std::string &meshName)
 	: name(meshName)
 	, mode(DRAW_TRIANGLES)
+	, indexSize(0)
+	, vertexFormat(FORMAT_FLOAT)
+	, bVertexColor(true)
+	, bNormalisedTexCoord(false)
+	, bShortIndices(false)
+	, generation(++lastGeneration)
 {
-	glGenBuffers(1, &vertexBuffer);
-	glGenBuffers(1, &indexBuffer);
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	// Keep the vertex array bound until SetupVertexArray, so the index buffer is bound into it
+	vertexArray = theDevice->GenVertexArray();
+	theDevice->BindVertexArray(vertexArray);
+	vertexBuffer = theDevice->GenBuffer();
+	indexBuffer = theDevice->GenBuffer();
 	textureID = 0;
+	bSharedTexture = false;
+	bSharedBuffers = false;
 }
 
 Mesh::~Mesh()
 {
-	glDeleteBuffers(1, &vertexBuffer);
-	glDeleteBuffers(1, &indexBuffer);
-	if(textureID > 0)
-		glDeleteTextures(1, &textureID);
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->DeleteVertexArray(vertexArray);
+	if(!bSharedBuffers)
+	{
+		theDevice->DeleteBuffer(vertexBuffer);
+		theDevice->DeleteBuffer(indexBuffer);
+	}
+	if(textureID > 0 && !bSharedTexture)
+		theDevice->DeleteTexture(textureID);
 }
 
 void Mesh::Render()
 {
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
+	Bind();
+	Draw(0, indexSize);
+	Unbind();
+}
+
+void Mesh::Render(unsigned offset, unsigned count)
+{
+	Bind();
+	Draw(offset, count);
+	Unbind();
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(Position));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color)));
-	if(textureID > 0)
+void Mesh::Upload(const std::vector<Vertex>& theVertices, const std::vector<unsigned>& theIndices, const VERTEX_FORMAT theFormat)
+{
+	vertexFormat = theFormat;
+	bVertexColor = true;
+	bNormalisedTexCoord = false;
+
+	std::vector<unsigned char> theVertexData;
+	if (vertexFormat == FORMAT_COMPACT)
+	{
+		// Leave out the colour if every vertex is white, such as for a textured OBJ,
+		// and use the more precise normalised texture coordinates when they fit
+		bVertexColor = false;
+		bNormalisedTexCoord = true;
+		for (unsigned i = 0; i < theVertices.size(); ++i)
+		{
+			const Vertex& v = theVertices[i];
+			if ((v.color.r != 1.0f) || (v.color.g != 1.0f) || (v.color.b != 1.0f))
+				bVertexColor = true;
+			if ((v.texCoord.u < 0.0f) || (v.texCoord.u > 1.0f) || (v.texCoord.v < 0.0f) || (v.texCoord.v > 1.0f))
+				bNormalisedTexCoord = false;
+		}
+
+		const unsigned vertexSize = GetVertexSize();
+		theVertexData.resize(theVertices.size() * vertexSize);
+		for (unsigned i = 0; i < theVertices.size(); ++i)
+		{
+			const Vertex& v = theVertices[i];
+			unsigned char* theVertex = &theVertexData[i * vertexSize];
+			memcpy(theVertex, &v.pos, sizeof(Position));
+			theVertex += sizeof(Position);
+			if (bVertexColor)
+			{
+				const float components[3] = { v.color.r, v.color.g, v.color.b };
+				for (int j = 0; j < 3; ++j)
+					theVertex[j] = (unsigned char)floor((components[j] < 0.0f ? 0.0f : (components[j] > 1.0f ? 1.0f : components[j])) * 255.0f + 0.5f);
+				theVertex[3] = 255;
+				theVertex += 4;
+			}
+			const unsigned normal = PackNormal(v.normal);
+			memcpy(theVertex, &normal, sizeof(normal));
+			theVertex += sizeof(normal);
+			unsigned short texCoord[2];
+			if (bNormalisedTexCoord)
+			{
+				texCoord[0] = (unsigned short)floor(v.texCoord.u * 65535.0f + 0.5f);
+				texCoord[1] = (unsigned short)floor(v.texCoord.v * 65535.0f + 0.5f);
+			}
+			else
+			{
+				texCoord[0] = FloatToHalf(v.texCoord.u);
+				texCoord[1] = FloatToHalf(v.texCoord.v);
+			}
+			memcpy(theVertex, texCoord, sizeof(texCoord));
+		}
+	}
+	else if (!theVertices.empty())
 	{
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color) + sizeof(Vector3)));
+		theVertexData.resize(theVertices.size() * sizeof(Vertex));
+		memcpy(&theVertexData[0], &theVertices[0], theVertexData.size());
 	}
 
-	
-	//glDrawArrays(GL_TRIANGLES, 0, 3);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	// Use 16-bit indices when every index fits into them, which halves the index buffer
+	unsigned maxIndex = 0;
+	for (unsigned i = 0; i < theIndices.size(); ++i)
+	{
+		if (theIndices[i] > maxIndex)
+			maxIndex = theIndices[i];
+	}
+	bShortIndices = (maxIndex <= 0xFFFF);
+	std::vector<GLushort> theShortIndices;
+	if (bShortIndices)
+		theShortIndices.assign(theIndices.begin(), theIndices.end());
 
-	if(mode == DRAW_LINES)
-		glDrawElements(GL_LINES, indexSize, GL_UNSIGNED_INT, 0);
-	else if(mode == DRAW_TRIANGLE_STRIP)
-		glDrawElements(GL_TRIANGLE_STRIP, indexSize, GL_UNSIGNED_INT, 0);
+	// The index buffer binding belongs to the vertex array
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->BindVertexArray(vertexArray);
+	theDevice->BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	theDevice->BufferData(GL_ARRAY_BUFFER, theVertexData.size(), theVertexData.empty() ? nullptr : &theVertexData[0], GL_STATIC_DRAW);
+	theDevice->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	if (theIndices.empty())
+		theDevice->BufferData(GL_ELEMENT_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+	else if (bShortIndices)
+		theDevice->BufferData(GL_ELEMENT_ARRAY_BUFFER, theShortIndices.size() * sizeof(GLushort), &theShortIndices[0], GL_STATIC_DRAW);
 	else
-		glDrawElements(GL_TRIANGLES, indexSize, GL_UNSIGNED_INT, 0);
+		theDevice->BufferData(GL_ELEMENT_ARRAY_BUFFER, theIndices.size() * sizeof(GLuint), &theIndices[0], GL_STATIC_DRAW);
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	CRenderStats::GetInstance()->AddBufferUpload((unsigned)(theVertexData.size() + theIndices.size() * GetIndexSize()));
 
-	if(textureID > 0)
-	{
-		glDisableVertexAttribArray(3);
-	}
+	indexSize = theIndices.size();
+	MarkChanged();
+	SetupVertexArray();
 }
 
-void Mesh::Render(unsigned offset, unsigned count)
+void Mesh::SetupVertexArray()
 {
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->BindVertexArray(vertexArray);
 
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(Position));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color)));
-	if(textureID > 0)
+	theDevice->BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	theDevice->EnableVertexAttribArray(0);
+	theDevice->EnableVertexAttribArray(2);
+	theDevice->EnableVertexAttribArray(3);
+	if (vertexFormat == FORMAT_COMPACT)
+	{
+		const GLsizei stride = GetVertexSize();
+		unsigned offset = sizeof(Position);
+		theDevice->VertexAttribPointer(0, 3, GL_FLOAT, false, stride, 0);
+		// Without the colours, the shader gets the white set in Bind
+		if (bVertexColor)
+		{
+			theDevice->EnableVertexAttribArray(1);
+			theDevice->VertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true, stride, offset);
+			offset += 4;
+		}
+		else
+		{
+			theDevice->DisableVertexAttribArray(1);
+		}
+		theDevice->VertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, true, stride, offset);
+		offset += 4;
+		if (bNormalisedTexCoord)
+			theDevice->VertexAttribPointer(3, 2, GL_UNSIGNED_SHORT, true, stride, offset);
+		else
+			theDevice->VertexAttribPointer(3, 2, GL_HALF_FLOAT, false, stride, offset);
+	}
+	else
 	{
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color) + sizeof(Vector3)));
+		theDevice->EnableVertexAttribArray(1);
+		theDevice->VertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex), 0);
+		theDevice->VertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(Vertex), sizeof(Position));
+		theDevice->VertexAttribPointer(2, 3, GL_FLOAT, false, sizeof(Vertex), sizeof(Position) + sizeof(Color));
+		// The texture may be set after the mesh is built, so the texture coordinates are always set up
+		theDevice->VertexAttribPointer(3, 2, GL_FLOAT, false, sizeof(Vertex), sizeof(Position) + sizeof(Color) + sizeof(Vector3));
 	}
 
-	//glDrawArrays(GL_TRIANGLES, offset, count);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	theDevice->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+	theDevice->BindVertexArray(0);
+}
+
+unsigned Mesh::GetVertexSize() const
+{
+	if (vertexFormat == FORMAT_COMPACT)
+		return (bVertexColor ? COMPACT_VERTEX_SIZE : COMPACT_VERTEX_SIZE_NO_COLOR);
+	return sizeof(Vertex);
+}
+
+unsigned Mesh::GetIndexSize() const
+{
+	return (bShortIndices ? sizeof(GLushort) : sizeof(GLuint));
+}
 
+void Mesh::Bind()
+{
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->BindVertexArray(vertexArray);
+	// The value of an attribute without an array is not kept in the vertex array, so set it for every bind
+	if (!bVertexColor)
+		theDevice->VertexAttrib4f(1, 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void Mesh::Draw(unsigned offset, unsigned count)
+{
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	const GLenum indexType = (bShortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+	const unsigned indexOffset = offset * GetIndexSize();
 	if(mode == DRAW_LINES)
-		glDrawElements(GL_LINES, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
+		theDevice->DrawElements(GL_LINES, count, indexType, indexOffset);
 	else if(mode == DRAW_TRIANGLE_STRIP)
-		glDrawElements(GL_TRIANGLE_STRIP, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
+		theDevice->DrawElements(GL_TRIANGLE_STRIP, count, indexType, indexOffset);
+	else
+		theDevice->DrawElements(GL_TRIANGLES, count, indexType, indexOffset);
+	CRenderStats::GetInstance()->AddDrawCall(GetNumOfTriangles(mode, count));
+}
+
+void Mesh::DrawInstanced(unsigned offset, unsigned count, unsigned numOfInstances)
+{
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	const GLenum indexType = (bShortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+	const unsigned indexOffset = offset * GetIndexSize();
+	if(mode == DRAW_LINES)
+		theDevice->DrawElementsInstanced(GL_LINES, count, indexType, indexOffset, numOfInstances);
+	else if(mode == DRAW_TRIANGLE_STRIP)
+		theDevice->DrawElementsInstanced(GL_TRIANGLE_STRIP, count, indexType, indexOffset, numOfInstances);
+	else
+		theDevice->DrawElementsInstanced(GL_TRIANGLES, count, indexType, indexOffset, numOfInstances);
+	CRenderStats::GetInstance()->AddDrawCall(GetNumOfTriangles(mode, count) * numOfInstances);
+}
+
+void Mesh::Unbind()
+{
+	CGraphicsDevice::GetDevice()->BindVertexArray(0);
+}
+
+void Mesh::MarkChanged()
+{
+	generation = ++lastGeneration;
+}
+
+bool Mesh::ReadBack(std::vector<Vertex>& theVertices, std::vector<unsigned>& theIndices) const
+{
+	theVertices.clear();
+	theIndices.clear();
+
+	// Read through the copy read target, so the element array binding of the bound vertex array is left alone
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	const unsigned vertexSize = GetVertexSize();
+	theDevice->BindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+	const int vertexBytes = theDevice->GetBufferSize(GL_COPY_READ_BUFFER);
+	const unsigned numOfVertices = vertexBytes / vertexSize;
+	if ((numOfVertices == 0) || (indexSize == 0))
+	{
+		theDevice->BindBuffer(GL_COPY_READ_BUFFER, 0);
+		return false;
+	}
+
+	theVertices.resize(numOfVertices);
+	if (vertexFormat == FORMAT_COMPACT)
+	{
+		// Unpack the vertices into the Vertex struct
+		std::vector<unsigned char> theVertexData(numOfVertices * vertexSize);
+		theDevice->GetBufferSubData(GL_COPY_READ_BUFFER, 0, theVertexData.size(), &theVertexData[0]);
+		for (unsigned i = 0; i < numOfVertices; ++i)
+		{
+			Vertex& v = theVertices[i];
+			const unsigned char* theVertex = &theVertexData[i * vertexSize];
+			memcpy(&v.pos, theVertex, sizeof(Position));
+			theVertex += sizeof(Position);
+			if (bVertexColor)
+			{
+				v.color.Set(theVertex[0] / 255.0f, theVertex[1] / 255.0f, theVertex[2] / 255.0f);
+				theVertex += 4;
+			}
+			unsigned normal;
+			memcpy(&normal, theVertex, sizeof(normal));
+			v.normal = UnpackNormal(normal);
+			theVertex += sizeof(normal);
+			unsigned short texCoord[2];
+			memcpy(texCoord, theVertex, sizeof(texCoord));
+			if (bNormalisedTexCoord)
+				v.texCoord.Set(texCoord[0] / 65535.0f, texCoord[1] / 65535.0f);
+			else
+				v.texCoord.Set(HalfToFloat(texCoord[0]), HalfToFloat(texCoord[1]));
+		}
+	}
 	else
-		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
+	{
+		theDevice->GetBufferSubData(GL_COPY_READ_BUFFER, 0, numOfVertices * sizeof(Vertex), &theVertices[0]);
+	}
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	theDevice->BindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+	if (bShortIndices)
+	{
+		std::vector<GLushort> theShortIndices(indexSize);
+		theDevice->GetBufferSubData(GL_COPY_READ_BUFFER, 0, indexSize * sizeof(GLushort), &theShortIndices[0]);
+		theIndices.assign(theShortIndices.begin(), theShortIndices.end());
+	}
+	else
+	{
+		theIndices.resize(indexSize);
+		theDevice->GetBufferSubData(GL_COPY_READ_BUFFER, 0, indexSize * sizeof(GLuint), &theIndices[0]);
+	}
+	theDevice->BindBuffer(GL_COPY_READ_BUFFER, 0);
 
-	if(textureID > 0)
+	for (unsigned i = 0; i < theIndices.size(); ++i)
 	{
-		glDisableVertexAttribArray(3);
+		if (theIndices[i] >= numOfVertices)
+		{
+			theVertices.clear();
+			theIndices.clear();
+			return false;
+		}
 	}
-}
\ No newline at end of file
+	return true;
+}
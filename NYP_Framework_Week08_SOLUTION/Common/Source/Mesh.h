@@ -2,8 +2,11 @@
 #define MESH_H
 
 #include <string>
+#include <vector>
 #include "Material.h"
 
+struct Vertex;
+
 class Mesh
 {
 public:
@@ -14,19 +17,62 @@ public:
 		DRAW_LINES,
 		DRAW_MODE_LAST,
 	};
+	// The layout of the vertices in the vertex buffer
+	enum VERTEX_FORMAT
+	{
+		FORMAT_FLOAT,		// The Vertex struct as it is, 44 bytes of floats
+		FORMAT_COMPACT,		// Float position, RGBA8 colour, 10_10_10_2 normal and 16-bit texture coordinates, 24 bytes.
+							// The colour is left out when every vertex is white, for 20 bytes
+	};
 	Mesh(const std::string &meshName);
 	~Mesh();
 	void Render();
 	void Render(unsigned offset, unsigned count);
 
+	// Upload the vertices in a format, and the indices as 16-bit when they all fit, then set up the vertex array
+	void Upload(const std::vector<Vertex>& theVertices, const std::vector<unsigned>& theIndices, const VERTEX_FORMAT theFormat);
+	// Set up the vertex attributes in the vertex array, once the buffers have their data
+	void SetupVertexArray();
+	// Get the number of bytes of each vertex, and of each index
+	unsigned GetVertexSize() const;
+	unsigned GetIndexSize() const;
+	// Bind the vertex array, so several draws can share one bind
+	void Bind();
+	// Draw a range of the indices. The mesh must be bound
+	void Draw(unsigned offset, unsigned count);
+	// Draw a range of the indices several times, with the per-instance attributes set up. The mesh must be bound
+	void DrawInstanced(unsigned offset, unsigned count, unsigned numOfInstances);
+	// Unbind the vertex array
+	void Unbind();
+	// Read the vertices and indices back from the buffers, such as to merge them into another mesh
+	bool ReadBack(std::vector<Vertex>& theVertices, std::vector<unsigned>& theIndices) const;
+	// Give the mesh a new generation, after its buffers were refilled
+	void MarkChanged();
+
 	const std::string name;
 	DRAW_MODE mode;
+	unsigned vertexArray;
 	unsigned vertexBuffer;
 	unsigned indexBuffer;
 	unsigned indexSize;
+	VERTEX_FORMAT vertexFormat;
+	// For FORMAT_COMPACT: set if the vertices have colours, else the shader gets white
+	bool bVertexColor;
+	// For FORMAT_COMPACT: set if the texture coordinates are normalised unsigned shorts, else half floats,
+	// which are used when they go outside 0 to 1, such as for a tiled texture
+	bool bNormalisedTexCoord;
+	// Set if the indices are unsigned shorts, else unsigned ints
+	bool bShortIndices;
 
 	Material material;
 	unsigned textureID;
+	// Set if the texture belongs to something else, such as a texture atlas, so it is not deleted with the mesh
+	bool bSharedTexture;
+	// Set if the buffers belong to something else, such as CStreamBuffer, so they are not deleted with the mesh
+	bool bSharedBuffers;
+	// Unique to each mesh and to each time its buffers are filled, so a copy of its data, such as in
+	// CSpriteBatch, can tell that it is out of date even if a new mesh reuses the address and the buffers
+	unsigned generation;
 };
 
 #endif
\ No newline at end of file
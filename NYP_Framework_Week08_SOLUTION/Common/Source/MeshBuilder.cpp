@@ -4,8 +4,16 @@
 #include <vector>
 #include "MyMath.h"
 #include "LoadOBJ.h"
+#include "MeshSimplifier.h"
 #include <iostream>
+#include <sstream>
 using namespace std;
+
+MeshBuilder::MeshBuilder(void)
+	: vertexFormat(Mesh::FORMAT_COMPACT)
+{
+}
+
 /******************************************************************************/
 /*!
 \brief
@@ -53,12 +61,7 @@ Mesh* MeshBuilder::GenerateAxes(const std::string &meshName, float lengthX, floa
 
 	Mesh *mesh = new Mesh(meshName);
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 	mesh->mode = Mesh::DRAW_LINES;
 
 	AddMesh(meshName, mesh);
@@ -110,12 +113,7 @@ Mesh* MeshBuilder::GenerateCrossHair(const std::string &meshName, float colour_r
 
 	Mesh *mesh = new Mesh(meshName);
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 	mesh->mode = Mesh::DRAW_LINES;
 
 	AddMesh(meshName, mesh);
@@ -137,6 +135,11 @@ Then generate the VBO/IBO and store them in Mesh object
 */
 /******************************************************************************/
 Mesh* MeshBuilder::GenerateQuad(const std::string &meshName, Color color, float length)
+{
+	return GenerateQuad(meshName, color, length, TexCoord(0, 0), TexCoord(1.0f, 1.0f));
+}
+
+Mesh* MeshBuilder::GenerateQuad(const std::string &meshName, Color color, float length, const TexCoord& minUV, const TexCoord& maxUV)
 {
 	Vertex v;
 	std::vector<Vertex> vertex_buffer_data;
@@ -145,22 +148,22 @@ Mesh* MeshBuilder::GenerateQuad(const std::string &meshName, Color color, float
 	v.pos.Set(-0.5f * length,-0.5f * length,0);
 	v.color = color;
 	v.normal.Set(0, 0, 1);
-	v.texCoord.Set(0, 0);
+	v.texCoord.Set(minUV.u, minUV.v);
 	vertex_buffer_data.push_back(v);
 	v.pos.Set(0.5f * length,-0.5f * length,0);
 	v.color = color;
 	v.normal.Set(0, 0, 1);
-	v.texCoord.Set(1.0f, 0);
+	v.texCoord.Set(maxUV.u, minUV.v);
 	vertex_buffer_data.push_back(v);
 	v.pos.Set(0.5f * length, 0.5f * length,0);
 	v.color = color;
 	v.normal.Set(0, 0, 1);
-	v.texCoord.Set(1.0f, 1.0f);
+	v.texCoord.Set(maxUV.u, maxUV.v);
 	vertex_buffer_data.push_back(v);
 	v.pos.Set(-0.5f * length, 0.5f * length,0);
 	v.color = color;
 	v.normal.Set(0, 0, 1);
-	v.texCoord.Set(0, 1.0f);
+	v.texCoord.Set(minUV.u, maxUV.v);
 	vertex_buffer_data.push_back(v);
 	
 	index_buffer_data.push_back(3);
@@ -172,12 +175,7 @@ Mesh* MeshBuilder::GenerateQuad(const std::string &meshName, Color color, float
 	
 	Mesh *mesh = new Mesh(meshName);
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	AddMesh(meshName, mesh);
@@ -269,12 +267,7 @@ Mesh* MeshBuilder::GenerateCube(const std::string &meshName, Color color, float
 	
 	Mesh *mesh = new Mesh(meshName);
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = 36;
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	AddMesh(meshName, mesh);
@@ -315,15 +308,10 @@ Mesh* MeshBuilder::GenerateRing(const std::string &meshName, Color color, unsign
 
 	Mesh *mesh = new Mesh(meshName);
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 
 	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
 
-	mesh->indexSize = index_buffer_data.size();
-
 	AddMesh(meshName, mesh);
 
 	return mesh;
@@ -381,12 +369,7 @@ Mesh* MeshBuilder::GenerateSphere(const std::string &meshName, Color color, unsi
 
 	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 
 	AddMesh(meshName, mesh);
 
@@ -427,12 +410,7 @@ Mesh* MeshBuilder::GenerateCone(const std::string &meshName, Color color, unsign
 
 	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 
 	AddMesh(meshName, mesh);
 
@@ -457,18 +435,86 @@ Mesh* MeshBuilder::GenerateOBJ(const std::string &meshName, const std::string &f
 	
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 
 	AddMesh(meshName, mesh);
 
 	return mesh;
 }
 
+/******************************************************************************/
+/*!
+\brief
+Load an OBJ file and generate a mesh for each LOD level by simplifying it.
+Level 0 is the first ratio, and each level is simplified from the level before it.
+The meshes are named with GetLODMeshName, e.g. meshName_LOD0, meshName_LOD1
+
+\param meshName - name of mesh
+\param file_path - path of the OBJ file
+\param triangleRatios - the fraction of the OBJ's triangles to keep at each level
+
+\return Pointer to the mesh of level 0. A level which cannot be simplified
+at all is not generated, nor are the levels after it
+*/
+/******************************************************************************/
+Mesh* MeshBuilder::GenerateOBJLOD(const std::string &meshName, const std::string &file_path, const std::vector<float>& triangleRatios)
+{
+	std::vector<Position> vertices;
+	std::vector<TexCoord> uvs;
+	std::vector<Vector3> normals;
+	bool success = LoadOBJ(file_path.c_str(), vertices, uvs, normals);
+	if(!success)
+		return NULL;
+
+	std::vector<Vertex> vertex_buffer_data;
+	std::vector<GLuint> index_buffer_data;
+	
+	IndexVBO(vertices, uvs, normals, index_buffer_data, vertex_buffer_data);
+
+	const unsigned numOfTriangles = index_buffer_data.size() / 3;
+	Mesh* firstMesh = NULL;
+	for (int level = 0; level < (int)triangleRatios.size(); ++level)
+	{
+		std::string levelName = GetLODMeshName(meshName, level);
+
+		// Simplify from the previous level, as it is smaller than the OBJ
+		unsigned currentTriangles = index_buffer_data.size() / 3;
+		float ratio = (numOfTriangles * triangleRatios[level]) / Math::Max(currentTriangles, 1u);
+		if (ratio < 1.0f)
+		{
+			std::vector<Vertex> simplified_vertex_data;
+			std::vector<GLuint> simplified_index_data;
+			bool bReached = SimplifyMesh(vertex_buffer_data, index_buffer_data, ratio, simplified_vertex_data, simplified_index_data);
+			unsigned simplifiedTriangles = simplified_index_data.size() / 3;
+			if ((simplifiedTriangles == 0) || (simplifiedTriangles >= currentTriangles))
+			{
+				// Leave out this level and the ones after it, rather than register copies of the last level
+				cout << "GenerateOBJLOD: " << levelName << " could not be simplified" << endl;
+				break;
+			}
+			if (!bReached)
+				cout << "GenerateOBJLOD: " << levelName << " has " << simplifiedTriangles << " triangles instead of "
+					 << (unsigned)(numOfTriangles * triangleRatios[level]) << endl;
+
+			vertex_buffer_data.swap(simplified_vertex_data);
+			index_buffer_data.swap(simplified_index_data);
+		}
+
+		Mesh *mesh = new Mesh(levelName);
+
+		mesh->mode = Mesh::DRAW_TRIANGLES;
+
+		mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
+
+		AddMesh(levelName, mesh);
+
+		if (level == 0)
+			firstMesh = mesh;
+	}
+
+	return firstMesh;
+}
+
 Mesh* MeshBuilder::GenerateText(const std::string &meshName, unsigned numRow, unsigned numCol)
 {
 	Vertex v;
@@ -512,12 +558,7 @@ Mesh* MeshBuilder::GenerateText(const std::string &meshName, unsigned numRow, un
 	
 	Mesh *mesh = new Mesh(meshName);
 	
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	AddMesh(meshName, mesh);
@@ -563,11 +604,7 @@ Mesh* MeshBuilder::GenerateCircle(const std::string &meshName, Color color, floa
 	}
 
 	Mesh *mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 	return mesh;
 }
@@ -601,14 +638,7 @@ Mesh* MeshBuilder::GenerateRay(const std::string &meshName, const float length)
 
 	Mesh *mesh = new Mesh(meshName);
 
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex),
-		&vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint),
-		&index_buffer_data[0], GL_STATIC_DRAW);
-
-	mesh->indexSize = index_buffer_data.size();
+	mesh->Upload(vertex_buffer_data, index_buffer_data, vertexFormat);
 	mesh->mode = Mesh::DRAW_LINES;
 
 	AddMesh(meshName, mesh);
@@ -645,4 +675,21 @@ void MeshBuilder::RemoveMesh(const std::string& _meshName)
 		delete currMesh;
 		meshMap.erase(_meshName);
 	}
-}
\ No newline at end of file
+}
+
+std::string MeshBuilder::GetLODMeshName(const std::string& _meshName, const int _level)
+{
+	std::ostringstream levelName;
+	levelName << _meshName << "_LOD" << _level;
+	return levelName.str();
+}
+
+void MeshBuilder::SetVertexFormat(const Mesh::VERTEX_FORMAT _vertexFormat)
+{
+	vertexFormat = _vertexFormat;
+}
+
+Mesh::VERTEX_FORMAT MeshBuilder::GetVertexFormat(void) const
+{
+	return vertexFormat;
+}
@@ -3,11 +3,10 @@
 
 #include "SingletonTemplate.h"
 #include "Vertex.h"
+#include "Mesh.h"
 #include <map>
 #include <string>
-
-// Forward Declaration
-class Mesh;
+#include <vector>
 
 /******************************************************************************/
 /*!
@@ -22,11 +21,14 @@ public:
 	Mesh* GenerateAxes(const std::string &meshName, float lengthX=0.0f, float lengthY=0.0f, float lengthZ=0.0f);
 	Mesh* GenerateCrossHair(const std::string &meshName, float colour_r=1.0f, float colour_g=1.0f, float colour_b=0.0f, float length=1.0f);
 	Mesh* GenerateQuad(const std::string &meshName, Color color, float length = 1.f);
+	// Generate a quad which shows a rectangle of its texture, such as a region of a texture atlas
+	Mesh* GenerateQuad(const std::string &meshName, Color color, float length, const TexCoord& minUV, const TexCoord& maxUV);
 	Mesh* GenerateCube(const std::string &meshName, Color color, float length = 1.f);
 	Mesh* GenerateRing(const std::string &meshName, Color color, unsigned numSlice, float outerR = 1.f, float innerR = 0.f);
 	Mesh* GenerateSphere(const std::string &meshName, Color color, unsigned numStack, unsigned numSlice, float radius = 1.f);
 	Mesh* GenerateCone(const std::string &meshName, Color color, unsigned numSlice, float radius, float height);
 	Mesh* GenerateOBJ(const std::string &meshName, const std::string &file_path);
+	Mesh* GenerateOBJLOD(const std::string &meshName, const std::string &file_path, const std::vector<float>& triangleRatios);
 	Mesh* GenerateText(const std::string &meshName, unsigned row, unsigned col);
 	Mesh* GenerateSkyPlane(const std::string &meshName, Color color, int slices,float PlanetRadius, float AtmosphereRadius, float hTile, float vTile);
 	Mesh* GenerateCircle(const std::string &meshName, Color color, float length = 1.0f);
@@ -36,8 +38,18 @@ public:
 	void AddMesh(const std::string& _meshName, Mesh* _newMesh);
 	void RemoveMesh(const std::string& _meshName);
 
+	// Get the name of a mesh generated by GenerateOBJLOD for a LOD level
+	static std::string GetLODMeshName(const std::string& _meshName, const int _level);
+
+	// Set the vertex format of the meshes generated after this. FORMAT_COMPACT by default
+	void SetVertexFormat(const Mesh::VERTEX_FORMAT _vertexFormat);
+	Mesh::VERTEX_FORMAT GetVertexFormat(void) const;
+
 private:
+	MeshBuilder(void);
+
 	std::map<std::string, Mesh*> meshMap;
+	Mesh::VERTEX_FORMAT vertexFormat;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include <iostream>
+#include <map>
+#include <queue>
+#include <algorithm>
+#include <cfloat>
+
+#include "MeshSimplifier.h"
+
+// A symmetric 4x4 matrix which sums the squared distances to a set of planes
+struct Quadric
+{
+	double a[10];
+
+	Quadric() { for (int i = 0; i < 10; ++i) a[i] = 0.0; }
+
+	// Add the plane nx*x + ny*y + nz*z + d = 0, weighted by weight
+	void AddPlane(double nx, double ny, double nz, double d, double weight)
+	{
+		a[0] += weight * nx * nx; a[1] += weight * nx * ny; a[2] += weight * nx * nz; a[3] += weight * nx * d;
+		a[4] += weight * ny * ny; a[5] += weight * ny * nz; a[6] += weight * ny * d;
+		a[7] += weight * nz * nz; a[8] += weight * nz * d;
+		a[9] += weight * d * d;
+	}
+
+	void Add(const Quadric& rhs) { for (int i = 0; i < 10; ++i) a[i] += rhs.a[i]; }
+
+	// The sum of the squared distances from a point to the planes
+	double Error(double x, double y, double z) const
+	{
+		return	a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x +
+				a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y +
+				a[7] * z * z + 2 * a[8] * z +
+				a[9];
+	}
+};
+
+// A candidate collapse which moves the vertices at position "from" onto the vertices at position "to"
+struct Collapse
+{
+	double cost;
+	unsigned from, to;
+	unsigned fromStamp, toStamp;
+
+	bool operator>(const Collapse& rhs) const { return cost > rhs.cost; }
+};
+
+typedef std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > CollapseQueue;
+
+static Vector3 ToVector3(const Position& pos)
+{
+	return Vector3(pos.x, pos.y, pos.z);
+}
+
+static Vector3 TriangleNormal(const Vector3& p0, const Vector3& p1, const Vector3& p2)
+{
+	return (p1 - p0).Cross(p2 - p0);
+}
+
+// Queue the collapse of group "from" onto group "to" if "from" is allowed to move
+static void PushCollapse(	CollapseQueue& theQueue, const std::vector<Quadric>& quadrics, const std::vector<bool>& locked,
+							const std::vector<unsigned>& stamps, const std::vector<Vector3>& positions, unsigned from, unsigned to)
+{
+	if ((from == to) || (locked[from]))
+		return;
+
+	Quadric q = quadrics[from];
+	q.Add(quadrics[to]);
+	const Vector3& target = positions[to];
+
+	Collapse aCollapse;
+	aCollapse.cost = q.Error(target.x, target.y, target.z);
+	aCollapse.from = from;
+	aCollapse.to = to;
+	aCollapse.fromStamp = stamps[from];
+	aCollapse.toStamp = stamps[to];
+	theQueue.push(aCollapse);
+}
+
+bool SimplifyMesh(
+	const std::vector<Vertex> & in_vertices,
+	const std::vector<unsigned> & in_indices,
+	const float targetRatio,
+
+	std::vector<Vertex> & out_vertices,
+	std::vector<unsigned> & out_indices
+)
+{
+	out_vertices.clear();
+	out_indices.clear();
+
+	const unsigned numOfVertices = (unsigned)in_vertices.size();
+	const unsigned numOfTriangles = (unsigned)in_indices.size() / 3;
+	if ((numOfVertices == 0) || (numOfTriangles == 0) || (in_indices.size() % 3 != 0))
+	{
+		std::cout << "SimplifyMesh: The mesh is not a triangle list" << std::endl;
+		return false;
+	}
+	for (unsigned i = 0; i < in_indices.size(); ++i)
+	{
+		if (in_indices[i] >= numOfVertices)
+		{
+			std::cout << "SimplifyMesh: Index " << in_indices[i] << " is out of range" << std::endl;
+			return false;
+		}
+	}
+
+	std::vector<Vertex> vertices(in_vertices);
+	std::vector<unsigned> indices(in_indices);
+	std::vector<bool> triangleRemoved(numOfTriangles, false);
+	unsigned targetTriangles = (unsigned)(numOfTriangles * std::max(0.0f, std::min(1.0f, targetRatio)));
+
+	// Group the vertices which share a position. The vertices are split at UV and normal seams,
+	// so a group is a single point of the surface, and it is collapsed as a whole
+	std::vector<unsigned> groupOf(numOfVertices);
+	std::vector< std::vector<unsigned> > groupVertices;
+	std::vector<Vector3> positions;
+	std::map<std::pair<float, std::pair<float, float> >, unsigned> positionMap;
+	for (unsigned i = 0; i < numOfVertices; ++i)
+	{
+		const Position& pos = in_vertices[i].pos;
+		std::pair<float, std::pair<float, float> > key(pos.x, std::make_pair(pos.y, pos.z));
+		std::map<std::pair<float, std::pair<float, float> >, unsigned>::iterator it = positionMap.find(key);
+		if (it == positionMap.end())
+		{
+			it = positionMap.insert(std::make_pair(key, (unsigned)groupVertices.size())).first;
+			groupVertices.push_back(std::vector<unsigned>());
+			positions.push_back(ToVector3(pos));
+		}
+		groupOf[i] = it->second;
+		groupVertices[it->second].push_back(i);
+	}
+	const unsigned numOfGroups = (unsigned)groupVertices.size();
+
+	// Build the quadric of each group from the planes of its triangles, weighted by area
+	std::vector<Quadric> quadrics(numOfGroups);
+	std::vector< std::vector<unsigned> > vertexTriangles(numOfVertices);
+	for (unsigned t = 0; t < numOfTriangles; ++t)
+	{
+		Vector3 p0 = ToVector3(in_vertices[indices[t * 3]].pos);
+		Vector3 p1 = ToVector3(in_vertices[indices[t * 3 + 1]].pos);
+		Vector3 p2 = ToVector3(in_vertices[indices[t * 3 + 2]].pos);
+		Vector3 normal = TriangleNormal(p0, p1, p2);
+		double area = normal.Length();
+		for (int k = 0; k < 3; ++k)
+			vertexTriangles[indices[t * 3 + k]].push_back(t);
+		if (area <= 0.0)
+			continue;
+		double nx = normal.x / area, ny = normal.y / area, nz = normal.z / area;
+		double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+		for (int k = 0; k < 3; ++k)
+			quadrics[groupOf[indices[t * 3 + k]]].AddPlane(nx, ny, nz, d, area * 0.5);
+	}
+
+	// Lock the groups on open borders. The edges are counted between the groups, so the
+	// UV and normal seams are not borders, as they have a triangle on each side
+	std::vector<bool> locked(numOfGroups, false);
+	std::map<std::pair<unsigned, unsigned>, int> edgeCount;
+	for (unsigned t = 0; t < numOfTriangles; ++t)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			unsigned g0 = groupOf[indices[t * 3 + k]];
+			unsigned g1 = groupOf[indices[t * 3 + (k + 1) % 3]];
+			edgeCount[std::make_pair(std::min(g0, g1), std::max(g0, g1))]++;
+		}
+	}
+	for (std::map<std::pair<unsigned, unsigned>, int>::iterator it = edgeCount.begin(); it != edgeCount.end(); ++it)
+	{
+		if (it->second != 2)
+		{
+			locked[it->first.first] = true;
+			locked[it->first.second] = true;
+		}
+	}
+
+	// Queue all the possible collapses
+	std::vector<unsigned> stamps(numOfGroups, 0);
+	std::vector<bool> groupRemoved(numOfGroups, false);
+	CollapseQueue theQueue;
+	for (unsigned t = 0; t < numOfTriangles; ++t)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			unsigned g0 = groupOf[indices[t * 3 + k]];
+			unsigned g1 = groupOf[indices[t * 3 + (k + 1) % 3]];
+			PushCollapse(theQueue, quadrics, locked, stamps, positions, g0, g1);
+			PushCollapse(theQueue, quadrics, locked, stamps, positions, g1, g0);
+		}
+	}
+
+	// Collapse the cheapest edges until the target is reached
+	unsigned numOfLiveTriangles = numOfTriangles;
+	while ((numOfLiveTriangles > targetTriangles) && (!theQueue.empty()))
+	{
+		Collapse aCollapse = theQueue.top();
+		theQueue.pop();
+
+		unsigned from = aCollapse.from;
+		unsigned to = aCollapse.to;
+		if ((groupRemoved[from]) || (groupRemoved[to]) ||
+			(aCollapse.fromStamp != stamps[from]) || (aCollapse.toStamp != stamps[to]))
+			continue;
+
+		// Reject the collapse if it flips or degenerates any triangle which is kept
+		bool bValid = true;
+		bool bSharesTriangle = false;
+		const std::vector<unsigned>& fromVertices = groupVertices[from];
+		const Vector3& target = positions[to];
+		for (unsigned i = 0; i < fromVertices.size() && bValid; ++i)
+		{
+			const std::vector<unsigned>& theTriangles = vertexTriangles[fromVertices[i]];
+			for (unsigned j = 0; j < theTriangles.size() && bValid; ++j)
+			{
+				unsigned t = theTriangles[j];
+				if (triangleRemoved[t])
+					continue;
+				const unsigned* tri = &indices[t * 3];
+				if ((groupOf[tri[0]] == to) || (groupOf[tri[1]] == to) || (groupOf[tri[2]] == to))
+				{
+					bSharesTriangle = true;
+					continue;
+				}
+
+				Vector3 p[3], q[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					p[k] = positions[groupOf[tri[k]]];
+					q[k] = (groupOf[tri[k]] == from) ? target : p[k];
+				}
+				Vector3 oldNormal = TriangleNormal(p[0], p[1], p[2]);
+				Vector3 newNormal = TriangleNormal(q[0], q[1], q[2]);
+				float newLength = newNormal.Length();
+				if ((newLength <= 1e-12f) || (oldNormal.Dot(newNormal) <= 0.2f * oldNormal.Length() * newLength))
+					bValid = false;
+			}
+		}
+		if ((!bValid) || (!bSharesTriangle))
+			continue;
+
+		// Move every vertex of "from" onto the vertex of "to" which shares a triangle with it, so it keeps the
+		// UVs and normal of its side of a seam. A vertex with no such neighbour, such as on a hard edge, is
+		// moved to the position of "to" with its own normal, and the nearest UVs there
+		const std::vector<unsigned>& toVertices = groupVertices[to];
+		std::vector<unsigned> theMovedVertices;
+		for (unsigned i = 0; i < fromVertices.size(); ++i)
+		{
+			const unsigned v = fromVertices[i];
+			std::vector<unsigned>& theTriangles = vertexTriangles[v];
+			unsigned moveTo = (unsigned)-1;
+			for (unsigned j = 0; j < theTriangles.size() && moveTo == (unsigned)-1; ++j)
+			{
+				if (triangleRemoved[theTriangles[j]])
+					continue;
+				const unsigned* tri = &indices[theTriangles[j] * 3];
+				for (int k = 0; k < 3; ++k)
+				{
+					if (groupOf[tri[k]] == to)
+						moveTo = tri[k];
+				}
+			}
+			if (moveTo == (unsigned)-1)
+			{
+				const TexCoord theTexCoord = vertices[v].texCoord;
+				float bestDistance = FLT_MAX;
+				for (unsigned j = 0; j < toVertices.size(); ++j)
+				{
+					const TexCoord& uv = vertices[toVertices[j]].texCoord;
+					float du = uv.u - theTexCoord.u, dv = uv.v - theTexCoord.v;
+					if (du * du + dv * dv < bestDistance)
+					{
+						bestDistance = du * du + dv * dv;
+						vertices[v].texCoord = uv;
+					}
+				}
+				vertices[v].pos = vertices[toVertices[0]].pos;
+				moveTo = v;
+				theMovedVertices.push_back(v);
+			}
+
+			for (unsigned j = 0; j < theTriangles.size(); ++j)
+			{
+				unsigned t = theTriangles[j];
+				if (triangleRemoved[t])
+					continue;
+				unsigned* tri = &indices[t * 3];
+				if ((groupOf[tri[0]] == to) || (groupOf[tri[1]] == to) || (groupOf[tri[2]] == to))
+				{
+					triangleRemoved[t] = true;
+					numOfLiveTriangles--;
+				}
+				else if (moveTo != v)
+				{
+					for (int k = 0; k < 3; ++k)
+					{
+						if (tri[k] == v)
+							tri[k] = moveTo;
+					}
+					vertexTriangles[moveTo].push_back(t);
+				}
+			}
+			if (moveTo != v)
+				theTriangles.clear();
+		}
+		// The vertices which were moved in place are now at "to"
+		for (unsigned i = 0; i < theMovedVertices.size(); ++i)
+		{
+			groupOf[theMovedVertices[i]] = to;
+			groupVertices[to].push_back(theMovedVertices[i]);
+		}
+		groupVertices[from].clear();
+		groupRemoved[from] = true;
+		quadrics[to].Add(quadrics[from]);
+		stamps[to]++;
+
+		// Queue the new collapses around "to"
+		for (unsigned i = 0; i < toVertices.size(); ++i)
+		{
+			std::vector<unsigned>& toTriangles = vertexTriangles[toVertices[i]];
+			std::vector<unsigned> liveTriangles;
+			for (unsigned j = 0; j < toTriangles.size(); ++j)
+			{
+				unsigned t = toTriangles[j];
+				if (triangleRemoved[t])
+					continue;
+				liveTriangles.push_back(t);
+				for (int k = 0; k < 3; ++k)
+				{
+					unsigned neighbour = groupOf[indices[t * 3 + k]];
+					if (neighbour == to)
+						continue;
+					PushCollapse(theQueue, quadrics, locked, stamps, positions, neighbour, to);
+					PushCollapse(theQueue, quadrics, locked, stamps, positions, to, neighbour);
+				}
+			}
+			toTriangles.swap(liveTriangles);
+		}
+	}
+
+	// Copy out the remaining triangles and the vertices which they use
+	std::vector<unsigned> remap(numOfVertices, (unsigned)-1);
+	for (unsigned t = 0; t < numOfTriangles; ++t)
+	{
+		if (triangleRemoved[t])
+			continue;
+		for (int k = 0; k < 3; ++k)
+		{
+			unsigned index = indices[t * 3 + k];
+			if (remap[index] == (unsigned)-1)
+			{
+				remap[index] = (unsigned)out_vertices.size();
+				out_vertices.push_back(vertices[index]);
+			}
+			out_indices.push_back(remap[index]);
+		}
+	}
+	return (numOfLiveTriangles <= targetTriangles);
+}
@@ -0,0 +1,39 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <vector>
+#include "Vertex.h"
+
+/******************************************************************************/
+/*!
+\brief
+Simplify an indexed triangle mesh with quadric error metrics
+
+Edges are collapsed in order of their quadric error until the number of
+triangles is at most targetRatio of the input. The vertices which share a
+position, such as on UV or normal seams, are collapsed together, each onto
+the neighbour on its own side of the seam, so the seams stay closed. A vertex
+with no such neighbour, such as on a hard edge, is moved to the neighbour's
+position and keeps its own normal. Vertices on open borders are never moved.
+
+\param in_vertices - the vertices of the input mesh
+\param in_indices - the triangle indices of the input mesh
+\param targetRatio - the fraction of triangles to keep, from 0 to 1
+\param out_vertices - the vertices of the simplified mesh
+\param out_indices - the triangle indices of the simplified mesh
+
+\return true if the target was reached, false if the input is not a valid triangle
+mesh, or if too few edges could be collapsed. The output then holds the mesh
+as far as it was simplified, with out_indices.size() / 3 triangles
+*/
+/******************************************************************************/
+bool SimplifyMesh(
+	const std::vector<Vertex> & in_vertices,
+	const std::vector<unsigned> & in_indices,
+	const float targetRatio,
+
+	std::vector<Vertex> & out_vertices,
+	std::vector<unsigned> & out_indices
+);
+
+#endif
@@ -0,0 +1,231 @@
+/******************************************************************************/
+/*!
+\file	Quaternion.cpp
+\brief
+Struct to define a unit quaternion for 3D rotations
+*/
+/******************************************************************************/
+#include <cmath>
+#include "Quaternion.h"
+
+Quaternion::Quaternion(float w, float x, float y, float z)
+	: w(w), x(x), y(y), z(z)
+{
+}
+
+Quaternion::Quaternion(const Quaternion &rhs)
+	: w(rhs.w), x(rhs.x), y(rhs.y), z(rhs.z)
+{
+}
+
+Quaternion::~Quaternion()
+{
+}
+
+void Quaternion::Set(float w, float x, float y, float z)
+{
+	this->w = w;
+	this->x = x;
+	this->y = y;
+	this->z = z;
+}
+
+void Quaternion::SetToIdentity(void)
+{
+	Set(1.0f, 0.0f, 0.0f, 0.0f);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Set to a rotation of degrees about an axis
+
+\param degrees
+	angle of rotation, in degrees, anticlockwise
+\param axisX, axisY, axisZ
+	axis of rotation. It does not need to be normalized
+\exception DivideByZero
+	thrown if the axis is a zero vector
+*/
+/******************************************************************************/
+void Quaternion::SetToRotation(float degrees, float axisX, float axisY, float axisZ) throw( DivideByZero )
+{
+	float mag = sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
+	if (Math::FAbs(mag) < Math::EPSILON)
+		throw DivideByZero();
+
+	float halfAngle = Math::DegreeToRadian(degrees) * 0.5f;
+	float s = sin(halfAngle) / mag;
+	Set(cos(halfAngle), axisX * s, axisY * s, axisZ * s);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Set to the rotation part of a matrix. The columns of the matrix are normalized
+first, so a matrix with a scale can be used as long as it has no shear
+
+\param theMatrix
+	the matrix to take the rotation from
+*/
+/******************************************************************************/
+void Quaternion::SetFromMatrix(const Mtx44& theMatrix)
+{
+	// Remove the scale from each column
+	float m[3][3];
+	for (int column = 0; column < 3; ++column)
+	{
+		float length = sqrt(theMatrix.a[column * 4] * theMatrix.a[column * 4] +
+							theMatrix.a[column * 4 + 1] * theMatrix.a[column * 4 + 1] +
+							theMatrix.a[column * 4 + 2] * theMatrix.a[column * 4 + 2]);
+		if (length < Math::EPSILON)
+			length = 1.0f;
+		for (int row = 0; row < 3; ++row)
+			m[row][column] = theMatrix.a[column * 4 + row] / length;
+	}
+
+	// Use the largest diagonal term to keep the division well away from zero
+	float trace = m[0][0] + m[1][1] + m[2][2];
+	if (trace > 0.0f)
+	{
+		float s = sqrt(trace + 1.0f) * 2.0f;
+		Set(0.25f * s, (m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s);
+	}
+	else if ((m[0][0] > m[1][1]) && (m[0][0] > m[2][2]))
+	{
+		float s = sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]) * 2.0f;
+		Set((m[2][1] - m[1][2]) / s, 0.25f * s, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s);
+	}
+	else if (m[1][1] > m[2][2])
+	{
+		float s = sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]) * 2.0f;
+		Set((m[0][2] - m[2][0]) / s, (m[0][1] + m[1][0]) / s, 0.25f * s, (m[1][2] + m[2][1]) / s);
+	}
+	else
+	{
+		float s = sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]) * 2.0f;
+		Set((m[1][0] - m[0][1]) / s, (m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, 0.25f * s);
+	}
+	Normalize();
+}
+
+Quaternion Quaternion::operator*(const Quaternion& rhs) const
+{
+	return Quaternion(	w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z,
+						w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+						w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+						w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w);
+}
+
+Vector3 Quaternion::operator*(const Vector3& rhs) const
+{
+	// v' = v + 2w(q x v) + 2(q x (q x v)), where q is the vector part
+	Vector3 q(x, y, z);
+	Vector3 t = q.Cross(rhs) * 2.0f;
+	return rhs + t * w + q.Cross(t);
+}
+
+Quaternion& Quaternion::operator=(const Quaternion& rhs)
+{
+	Set(rhs.w, rhs.x, rhs.y, rhs.z);
+	return *this;
+}
+
+float Quaternion::Length(void) const
+{
+	return sqrt(w * w + x * x + y * y + z * z);
+}
+
+Quaternion& Quaternion::Normalize(void)
+{
+	float length = Length();
+	if (length < Math::EPSILON)
+	{
+		SetToIdentity();
+		return *this;
+	}
+	w /= length;
+	x /= length;
+	y /= length;
+	z /= length;
+	return *this;
+}
+
+Quaternion Quaternion::Conjugate(void) const
+{
+	return Quaternion(w, -x, -y, -z);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Get the rotation matrix of this quaternion, in the same layout as Mtx44::SetToRotation
+
+\return
+	the rotation matrix
+*/
+/******************************************************************************/
+Mtx44 Quaternion::ToMatrix(void) const
+{
+	Mtx44 result;
+	result.a[0] = 1.0f - 2.0f * (y * y + z * z);
+	result.a[1] = 2.0f * (x * y + w * z);
+	result.a[2] = 2.0f * (x * z - w * y);
+	result.a[3] = 0.0f;
+	result.a[4] = 2.0f * (x * y - w * z);
+	result.a[5] = 1.0f - 2.0f * (x * x + z * z);
+	result.a[6] = 2.0f * (y * z + w * x);
+	result.a[7] = 0.0f;
+	result.a[8] = 2.0f * (x * z + w * y);
+	result.a[9] = 2.0f * (y * z - w * x);
+	result.a[10] = 1.0f - 2.0f * (x * x + y * y);
+	result.a[11] = 0.0f;
+	result.a[12] = 0.0f;
+	result.a[13] = 0.0f;
+	result.a[14] = 0.0f;
+	result.a[15] = 1.0f;
+	return result;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Interpolate between 2 rotations along the shortest arc, at a constant angular speed
+
+\param from
+	the rotation at t = 0
+\param to
+	the rotation at t = 1
+\param t
+	the interpolation factor, from 0 to 1
+\return
+	the interpolated rotation
+*/
+/******************************************************************************/
+Quaternion Slerp(const Quaternion& from, const Quaternion& to, float t)
+{
+	// q and -q are the same rotation, so flip one to take the shortest arc
+	float cosAngle = from.w * to.w + from.x * to.x + from.y * to.y + from.z * to.z;
+	Quaternion target = to;
+	if (cosAngle < 0.0f)
+	{
+		cosAngle = -cosAngle;
+		target.Set(-to.w, -to.x, -to.y, -to.z);
+	}
+
+	float fromWeight = 1.0f - t, toWeight = t;
+	// Use a linear interpolation when the rotations are too close for sin to be accurate
+	if (cosAngle < 0.9995f)
+	{
+		float angle = acos(cosAngle);
+		float sinAngle = sin(angle);
+		fromWeight = sin((1.0f - t) * angle) / sinAngle;
+		toWeight = sin(t * angle) / sinAngle;
+	}
+
+	Quaternion result(	fromWeight * from.w + toWeight * target.w,
+						fromWeight * from.x + toWeight * target.x,
+						fromWeight * from.y + toWeight * target.y,
+						fromWeight * from.z + toWeight * target.z);
+	return result.Normalize();
+}
@@ -0,0 +1,51 @@
+/******************************************************************************/
+/*!
+\file	Quaternion.h
+\brief
+Struct to define a unit quaternion for 3D rotations
+*/
+/******************************************************************************/
+
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include "Vector3.h"
+#include "Mtx44.h"
+
+/******************************************************************************/
+/*!
+		Class Quaternion:
+\brief	Defines a rotation as a unit quaternion, w + xi + yj + zk
+*/
+/******************************************************************************/
+struct Quaternion
+{
+	float w, x, y, z;
+
+	Quaternion(float w = 1.0f, float x = 0.0f, float y = 0.0f, float z = 0.0f);
+	Quaternion(const Quaternion &rhs);
+	~Quaternion();
+
+	void Set(float w, float x, float y, float z); //Set all data
+	void SetToIdentity(void); //Set to no rotation
+	//Set to a rotation of degrees about an axis, as in Mtx44::SetToRotation
+	//Throw a divide by zero exception if the axis is a zero vector
+	void SetToRotation(float degrees, float axisX, float axisY, float axisZ) throw( DivideByZero );
+	//Set to the rotation part of a matrix. The matrix must not have any shear
+	void SetFromMatrix(const Mtx44& theMatrix);
+
+	Quaternion operator*(const Quaternion& rhs) const; //Apply rhs first, then this rotation
+	Vector3 operator*(const Vector3& rhs) const; //Rotate a vector
+	Quaternion& operator=(const Quaternion& rhs); //Assignment operator
+
+	float Length(void) const; //Get magnitude
+	Quaternion& Normalize(void); //Normalize this quaternion and return a reference to it
+	Quaternion Conjugate(void) const; //The inverse rotation of a unit quaternion
+
+	Mtx44 ToMatrix(void) const; //Get the rotation matrix
+
+	//Interpolate between 2 rotations along the shortest arc, t from 0 to 1
+	friend Quaternion Slerp(const Quaternion& from, const Quaternion& to, float t);
+};
+
+#endif //QUATERNION_H
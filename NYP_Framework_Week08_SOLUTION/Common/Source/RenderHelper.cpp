@@ -3,11 +3,21 @@
 #include "GraphicsManager.h"
 #include "ShaderProgram.h"
 #include "MatrixStack.h"
-
-bool RenderHelper::bLightEnable = false;
-bool RenderHelper::bColorTextureEnabled = false;
-bool RenderHelper::bColorTexture = false;
-bool RenderHelper::bTextEnabled = false;
+#include "RenderQueue.h"
+#include "SpriteBatch.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+#include "GL\glew.h"
+
+thread_local bool RenderHelper::bLightEnable = false;
+thread_local bool RenderHelper::bColorTextureEnabled = false;
+thread_local bool RenderHelper::bColorTexture = false;
+thread_local bool RenderHelper::bTextEnabled = false;
+thread_local bool RenderHelper::bAlphaTestEnabled = false;
+thread_local bool RenderHelper::bDitherEnabled = false;
+thread_local bool RenderHelper::bDitherInverted = false;
+thread_local float RenderHelper::ditherAlpha = 1.0f;
+thread_local bool RenderHelper::bWireframe = false;
+thread_local float RenderHelper::lineWidth = 1.0f;
 
 /**
 * Pre Render Mesh to setup the shaders before rendering a mesh without light
@@ -20,30 +30,30 @@ void RenderHelper::PreRenderMesh(const bool bLightEnable, const bool bColorTextu
 	// Enable / Disable lighting stuff
 	RenderHelper::bLightEnable = bLightEnable;
 	if (bLightEnable)
-		currProg->UpdateInt("lightEnabled", 1);
+		currProg->GetUniforms().lightEnabled.Set(1);
 	else
-		currProg->UpdateInt("lightEnabled", 0);
+		currProg->GetUniforms().lightEnabled.Set(0);
 
 	// Enable / Disable colour texture enabled
 	RenderHelper::bColorTextureEnabled = bColorTextureEnabled;
 	if (bColorTextureEnabled)
-		currProg->UpdateInt("colorTextureEnabled", 1);
+		currProg->GetUniforms().colorTextureEnabled.Set(1);
 	else
-		currProg->UpdateInt("colorTextureEnabled", 0);
+		currProg->GetUniforms().colorTextureEnabled.Set(0);
 
 	// Enable / Disable colour texture
 	RenderHelper::bColorTexture = bColorTexture;
 	if (bColorTexture)
-		currProg->UpdateInt("colorTexture", 1);
+		currProg->GetUniforms().colorTexture.Set(1);
 	else
-		currProg->UpdateInt("colorTexture", 0);
+		currProg->GetUniforms().colorTexture.Set(0);
 
 	// Enable / Disable text display
 	RenderHelper::bTextEnabled = bTextEnabled;
 	if (bColorTexture)
-		currProg->UpdateInt("textEnabled", 1);
+		currProg->GetUniforms().textEnabled.Set(1);
 	else
-		currProg->UpdateInt("textEnabled", 0);
+		currProg->GetUniforms().textEnabled.Set(0);
 }
 
 /**
@@ -51,11 +61,25 @@ void RenderHelper::PreRenderMesh(const bool bLightEnable, const bool bColorTextu
 */
 void RenderHelper::RenderMesh(Mesh* _mesh)
 {
+	// Let the render queue draw it later, in a better order
+	if (CRenderQueue::GetInstance()->IsRecording())
+	{
+		CRenderQueue::GetInstance()->Submit(_mesh, 0, 0, GetRenderFlags(false), ditherAlpha, lineWidth);
+		return;
+	}
+	// Let the sprite batch draw it with the other sprites, else draw the sprites before it to keep their order
+	if (CSpriteBatch::GetInstance()->IsRecording())
+	{
+		if (CSpriteBatch::GetInstance()->Add(_mesh, 0, 0, GetRenderFlags(false), ditherAlpha))
+			return;
+		CSpriteBatch::GetInstance()->Flush();
+	}
+
 	// Get all our transform matrices & update shader
 	Mtx44 MVP;
 	MVP = GraphicsManager::GetInstance()->GetProjectionMatrix() * GraphicsManager::GetInstance()->GetViewMatrix() * GraphicsManager::GetInstance()->GetModelStack().Top();
 	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
-	currProg->UpdateMatrix44("MVP", &MVP.a[0]);
+	currProg->GetUniforms().MVP.Set(MVP);
 
 	// Update textures first if available
 	if (_mesh->textureID > 0)
@@ -72,7 +96,7 @@ void RenderHelper::RenderMesh(Mesh* _mesh)
 	{
 		if (bColorTextureEnabled)
 		{
-			currProg->UpdateInt("colorTextureEnabled", 0);
+			currProg->GetUniforms().colorTextureEnabled.Set(0);
 		}
 	}
 
@@ -88,7 +112,62 @@ void RenderHelper::RenderMesh(Mesh* _mesh)
 	{
 		if (bColorTextureEnabled)
 		{
-			currProg->UpdateInt("colorTextureEnabled", 1);
+			currProg->GetUniforms().colorTextureEnabled.Set(1);
+		}
+	}
+}
+
+/**
+* Render Mesh to render a range of a mesh's indices without light
+*/
+void RenderHelper::RenderMesh(Mesh* _mesh, const unsigned _offset, const unsigned _count)
+{
+	// Let the render queue draw it later, in a better order
+	if (CRenderQueue::GetInstance()->IsRecording())
+	{
+		CRenderQueue::GetInstance()->Submit(_mesh, _offset, _count, GetRenderFlags(false), ditherAlpha, lineWidth);
+		return;
+	}
+	// Let the sprite batch draw it with the other sprites, else draw the sprites before it to keep their order
+	if (CSpriteBatch::GetInstance()->IsRecording())
+	{
+		if (CSpriteBatch::GetInstance()->Add(_mesh, _offset, _count, GetRenderFlags(false), ditherAlpha))
+			return;
+		CSpriteBatch::GetInstance()->Flush();
+	}
+
+	// Get all our transform matrices & update shader
+	Mtx44 MVP;
+	MVP = GraphicsManager::GetInstance()->GetProjectionMatrix() * GraphicsManager::GetInstance()->GetViewMatrix() * GraphicsManager::GetInstance()->GetModelStack().Top();
+	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
+	currProg->GetUniforms().MVP.Set(MVP);
+
+	// Update textures first if available
+	if (_mesh->textureID > 0)
+	{
+		GraphicsManager::GetInstance()->UpdateTexture(0, _mesh->textureID);
+	}
+	else
+	{
+		if (bColorTextureEnabled)
+		{
+			currProg->GetUniforms().colorTextureEnabled.Set(0);
+		}
+	}
+
+	// Do actual rendering
+	_mesh->Render(_offset, _count);
+
+	// Unbind texture for safety (in case next render call uses it by accident)
+	if (_mesh->textureID > 0)
+	{
+		GraphicsManager::GetInstance()->UnbindTexture(0);
+	}
+	else
+	{
+		if (bColorTextureEnabled)
+		{
+			currProg->GetUniforms().colorTextureEnabled.Set(1);
 		}
 	}
 }
@@ -104,30 +183,30 @@ void RenderHelper::PostRenderMesh(const bool bLightEnable, const bool bColorText
 	// Enable / Disable lighting stuff
 	RenderHelper::bLightEnable = bLightEnable;
 	if (bLightEnable)
-		currProg->UpdateInt("lightEnabled", 1);
+		currProg->GetUniforms().lightEnabled.Set(1);
 	else
-		currProg->UpdateInt("lightEnabled", 0);
+		currProg->GetUniforms().lightEnabled.Set(0);
 
 	// Enable / Disable colour texture
 	RenderHelper::bColorTextureEnabled = bColorTextureEnabled;
 	if (bColorTextureEnabled)
-		currProg->UpdateInt("colorTextureEnabled", 1);
+		currProg->GetUniforms().colorTextureEnabled.Set(1);
 	else
-		currProg->UpdateInt("colorTextureEnabled", 0);
+		currProg->GetUniforms().colorTextureEnabled.Set(0);
 
 	// Enable / Disable colour texture
 	RenderHelper::bColorTexture = bColorTexture;
 	if (bColorTexture)
-		currProg->UpdateInt("colorTexture", 1);
+		currProg->GetUniforms().colorTexture.Set(1);
 	else
-		currProg->UpdateInt("colorTexture", 0);
+		currProg->GetUniforms().colorTexture.Set(0);
 
 	// Enable / Disable text display
 	RenderHelper::bTextEnabled = bTextEnabled;
 	if (bColorTexture)
-		currProg->UpdateInt("textEnabled", 1);
+		currProg->GetUniforms().textEnabled.Set(1);
 	else
-		currProg->UpdateInt("textEnabled", 0);
+		currProg->GetUniforms().textEnabled.Set(0);
 }
 
 /**
@@ -139,30 +218,32 @@ void RenderHelper::PreRenderMeshWithLight(const bool bLightEnable, const bool bC
 	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
 
 	// Enable / Disable lighting stuff
+	RenderHelper::bLightEnable = bLightEnable;
 	if (bLightEnable)
-		currProg->UpdateInt("lightEnabled", 1);
+		currProg->GetUniforms().lightEnabled.Set(1);
 	else
-		currProg->UpdateInt("lightEnabled", 0);
+		currProg->GetUniforms().lightEnabled.Set(0);
 
 	// Enable / Disable colour texture
+	RenderHelper::bColorTextureEnabled = bColorTextureEnabled;
 	if (bColorTextureEnabled)
-		currProg->UpdateInt("colorTextureEnabled", 1);
+		currProg->GetUniforms().colorTextureEnabled.Set(1);
 	else
-		currProg->UpdateInt("colorTextureEnabled", 0);
+		currProg->GetUniforms().colorTextureEnabled.Set(0);
 
 	// Enable / Disable colour texture
 	RenderHelper::bColorTexture = bColorTexture;
 	if (bColorTexture)
-		currProg->UpdateInt("colorTexture", 1);
+		currProg->GetUniforms().colorTexture.Set(1);
 	else
-		currProg->UpdateInt("colorTexture", 0);
+		currProg->GetUniforms().colorTexture.Set(0);
 
 	// Enable / Disable text display
 	RenderHelper::bTextEnabled = bTextEnabled;
 	if (bColorTexture)
-		currProg->UpdateInt("textEnabled", 1);
+		currProg->GetUniforms().textEnabled.Set(1);
 	else
-		currProg->UpdateInt("textEnabled", 0);
+		currProg->GetUniforms().textEnabled.Set(0);
 }
 
 /**
@@ -170,24 +251,34 @@ void RenderHelper::PreRenderMeshWithLight(const bool bLightEnable, const bool bC
 */
 void RenderHelper::RenderMeshWithLight(Mesh* _mesh)
 {
+	// Let the render queue draw it later, in a better order
+	if (CRenderQueue::GetInstance()->IsRecording())
+	{
+		CRenderQueue::GetInstance()->Submit(_mesh, 0, 0, GetRenderFlags(true), ditherAlpha, lineWidth);
+		return;
+	}
+	// Draw the batched sprites first, to keep them in order
+	if (CSpriteBatch::GetInstance()->IsRecording())
+		CSpriteBatch::GetInstance()->Flush();
+
 	// Get all our transform matrices & update shader
 	Mtx44 MVP, modelView, modelView_inverse_transpose;
 	MVP = GraphicsManager::GetInstance()->GetProjectionMatrix() * GraphicsManager::GetInstance()->GetViewMatrix() * GraphicsManager::GetInstance()->GetModelStack().Top();
 	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
-	currProg->UpdateMatrix44("MVP", &MVP.a[0]);
+	currProg->GetUniforms().MVP.Set(MVP);
 
 	// Update light stuff
 	//currProg->UpdateInt("lightEnabled", 1);
 	modelView = GraphicsManager::GetInstance()->GetViewMatrix() * GraphicsManager::GetInstance()->GetModelStack().Top();
-	currProg->UpdateMatrix44("MV", &modelView.a[0]);
+	currProg->GetUniforms().MV.Set(modelView);
 	modelView_inverse_transpose = modelView.GetInverse().GetTranspose();
-	currProg->UpdateMatrix44("MV_inverse_transpose", &modelView.a[0]);
+	currProg->GetUniforms().MV_inverse_transpose.Set(modelView);
 
 	//load material
-	currProg->UpdateVector3("material.kAmbient", &_mesh->material.kAmbient.r);
-	currProg->UpdateVector3("material.kDiffuse", &_mesh->material.kDiffuse.r);
-	currProg->UpdateVector3("material.kSpecular", &_mesh->material.kSpecular.r);
-	currProg->UpdateFloat("material.kShininess", _mesh->material.kShininess);
+	currProg->GetUniforms().kAmbient.Set(Vector3(_mesh->material.kAmbient.r, _mesh->material.kAmbient.g, _mesh->material.kAmbient.b));
+	currProg->GetUniforms().kDiffuse.Set(Vector3(_mesh->material.kDiffuse.r, _mesh->material.kDiffuse.g, _mesh->material.kDiffuse.b));
+	currProg->GetUniforms().kSpecular.Set(Vector3(_mesh->material.kSpecular.r, _mesh->material.kSpecular.g, _mesh->material.kSpecular.b));
+	currProg->GetUniforms().kShininess.Set(_mesh->material.kShininess);
 
 	// Update textures first if available
 	if (_mesh->textureID > 0)
@@ -200,7 +291,7 @@ void RenderHelper::RenderMeshWithLight(Mesh* _mesh)
 	{
 		if (bColorTextureEnabled)
 		{
-			currProg->UpdateInt("colorTextureEnabled", 0);
+			currProg->GetUniforms().colorTextureEnabled.Set(0);
 		}
 	}
 
@@ -216,7 +307,7 @@ void RenderHelper::RenderMeshWithLight(Mesh* _mesh)
 	{
 		if (bColorTextureEnabled)
 		{
-			currProg->UpdateInt("colorTextureEnabled", 1);
+			currProg->GetUniforms().colorTextureEnabled.Set(1);
 		}
 	}
 }
@@ -230,30 +321,32 @@ void RenderHelper::PostRenderMeshWithLight(const bool bLightEnable, const bool b
 	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
 
 	// Enable / Disable lighting stuff
+	RenderHelper::bLightEnable = bLightEnable;
 	if (bLightEnable)
-		currProg->UpdateInt("lightEnabled", 1);
+		currProg->GetUniforms().lightEnabled.Set(1);
 	else
-		currProg->UpdateInt("lightEnabled", 0);
+		currProg->GetUniforms().lightEnabled.Set(0);
 
 	// Enable / Disable colour texture
+	RenderHelper::bColorTextureEnabled = bColorTextureEnabled;
 	if (bColorTextureEnabled)
-		currProg->UpdateInt("colorTextureEnabled", 1);
+		currProg->GetUniforms().colorTextureEnabled.Set(1);
 	else
-		currProg->UpdateInt("colorTextureEnabled", 0);
+		currProg->GetUniforms().colorTextureEnabled.Set(0);
 
 	// Enable / Disable colour texture
 	RenderHelper::bColorTexture = bColorTexture;
 	if (bColorTexture)
-		currProg->UpdateInt("colorTexture", 1);
+		currProg->GetUniforms().colorTexture.Set(1);
 	else
-		currProg->UpdateInt("colorTexture", 0);
+		currProg->GetUniforms().colorTexture.Set(0);
 
 	// Enable / Disable text display
 	RenderHelper::bTextEnabled = bTextEnabled;
 	if (bColorTexture)
-		currProg->UpdateInt("textEnabled", 1);
+		currProg->GetUniforms().textEnabled.Set(1);
 	else
-		currProg->UpdateInt("textEnabled", 0);
+		currProg->GetUniforms().textEnabled.Set(0);
 }
 
 
@@ -266,84 +359,60 @@ void RenderHelper::PreRenderText(const bool bLightEnable, const bool bColorTextu
 	// Enable / Disable lighting stuff
 	RenderHelper::bLightEnable = bLightEnable;
 	if (bLightEnable)
-		currProg->UpdateInt("lightEnabled", 1);
+		currProg->GetUniforms().lightEnabled.Set(1);
 	else
-		currProg->UpdateInt("lightEnabled", 0);
+		currProg->GetUniforms().lightEnabled.Set(0);
 
 	// Enable / Disable colour texture enabled
 	RenderHelper::bColorTextureEnabled = bColorTextureEnabled;
 	if (bColorTextureEnabled)
-		currProg->UpdateInt("colorTextureEnabled", 1);
+		currProg->GetUniforms().colorTextureEnabled.Set(1);
 	else
-		currProg->UpdateInt("colorTextureEnabled", 0);
+		currProg->GetUniforms().colorTextureEnabled.Set(0);
 
 	// Enable / Disable colour texture
 	RenderHelper::bColorTexture = bColorTexture;
 	if (bColorTexture)
-		currProg->UpdateInt("colorTexture", 1);
+		currProg->GetUniforms().colorTexture.Set(1);
 	else
-		currProg->UpdateInt("colorTexture", 0);
+		currProg->GetUniforms().colorTexture.Set(0);
 
 	// Enable / Disable text display
 	RenderHelper::bTextEnabled = bTextEnabled;
 	if (bColorTexture)
-		currProg->UpdateInt("textEnabled", 1);
+		currProg->GetUniforms().textEnabled.Set(1);
 	else
-		currProg->UpdateInt("textEnabled", 0);
+		currProg->GetUniforms().textEnabled.Set(0);
 }
 
 /**
-* Setup the shaders before rendering a text
+* Render a text mesh with the font mesh's texture, in one draw call
 */
-void RenderHelper::RenderText(Mesh* _mesh, const std::string& _text, Color _color)
+void RenderHelper::RenderText(Mesh* _textMesh, Mesh* _fontMesh, Color _color)
 {
 	// Trivial Rejection : Unable to render without mesh or texture
-	if (!_mesh || _mesh->textureID <= 0)
+	if (!_textMesh || !_fontMesh || _fontMesh->textureID <= 0)
+		return;
+	if (_textMesh->indexSize == 0)
 		return;
 
-	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
-
-	currProg->UpdateInt("textEnabled", 1);
-	currProg->UpdateVector3("textColor", &_color.r);
-	//currProg->UpdateInt("lightEnabled", 0);
+	// Draw the batched sprites first, to keep them in order
+	if (CSpriteBatch::GetInstance()->IsRecording())
+		CSpriteBatch::GetInstance()->Flush();
 
-	if (_mesh->textureID > 0)
-	{
-		//currProg->UpdateInt("colorTextureEnabled", 1);
-		GraphicsManager::GetInstance()->UpdateTexture(0, _mesh->textureID);
-		//currProg->UpdateInt("colorTexture", 0);
-	}
-	else
-	{
-		if (bColorTextureEnabled)
-		{
-			currProg->UpdateInt("colorTextureEnabled", 1);
-		}
-	}
+	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
 
-	for (unsigned i = 0; i < _text.length(); ++i)
-	{
-		Mtx44 characterSpacing, MVP;
-		//characterSpacing.SetToTranslation((i+0.5f) * 1.0f, 0, 0); // 1.0f is the spacing of each character, you may change this value
-		characterSpacing.SetToTranslation((float)(1 + (int)i), 0.0f, 0.0f); // 1.0f is the spacing of each character, you may change this value
-		MVP = GraphicsManager::GetInstance()->GetProjectionMatrix() * GraphicsManager::GetInstance()->GetViewMatrix() * GraphicsManager::GetInstance()->GetModelStack().Top() * characterSpacing;
-		currProg->UpdateMatrix44("MVP", &MVP.a[0]);
+	currProg->GetUniforms().textEnabled.Set(1);
+	currProg->GetUniforms().textColor.Set(Vector3(_color.r, _color.g, _color.b));
+	GraphicsManager::GetInstance()->UpdateTexture(0, _fontMesh->textureID);
 
-		_mesh->Render((unsigned)_text[i] * 6, 6);
-	}
+	// The glyphs are laid out in the text mesh, so the whole string shares one MVP
+	Mtx44 MVP = GraphicsManager::GetInstance()->GetProjectionMatrix() * GraphicsManager::GetInstance()->GetViewMatrix() * GraphicsManager::GetInstance()->GetModelStack().Top();
+	currProg->GetUniforms().MVP.Set(MVP);
+	_textMesh->Render();
 
-	if (_mesh->textureID > 0)
-	{
-		GraphicsManager::GetInstance()->UnbindTexture(0);
-	}
-	else
-	{
-		if (bColorTextureEnabled)
-		{
-			currProg->UpdateInt("colorTextureEnabled", 0);
-		}
-	}
-	currProg->UpdateInt("textEnabled", 0);
+	GraphicsManager::GetInstance()->UnbindTexture(0);
+	currProg->GetUniforms().textEnabled.Set(0);
 }
 
 // Post Render Text to setup the shaders before rendering text
@@ -355,28 +424,160 @@ void RenderHelper::PostRenderText(const bool bLightEnable, const bool bColorText
 	// Enable / Disable lighting stuff
 	RenderHelper::bLightEnable = bLightEnable;
 	if (bLightEnable)
-		currProg->UpdateInt("lightEnabled", 1);
+		currProg->GetUniforms().lightEnabled.Set(1);
 	else
-		currProg->UpdateInt("lightEnabled", 0);
+		currProg->GetUniforms().lightEnabled.Set(0);
 
 	// Enable / Disable colour texture
 	RenderHelper::bColorTextureEnabled = bColorTextureEnabled;
 	if (bColorTextureEnabled)
-		currProg->UpdateInt("colorTextureEnabled", 1);
+		currProg->GetUniforms().colorTextureEnabled.Set(1);
 	else
-		currProg->UpdateInt("colorTextureEnabled", 0);
+		currProg->GetUniforms().colorTextureEnabled.Set(0);
 
 	// Enable / Disable colour texture
 	RenderHelper::bColorTexture = bColorTexture;
 	if (bColorTexture)
-		currProg->UpdateInt("colorTexture", 1);
+		currProg->GetUniforms().colorTexture.Set(1);
 	else
-		currProg->UpdateInt("colorTexture", 0);
+		currProg->GetUniforms().colorTexture.Set(0);
 
 	// Enable / Disable text display
 	RenderHelper::bTextEnabled = bTextEnabled;
 	if (bColorTexture)
-		currProg->UpdateInt("textEnabled", 1);
+		currProg->GetUniforms().textEnabled.Set(1);
 	else
-		currProg->UpdateInt("textEnabled", 0);
+		currProg->GetUniforms().textEnabled.Set(0);
+}
+
+// Set the dithered fade for the next meshes
+void RenderHelper::SetDitherFade(const float alpha, const bool bInverted)
+{
+	bDitherEnabled = true;
+	ditherAlpha = alpha;
+	bDitherInverted = bInverted;
+
+	// The render queue applies the fade to each draw item by itself
+	if (CRenderQueue::GetInstance()->IsRecording())
+		return;
+
+	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
+	currProg->GetUniforms().ditherEnabled.Set(1);
+	currProg->GetUniforms().ditherAlpha.Set(alpha);
+	currProg->GetUniforms().ditherInverted.Set(bInverted ? 1 : 0);
+}
+
+// Stop the dithered fade
+void RenderHelper::DisableDitherFade(void)
+{
+	bDitherEnabled = false;
+	if (CRenderQueue::GetInstance()->IsRecording())
+		return;
+
+	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
+	currProg->GetUniforms().ditherEnabled.Set(0);
+}
+
+// Enable / Disable discarding the transparent texels of the next meshes
+void RenderHelper::SetAlphaTest(const bool bAlphaTestEnabled)
+{
+	RenderHelper::bAlphaTestEnabled = bAlphaTestEnabled;
+	if (CRenderQueue::GetInstance()->IsRecording())
+		return;
+
+	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
+	currProg->GetUniforms().alphaTestEnabled.Set(bAlphaTestEnabled ? 1 : 0);
+}
+
+// Enable / Disable drawing the next meshes as wireframes
+void RenderHelper::SetWireframe(const bool bWireframe)
+{
+	RenderHelper::bWireframe = bWireframe;
+	if (CRenderQueue::GetInstance()->IsRecording())
+		return;
+
+	CGraphicsDevice::GetDevice()->PolygonMode(GL_FRONT_AND_BACK, bWireframe ? GL_LINE : GL_FILL);
+}
+
+// Set the width of the lines of the next meshes
+void RenderHelper::SetLineWidth(const float lineWidth)
+{
+	RenderHelper::lineWidth = lineWidth;
+	if (CRenderQueue::GetInstance()->IsRecording())
+		return;
+
+	CGraphicsDevice::GetDevice()->LineWidth(lineWidth);
+}
+
+// Apply the fade, alpha test, wireframe and line width states again, after CRenderQueue has changed them
+void RenderHelper::RestoreRenderStates(void)
+{
+	ShaderProgram* currProg = GraphicsManager::GetInstance()->GetActiveShader();
+	if (currProg)
+	{
+		currProg->GetUniforms().lightEnabled.Set(bLightEnable ? 1 : 0);
+		currProg->GetUniforms().colorTextureEnabled.Set(bColorTextureEnabled ? 1 : 0);
+		currProg->GetUniforms().alphaTestEnabled.Set(bAlphaTestEnabled ? 1 : 0);
+		currProg->GetUniforms().ditherEnabled.Set(bDitherEnabled ? 1 : 0);
+		currProg->GetUniforms().ditherAlpha.Set(ditherAlpha);
+		currProg->GetUniforms().ditherInverted.Set(bDitherInverted ? 1 : 0);
+	}
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->PolygonMode(GL_FRONT_AND_BACK, bWireframe ? GL_LINE : GL_FILL);
+	theDevice->LineWidth(lineWidth);
+}
+
+// Get this thread's render states
+RenderHelper::RenderStates RenderHelper::GetRenderStates(void)
+{
+	RenderStates theStates;
+	theStates.bLightEnable = bLightEnable;
+	theStates.bColorTextureEnabled = bColorTextureEnabled;
+	theStates.bColorTexture = bColorTexture;
+	theStates.bTextEnabled = bTextEnabled;
+	theStates.bAlphaTestEnabled = bAlphaTestEnabled;
+	theStates.bDitherEnabled = bDitherEnabled;
+	theStates.bDitherInverted = bDitherInverted;
+	theStates.ditherAlpha = ditherAlpha;
+	theStates.bWireframe = bWireframe;
+	theStates.lineWidth = lineWidth;
+	return theStates;
+}
+
+// Set this thread's render states
+void RenderHelper::SetRenderStates(const RenderStates& theStates)
+{
+	bLightEnable = theStates.bLightEnable;
+	bColorTextureEnabled = theStates.bColorTextureEnabled;
+	bColorTexture = theStates.bColorTexture;
+	bTextEnabled = theStates.bTextEnabled;
+	bAlphaTestEnabled = theStates.bAlphaTestEnabled;
+	bDitherEnabled = theStates.bDitherEnabled;
+	bDitherInverted = theStates.bDitherInverted;
+	ditherAlpha = theStates.ditherAlpha;
+	bWireframe = theStates.bWireframe;
+	lineWidth = theStates.lineWidth;
+}
+
+// Get the render states of the next mesh, for CRenderQueue
+unsigned char RenderHelper::GetRenderFlags(const bool bLit)
+{
+	unsigned char flags = 0;
+	if (bLit)
+		flags |= CRenderQueue::FLAG_LIT;
+	if (bLightEnable)
+		flags |= CRenderQueue::FLAG_LIGHT_ENABLED;
+	if (bColorTextureEnabled)
+		flags |= CRenderQueue::FLAG_COLOR_TEXTURE_ENABLED;
+	if (bAlphaTestEnabled)
+		flags |= CRenderQueue::FLAG_ALPHA_TEST;
+	if (bDitherEnabled)
+		flags |= CRenderQueue::FLAG_DITHER;
+	if (bDitherEnabled && bDitherInverted)
+		flags |= CRenderQueue::FLAG_DITHER_INVERTED;
+	if (bWireframe)
+		flags |= CRenderQueue::FLAG_WIREFRAME;
+	if (lineWidth != 1.0f)
+		flags |= CRenderQueue::FLAG_LINE_WIDTH;
+	return flags;
 }
@@ -7,17 +7,45 @@ class Mesh;
 
 class RenderHelper
 {
+public:
+	// The render states of the next meshes
+	struct RenderStates
+	{
+		bool bLightEnable;
+		bool bColorTextureEnabled;
+		bool bColorTexture;
+		bool bTextEnabled;
+		bool bAlphaTestEnabled;
+		bool bDitherEnabled;
+		bool bDitherInverted;
+		float ditherAlpha;
+		bool bWireframe;
+		float lineWidth;
+	};
+
 private:
-	static bool bLightEnable;
-	static bool bColorTextureEnabled;
-	static bool bColorTexture;
-	static bool bTextEnabled;
+	// Each thread has its own states, so the jobs of CRenderQueue::RecordParallel can change them at the same time
+	static thread_local bool bLightEnable;
+	static thread_local bool bColorTextureEnabled;
+	static thread_local bool bColorTexture;
+	static thread_local bool bTextEnabled;
+	static thread_local bool bAlphaTestEnabled;
+	static thread_local bool bDitherEnabled;
+	static thread_local bool bDitherInverted;
+	static thread_local float ditherAlpha;
+	static thread_local bool bWireframe;
+	static thread_local float lineWidth;
+
+	// Get the render states of the next mesh, for CRenderQueue
+	static unsigned char GetRenderFlags(const bool bLit);
 
 public:
 	// Pre Render Mesh to setup the shaders before rendering a mesh without light
 	static void PreRenderMesh(const bool bLightEnable = false, const bool bColorTextureEnabled = true, const bool bColorTexture = false, const bool bTextEnabled = false);
 	// Render Mesh to render a mesh without light
 	static void RenderMesh(Mesh* _mesh);
+	// Render Mesh to render a range of a mesh's indices without light
+	static void RenderMesh(Mesh* _mesh, const unsigned _offset, const unsigned _count);
 	// Post Render Mesh to setup the shaders after rendering a mesh without light
 	static void PostRenderMesh(const bool bLightEnable = true, const bool bColorTextureEnabled = false, const bool bColorTexture = true, const bool bTextEnabled = false);
 
@@ -30,10 +58,28 @@ public:
 
 	// Pre Render Text to setup the shaders before rendering text
 	static void PreRenderText(const bool bLightEnable = false, const bool bColorTextureEnabled = true, const bool bColorTexture = false, const bool bTextEnabled = true);
-	// Setup the shaders before rendering a text
-	static void RenderText(Mesh* _mesh, const std::string& _text, Color _color);
+	// Render a text mesh, such as a CTextMesh, with the texture of the font mesh
+	static void RenderText(Mesh* _textMesh, Mesh* _fontMesh, Color _color);
 	// Post Render Text to setup the shaders before rendering text
 	static void PostRenderText(const bool bLightEnable = true, const bool bColorTextureEnabled = false, const bool bColorTexture = true, const bool bTextEnabled = false);
+
+	// Set the dithered fade for the next meshes. alpha is the fraction of pixels kept, 
+	// and bInverted keeps the other pixels instead, for the mesh which is fading out
+	static void SetDitherFade(const float alpha, const bool bInverted);
+	// Stop the dithered fade
+	static void DisableDitherFade(void);
+	// Enable / Disable discarding the transparent texels of the next meshes
+	static void SetAlphaTest(const bool bAlphaTestEnabled);
+	// Enable / Disable drawing the next meshes as wireframes
+	static void SetWireframe(const bool bWireframe);
+	// Set the width of the lines of the next meshes
+	static void SetLineWidth(const float lineWidth);
+	// Apply the fade, alpha test, wireframe and line width states again, after CRenderQueue has changed them
+	static void RestoreRenderStates(void);
+	// Get this thread's render states, without any OpenGL calls
+	static RenderStates GetRenderStates(void);
+	// Set this thread's render states, without any OpenGL calls, such as to copy them into a recording thread
+	static void SetRenderStates(const RenderStates& theStates);
 };
 
 #endif // RENDER_HELPER_H
\ No newline at end of file
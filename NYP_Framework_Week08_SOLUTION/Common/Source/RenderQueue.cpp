@@ -0,0 +1,605 @@
+#include "RenderQueue.h"
+#include "RenderHelper.h"
+#include "Mesh.h"
+#include "GraphicsManager.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include "RenderStats.h"
+#include "ThreadPool/ThreadPool.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+#include "GL\glew.h"
+
+// The bits of each part of the sort key.
+// Opaque:		pass(2) | shader(6) | flags(8) | texture(12) | mesh(12) | depth(24)
+// Transparent:	pass(2) | inverted depth(24) | shader(6) | flags(8) | texture(12) | mesh(12)
+static const int PASS_BITS = 2;
+static const int SHADER_BITS = 6;
+static const int FLAG_BITS = 8;
+static const int TEXTURE_BITS = 12;
+static const int MESH_BITS = 12;
+static const int DEPTH_BITS = 24;
+
+thread_local std::vector<CRenderQueue::DrawItem>* CRenderQueue::theThreadItems = nullptr;
+
+CRenderQueue::CRenderQueue(void)
+	: bRecording(false)
+	, bTransparent(false)
+	, bInstancing(true)
+	, bParallelRecording(true)
+	, maxDepth(10000.0f)
+	, numOfDrawItems(0)
+	, numOfBinds(0)
+	, numOfDrawCalls(0)
+	, instanceOffset(0)
+{
+}
+
+CRenderQueue::~CRenderQueue(void)
+{
+}
+
+/**
+* Start collecting the draw items
+*/
+void CRenderQueue::Begin(void)
+{
+	theItems.clear();
+	theKeys.clear();
+	bRecording = true;
+	bTransparent = false;
+}
+
+/**
+* Return true if the draw items are being collected
+*/
+bool CRenderQueue::IsRecording(void) const
+{
+	return bRecording;
+}
+
+/**
+* Add a draw item with the current model, view and projection matrices and the active shader
+*/
+void CRenderQueue::Submit(Mesh* theMesh, const unsigned offset, const unsigned count, const unsigned char flags,
+						  const float ditherAlpha, const float lineWidth)
+{
+	ShaderProgram* theShader = GraphicsManager::GetInstance()->GetActiveShader();
+	if ((theMesh == nullptr) || (theShader == nullptr))
+		return;
+
+	DrawItem theItem;
+	theItem.modelView = GraphicsManager::GetInstance()->GetViewMatrix() * GraphicsManager::GetInstance()->GetModelStack().Top();
+	theItem.MVP = GraphicsManager::GetInstance()->GetProjectionMatrix() * theItem.modelView;
+	theItem.theMesh = theMesh;
+	theItem.theShader = theShader;
+	theItem.offset = offset;
+	theItem.count = (count == 0 ? theMesh->indexSize : count);
+	theItem.ditherAlpha = ditherAlpha;
+	theItem.lineWidth = lineWidth;
+	theItem.flags = flags;
+	theItem.bTransparent = bTransparent;
+
+	// A job of RecordParallel has a list of its own. The sort keys are made once the lists are added,
+	// as the small IDs in the keys are shared
+	if (theThreadItems != nullptr)
+	{
+		theThreadItems->push_back(theItem);
+		return;
+	}
+	theItems.push_back(theItem);
+	theKeys.push_back(GetSortKey(theItem));
+}
+
+/**
+* Run the jobs on the thread pool, each recording into a draw item list of its own, then add the lists in job order
+*/
+void CRenderQueue::RecordParallel(const int numOfJobs, const std::function<void(const int)>& theJob)
+{
+	// Run the jobs on this thread if the meshes are drawn at once, or if this is already a job
+	if ((!bRecording) || (!bParallelRecording) || (numOfJobs <= 1) || (theThreadItems != nullptr) ||
+		(CThreadPool::GetInstance()->GetNumOfThreads() <= 1))
+	{
+		for (int i = 0; i < numOfJobs; ++i)
+			theJob(i);
+		return;
+	}
+
+	// The jobs only read the view matrix, so bring it up to date before they start
+	GraphicsManager::GetInstance()->GetViewMatrix();
+	const Mtx44 theTop = GraphicsManager::GetInstance()->GetModelStack().Top();
+	const RenderHelper::RenderStates theStates = RenderHelper::GetRenderStates();
+
+	if ((int)theJobItems.size() < numOfJobs)
+	{
+		theJobItems.resize(numOfJobs);
+		theJobStacks.resize(numOfJobs);
+	}
+
+	CThreadPool::GetInstance()->ParallelFor(numOfJobs, [this, &theJob, &theTop, &theStates](const int jobIndex)
+	{
+		// This thread may run other jobs afterwards, or be the calling thread, so its own states are put back
+		const RenderHelper::RenderStates theSavedStates = RenderHelper::GetRenderStates();
+		MS& theStack = theJobStacks[jobIndex];
+		theStack.Clear();
+		theStack.LoadMatrix(theTop);
+		GraphicsManager::GetInstance()->SetThreadModelStack(&theStack);
+		RenderHelper::SetRenderStates(theStates);
+		theThreadItems = &theJobItems[jobIndex];
+		theThreadItems->clear();
+
+		theJob(jobIndex);
+
+		theThreadItems = nullptr;
+		GraphicsManager::GetInstance()->SetThreadModelStack(nullptr);
+		RenderHelper::SetRenderStates(theSavedStates);
+	});
+
+	for (int i = 0; i < numOfJobs; ++i)
+	{
+		for (unsigned j = 0; j < theJobItems[i].size(); ++j)
+		{
+			theItems.push_back(theJobItems[i][j]);
+			theKeys.push_back(GetSortKey(theJobItems[i][j]));
+		}
+	}
+}
+
+/**
+* Sort and draw the draw items, then stop collecting them
+*/
+void CRenderQueue::Flush(void)
+{
+	bRecording = false;
+	bTransparent = false;
+	numOfDrawItems = (int)theItems.size();
+	numOfBinds = 0;
+	numOfDrawCalls = 0;
+	if (theItems.empty())
+		return;
+
+	RadixSort();
+	BuildDrawRuns();
+
+	// Upload the matrices of all the instanced runs at once
+	if (!theInstanceData.empty())
+	{
+		const int offset = CStreamBuffer::GetInstance()->Upload(&theInstanceData[0], theInstanceData.size() * sizeof(float), 4 * sizeof(float));
+		if (offset >= 0)
+		{
+			instanceOffset = (unsigned)offset;
+		}
+		else
+		{
+			// The matrices do not fit into the streaming buffer, so draw the items one at a time
+			const bool bWasInstancing = bInstancing;
+			bInstancing = false;
+			BuildDrawRuns();
+			bInstancing = bWasInstancing;
+		}
+	}
+
+	// The states which are in place. They are unknown at the start, so the first item sets all of them
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	ShaderProgram* currShader = nullptr;
+	Mesh* currMesh = nullptr;
+	const ShaderUniforms* theUniforms = nullptr;
+	int currTexture = -1;
+	int currFlags = -1;
+	int currColorTexture = -1;
+	int currInstancing = -1;
+	bool bInstanceAttributes = false;
+	float currDitherAlpha = -1.0f;
+	float currLineWidth = -1.0f;
+
+	// The passes are counted and timed separately, and the pass is the top of the sort key
+	int currPass = -1;
+	for (unsigned i = 0; i < theRuns.size(); ++i)
+	{
+		const DrawRun& theRun = theRuns[i];
+		const DrawItem& theItem = theItems[theSortedIndices[theRun.first]];
+		Mesh* theMesh = theItem.theMesh;
+
+		const int pass = (int)(theKeys[theRun.first] >> (64 - PASS_BITS));
+		if (pass != currPass)
+		{
+			if (currPass >= 0)
+				CRenderStats::GetInstance()->EndPass();
+			CRenderStats::GetInstance()->BeginPass((CRenderStats::PASS)(CRenderStats::PASS_OPAQUE + pass));
+			currPass = pass;
+		}
+
+		if (theItem.theShader != currShader)
+		{
+			currShader = theItem.theShader;
+			theDevice->UseProgram(currShader->GetProgramID());
+			CRenderStats::GetInstance()->AddProgramSwitch();
+			theUniforms = &currShader->GetUniforms();
+			currFlags = -1;
+			currColorTexture = -1;
+			currInstancing = -1;
+			currDitherAlpha = -1.0f;
+		}
+
+		// Update the render states which have changed
+		const int changedFlags = (currFlags < 0 ? 0xFF : (currFlags ^ theItem.flags));
+		if (changedFlags & FLAG_LIGHT_ENABLED)
+			theUniforms->lightEnabled.Set((theItem.flags & FLAG_LIGHT_ENABLED) ? 1 : 0);
+		if (changedFlags & FLAG_ALPHA_TEST)
+			theUniforms->alphaTestEnabled.Set((theItem.flags & FLAG_ALPHA_TEST) ? 1 : 0);
+		if (changedFlags & FLAG_DITHER)
+			theUniforms->ditherEnabled.Set((theItem.flags & FLAG_DITHER) ? 1 : 0);
+		if (changedFlags & FLAG_DITHER_INVERTED)
+			theUniforms->ditherInverted.Set((theItem.flags & FLAG_DITHER_INVERTED) ? 1 : 0);
+		if (changedFlags & FLAG_WIREFRAME)
+			theDevice->PolygonMode(GL_FRONT_AND_BACK, (theItem.flags & FLAG_WIREFRAME) ? GL_LINE : GL_FILL);
+		currFlags = theItem.flags;
+		if ((theItem.flags & FLAG_DITHER) && (theItem.ditherAlpha != currDitherAlpha))
+		{
+			theUniforms->ditherAlpha.Set(theItem.ditherAlpha);
+			currDitherAlpha = theItem.ditherAlpha;
+		}
+		if (theItem.lineWidth != currLineWidth)
+		{
+			theDevice->LineWidth(theItem.lineWidth);
+			currLineWidth = theItem.lineWidth;
+		}
+
+		// A mesh without a texture is drawn with its vertex colours
+		const int colorTexture = ((theItem.flags & FLAG_COLOR_TEXTURE_ENABLED) && (theMesh->textureID > 0)) ? 1 : 0;
+		if (colorTexture != currColorTexture)
+		{
+			theUniforms->colorTextureEnabled.Set(colorTexture);
+			currColorTexture = colorTexture;
+		}
+		if ((theMesh->textureID > 0) && ((int)theMesh->textureID != currTexture))
+		{
+			GraphicsManager::GetInstance()->UpdateTexture(0, theMesh->textureID);
+			currTexture = theMesh->textureID;
+			numOfBinds++;
+		}
+
+		if (theMesh != currMesh)
+		{
+			// The instance attributes are a part of the bound mesh's vertex array, so turn them off first
+			if (bInstanceAttributes)
+			{
+				SetInstanceAttributes(false, 0);
+				bInstanceAttributes = false;
+			}
+			theMesh->Bind();
+			currMesh = theMesh;
+			numOfBinds++;
+		}
+
+		if (theItem.flags & FLAG_LIT)
+		{
+			theUniforms->kAmbient.Set(Vector3(theMesh->material.kAmbient.r, theMesh->material.kAmbient.g, theMesh->material.kAmbient.b));
+			theUniforms->kDiffuse.Set(Vector3(theMesh->material.kDiffuse.r, theMesh->material.kDiffuse.g, theMesh->material.kDiffuse.b));
+			theUniforms->kSpecular.Set(Vector3(theMesh->material.kSpecular.r, theMesh->material.kSpecular.g, theMesh->material.kSpecular.b));
+			theUniforms->kShininess.Set(theMesh->material.kShininess);
+		}
+
+		// The vertex shader takes the matrices from the instance buffer when instancing is enabled
+		const int instancing = (theRun.numOfItems > 1 ? 1 : 0);
+		if (instancing != currInstancing)
+		{
+			theUniforms->instancingEnabled.Set(instancing);
+			currInstancing = instancing;
+		}
+
+		if (instancing)
+		{
+			SetInstanceAttributes(true, theRun.firstInstance);
+			bInstanceAttributes = true;
+			theMesh->DrawInstanced(theItem.offset, theItem.count, theRun.numOfItems);
+		}
+		else
+		{
+			if (bInstanceAttributes)
+			{
+				SetInstanceAttributes(false, 0);
+				bInstanceAttributes = false;
+			}
+			theUniforms->MVP.Set(theItem.MVP);
+			if (theItem.flags & FLAG_LIT)
+			{
+				theUniforms->MV.Set(theItem.modelView);
+				theUniforms->MV_inverse_transpose.Set(theItem.modelView);
+			}
+			theMesh->Draw(theItem.offset, theItem.count);
+		}
+		numOfDrawCalls++;
+	}
+
+	if (currPass >= 0)
+		CRenderStats::GetInstance()->EndPass();
+
+	// Leave the states as RenderHelper expects them
+	if (bInstanceAttributes)
+		SetInstanceAttributes(false, 0);
+	if (currMesh)
+		currMesh->Unbind();
+	if (theUniforms)
+		theUniforms->instancingEnabled.Set(0);
+	GraphicsManager::GetInstance()->UnbindTexture(0);
+	ShaderProgram* theActiveShader = GraphicsManager::GetInstance()->GetActiveShader();
+	if (theActiveShader)
+	{
+		theDevice->UseProgram(theActiveShader->GetProgramID());
+		CRenderStats::GetInstance()->AddProgramSwitch();
+	}
+	RenderHelper::RestoreRenderStates();
+
+	theItems.clear();
+	theKeys.clear();
+}
+
+/**
+* Put the next draw items into the transparent pass
+*/
+void CRenderQueue::SetTransparent(const bool bTransparent)
+{
+	this->bTransparent = bTransparent;
+}
+
+/**
+* Set the view depth which the depth part of the sort key spans
+*/
+void CRenderQueue::SetMaxDepth(const float maxDepth)
+{
+	if (maxDepth > 0.0f)
+		this->maxDepth = maxDepth;
+}
+
+/**
+* Enable / Disable drawing the items which share a mesh and states with instanced draw calls
+*/
+void CRenderQueue::SetInstancing(const bool bInstancing)
+{
+	this->bInstancing = bInstancing;
+}
+
+/**
+* Return true if the items which share a mesh and states are drawn with instanced draw calls
+*/
+bool CRenderQueue::GetInstancing(void) const
+{
+	return bInstancing;
+}
+
+/**
+* Enable / Disable running the jobs of RecordParallel on the thread pool
+*/
+void CRenderQueue::SetParallelRecording(const bool bParallelRecording)
+{
+	this->bParallelRecording = bParallelRecording;
+}
+
+/**
+* Return true if the jobs of RecordParallel are run on the thread pool
+*/
+bool CRenderQueue::GetParallelRecording(void) const
+{
+	return bParallelRecording;
+}
+
+/**
+* Get the number of draw items drawn by the last Flush
+*/
+int CRenderQueue::GetNumOfDrawItems(void) const
+{
+	return numOfDrawItems;
+}
+
+/**
+* Get the number of mesh and texture binds done by the last Flush
+*/
+int CRenderQueue::GetNumOfBinds(void) const
+{
+	return numOfBinds;
+}
+
+/**
+* Get the number of draw calls made by the last Flush
+*/
+int CRenderQueue::GetNumOfDrawCalls(void) const
+{
+	return numOfDrawCalls;
+}
+
+/**
+* Build the sort key of a draw item
+*/
+unsigned long long CRenderQueue::GetSortKey(const DrawItem& theItem)
+{
+	unsigned long long pass = PASS_OPAQUE;
+	if (theItem.bTransparent)
+		pass = PASS_TRANSPARENT;
+	else if (theItem.flags & (FLAG_ALPHA_TEST | FLAG_DITHER))
+		pass = PASS_ALPHA_TESTED;
+
+	// The distance in front of the camera, scaled to the depth bits
+	float depth = -theItem.modelView.a[14] / maxDepth;
+	depth = (depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth));
+	const unsigned long long maxDepthKey = (1ULL << DEPTH_BITS) - 1;
+	unsigned long long depthKey = (unsigned long long)(depth * maxDepthKey);
+
+	unsigned long long stateKey = GetShaderKey(theItem.theShader);
+	stateKey = (stateKey << FLAG_BITS) | theItem.flags;
+	stateKey = (stateKey << TEXTURE_BITS) | GetTextureKey(theItem.theMesh->textureID);
+	stateKey = (stateKey << MESH_BITS) | GetMeshKey(theItem.theMesh);
+
+	// The opaque items are grouped by state, and drawn front-to-back within each group.
+	// The transparent items have to be drawn back-to-front, so the depth comes first
+	const int STATE_BITS = SHADER_BITS + FLAG_BITS + TEXTURE_BITS + MESH_BITS;
+	if (pass == PASS_TRANSPARENT)
+		return (pass << (DEPTH_BITS + STATE_BITS)) | ((maxDepthKey - depthKey) << STATE_BITS) | stateKey;
+	return (pass << (STATE_BITS + DEPTH_BITS)) | (stateKey << DEPTH_BITS) | depthKey;
+}
+
+/**
+* Get a small ID for a shader, to fit into the sort key
+*/
+unsigned CRenderQueue::GetShaderKey(ShaderProgram* theShader)
+{
+	std::map<ShaderProgram*, unsigned>::iterator it = theShaderKeys.find(theShader);
+	if (it != theShaderKeys.end())
+		return it->second;
+
+	// The IDs wrap around when they run out of bits, which only costs some extra state changes
+	unsigned key = (unsigned)theShaderKeys.size() & ((1 << SHADER_BITS) - 1);
+	theShaderKeys[theShader] = key;
+	return key;
+}
+
+/**
+* Get a small ID for a texture, to fit into the sort key
+*/
+unsigned CRenderQueue::GetTextureKey(const unsigned textureID)
+{
+	std::map<unsigned, unsigned>::iterator it = theTextureKeys.find(textureID);
+	if (it != theTextureKeys.end())
+		return it->second;
+
+	unsigned key = (unsigned)theTextureKeys.size() & ((1 << TEXTURE_BITS) - 1);
+	theTextureKeys[textureID] = key;
+	return key;
+}
+
+/**
+* Get a small ID for a mesh, to fit into the sort key
+*/
+unsigned CRenderQueue::GetMeshKey(Mesh* theMesh)
+{
+	std::map<Mesh*, unsigned>::iterator it = theMeshKeys.find(theMesh);
+	if (it != theMeshKeys.end())
+		return it->second;
+
+	unsigned key = (unsigned)theMeshKeys.size() & ((1 << MESH_BITS) - 1);
+	theMeshKeys[theMesh] = key;
+	return key;
+}
+
+/**
+* Sort theSortedIndices by theKeys, 8 bits at a time from the lowest bits.
+* Each pass is stable, so the order of the lower bits is kept by the higher passes
+*/
+void CRenderQueue::RadixSort(void)
+{
+	const unsigned numOfItems = (unsigned)theKeys.size();
+	theSortedIndices.resize(numOfItems);
+	for (unsigned i = 0; i < numOfItems; ++i)
+		theSortedIndices[i] = i;
+	theSwapKeys.resize(numOfItems);
+	theSwapIndices.resize(numOfItems);
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		unsigned count[256] = { 0 };
+		for (unsigned i = 0; i < numOfItems; ++i)
+			count[(theKeys[i] >> shift) & 0xFF]++;
+
+		// Skip the pass if all the keys have the same bits here
+		if (count[(theKeys[0] >> shift) & 0xFF] == numOfItems)
+			continue;
+
+		unsigned offset = 0;
+		for (int digit = 0; digit < 256; ++digit)
+		{
+			unsigned digitCount = count[digit];
+			count[digit] = offset;
+			offset += digitCount;
+		}
+
+		for (unsigned i = 0; i < numOfItems; ++i)
+		{
+			unsigned destination = count[(theKeys[i] >> shift) & 0xFF]++;
+			theSwapKeys[destination] = theKeys[i];
+			theSwapIndices[destination] = theSortedIndices[i];
+		}
+		theKeys.swap(theSwapKeys);
+		theSortedIndices.swap(theSwapIndices);
+	}
+}
+
+/**
+* Return true if 2 items can be drawn in the same instanced draw call, which only
+* differ in their matrices
+*/
+bool CRenderQueue::CanInstance(const DrawItem& theItem, const DrawItem& theOtherItem) const
+{
+	return ((theItem.theMesh == theOtherItem.theMesh) &&
+			(theItem.theShader == theOtherItem.theShader) &&
+			(theItem.offset == theOtherItem.offset) &&
+			(theItem.count == theOtherItem.count) &&
+			(theItem.flags == theOtherItem.flags) &&
+			(theItem.lineWidth == theOtherItem.lineWidth) &&
+			(((theItem.flags & FLAG_DITHER) == 0) || (theItem.ditherAlpha == theOtherItem.ditherAlpha)));
+}
+
+/**
+* Group the sorted items into runs, and pack the matrices of the instanced runs into theInstanceData.
+* Only neighbouring items are grouped, so the sorted order is kept
+*/
+void CRenderQueue::BuildDrawRuns(void)
+{
+	theRuns.clear();
+	theInstanceData.clear();
+
+	unsigned i = 0;
+	while (i < theSortedIndices.size())
+	{
+		DrawRun theRun;
+		theRun.first = i;
+		theRun.numOfItems = 1;
+		theRun.firstInstance = 0;
+
+		const DrawItem& theFirstItem = theItems[theSortedIndices[i]];
+		if (bInstancing)
+		{
+			while ((i + theRun.numOfItems < theSortedIndices.size()) &&
+				   (CanInstance(theFirstItem, theItems[theSortedIndices[i + theRun.numOfItems]])))
+				theRun.numOfItems++;
+		}
+
+		if (theRun.numOfItems > 1)
+		{
+			theRun.firstInstance = (unsigned)(theInstanceData.size() / 32);
+			for (unsigned j = i; j < i + theRun.numOfItems; ++j)
+			{
+				const DrawItem& theItem = theItems[theSortedIndices[j]];
+				theInstanceData.insert(theInstanceData.end(), theItem.MVP.a, theItem.MVP.a + 16);
+				theInstanceData.insert(theInstanceData.end(), theItem.modelView.a, theItem.modelView.a + 16);
+			}
+		}
+
+		theRuns.push_back(theRun);
+		i += theRun.numOfItems;
+	}
+}
+
+/**
+* Enable / Disable the per-instance matrices, starting from an instance in the instance buffer.
+* Each matrix takes 4 attributes, one per column: the MVP is at 4 to 7 and the modelview at 8 to 11
+*/
+void CRenderQueue::SetInstanceAttributes(const bool bEnabled, const unsigned firstInstance)
+{
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	const GLsizei stride = 32 * sizeof(float);
+	for (GLuint column = 0; column < 8; ++column)
+	{
+		if (bEnabled)
+		{
+			if (column == 0)
+				theDevice->BindBuffer(GL_ARRAY_BUFFER, CStreamBuffer::GetInstance()->GetBufferID());
+			theDevice->EnableVertexAttribArray(4 + column);
+			theDevice->VertexAttribPointer(4 + column, 4, GL_FLOAT, false, stride, instanceOffset + (firstInstance * 32 + column * 4) * sizeof(float));
+			theDevice->VertexAttribDivisor(4 + column, 1);
+		}
+		else
+		{
+			theDevice->DisableVertexAttribArray(4 + column);
+			theDevice->VertexAttribDivisor(4 + column, 0);
+		}
+	}
+}
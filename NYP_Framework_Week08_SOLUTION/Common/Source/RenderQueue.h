@@ -0,0 +1,156 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "SingletonTemplate.h"
+#include "Mtx44.h"
+#include "MatrixStack.h"
+#include <functional>
+#include <map>
+#include <vector>
+
+class Mesh;
+class ShaderProgram;
+
+// Collects the meshes rendered through RenderHelper between Begin and Flush, instead of drawing them at once.
+// Each draw item gets a 64-bit sort key of its pass, shader, render states, texture, mesh and depth.
+// Flush radix sorts the keys and draws the items, skipping the binds and uniform updates which
+// are already in place, so the meshes which share a texture and a mesh are drawn back to back.
+// Neighbouring items which differ only in their matrices are drawn with one instanced draw call.
+// RecordParallel records draw items on the thread pool. Only Flush makes OpenGL calls, on the calling thread.
+class CRenderQueue : public Singleton<CRenderQueue>
+{
+	friend Singleton<CRenderQueue>;
+public:
+	enum PASS
+	{
+		PASS_OPAQUE = 0,		// Sorted by state, then front-to-back
+		PASS_ALPHA_TESTED,		// Discards pixels, so it is drawn after the opaque items have filled the depth buffer
+		PASS_TRANSPARENT,		// Sorted back-to-front
+		NUM_PASS
+	};
+
+	// The render states of a draw item, which are set up by RenderHelper
+	enum RENDER_FLAG
+	{
+		FLAG_LIT = 1 << 0,					// Update the modelview matrix and the material
+		FLAG_LIGHT_ENABLED = 1 << 1,
+		FLAG_COLOR_TEXTURE_ENABLED = 1 << 2,
+		FLAG_ALPHA_TEST = 1 << 3,
+		FLAG_DITHER = 1 << 4,
+		FLAG_DITHER_INVERTED = 1 << 5,
+		FLAG_WIREFRAME = 1 << 6,
+		FLAG_LINE_WIDTH = 1 << 7,			// The line width is not 1
+	};
+
+	virtual ~CRenderQueue(void);
+
+	// Start collecting the draw items
+	void Begin(void);
+	// Return true if the draw items are being collected
+	bool IsRecording(void) const;
+	// Add a draw item with the current model, view and projection matrices and the active shader.
+	// A count of 0 draws all the indices of the mesh
+	void Submit(Mesh* theMesh, const unsigned offset, const unsigned count, const unsigned char flags,
+				const float ditherAlpha, const float lineWidth);
+	// Run theJob(index) for index = 0 .. numOfJobs-1 on the thread pool, each recording into a draw item list of its own.
+	// Each job starts with its own copy of the model stack's top and of RenderHelper's render states, and
+	// must only render through RenderHelper, without any OpenGL calls of its own. The lists are added in job
+	// order, so the draw items are the same as when the jobs are run one after another on this thread
+	void RecordParallel(const int numOfJobs, const std::function<void(const int)>& theJob);
+	// Sort and draw the draw items, then stop collecting them
+	void Flush(void);
+
+	// Put the next draw items into the transparent pass
+	void SetTransparent(const bool bTransparent);
+	// Set the view depth which the depth part of the sort key spans
+	void SetMaxDepth(const float maxDepth);
+	// Enable / Disable drawing the items which share a mesh and states with instanced draw calls
+	void SetInstancing(const bool bInstancing);
+	// Return true if the items which share a mesh and states are drawn with instanced draw calls
+	bool GetInstancing(void) const;
+	// Enable / Disable running the jobs of RecordParallel on the thread pool
+	void SetParallelRecording(const bool bParallelRecording);
+	// Return true if the jobs of RecordParallel are run on the thread pool
+	bool GetParallelRecording(void) const;
+
+	// Get the number of draw items drawn by the last Flush
+	int GetNumOfDrawItems(void) const;
+	// Get the number of mesh and texture binds done by the last Flush
+	int GetNumOfBinds(void) const;
+	// Get the number of draw calls made by the last Flush
+	int GetNumOfDrawCalls(void) const;
+
+protected:
+	CRenderQueue(void);
+
+	struct DrawItem
+	{
+		Mtx44 MVP;
+		Mtx44 modelView;
+		Mesh* theMesh;
+		ShaderProgram* theShader;
+		unsigned offset;
+		unsigned count;
+		float ditherAlpha;
+		float lineWidth;
+		unsigned char flags;
+		bool bTransparent;
+	};
+
+	// A run of sorted items which are drawn with one draw call
+	struct DrawRun
+	{
+		unsigned first;				// Index into theSortedIndices
+		unsigned numOfItems;
+		unsigned firstInstance;		// Index of the first item's matrices in the instance buffer
+	};
+
+	// Build the sort key of a draw item
+	unsigned long long GetSortKey(const DrawItem& theItem);
+	// Get a small ID for a shader, a texture or a mesh, to fit into the sort key
+	unsigned GetShaderKey(ShaderProgram* theShader);
+	unsigned GetTextureKey(const unsigned textureID);
+	unsigned GetMeshKey(Mesh* theMesh);
+	// Sort theSortedIndices by theKeys, 8 bits at a time
+	void RadixSort(void);
+	// Return true if 2 items can be drawn in the same instanced draw call
+	bool CanInstance(const DrawItem& theItem, const DrawItem& theOtherItem) const;
+	// Group the sorted items into runs, and pack the matrices of the instanced runs into theInstanceData
+	void BuildDrawRuns(void);
+	// Enable / Disable the per-instance matrices, starting from an instance in the instance buffer
+	void SetInstanceAttributes(const bool bEnabled, const unsigned firstInstance);
+
+	bool bRecording;
+	bool bTransparent;
+	bool bInstancing;
+	bool bParallelRecording;
+	float maxDepth;
+	int numOfDrawItems;
+	int numOfBinds;
+	int numOfDrawCalls;
+
+	std::vector<DrawItem> theItems;
+	std::vector<unsigned long long> theKeys;
+	std::vector<unsigned> theSortedIndices;
+	// The buffers for RadixSort, kept so they are not allocated every frame
+	std::vector<unsigned long long> theSwapKeys;
+	std::vector<unsigned> theSwapIndices;
+
+	// The draw item list and the model stack of each job of RecordParallel, kept so they are not allocated every frame
+	std::vector< std::vector<DrawItem> > theJobItems;
+	std::vector<MS> theJobStacks;
+	// The list which this thread's job is recording into, or nullptr to record into theItems
+	static thread_local std::vector<DrawItem>* theThreadItems;
+
+	std::vector<DrawRun> theRuns;
+	// The MVP and modelview matrices of each instance, 32 floats per instance,
+	// which are uploaded into CStreamBuffer at instanceOffset
+	std::vector<float> theInstanceData;
+	unsigned instanceOffset;
+
+	std::map<ShaderProgram*, unsigned> theShaderKeys;
+	std::map<unsigned, unsigned> theTextureKeys;
+	std::map<Mesh*, unsigned> theMeshKeys;
+};
+
+#endif // RENDER_QUEUE_H
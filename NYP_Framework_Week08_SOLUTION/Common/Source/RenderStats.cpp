@@ -0,0 +1,293 @@
+#include "RenderStats.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+#include "GL\glew.h"
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+CRenderStats::CRenderStats(void)
+	: bTimerAvailable(false)
+	, bFrameStarted(false)
+	, currPass(PASS_OTHER)
+	, currQueryFrame(0)
+	, bQueryRunning(false)
+	, numOfDroppedFrames(0)
+{
+	memset(theCounters, 0, sizeof(theCounters));
+	memset(theLastCounters, 0, sizeof(theLastCounters));
+	for (int i = 0; i < NUM_PASS; ++i)
+		theGPUTimes[i] = 0.0;
+}
+
+CRenderStats::~CRenderStats(void)
+{
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	for (int i = 0; i < NUM_QUERY_FRAMES; ++i)
+	{
+		for (unsigned j = 0; j < theQueryFrames[i].theQueries.size(); ++j)
+			theDevice->DeleteQuery(theQueryFrames[i].theQueries[j]);
+	}
+}
+
+/**
+* Check for the timer queries, which are core since OpenGL 3.3
+*/
+void CRenderStats::Init(void)
+{
+	bTimerAvailable = CGraphicsDevice::GetDevice()->IsSupported(CGraphicsDevice::FEATURE_TIMER_QUERY);
+}
+
+/**
+* Start counting a frame, and read back the timings of the earlier frames which the GPU has finished
+*/
+void CRenderStats::BeginFrame(void)
+{
+	if (bFrameStarted)
+		return;
+
+	memset(theCounters, 0, sizeof(theCounters));
+	currPass = PASS_OTHER;
+	thePassStack.clear();
+
+	if (bTimerAvailable)
+	{
+		// The frame about to be reused is the oldest, so read the frames from it onwards.
+		// The GPU finishes them in order, so stop at the first one which is not done
+		for (int i = 0; i < NUM_QUERY_FRAMES; ++i)
+		{
+			QueryFrame& theFrame = theQueryFrames[(currQueryFrame + i) % NUM_QUERY_FRAMES];
+			if ((theFrame.bPending) && (!ReadQueries(theFrame)))
+				break;
+		}
+
+		// Give up on the oldest frame rather than waiting for the GPU to catch up
+		QueryFrame& theFrame = theQueryFrames[currQueryFrame];
+		if (theFrame.bPending)
+		{
+			theFrame.bPending = false;
+			numOfDroppedFrames++;
+		}
+		theFrame.numOfQueries = 0;
+	}
+
+	bFrameStarted = true;
+	RestartQuery();
+}
+
+/**
+* Stop counting the frame, and keep its counters for the Get functions
+*/
+void CRenderStats::EndFrame(void)
+{
+	if (!bFrameStarted)
+		return;
+
+	if (bQueryRunning)
+	{
+		CGraphicsDevice::GetDevice()->EndQuery(GL_TIME_ELAPSED);
+		bQueryRunning = false;
+	}
+	if (bTimerAvailable)
+	{
+		theQueryFrames[currQueryFrame].bPending = (theQueryFrames[currQueryFrame].numOfQueries > 0);
+		currQueryFrame = (currQueryFrame + 1) % NUM_QUERY_FRAMES;
+	}
+
+	memcpy(theLastCounters, theCounters, sizeof(theCounters));
+	bFrameStarted = false;
+	currPass = PASS_OTHER;
+	thePassStack.clear();
+}
+
+/**
+* Count and time the next work in a pass
+*/
+void CRenderStats::BeginPass(const PASS thePass)
+{
+	thePassStack.push_back(currPass);
+	if (thePass != currPass)
+	{
+		currPass = thePass;
+		RestartQuery();
+	}
+}
+
+/**
+* Go back to the pass before the last BeginPass
+*/
+void CRenderStats::EndPass(void)
+{
+	if (thePassStack.empty())
+		return;
+
+	const PASS thePreviousPass = thePassStack.back();
+	thePassStack.pop_back();
+	if (thePreviousPass != currPass)
+	{
+		currPass = thePreviousPass;
+		RestartQuery();
+	}
+}
+
+/**
+* Get the pass which the work is counted in
+*/
+CRenderStats::PASS CRenderStats::GetPass(void) const
+{
+	return currPass;
+}
+
+/**
+* Get a counter of a pass for the last frame
+*/
+unsigned CRenderStats::GetCounter(const PASS thePass, const COUNTER theCounter) const
+{
+	return theLastCounters[thePass][theCounter];
+}
+
+/**
+* Get a counter of the whole last frame
+*/
+unsigned CRenderStats::GetTotal(const COUNTER theCounter) const
+{
+	unsigned total = 0;
+	for (int i = 0; i < NUM_PASS; ++i)
+		total += theLastCounters[i][theCounter];
+	return total;
+}
+
+/**
+* Return true if the passes are timed on the GPU
+*/
+bool CRenderStats::IsTimerAvailable(void) const
+{
+	return bTimerAvailable;
+}
+
+/**
+* Get the GPU time of a pass in milliseconds, for the latest frame which was read back
+*/
+double CRenderStats::GetGPUTime(const PASS thePass) const
+{
+	return theGPUTimes[thePass];
+}
+
+/**
+* Get the GPU time of the whole frame in milliseconds, for the latest frame which was read back
+*/
+double CRenderStats::GetGPUFrameTime(void) const
+{
+	double total = 0.0;
+	for (int i = 0; i < NUM_PASS; ++i)
+		total += theGPUTimes[i];
+	return total;
+}
+
+/**
+* Get the number of frames whose timings were given up on
+*/
+int CRenderStats::GetNumOfDroppedFrames(void) const
+{
+	return numOfDroppedFrames;
+}
+
+/**
+* Get the name of a pass
+*/
+const char* CRenderStats::GetPassName(const PASS thePass)
+{
+	static const char* theNames[NUM_PASS] = { "Other", "Opaque", "Alpha tested", "Transparent", "UI" };
+	return theNames[thePass];
+}
+
+/**
+* Get a line which sums up the counters and GPU time of a pass
+*/
+std::string CRenderStats::GetPassSummary(const PASS thePass) const
+{
+	return GetSummary(GetPassName(thePass), theLastCounters[thePass], theGPUTimes[thePass]);
+}
+
+/**
+* Get a line which sums up the counters and GPU time of the whole frame
+*/
+std::string CRenderStats::GetFrameSummary(void) const
+{
+	unsigned theTotals[NUM_COUNTER];
+	for (int i = 0; i < NUM_COUNTER; ++i)
+		theTotals[i] = GetTotal((COUNTER)i);
+	return GetSummary("Frame", theTotals, GetGPUFrameTime());
+}
+
+/**
+* End the running query, and start one for the current pass. GL_TIME_ELAPSED queries cannot
+* be nested, so the frame is timed as a run of queries, one for each change of pass
+*/
+void CRenderStats::RestartQuery(void)
+{
+	if ((!bTimerAvailable) || (!bFrameStarted))
+		return;
+
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	if (bQueryRunning)
+		theDevice->EndQuery(GL_TIME_ELAPSED);
+
+	QueryFrame& theFrame = theQueryFrames[currQueryFrame];
+	if (theFrame.numOfQueries == theFrame.theQueries.size())
+	{
+		theFrame.theQueries.push_back(theDevice->GenQuery());
+		theFrame.thePasses.push_back(currPass);
+	}
+	theFrame.thePasses[theFrame.numOfQueries] = currPass;
+	theDevice->BeginQuery(GL_TIME_ELAPSED, theFrame.theQueries[theFrame.numOfQueries]);
+	theFrame.numOfQueries++;
+	bQueryRunning = true;
+}
+
+/**
+* Read back the timings of a frame if the GPU has finished it
+*/
+bool CRenderStats::ReadQueries(QueryFrame& theFrame)
+{
+	if (theFrame.numOfQueries == 0)
+	{
+		theFrame.bPending = false;
+		return true;
+	}
+
+	// The queries finish in order, so the last one being done means they all are
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	if (!theDevice->GetQueryObjectui(theFrame.theQueries[theFrame.numOfQueries - 1], GL_QUERY_RESULT_AVAILABLE))
+		return false;
+
+	for (int i = 0; i < NUM_PASS; ++i)
+		theGPUTimes[i] = 0.0;
+	for (unsigned i = 0; i < theFrame.numOfQueries; ++i)
+	{
+		const unsigned long long elapsedTime = theDevice->GetQueryObjectui64(theFrame.theQueries[i], GL_QUERY_RESULT);
+		theGPUTimes[theFrame.thePasses[i]] += elapsedTime / 1000000.0;
+	}
+	theFrame.bPending = false;
+	return true;
+}
+
+/**
+* Build a summary line from the counters and the GPU time
+*/
+std::string CRenderStats::GetSummary(const char* theName, const unsigned* theFrameCounters, const double gpuTime) const
+{
+	std::ostringstream theSummary;
+	theSummary << theName << ":";
+	if (bTimerAvailable)
+		theSummary << " " << std::fixed << std::setprecision(2) << gpuTime << "ms";
+	theSummary << " " << theFrameCounters[COUNTER_DRAW_CALLS] << " draws"
+		<< " " << theFrameCounters[COUNTER_TRIANGLES] << " tris"
+		<< " " << theFrameCounters[COUNTER_TEXTURE_BINDS] << " tex"
+		<< " " << theFrameCounters[COUNTER_PROGRAM_SWITCHES] << " prog"
+		<< " " << theFrameCounters[COUNTER_UNIFORM_UPLOADS] << " unif"
+		<< " " << theFrameCounters[COUNTER_BUFFER_UPLOADS] << " buf "
+		<< (theFrameCounters[COUNTER_BUFFER_UPLOAD_BYTES] + 1023) / 1024 << "KB";
+	return theSummary.str();
+}
@@ -0,0 +1,126 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include "SingletonTemplate.h"
+#include <string>
+#include <vector>
+
+// Counts the draw calls, triangles and state changes of each frame, broken down by the pass they are made in,
+// and times each pass on the GPU with GL_TIME_ELAPSED queries. The queries of a frame are read back a few
+// frames later, once the GPU has finished them, so reading the timings never stalls the CPU.
+// The counters are only updated on the thread which owns the OpenGL context.
+class CRenderStats : public Singleton<CRenderStats>
+{
+	friend Singleton<CRenderStats>;
+public:
+	enum PASS
+	{
+		PASS_OTHER = 0,			// Everything outside a pass, such as the uniform buffer and light uploads
+		PASS_OPAQUE,			// The passes of CRenderQueue
+		PASS_ALPHA_TESTED,
+		PASS_TRANSPARENT,
+		PASS_UI,				// The 2D sprites and text
+		NUM_PASS
+	};
+
+	enum COUNTER
+	{
+		COUNTER_DRAW_CALLS = 0,
+		COUNTER_TRIANGLES,
+		COUNTER_TEXTURE_BINDS,
+		COUNTER_PROGRAM_SWITCHES,
+		COUNTER_UNIFORM_UPLOADS,
+		COUNTER_BUFFER_UPLOADS,
+		COUNTER_BUFFER_UPLOAD_BYTES,
+		NUM_COUNTER
+	};
+
+	// The number of frames of queries in flight before the oldest one is given up on
+	static const int NUM_QUERY_FRAMES = 4;
+
+	virtual ~CRenderStats(void);
+
+	// Check for the timer queries. Call it after the OpenGL context is created
+	void Init(void);
+
+	// Start counting a frame, and read back the timings of the earlier frames which the GPU has finished
+	void BeginFrame(void);
+	// Stop counting the frame, and keep its counters for the Get functions
+	void EndFrame(void);
+
+	// Count and time the next work in a pass, until EndPass goes back to the pass before it
+	void BeginPass(const PASS thePass);
+	void EndPass(void);
+	// Get the pass which the work is counted in
+	PASS GetPass(void) const;
+
+	// Count a draw call with the number of triangles it draws
+	inline void AddDrawCall(const unsigned numOfTriangles)
+	{
+		theCounters[currPass][COUNTER_DRAW_CALLS]++;
+		theCounters[currPass][COUNTER_TRIANGLES] += numOfTriangles;
+	}
+	inline void AddTextureBind(void) { theCounters[currPass][COUNTER_TEXTURE_BINDS]++; }
+	inline void AddProgramSwitch(void) { theCounters[currPass][COUNTER_PROGRAM_SWITCHES]++; }
+	inline void AddUniformUpload(void) { theCounters[currPass][COUNTER_UNIFORM_UPLOADS]++; }
+	inline void AddBufferUpload(const unsigned size)
+	{
+		theCounters[currPass][COUNTER_BUFFER_UPLOADS]++;
+		theCounters[currPass][COUNTER_BUFFER_UPLOAD_BYTES] += size;
+	}
+
+	// Get a counter of a pass, or of the whole frame, for the last frame
+	unsigned GetCounter(const PASS thePass, const COUNTER theCounter) const;
+	unsigned GetTotal(const COUNTER theCounter) const;
+	// Return true if the passes are timed on the GPU
+	bool IsTimerAvailable(void) const;
+	// Get the GPU time of a pass, or of the whole frame, in milliseconds, for the latest frame which was read back
+	double GetGPUTime(const PASS thePass) const;
+	double GetGPUFrameTime(void) const;
+	// Get the number of frames whose timings were given up on because the GPU was too far behind
+	int GetNumOfDroppedFrames(void) const;
+
+	// Get the name of a pass, and a line which sums up its counters and GPU time, such as for an overlay
+	static const char* GetPassName(const PASS thePass);
+	std::string GetPassSummary(const PASS thePass) const;
+	std::string GetFrameSummary(void) const;
+
+protected:
+	CRenderStats(void);
+
+	// The timer queries of a frame, each timing the work of a pass from when it became the current pass
+	struct QueryFrame
+	{
+		std::vector<unsigned> theQueries;
+		std::vector<PASS> thePasses;
+		unsigned numOfQueries;
+		bool bPending;
+
+		QueryFrame(void) : numOfQueries(0), bPending(false) {}
+	};
+
+	// End the running query, and start one for the current pass
+	void RestartQuery(void);
+	// Read back the timings of a frame if the GPU has finished it. Return false if it has not
+	bool ReadQueries(QueryFrame& theFrame);
+	// Build a summary line from the counters and the GPU time
+	std::string GetSummary(const char* theName, const unsigned* theFrameCounters, const double gpuTime) const;
+
+	bool bTimerAvailable;
+	bool bFrameStarted;
+	PASS currPass;
+	std::vector<PASS> thePassStack;
+
+	// The counters of the frame being counted, and of the last frame
+	unsigned theCounters[NUM_PASS][NUM_COUNTER];
+	unsigned theLastCounters[NUM_PASS][NUM_COUNTER];
+
+	// The queries of the frames in flight, used round robin
+	QueryFrame theQueryFrames[NUM_QUERY_FRAMES];
+	int currQueryFrame;
+	bool bQueryRunning;
+	double theGPUTimes[NUM_PASS];
+	int numOfDroppedFrames;
+};
+
+#endif // RENDER_STATS_H
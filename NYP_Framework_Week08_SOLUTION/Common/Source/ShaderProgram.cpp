@@ -1,4 +1,7 @@
 #include "ShaderProgram.h"
+#include "LightClusters.h"
+#include "RenderStats.h"
+#include "GraphicsDevice/GraphicsDevice.h"
 #include "GL\glew.h"
 
 #include <iostream>
@@ -7,12 +10,13 @@ using namespace std;
 ShaderProgram::ShaderProgram(unsigned int _programID) :
 programID(_programID)
 {
+	ResolveUniforms();
 }
 
 ShaderProgram::~ShaderProgram()
 {
 	if (programID != SHADER_ERROR)
-		glDeleteProgram(programID);
+		CGraphicsDevice::GetDevice()->DeleteProgram(programID);
 }
 
 unsigned int ShaderProgram::GetProgramID()
@@ -24,11 +28,61 @@ void ShaderProgram::SetProgramID(const unsigned int _programID)
 {
 	programID = _programID;
 	cout << programID;
+	ResolveUniforms();
+}
+
+const ShaderUniforms& ShaderProgram::GetUniforms() const
+{
+	return uniforms;
+}
+
+void ShaderProgram::ResolveUniforms()
+{
+	uniforms.MVP.Resolve(programID, "MVP");
+	uniforms.MV.Resolve(programID, "MV");
+	uniforms.MV_inverse_transpose.Resolve(programID, "MV_inverse_transpose");
+	uniforms.instancingEnabled.Resolve(programID, "instancingEnabled");
+	uniforms.kAmbient.Resolve(programID, "material.kAmbient");
+	uniforms.kDiffuse.Resolve(programID, "material.kDiffuse");
+	uniforms.kSpecular.Resolve(programID, "material.kSpecular");
+	uniforms.kShininess.Resolve(programID, "material.kShininess");
+	uniforms.lightEnabled.Resolve(programID, "lightEnabled");
+	uniforms.colorTextureEnabled.Resolve(programID, "colorTextureEnabled");
+	uniforms.colorTexture.Resolve(programID, "colorTexture");
+	uniforms.textEnabled.Resolve(programID, "textEnabled");
+	uniforms.textColor.Resolve(programID, "textColor");
+	uniforms.alphaTestEnabled.Resolve(programID, "alphaTestEnabled");
+	uniforms.ditherEnabled.Resolve(programID, "ditherEnabled");
+	uniforms.ditherAlpha.Resolve(programID, "ditherAlpha");
+	uniforms.ditherInverted.Resolve(programID, "ditherInverted");
+
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	// Attach the shared uniform blocks, if the program uses them
+	unsigned int blockIndex = theDevice->GetUniformBlockIndex(programID, "FrameBlock");
+	if (blockIndex != GL_INVALID_INDEX)
+		theDevice->UniformBlockBinding(programID, blockIndex, FRAME_BLOCK_BINDING);
+	blockIndex = theDevice->GetUniformBlockIndex(programID, "LightBlock");
+	if (blockIndex != GL_INVALID_INDEX)
+		theDevice->UniformBlockBinding(programID, blockIndex, LIGHT_BLOCK_BINDING);
+
+	// Point the light cluster samplers at their texture units, which needs the program to be in use
+	GLint clusterLights = theDevice->GetUniformLocation(programID, "clusterLights");
+	GLint clusterGrid = theDevice->GetUniformLocation(programID, "clusterGrid");
+	GLint clusterLightIndices = theDevice->GetUniformLocation(programID, "clusterLightIndices");
+	if ((clusterLights >= 0) || (clusterGrid >= 0) || (clusterLightIndices >= 0))
+	{
+		const GLint currentProgram = theDevice->GetInteger(GL_CURRENT_PROGRAM);
+		theDevice->UseProgram(programID);
+		theDevice->Uniform1i(clusterLights, CLightClusters::LIGHT_DATA_UNIT);
+		theDevice->Uniform1i(clusterGrid, CLightClusters::CLUSTER_GRID_UNIT);
+		theDevice->Uniform1i(clusterLightIndices, CLightClusters::LIGHT_INDEX_UNIT);
+		theDevice->UseProgram(currentProgram);
+	}
 }
 
 unsigned int ShaderProgram::AddUniform(const std::string& _name)
 {
-	unsigned int ID = glGetUniformLocation(programID, _name.c_str());
+	unsigned int ID = CGraphicsDevice::GetDevice()->GetUniformLocation(programID, _name.c_str());
 
 	if (ID != SHADER_ERROR)
 		uniformMap[_name] = ID;
@@ -59,32 +113,38 @@ unsigned int ShaderProgram::GetOrAddUniform(const std::string& _name)
 
 void ShaderProgram::UpdateInt(unsigned int _ID, int _value)
 {
-	glUniform1i(_ID, _value);
+	CGraphicsDevice::GetDevice()->Uniform1i(_ID, _value);
+	CRenderStats::GetInstance()->AddUniformUpload();
 }
 
 void ShaderProgram::UpdateFloat(unsigned int _ID, float _value)
 {
-	glUniform1f(_ID, _value);
+	CGraphicsDevice::GetDevice()->Uniform1f(_ID, _value);
+	CRenderStats::GetInstance()->AddUniformUpload();
 }
 
 void ShaderProgram::UpdateVector3(unsigned int _ID, const Vector3& _value)
 {
-	glUniform3fv(_ID, 1, &_value.x);
+	CGraphicsDevice::GetDevice()->Uniform3fv(_ID, &_value.x);
+	CRenderStats::GetInstance()->AddUniformUpload();
 }
 
 void ShaderProgram::UpdateVector3(unsigned int _ID, float* _startPtr)
 {
-	glUniform3fv(_ID, 1, _startPtr);
+	CGraphicsDevice::GetDevice()->Uniform3fv(_ID, _startPtr);
+	CRenderStats::GetInstance()->AddUniformUpload();
 }
 
 void ShaderProgram::UpdateMatrix44(unsigned int _ID, const Mtx44& _value)
 {
-	glUniformMatrix4fv(_ID, 1, GL_FALSE, &_value.a[0]);
+	CGraphicsDevice::GetDevice()->UniformMatrix4fv(_ID, &_value.a[0]);
+	CRenderStats::GetInstance()->AddUniformUpload();
 }
 
 void ShaderProgram::UpdateMatrix44(unsigned int _ID, float* _startPtr)
 {
-	glUniformMatrix4fv(_ID, 1, GL_FALSE, _startPtr);
+	CGraphicsDevice::GetDevice()->UniformMatrix4fv(_ID, _startPtr);
+	CRenderStats::GetInstance()->AddUniformUpload();
 }
 
 void ShaderProgram::UpdateInt(const std::string& _name, int _value)
@@ -145,4 +205,55 @@ void ShaderProgram::UpdateMatrix44(const std::string& _name, float* _startPtr)
 		return;
 
 	UpdateMatrix44(ID, _startPtr);
-}
\ No newline at end of file
+}
+
+template <typename T>
+void UniformHandle<T>::Resolve(const unsigned int _programID, const char* _name)
+{
+	location = CGraphicsDevice::GetDevice()->GetUniformLocation(_programID, _name);
+}
+
+template <>
+void UniformHandle<int>::Set(const int& _value) const
+{
+	if (location >= 0)
+	{
+		CGraphicsDevice::GetDevice()->Uniform1i(location, _value);
+		CRenderStats::GetInstance()->AddUniformUpload();
+	}
+}
+
+template <>
+void UniformHandle<float>::Set(const float& _value) const
+{
+	if (location >= 0)
+	{
+		CGraphicsDevice::GetDevice()->Uniform1f(location, _value);
+		CRenderStats::GetInstance()->AddUniformUpload();
+	}
+}
+
+template <>
+void UniformHandle<Vector3>::Set(const Vector3& _value) const
+{
+	if (location >= 0)
+	{
+		CGraphicsDevice::GetDevice()->Uniform3fv(location, &_value.x);
+		CRenderStats::GetInstance()->AddUniformUpload();
+	}
+}
+
+template <>
+void UniformHandle<Mtx44>::Set(const Mtx44& _value) const
+{
+	if (location >= 0)
+	{
+		CGraphicsDevice::GetDevice()->UniformMatrix4fv(location, &_value.a[0]);
+		CRenderStats::GetInstance()->AddUniformUpload();
+	}
+}
+
+template class UniformHandle<int>;
+template class UniformHandle<float>;
+template class UniformHandle<Vector3>;
+template class UniformHandle<Mtx44>;
\ No newline at end of file
@@ -6,17 +6,72 @@
 #include "Vector3.h"
 #include "Mtx44.h"
 
+// A uniform location which is looked up once, when the program is linked,
+// so setting it does no string hashing or map lookup.
+// Setting a uniform which the program does not have does nothing
+template <typename T>
+class UniformHandle
+{
+public:
+	UniformHandle(void) : location(-1) {}
+
+	void Resolve(const unsigned int _programID, const char* _name);
+	bool IsValid(void) const { return location >= 0; }
+	void Set(const T& _value) const;
+
+private:
+	int location;
+};
+
+template <> void UniformHandle<int>::Set(const int& _value) const;
+template <> void UniformHandle<float>::Set(const float& _value) const;
+template <> void UniformHandle<Vector3>::Set(const Vector3& _value) const;
+template <> void UniformHandle<Mtx44>::Set(const Mtx44& _value) const;
+
+// The uniforms used by RenderHelper and CRenderQueue, which every program resolves when it is created
+struct ShaderUniforms
+{
+	UniformHandle<Mtx44> MVP;
+	UniformHandle<Mtx44> MV;
+	UniformHandle<Mtx44> MV_inverse_transpose;
+	UniformHandle<int> instancingEnabled;
+	UniformHandle<Vector3> kAmbient;
+	UniformHandle<Vector3> kDiffuse;
+	UniformHandle<Vector3> kSpecular;
+	UniformHandle<float> kShininess;
+	UniformHandle<int> lightEnabled;
+	UniformHandle<int> colorTextureEnabled;
+	UniformHandle<int> colorTexture;
+	UniformHandle<int> textEnabled;
+	UniformHandle<Vector3> textColor;
+	UniformHandle<int> alphaTestEnabled;
+	UniformHandle<int> ditherEnabled;
+	UniformHandle<float> ditherAlpha;
+	UniformHandle<int> ditherInverted;
+};
+
 class ShaderProgram
 {
 public:
 	const unsigned int SHADER_ERROR = UINT_MAX;
 
+	// The binding points of the uniform blocks shared by all the programs
+	enum UNIFORM_BLOCK_BINDING
+	{
+		FRAME_BLOCK_BINDING = 0,	// FrameBlock: the view and projection matrices
+		LIGHT_BLOCK_BINDING,		// LightBlock: the lights and the number of lights
+		NUM_UNIFORM_BLOCK_BINDING
+	};
+
 	ShaderProgram(unsigned int _programID);
 	~ShaderProgram();
 
 	unsigned int GetProgramID();
 	void SetProgramID(const unsigned int _programID);
 
+	// Get the uniform handles resolved when the program was linked
+	const ShaderUniforms& GetUniforms() const;
+
 	unsigned int AddUniform(const std::string& _name);
 	unsigned int GetUniform(const std::string& _name);
 	unsigned int GetOrAddUniform(const std::string& _name);
@@ -36,7 +91,11 @@ public:
 	void UpdateMatrix44(const std::string& _name, float* _startPtr);
 
 private:
+	// Look up the uniform handles and attach the uniform blocks to their binding points
+	void ResolveUniforms();
+
 	unsigned int programID;
+	ShaderUniforms uniforms;
 	std::map<std::string, unsigned int> uniformMap;
 };
 
@@ -0,0 +1,91 @@
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <vector>
+#include <new>
+
+// A fixed-size allocator for objects of type T.
+// Memory is reserved in slabs of NUM_PER_SLAB objects, and freed objects are kept in a
+// free list for reuse, so allocating and freeing an object never calls the heap once
+// the slabs are warm. The slabs are only returned to the heap when the allocator is destroyed.
+template <typename T, unsigned NUM_PER_SLAB = 256>
+class SlabAllocator
+{
+public:
+	SlabAllocator(void)
+		: theFreeList(nullptr)
+		, numOfAllocated(0)
+	{
+	}
+
+	~SlabAllocator(void)
+	{
+		for (unsigned i = 0; i < theSlabs.size(); ++i)
+			::operator delete(theSlabs[i]);
+		theSlabs.clear();
+	}
+
+	// Get the memory for one object. The object is not constructed
+	void* Allocate(void)
+	{
+		if (theFreeList == nullptr)
+			AddSlab();
+
+		Block* theBlock = theFreeList;
+		theFreeList = theBlock->next;
+		numOfAllocated++;
+		return theBlock;
+	}
+
+	// Return the memory of one object. The object must already be destructed
+	void Free(void* p)
+	{
+		if (p == nullptr)
+			return;
+
+		Block* theBlock = static_cast<Block*>(p);
+		theBlock->next = theFreeList;
+		theFreeList = theBlock;
+		numOfAllocated--;
+	}
+
+	// Get the number of objects which are allocated
+	unsigned GetNumOfAllocated(void) const
+	{
+		return numOfAllocated;
+	}
+
+	// Get the number of objects which the slabs can hold
+	unsigned GetCapacity(void) const
+	{
+		return (unsigned)theSlabs.size() * NUM_PER_SLAB;
+	}
+
+private:
+	// A free block holds the pointer to the next free block
+	union Block
+	{
+		Block* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	// Reserve a new slab and add its blocks to the free list
+	void AddSlab(void)
+	{
+		Block* theSlab = static_cast<Block*>(::operator new(sizeof(Block) * NUM_PER_SLAB));
+		theSlabs.push_back(theSlab);
+
+		// Link the blocks in reverse, so they are handed out in address order
+		for (int i = NUM_PER_SLAB - 1; i >= 0; --i)
+		{
+			theSlab[i].next = theFreeList;
+			theFreeList = &theSlab[i];
+		}
+	}
+
+	Block* theFreeList;
+	std::vector<Block*> theSlabs;
+	unsigned numOfAllocated;
+};
+
+#endif // SLAB_ALLOCATOR_H
@@ -0,0 +1,293 @@
+#include "SpriteBatch.h"
+#include "RenderHelper.h"
+#include "RenderQueue.h"
+#include "Mesh.h"
+#include "GraphicsManager.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include "RenderStats.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+#include "GL\glew.h"
+#include <cstring>
+
+CSpriteBatch::CSpriteBatch(void)
+	: bRecording(false)
+	, numOfSprites(0)
+	, numOfDrawCalls(0)
+	, numOfBegins(0)
+	, theBatchMesh(nullptr)
+{
+}
+
+CSpriteBatch::~CSpriteBatch(void)
+{
+	if (theBatchMesh)
+		delete theBatchMesh;
+}
+
+/**
+* Start collecting the sprites
+*/
+void CSpriteBatch::Begin(void)
+{
+	theBatches.clear();
+	theVertices.clear();
+	theIndices.clear();
+	numOfSprites = 0;
+	numOfDrawCalls = 0;
+	bRecording = true;
+
+	// Forget the copies which have not been used for a while, such as those of the deleted meshes
+	numOfBegins++;
+	std::map<Mesh*, MeshData>::iterator it = theMeshData.begin();
+	while (it != theMeshData.end())
+	{
+		if (numOfBegins - it->second.lastUsed > MESH_DATA_LIFETIME)
+			it = theMeshData.erase(it);
+		else
+			++it;
+	}
+}
+
+/**
+* Return true if the sprites are being collected
+*/
+bool CSpriteBatch::IsRecording(void) const
+{
+	return bRecording;
+}
+
+/**
+* Add a range of a mesh's indices, moved by the top of the model stack
+*/
+bool CSpriteBatch::Add(Mesh* theMesh, const unsigned offset, const unsigned count, const unsigned char flags, const float ditherAlpha)
+{
+	if ((!bRecording) || (theMesh == nullptr) || (theMesh->mode != Mesh::DRAW_TRIANGLES))
+		return false;
+	ShaderProgram* theShader = GraphicsManager::GetInstance()->GetActiveShader();
+	if (theShader == nullptr)
+		return false;
+
+	// Large meshes gain little from the batch, and are not worth copying
+	const unsigned numOfIndices = (count == 0 ? theMesh->indexSize : count);
+	if ((numOfIndices == 0) || (numOfIndices > MAX_SPRITE_INDICES))
+		return false;
+
+	const MeshData& theData = GetMeshData(theMesh);
+	if ((!theData.bBatchable) || (offset + numOfIndices > theData.theIndices.size()))
+		return false;
+
+	// Start a new batch when the states change
+	if ((theBatches.empty()) ||
+		(theBatches.back().theShader != theShader) ||
+		(theBatches.back().textureID != theMesh->textureID) ||
+		(theBatches.back().flags != flags) ||
+		(theBatches.back().ditherAlpha != ditherAlpha))
+	{
+		Batch theBatch;
+		theBatch.theShader = theShader;
+		theBatch.textureID = theMesh->textureID;
+		theBatch.flags = flags;
+		theBatch.ditherAlpha = ditherAlpha;
+		theBatch.firstIndex = theIndices.size();
+		theBatch.numOfIndices = 0;
+		theBatches.push_back(theBatch);
+	}
+
+	// Only copy the vertices which the range of indices uses
+	unsigned minIndex = theData.theIndices[offset], maxIndex = minIndex;
+	for (unsigned i = offset + 1; i < offset + numOfIndices; ++i)
+	{
+		if (theData.theIndices[i] < minIndex)
+			minIndex = theData.theIndices[i];
+		if (theData.theIndices[i] > maxIndex)
+			maxIndex = theData.theIndices[i];
+	}
+
+	const unsigned baseVertex = theVertices.size() - minIndex;
+	for (unsigned i = offset; i < offset + numOfIndices; ++i)
+		theIndices.push_back(baseVertex + theData.theIndices[i]);
+
+	// Move the vertices by the model matrix, so the batch is drawn with only the view and projection
+	const Mtx44& theModel = GraphicsManager::GetInstance()->GetModelStack().Top();
+	for (unsigned i = minIndex; i <= maxIndex; ++i)
+	{
+		Vertex v = theData.theVertices[i];
+		const Position& p = theData.theVertices[i].pos;
+		v.pos.Set(theModel.a[0] * p.x + theModel.a[4] * p.y + theModel.a[8] * p.z + theModel.a[12],
+				  theModel.a[1] * p.x + theModel.a[5] * p.y + theModel.a[9] * p.z + theModel.a[13],
+				  theModel.a[2] * p.x + theModel.a[6] * p.y + theModel.a[10] * p.z + theModel.a[14]);
+		theVertices.push_back(v);
+	}
+
+	theBatches.back().numOfIndices += numOfIndices;
+	numOfSprites++;
+	return true;
+}
+
+/**
+* Draw the collected sprites, and keep collecting
+*/
+void CSpriteBatch::Flush(void)
+{
+	if (theBatches.empty())
+		return;
+
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	CStreamBuffer* theStreamBuffer = CStreamBuffer::GetInstance();
+	if (theBatchMesh == nullptr)
+	{
+		// Draw the vertices and the indices from the streaming buffer, instead of the mesh's own buffers
+		theBatchMesh = new Mesh("spritebatch");
+		theDevice->DeleteBuffer(theBatchMesh->vertexBuffer);
+		theDevice->DeleteBuffer(theBatchMesh->indexBuffer);
+		theBatchMesh->vertexBuffer = theStreamBuffer->GetBufferID();
+		theBatchMesh->indexBuffer = theStreamBuffer->GetBufferID();
+		theBatchMesh->bSharedBuffers = true;
+		theBatchMesh->SetupVertexArray();
+	}
+
+	// Map one range for the vertices followed by the indices, so a wrap of the ring cannot separate them.
+	// The range starts at a multiple of the vertex size, so the indices are moved to count from there
+	const unsigned vertexBytes = theVertices.size() * sizeof(Vertex);
+	unsigned offset = 0;
+	unsigned char* theMappedData = (unsigned char*)theStreamBuffer->Map(vertexBytes + theIndices.size() * sizeof(GLuint), sizeof(Vertex), offset);
+	if (theMappedData == nullptr)
+	{
+		theBatches.clear();
+		theVertices.clear();
+		theIndices.clear();
+		return;
+	}
+	memcpy(theMappedData, &theVertices[0], vertexBytes);
+	GLuint* theMappedIndices = (GLuint*)(theMappedData + vertexBytes);
+	const unsigned baseVertex = offset / sizeof(Vertex);
+	for (unsigned i = 0; i < theIndices.size(); ++i)
+		theMappedIndices[i] = baseVertex + theIndices[i];
+	theStreamBuffer->Unmap();
+	const unsigned firstIndex = (offset + vertexBytes) / sizeof(GLuint);
+	theBatchMesh->Bind();
+
+	const Mtx44 VP = GraphicsManager::GetInstance()->GetProjectionMatrix() * GraphicsManager::GetInstance()->GetViewMatrix();
+
+	// The states which are in place. They are unknown at the start, so the first batch sets all of them
+	ShaderProgram* currShader = nullptr;
+	const ShaderUniforms* theUniforms = nullptr;
+	int currFlags = -1;
+	int currColorTexture = -1;
+	unsigned currTexture = 0;
+	float currDitherAlpha = -1.0f;
+
+	for (unsigned i = 0; i < theBatches.size(); ++i)
+	{
+		const Batch& theBatch = theBatches[i];
+
+		if (theBatch.theShader != currShader)
+		{
+			currShader = theBatch.theShader;
+			theDevice->UseProgram(currShader->GetProgramID());
+			CRenderStats::GetInstance()->AddProgramSwitch();
+			theUniforms = &currShader->GetUniforms();
+			theUniforms->MVP.Set(VP);
+			currFlags = -1;
+			currColorTexture = -1;
+			currDitherAlpha = -1.0f;
+		}
+
+		// Update the render states which have changed
+		const int changedFlags = (currFlags < 0 ? 0xFF : (currFlags ^ theBatch.flags));
+		if (changedFlags & CRenderQueue::FLAG_LIGHT_ENABLED)
+			theUniforms->lightEnabled.Set((theBatch.flags & CRenderQueue::FLAG_LIGHT_ENABLED) ? 1 : 0);
+		if (changedFlags & CRenderQueue::FLAG_ALPHA_TEST)
+			theUniforms->alphaTestEnabled.Set((theBatch.flags & CRenderQueue::FLAG_ALPHA_TEST) ? 1 : 0);
+		if (changedFlags & CRenderQueue::FLAG_DITHER)
+			theUniforms->ditherEnabled.Set((theBatch.flags & CRenderQueue::FLAG_DITHER) ? 1 : 0);
+		if (changedFlags & CRenderQueue::FLAG_DITHER_INVERTED)
+			theUniforms->ditherInverted.Set((theBatch.flags & CRenderQueue::FLAG_DITHER_INVERTED) ? 1 : 0);
+		if (changedFlags & CRenderQueue::FLAG_WIREFRAME)
+			theDevice->PolygonMode(GL_FRONT_AND_BACK, (theBatch.flags & CRenderQueue::FLAG_WIREFRAME) ? GL_LINE : GL_FILL);
+		currFlags = theBatch.flags;
+		if ((theBatch.flags & CRenderQueue::FLAG_DITHER) && (theBatch.ditherAlpha != currDitherAlpha))
+		{
+			theUniforms->ditherAlpha.Set(theBatch.ditherAlpha);
+			currDitherAlpha = theBatch.ditherAlpha;
+		}
+
+		// A mesh without a texture is drawn with its vertex colours
+		const int colorTexture = ((theBatch.flags & CRenderQueue::FLAG_COLOR_TEXTURE_ENABLED) && (theBatch.textureID > 0)) ? 1 : 0;
+		if (colorTexture != currColorTexture)
+		{
+			theUniforms->colorTextureEnabled.Set(colorTexture);
+			currColorTexture = colorTexture;
+		}
+		if ((theBatch.textureID > 0) && (theBatch.textureID != currTexture))
+		{
+			GraphicsManager::GetInstance()->UpdateTexture(0, theBatch.textureID);
+			currTexture = theBatch.textureID;
+		}
+
+		theBatchMesh->Draw(firstIndex + theBatch.firstIndex, theBatch.numOfIndices);
+		numOfDrawCalls++;
+	}
+
+	// Leave the states as RenderHelper expects them
+	theBatchMesh->Unbind();
+	GraphicsManager::GetInstance()->UnbindTexture(0);
+	ShaderProgram* theActiveShader = GraphicsManager::GetInstance()->GetActiveShader();
+	if (theActiveShader)
+	{
+		theDevice->UseProgram(theActiveShader->GetProgramID());
+		CRenderStats::GetInstance()->AddProgramSwitch();
+	}
+	RenderHelper::RestoreRenderStates();
+
+	theBatches.clear();
+	theVertices.clear();
+	theIndices.clear();
+}
+
+/**
+* Draw the collected sprites, then stop collecting them
+*/
+void CSpriteBatch::End(void)
+{
+	Flush();
+	bRecording = false;
+}
+
+/**
+* Get the number of sprites drawn since Begin
+*/
+int CSpriteBatch::GetNumOfSprites(void) const
+{
+	return numOfSprites;
+}
+
+/**
+* Get the number of draw calls made since Begin
+*/
+int CSpriteBatch::GetNumOfDrawCalls(void) const
+{
+	return numOfDrawCalls;
+}
+
+/**
+* Get the copy of a mesh's vertices and indices, reading them back from its buffers the first time
+*/
+const CSpriteBatch::MeshData& CSpriteBatch::GetMeshData(Mesh* theMesh)
+{
+	std::map<Mesh*, MeshData>::iterator it = theMeshData.find(theMesh);
+	// Read the mesh again if it was refilled since it was copied, or if it is a new mesh at the same address
+	if ((it != theMeshData.end()) && (it->second.generation == theMesh->generation))
+	{
+		it->second.lastUsed = numOfBegins;
+		return it->second;
+	}
+
+	MeshData& theData = theMeshData[theMesh];
+	theData.generation = theMesh->generation;
+	theData.lastUsed = numOfBegins;
+	theData.bBatchable = theMesh->ReadBack(theData.theVertices, theData.theIndices);
+
+	return theData;
+}
@@ -0,0 +1,88 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "SingletonTemplate.h"
+#include "Vertex.h"
+#include <map>
+#include <vector>
+
+class Mesh;
+class ShaderProgram;
+
+// Collects the small unlit meshes rendered through RenderHelper between Begin and End, such as
+// sprites and tiles, and draws them from CStreamBuffer. Their vertices are moved by
+// the model matrix on the CPU, so meshes with different transformations share a draw call.
+// The meshes are drawn in the order they were added. A new batch is only started when the
+// shader, texture or render states change, so a layer of tiles with one texture is one draw call.
+// Call Flush before changing the OpenGL states directly, such as the stencil or blend states
+class CSpriteBatch : public Singleton<CSpriteBatch>
+{
+	friend Singleton<CSpriteBatch>;
+public:
+	// Meshes with more indices than this are drawn by RenderHelper as usual
+	static const unsigned MAX_SPRITE_INDICES = 96;
+	// The copy of a mesh is forgotten after this many calls to Begin without it being added
+	static const int MESH_DATA_LIFETIME = 300;
+
+	virtual ~CSpriteBatch(void);
+
+	// Start collecting the sprites
+	void Begin(void);
+	// Return true if the sprites are being collected
+	bool IsRecording(void) const;
+	// Add a range of a mesh's indices, moved by the top of the model stack. A count of 0 adds all the indices.
+	// Return false if the mesh cannot be batched, so it should be drawn at once
+	bool Add(Mesh* theMesh, const unsigned offset, const unsigned count, const unsigned char flags, const float ditherAlpha);
+	// Draw the collected sprites, and keep collecting
+	void Flush(void);
+	// Draw the collected sprites, then stop collecting them
+	void End(void);
+
+	// Get the number of sprites drawn since Begin
+	int GetNumOfSprites(void) const;
+	// Get the number of draw calls made since Begin
+	int GetNumOfDrawCalls(void) const;
+
+protected:
+	CSpriteBatch(void);
+
+	// A run of indices which share the same states
+	struct Batch
+	{
+		ShaderProgram* theShader;
+		unsigned textureID;
+		unsigned char flags;
+		float ditherAlpha;
+		unsigned firstIndex;
+		unsigned numOfIndices;
+	};
+
+	// A copy of a mesh's vertices and indices, read back from its buffers the first time it is added
+	struct MeshData
+	{
+		unsigned generation;		// The mesh's generation when it was copied
+		int lastUsed;				// The Begin which the copy was last used in
+		bool bBatchable;
+		std::vector<Vertex> theVertices;
+		std::vector<unsigned> theIndices;
+	};
+
+	// Get the copy of a mesh's vertices and indices
+	const MeshData& GetMeshData(Mesh* theMesh);
+
+	bool bRecording;
+	int numOfSprites;
+	int numOfDrawCalls;
+
+	std::vector<Batch> theBatches;
+	std::vector<Vertex> theVertices;
+	std::vector<unsigned> theIndices;
+	std::map<Mesh*, MeshData> theMeshData;
+	// The number of calls to Begin, to age out the copies of the meshes which are no longer added
+	int numOfBegins;
+
+	// The mesh whose vertex array draws from CStreamBuffer
+	Mesh* theBatchMesh;
+};
+
+#endif // SPRITE_BATCH_H
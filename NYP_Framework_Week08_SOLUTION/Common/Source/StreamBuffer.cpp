@@ -0,0 +1,287 @@
+#include "StreamBuffer.h"
+#include "RenderStats.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+#include "GL\glew.h"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+// GL_ARB_buffer_storage is newer than our GLEW, so its flags are defined by hand
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+CStreamBuffer::CStreamBuffer(void)
+	: bufferID(0)
+	, capacity(0)
+	, bPersistent(false)
+	, theMappedData(nullptr)
+	, head(0)
+	, frameSize(0)
+	, usedSize(0)
+	, mapOffset(0)
+	, mapSize(0)
+	, bytesUsed(0)
+	, lastFrameSize(0)
+	, numOfWaits(0)
+{
+}
+
+CStreamBuffer::~CStreamBuffer(void)
+{
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	while (!theFences.empty())
+	{
+		theDevice->DeleteSync(theFences.front().theSync);
+		theFences.pop_front();
+	}
+	if (bufferID != 0)
+	{
+		if (bPersistent)
+		{
+			theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+			theDevice->UnmapBuffer(GL_COPY_WRITE_BUFFER);
+			theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		theDevice->DeleteBuffer(bufferID);
+	}
+}
+
+/**
+* Create the buffer, persistently mapped if the driver supports it
+*/
+void CStreamBuffer::Init(const unsigned capacity)
+{
+	if (bufferID != 0)
+		return;
+	this->capacity = capacity;
+
+	// The copy write target is used throughout, so the vertex and index buffer bindings are left alone
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	bufferID = theDevice->GenBuffer();
+	theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+
+	const unsigned flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	if (theDevice->BufferStorage(GL_COPY_WRITE_BUFFER, capacity, nullptr, flags))
+	{
+		theMappedData = (unsigned char*)theDevice->MapBufferRange(GL_COPY_WRITE_BUFFER, 0, capacity, flags);
+		bPersistent = (theMappedData != nullptr);
+
+		// The storage cannot be changed once it is made, so start again with a new buffer
+		if (!bPersistent)
+		{
+			theDevice->DeleteBuffer(bufferID);
+			bufferID = theDevice->GenBuffer();
+			theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+		}
+	}
+	if (!bPersistent)
+	{
+		cout << "CStreamBuffer::Init: Persistent mapping is not available, so the buffer is orphaned instead" << endl;
+		theDevice->BufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+	}
+
+	theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/**
+* Get the buffer
+*/
+unsigned CStreamBuffer::GetBufferID(void) const
+{
+	return bufferID;
+}
+
+/**
+* Return true if the buffer is persistently mapped
+*/
+bool CStreamBuffer::IsPersistent(void) const
+{
+	return bPersistent;
+}
+
+/**
+* Get a range of the buffer and a pointer to write it
+*/
+void* CStreamBuffer::Map(const unsigned size, const unsigned alignment, unsigned& offset)
+{
+	if (!Allocate(size, alignment, offset))
+		return nullptr;
+
+	mapOffset = offset;
+	mapSize = size;
+	if (bPersistent)
+		return theMappedData + offset;
+
+	if (theStagingData.size() < size)
+		theStagingData.resize(size);
+	return &theStagingData[0];
+}
+
+/**
+* Finish writing the range from Map. A persistently mapped buffer is coherent, so it has nothing to do
+*/
+void CStreamBuffer::Unmap(void)
+{
+	if ((!bPersistent) && (mapSize > 0))
+	{
+		CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+		theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+		theDevice->BufferSubData(GL_COPY_WRITE_BUFFER, mapOffset, mapSize, &theStagingData[0]);
+		theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	if (mapSize > 0)
+		CRenderStats::GetInstance()->AddBufferUpload(mapSize);
+	mapSize = 0;
+}
+
+/**
+* Copy some data into a range of the buffer, and return its offset
+*/
+int CStreamBuffer::Upload(const void* theData, const unsigned size, const unsigned alignment)
+{
+	unsigned offset = 0;
+	if (!Allocate(size, alignment, offset))
+		return -1;
+
+	if (bPersistent)
+	{
+		memcpy(theMappedData + offset, theData, size);
+	}
+	else
+	{
+		CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+		theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+		theDevice->BufferSubData(GL_COPY_WRITE_BUFFER, offset, size, theData);
+		theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	CRenderStats::GetInstance()->AddBufferUpload(size);
+	return (int)offset;
+}
+
+/**
+* Fence the ranges used this frame, and free up the ranges of the frames which the GPU has finished
+*/
+void CStreamBuffer::EndFrame(void)
+{
+	if ((bPersistent) && (frameSize > 0))
+	{
+		FrameFence theFence;
+		theFence.theSync = CGraphicsDevice::GetDevice()->FenceSync();
+		theFence.size = frameSize;
+		theFences.push_back(theFence);
+		frameSize = 0;
+	}
+	while ((!theFences.empty()) && (RetireFrame(false)))
+		;
+
+	lastFrameSize = bytesUsed;
+	bytesUsed = 0;
+}
+
+/**
+* Get the number of bytes used by the last frame
+*/
+unsigned CStreamBuffer::GetBytesUsed(void) const
+{
+	return lastFrameSize;
+}
+
+/**
+* Get the number of times the CPU waited for the GPU to free up a range
+*/
+int CStreamBuffer::GetNumOfWaits(void) const
+{
+	return numOfWaits;
+}
+
+/**
+* Find the next range of the ring which the GPU is not drawing from
+*/
+bool CStreamBuffer::Allocate(const unsigned size, const unsigned alignment, unsigned& offset)
+{
+	if ((bufferID == 0) || (size == 0) || (size > capacity))
+	{
+		cout << "CStreamBuffer::Allocate: Unable to fit " << size << " bytes" << endl;
+		return false;
+	}
+
+	unsigned start = ((head + alignment - 1) / alignment) * alignment;
+	unsigned needed = (start - head) + size;
+	if (start + size > capacity)
+	{
+		// Wrap around, skipping the end of the ring
+		start = 0;
+		needed = (capacity - head) + size;
+
+		// Without the fences, orphan the buffer so the driver gives it new storage
+		if (!bPersistent)
+		{
+			CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+			theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+			theDevice->BufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+			theDevice->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			needed = size;
+		}
+	}
+
+	if (bPersistent)
+	{
+		while (usedSize + needed > capacity)
+		{
+			// Nothing is in use, so the skipped end of the ring does not count
+			if (usedSize == 0)
+			{
+				needed = size;
+				break;
+			}
+			// This frame alone has filled the ring, so fence it to wait for its draws
+			if (theFences.empty())
+			{
+				FrameFence theFence;
+				theFence.theSync = CGraphicsDevice::GetDevice()->FenceSync();
+				theFence.size = frameSize;
+				theFences.push_back(theFence);
+				frameSize = 0;
+			}
+			RetireFrame(true);
+		}
+		usedSize += needed;
+		frameSize += needed;
+	}
+
+	offset = start;
+	head = start + size;
+	bytesUsed += needed;
+	return true;
+}
+
+/**
+* Free up the ranges of the oldest fenced frame, once the GPU has finished drawing from them.
+* Return false if it is not finished and bWait is false
+*/
+bool CStreamBuffer::RetireFrame(const bool bWait)
+{
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	const FrameFence& theFence = theFences.front();
+	GLenum result = theDevice->ClientWaitSync(theFence.theSync, 0, 0);
+	if ((result == GL_TIMEOUT_EXPIRED) && (bWait))
+	{
+		numOfWaits++;
+		do
+		{
+			result = theDevice->ClientWaitSync(theFence.theSync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+	if (result == GL_TIMEOUT_EXPIRED)
+		return false;
+
+	theDevice->DeleteSync(theFence.theSync);
+	usedSize -= theFence.size;
+	theFences.pop_front();
+	return true;
+}
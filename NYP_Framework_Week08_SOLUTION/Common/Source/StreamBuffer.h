@@ -0,0 +1,78 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include "SingletonTemplate.h"
+#include <deque>
+#include <vector>
+
+// A large ring buffer for the geometry which is generated on the CPU every frame, such as the batched
+// sprites and the instance matrices. Each upload gets a range of the ring, so nothing is created every frame.
+// Where GL_ARB_buffer_storage is available, the buffer is mapped once for good, and each frame's ranges are
+// fenced so a range is only written again once the GPU has finished drawing from it. Otherwise the ranges
+// are written with glBufferSubData, and the buffer is orphaned when the ring wraps around.
+class CStreamBuffer : public Singleton<CStreamBuffer>
+{
+	friend Singleton<CStreamBuffer>;
+public:
+	virtual ~CStreamBuffer(void);
+
+	// Create the buffer. Call it after the OpenGL context is created
+	void Init(const unsigned capacity = 4 * 1024 * 1024);
+	// Get the buffer, to bind it as a vertex, index or other buffer
+	unsigned GetBufferID(void) const;
+	// Return true if the buffer is persistently mapped
+	bool IsPersistent(void) const;
+
+	// Get a range of the buffer which starts at a multiple of the alignment, and a pointer to write it.
+	// The range is valid until the end of the frame. Return nullptr if it is larger than the buffer
+	void* Map(const unsigned size, const unsigned alignment, unsigned& offset);
+	// Finish writing the range from Map
+	void Unmap(void);
+	// Copy some data into a range of the buffer, and return its offset, or -1 if it does not fit
+	int Upload(const void* theData, const unsigned size, const unsigned alignment);
+
+	// Fence the ranges used this frame. Call it after swapping the buffers
+	void EndFrame(void);
+
+	// Get the number of bytes used by the last frame
+	unsigned GetBytesUsed(void) const;
+	// Get the number of times the CPU waited for the GPU to free up a range
+	int GetNumOfWaits(void) const;
+
+protected:
+	CStreamBuffer(void);
+
+	// The ranges used by a frame which the GPU may still be drawing from
+	struct FrameFence
+	{
+		void* theSync;
+		unsigned size;
+	};
+
+	// Find the next free range of the ring, waiting for the GPU if it is full
+	bool Allocate(const unsigned size, const unsigned alignment, unsigned& offset);
+	// Free up the ranges of the oldest fenced frame once it is drawn. Return false if it is not drawn and bWait is false
+	bool RetireFrame(const bool bWait);
+
+	unsigned bufferID;
+	unsigned capacity;
+	bool bPersistent;
+	unsigned char* theMappedData;
+
+	// Where the next range starts
+	unsigned head;
+	// The number of bytes in use by this frame, and by all the frames which are still fenced
+	unsigned frameSize;
+	unsigned usedSize;
+	std::deque<FrameFence> theFences;
+
+	// The range being written through Map, and where it is staged when the buffer is not mapped
+	unsigned mapOffset, mapSize;
+	std::vector<unsigned char> theStagingData;
+
+	unsigned bytesUsed;
+	unsigned lastFrameSize;
+	int numOfWaits;
+};
+
+#endif // STREAM_BUFFER_H
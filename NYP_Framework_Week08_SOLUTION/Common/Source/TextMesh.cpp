@@ -0,0 +1,108 @@
+#include "TextMesh.h"
+#include "FontData.h"
+#include "RenderStats.h"
+#include "GraphicsDevice/GraphicsDevice.h"
+#include "GL\glew.h"
+
+CTextMesh::CTextMesh(const std::string& meshName)
+	: Mesh(meshName)
+	, numOfGlyphs(0)
+	, width(0.0f)
+{
+	indexSize = 0;
+	mode = DRAW_TRIANGLES;
+	SetupVertexArray();
+}
+
+CTextMesh::~CTextMesh()
+{
+	// Leave the font's texture for the font mesh to delete
+	textureID = 0;
+}
+
+/**
+* Fill the buffers with the glyph quads of a string
+*/
+void CTextMesh::Build(const std::string& theText)
+{
+	CFontData* theFont = CFontData::GetInstance();
+	const float cellU = theFont->GetCellU();
+	const float cellV = theFont->GetCellV();
+
+	theVertices.clear();
+	Vertex v;
+	v.normal.Set(0, 0, 1);
+	float x = 0.0f;
+	for (unsigned i = 0; i < theText.length(); ++i)
+	{
+		const unsigned char theChar = (unsigned char)theText[i];
+		const float glyphWidth = theFont->GetGlyphWidth(theChar);
+		// Spaces only move the next glyph along
+		if (theChar != ' ')
+		{
+			float u1, v1;
+			theFont->GetGlyphTexCoord(theChar, u1, v1);
+			const float u2 = u1 + glyphWidth * cellU;
+
+			v.pos.Set(x, -0.5f, 0);
+			v.texCoord.Set(u1, v1);
+			theVertices.push_back(v);
+
+			v.pos.Set(x + glyphWidth, -0.5f, 0);
+			v.texCoord.Set(u2, v1);
+			theVertices.push_back(v);
+
+			v.pos.Set(x + glyphWidth, 0.5f, 0);
+			v.texCoord.Set(u2, v1 + cellV);
+			theVertices.push_back(v);
+
+			v.pos.Set(x, 0.5f, 0);
+			v.texCoord.Set(u1, v1 + cellV);
+			theVertices.push_back(v);
+		}
+		x += glyphWidth;
+	}
+	width = x;
+
+	const unsigned numOfQuads = theVertices.size() / 4;
+	indexSize = numOfQuads * 6;
+	if (numOfQuads == 0)
+		return;
+
+	// Bind the vertex array, so the index buffer is not bound into another mesh's vertex array
+	CGraphicsDevice* theDevice = CGraphicsDevice::GetDevice();
+	theDevice->BindVertexArray(vertexArray);
+	theDevice->BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	if (numOfQuads > numOfGlyphs)
+	{
+		// Grow the buffers. The indices of a quad are the same for every glyph, so they are only filled here
+		numOfGlyphs = (numOfQuads > numOfGlyphs * 2 ? numOfQuads : numOfGlyphs * 2);
+
+		std::vector<GLuint> theIndices;
+		theIndices.reserve(numOfGlyphs * 6);
+		for (unsigned i = 0; i < numOfGlyphs; ++i)
+		{
+			theIndices.push_back(i * 4 + 0);
+			theIndices.push_back(i * 4 + 1);
+			theIndices.push_back(i * 4 + 2);
+			theIndices.push_back(i * 4 + 0);
+			theIndices.push_back(i * 4 + 2);
+			theIndices.push_back(i * 4 + 3);
+		}
+		theDevice->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		theDevice->BufferData(GL_ELEMENT_ARRAY_BUFFER, theIndices.size() * sizeof(GLuint), &theIndices[0], GL_STATIC_DRAW);
+		theDevice->BufferData(GL_ARRAY_BUFFER, numOfGlyphs * 4 * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+	}
+	theDevice->BufferSubData(GL_ARRAY_BUFFER, 0, theVertices.size() * sizeof(Vertex), &theVertices[0]);
+	theDevice->BindVertexArray(0);
+	CRenderStats::GetInstance()->AddBufferUpload((unsigned)(theVertices.size() * sizeof(Vertex)));
+	MarkChanged();
+}
+
+/**
+* Get the width of the built string, in cells
+*/
+float CTextMesh::GetWidth(void) const
+{
+	return width;
+}
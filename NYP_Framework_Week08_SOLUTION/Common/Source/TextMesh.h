@@ -0,0 +1,32 @@
+#ifndef TEXT_MESH_H
+#define TEXT_MESH_H
+
+#include "Mesh.h"
+#include "Vertex.h"
+#include <vector>
+
+// A mesh of the glyph quads of one string, so the whole string is drawn with one draw call.
+// The glyphs are laid out along the x-axis by their widths in CFontData, one cell high and
+// centred on y = 0. The buffers are only refilled by Build, and only grow when the string does.
+// The texture is borrowed from the font mesh, so it is not deleted with the text mesh
+class CTextMesh : public Mesh
+{
+public:
+	CTextMesh(const std::string& meshName);
+	~CTextMesh();
+
+	// Fill the buffers with the glyph quads of a string
+	void Build(const std::string& theText);
+	// Get the width of the built string, in cells
+	float GetWidth(void) const;
+
+protected:
+	// The number of glyphs which the buffers have room for
+	unsigned numOfGlyphs;
+	float width;
+
+	// The vertices of the glyphs, kept so they are not allocated every build
+	std::vector<Vertex> theVertices;
+};
+
+#endif // TEXT_MESH_H
@@ -0,0 +1,264 @@
+#include "TextureAtlas.h"
+#include "MeshBuilder.h"
+#include "Mesh.h"
+#include "GL\glew.h"
+#include "LoadTGA.h"
+#include <algorithm>
+#include <iostream>
+using namespace std;
+
+CTextureAtlas::CTextureAtlas(const int pageSize, const int padding)
+	: pageSize(pageSize)
+	, padding(padding)
+	, alignment(1)
+	, maxMipLevel(0)
+{
+	// Each level halves the texels. The border must be as wide as 2 texels of the last level,
+	// as the bilinear filter reads the texel next to the edge of the image too
+	while (alignment * 4 <= padding)
+	{
+		alignment *= 2;
+		maxMipLevel++;
+	}
+}
+
+CTextureAtlas::~CTextureAtlas(void)
+{
+	if (!thePageTextures.empty())
+		glDeleteTextures(thePageTextures.size(), &thePageTextures[0]);
+}
+
+/**
+* Load a TGA image to be packed by Build
+*/
+int CTextureAtlas::AddImage(const std::string& _imageName, const std::string& filePath)
+{
+	unsigned width, height, bytesPerPixel;
+	std::vector<unsigned char> theData;
+	if (!LoadTGAImage(filePath.c_str(), width, height, bytesPerPixel, theData))
+	{
+		cout << "CTextureAtlas::AddImage: Unable to load " << filePath << endl;
+		return -1;
+	}
+
+	Image theImage;
+	theImage.name = _imageName;
+	theImage.width = width;
+	theImage.height = height;
+	if (bytesPerPixel == 4)
+		theImage.thePixels.swap(theData);
+	else
+	{
+		// Give the 24 bit images an opaque alpha channel
+		theImage.thePixels.resize(width * height * 4);
+		for (unsigned i = 0; i < width * height; ++i)
+		{
+			theImage.thePixels[i * 4 + 0] = theData[i * 3 + 0];
+			theImage.thePixels[i * 4 + 1] = theData[i * 3 + 1];
+			theImage.thePixels[i * 4 + 2] = theData[i * 3 + 2];
+			theImage.thePixels[i * 4 + 3] = 255;
+		}
+	}
+
+	const int index = (int)theImages.size();
+	theImages.push_back(theImage);
+	theIndices[_imageName] = index;
+	return index;
+}
+
+/**
+* Pack the images into pages, and upload them
+*/
+bool CTextureAtlas::Build(void)
+{
+	if (theImages.empty())
+		return false;
+
+	// Pack the tallest images first, onto shelves which run across the page
+	std::vector<int> theOrder(theImages.size());
+	for (unsigned i = 0; i < theOrder.size(); ++i)
+		theOrder[i] = i;
+	std::stable_sort(theOrder.begin(), theOrder.end(), [this](const int a, const int b)
+	{
+		return theImages[a].height > theImages[b].height;
+	});
+
+	theRegions.assign(theImages.size(), Region());
+	for (unsigned i = 0; i < theRegions.size(); ++i)
+		theRegions[i].page = -1;
+
+	std::vector<unsigned char> thePage;
+	int numOfPages = 0;
+	int shelfX = 0, shelfY = 0, shelfHeight = 0;
+	bool bResult = true;
+	for (unsigned i = 0; i < theOrder.size(); ++i)
+	{
+		const Image& theImage = theImages[theOrder[i]];
+		const int cellWidth = (theImage.width + padding * 2 + alignment - 1) / alignment * alignment;
+		const int cellHeight = (theImage.height + padding * 2 + alignment - 1) / alignment * alignment;
+		if ((cellWidth > pageSize) || (cellHeight > pageSize))
+		{
+			cout << "CTextureAtlas::Build: " << theImage.name << " does not fit into a page" << endl;
+			bResult = false;
+			continue;
+		}
+
+		// Start a new shelf when this one is full, and a new page when there is no room for the shelf
+		if (shelfX + cellWidth > pageSize)
+		{
+			shelfX = 0;
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+		}
+		if ((numOfPages == 0) || (shelfY + cellHeight > pageSize))
+		{
+			if (numOfPages > 0)
+				thePageTextures.push_back(UploadPage(thePage));
+			thePage.assign(pageSize * pageSize * 4, 0);
+			numOfPages++;
+			shelfX = 0;
+			shelfY = 0;
+			shelfHeight = 0;
+		}
+
+		CopyImage(theImage, thePage, shelfX + padding, shelfY + padding);
+
+		Region& theRegion = theRegions[theOrder[i]];
+		theRegion.page = numOfPages - 1;
+		theRegion.width = theImage.width;
+		theRegion.height = theImage.height;
+		theRegion.minUV.Set((float)(shelfX + padding) / pageSize, (float)(shelfY + padding) / pageSize);
+		theRegion.maxUV.Set((float)(shelfX + padding + theImage.width) / pageSize, (float)(shelfY + padding + theImage.height) / pageSize);
+
+		shelfX += cellWidth;
+		shelfHeight = std::max(shelfHeight, cellHeight);
+	}
+	if (numOfPages > 0)
+		thePageTextures.push_back(UploadPage(thePage));
+
+	for (unsigned i = 0; i < theRegions.size(); ++i)
+	{
+		if (theRegions[i].page >= 0)
+			theRegions[i].textureID = thePageTextures[theRegions[i].page];
+	}
+
+	// The pixels are in the pages now
+	for (unsigned i = 0; i < theImages.size(); ++i)
+		std::vector<unsigned char>().swap(theImages[i].thePixels);
+
+	return bResult;
+}
+
+/**
+* Generate a quad mesh in MeshBuilder for each packed image, named after it
+*/
+void CTextureAtlas::GenerateQuads(const Color& color, const float length)
+{
+	for (unsigned i = 0; i < theRegions.size(); ++i)
+	{
+		if (theRegions[i].page < 0)
+			continue;
+
+		Mesh* theMesh = MeshBuilder::GetInstance()->GenerateQuad(theImages[i].name, color, length, theRegions[i].minUV, theRegions[i].maxUV);
+		theMesh->textureID = theRegions[i].textureID;
+		theMesh->bSharedTexture = true;
+	}
+}
+
+/**
+* Get the index of an image, or -1 if it was not added
+*/
+int CTextureAtlas::GetIndex(const std::string& _imageName) const
+{
+	std::map<std::string, int>::const_iterator it = theIndices.find(_imageName);
+	if (it == theIndices.end())
+		return -1;
+	return it->second;
+}
+
+/**
+* Get the region of an image by its index, or nullptr if it was not packed
+*/
+const CTextureAtlas::Region* CTextureAtlas::GetRegion(const int index) const
+{
+	if ((index < 0) || (index >= (int)theRegions.size()) || (theRegions[index].page < 0))
+		return nullptr;
+	return &theRegions[index];
+}
+
+/**
+* Get the region of an image by its name, or nullptr if it was not packed
+*/
+const CTextureAtlas::Region* CTextureAtlas::GetRegion(const std::string& _imageName) const
+{
+	return GetRegion(GetIndex(_imageName));
+}
+
+/**
+* Get the number of images
+*/
+int CTextureAtlas::GetNumOfImages(void) const
+{
+	return (int)theImages.size();
+}
+
+/**
+* Get the number of pages
+*/
+int CTextureAtlas::GetNumOfPages(void) const
+{
+	return (int)thePageTextures.size();
+}
+
+/**
+* Get the texture of a page
+*/
+unsigned CTextureAtlas::GetPageTexture(const int page) const
+{
+	if ((page < 0) || (page >= (int)thePageTextures.size()))
+		return 0;
+	return thePageTextures[page];
+}
+
+/**
+* Copy an image into a page with its bottom left pixel at (x, y), and repeat its edge pixels into the border
+*/
+void CTextureAtlas::CopyImage(const Image& theImage, std::vector<unsigned char>& thePage, const int x, const int y) const
+{
+	for (int j = -padding; j < theImage.height + padding; ++j)
+	{
+		const int srcY = std::min(std::max(j, 0), theImage.height - 1);
+		for (int i = -padding; i < theImage.width + padding; ++i)
+		{
+			const int srcX = std::min(std::max(i, 0), theImage.width - 1);
+			const unsigned char* src = &theImage.thePixels[(srcY * theImage.width + srcX) * 4];
+			unsigned char* dst = &thePage[((y + j) * pageSize + (x + i)) * 4];
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+			dst[3] = src[3];
+		}
+	}
+}
+
+/**
+* Upload a page into a new texture
+*/
+unsigned CTextureAtlas::UploadPage(const std::vector<unsigned char>& thePage) const
+{
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pageSize, pageSize, 0, GL_BGRA, GL_UNSIGNED_BYTE, &thePage[0]);
+
+	// Stop at the mip level whose texels are half as wide as the border, so no level mixes two images
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxMipLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return texture;
+}
@@ -0,0 +1,75 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "Vertex.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class Mesh;
+
+// Packs many small images, such as tiles and animation frames, into a few atlas pages at load time,
+// so the sprites which use them share a texture and can be drawn in one batch.
+// Each image is surrounded by a border of its own edge pixels, and placed on a grid which matches the
+// smallest mip level, so neither filtering nor the mipmaps blend in the neighbouring images
+class CTextureAtlas
+{
+public:
+	// Where an image was packed. The texture coordinates are of the image's own pixels, without the border
+	struct Region
+	{
+		unsigned textureID;
+		int page;
+		int width, height;
+		TexCoord minUV, maxUV;
+	};
+
+	CTextureAtlas(const int pageSize = 256, const int padding = 4);
+	virtual ~CTextureAtlas(void);
+
+	// Load a TGA image to be packed by Build. Return its index, which is the order it was added in, or -1
+	int AddImage(const std::string& _imageName, const std::string& filePath);
+	// Pack the images into pages, and upload them
+	bool Build(void);
+	// Generate a quad mesh in MeshBuilder for each packed image, named after it, which shows its region of the atlas
+	void GenerateQuads(const Color& color = Color(1, 1, 1), const float length = 1.0f);
+
+	// Get the index of an image, or -1 if it was not added
+	int GetIndex(const std::string& _imageName) const;
+	// Get the region of an image by its index or name, or nullptr if it was not packed
+	const Region* GetRegion(const int index) const;
+	const Region* GetRegion(const std::string& _imageName) const;
+	// Get the number of images
+	int GetNumOfImages(void) const;
+	// Get the number of pages
+	int GetNumOfPages(void) const;
+	// Get the texture of a page
+	unsigned GetPageTexture(const int page) const;
+
+protected:
+	// An image waiting to be packed, with its pixels in BGRA order
+	struct Image
+	{
+		std::string name;
+		int width, height;
+		std::vector<unsigned char> thePixels;
+	};
+
+	// Copy an image with its border into a page
+	void CopyImage(const Image& theImage, std::vector<unsigned char>& thePage, const int x, const int y) const;
+	// Upload a page into a new texture
+	unsigned UploadPage(const std::vector<unsigned char>& thePage) const;
+
+	int pageSize;
+	int padding;
+	// The images are placed on multiples of this, which is 2 to the power of the last mip level
+	int alignment;
+	int maxMipLevel;
+
+	std::vector<Image> theImages;
+	std::vector<Region> theRegions;
+	std::vector<unsigned> thePageTextures;
+	std::map<std::string, int> theIndices;
+};
+
+#endif // TEXTURE_ATLAS_H
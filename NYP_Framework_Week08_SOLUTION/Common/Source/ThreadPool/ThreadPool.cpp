@@ -0,0 +1,150 @@
+#include "ThreadPool.h"
+
+// Set to true on threads which are running jobs, so that nested ParallelFor calls run serially
+static thread_local bool bInsideParallelFor = false;
+
+/********************************************************************************
+ Constructor
+ ********************************************************************************/
+CThreadPool::CThreadPool(void)
+	: theCurrentJob(NULL)
+	, numOfJobs(0)
+	, nextJob(0)
+	, numOfJobsDone(0)
+	, batchID(0)
+	, numOfBusyWorkers(0)
+	, bQuit(false)
+{
+}
+
+/********************************************************************************
+ Destructor
+ ********************************************************************************/
+CThreadPool::~CThreadPool()
+{
+	Exit();
+}
+
+/********************************************************************************
+ Initialise the worker threads
+ ********************************************************************************/
+void CThreadPool::Init(const int numOfWorkers)
+{
+	// Do not create the workers twice
+	if (theWorkers.size() > 0)
+		return;
+
+	int theNumOfWorkers = numOfWorkers;
+	if (theNumOfWorkers <= 0)
+		theNumOfWorkers = (int)std::thread::hardware_concurrency() - 1;
+
+	bQuit = false;
+	for (int i = 0; i < theNumOfWorkers; ++i)
+	{
+		theWorkers.push_back(std::thread(&CThreadPool::WorkerLoop, this));
+	}
+}
+
+/********************************************************************************
+ Stop and join all the worker threads
+ ********************************************************************************/
+void CThreadPool::Exit(void)
+{
+	{
+		std::unique_lock<std::mutex> lock(theMutex);
+		bQuit = true;
+	}
+	theWakeCondition.notify_all();
+
+	for (int i = 0; i < (int)theWorkers.size(); ++i)
+	{
+		if (theWorkers[i].joinable())
+			theWorkers[i].join();
+	}
+	theWorkers.clear();
+}
+
+/********************************************************************************
+ Run theJob(index) for index = 0 .. numOfJobs-1 on all threads
+ ********************************************************************************/
+void CThreadPool::ParallelFor(const int numOfJobs, const std::function<void(const int)>& theJob)
+{
+	// Run the jobs on this thread if there are no workers, too few jobs,
+	// or if we are already inside a job
+	if ((theWorkers.size() == 0) || (numOfJobs <= 1) || (bInsideParallelFor))
+	{
+		for (int i = 0; i < numOfJobs; ++i)
+			theJob(i);
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(theMutex);
+		theCurrentJob = &theJob;
+		this->numOfJobs = numOfJobs;
+		nextJob = 0;
+		numOfJobsDone = 0;
+		numOfBusyWorkers = (int)theWorkers.size();
+		batchID++;
+	}
+	theWakeCondition.notify_all();
+
+	// The calling thread helps out too
+	RunJobs();
+
+	// Wait for the workers to release the current batch
+	std::unique_lock<std::mutex> lock(theMutex);
+	theDoneCondition.wait(lock, [this]() { return numOfBusyWorkers == 0; });
+	theCurrentJob = NULL;
+}
+
+/********************************************************************************
+ Get the number of threads which take part in a ParallelFor
+ ********************************************************************************/
+int CThreadPool::GetNumOfThreads(void) const
+{
+	return (int)theWorkers.size() + 1;
+}
+
+/********************************************************************************
+ The loop which each worker thread runs
+ ********************************************************************************/
+void CThreadPool::WorkerLoop(void)
+{
+	unsigned int lastBatchID = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(theMutex);
+			theWakeCondition.wait(lock, [this, lastBatchID]() { return bQuit || (batchID != lastBatchID); });
+			if (bQuit)
+				return;
+			lastBatchID = batchID;
+		}
+
+		RunJobs();
+
+		{
+			std::unique_lock<std::mutex> lock(theMutex);
+			numOfBusyWorkers--;
+			if (numOfBusyWorkers == 0)
+				theDoneCondition.notify_one();
+		}
+	}
+}
+
+/********************************************************************************
+ Take jobs from the current batch until it is empty
+ ********************************************************************************/
+void CThreadPool::RunJobs(void)
+{
+	bInsideParallelFor = true;
+	int index = nextJob++;
+	while (index < numOfJobs)
+	{
+		(*theCurrentJob)(index);
+		numOfJobsDone++;
+		index = nextJob++;
+	}
+	bInsideParallelFor = false;
+}
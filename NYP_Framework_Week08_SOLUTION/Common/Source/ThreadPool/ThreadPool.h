@@ -0,0 +1,53 @@
+#pragma once
+
+#include "SingletonTemplate.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+class CThreadPool : public Singleton<CThreadPool>
+{
+	friend Singleton<CThreadPool>;
+public:
+	virtual ~CThreadPool();
+
+	// Initialise the worker threads. numOfWorkers=0 means use the number of hardware threads - 1
+	void Init(const int numOfWorkers = 0);
+	// Stop and join all the worker threads
+	void Exit(void);
+
+	// Run theJob(index) for index = 0 .. numOfJobs-1 on the worker threads and the calling thread.
+	// This method returns only after all the jobs are done.
+	void ParallelFor(const int numOfJobs, const std::function<void(const int)>& theJob);
+
+	// Get the number of threads which take part in a ParallelFor, including the calling thread
+	int GetNumOfThreads(void) const;
+
+protected:
+	// Constructor
+	CThreadPool(void);
+
+	// The loop which each worker thread runs
+	void WorkerLoop(void);
+	// Take jobs from the current batch until it is empty
+	void RunJobs(void);
+
+	std::vector<std::thread> theWorkers;
+	std::mutex theMutex;
+	std::condition_variable theWakeCondition;
+	std::condition_variable theDoneCondition;
+
+	// The current batch of jobs
+	const std::function<void(const int)>* theCurrentJob;
+	int numOfJobs;
+	std::atomic<int> nextJob;
+	std::atomic<int> numOfJobsDone;
+	// Incremented for every batch so that sleeping workers know there is new work
+	unsigned int batchID;
+	// Number of workers still working on the current batch
+	int numOfBusyWorkers;
+	bool bQuit;
+};